@@ -0,0 +1,690 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      yafaray_bench.cc : render benchmark. Builds a fixed set of procedural
+ *      reference scenes through the public C API, renders them with fixed
+ *      seeds and reports the wall time of each render stage and the rays per
+ *      second as JSON, to compare performance changes and releases.
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "yafaray_c_api.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned int random_seed = 12345; //!< Fixed seed for the procedural geometry and for the library sampling that still depends on the C rand()
+
+constexpr float pi = 3.14159265358979323846f;
+
+struct Options
+{
+	int threads_{-1};
+	int width_{320};
+	int height_{240};
+	float scale_{1.f}; //!< Multiplier for the amount of geometry, lights and photons of the scenes
+	std::string accelerator_{"yafaray-bvh"};
+	std::string sampler_{"halton"};
+	std::string output_path_; //!< JSON results file. Empty to print the results to stdout
+	std::string images_dir_; //!< Folder to save the rendered images. Empty to not save any images
+	std::vector<std::string> scenes_;
+};
+
+struct BenchScene
+{
+	std::string name_;
+	std::string description_;
+	//! Fills the scene and the integrator parameters. Returns the number of primitives created by the client
+	std::function<size_t(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)> build_;
+	bool volumetric_{false};
+};
+
+struct StageTimes
+{
+	double scene_build_{0.0};
+	double scene_preprocess_{0.0};
+	double accelerator_build_{0.0};
+	double integrator_preprocess_{0.0};
+	double photon_shooting_{-1.0};
+	std::vector<double> passes_;
+	double output_{0.0};
+	double render_{0.0};
+	double rays_{0.0};
+	size_t primitives_{0};
+};
+
+class WallTimer
+{
+	public:
+		WallTimer() : start_{std::chrono::steady_clock::now()} { }
+		double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+
+	private:
+		std::chrono::steady_clock::time_point start_;
+};
+
+float randomFloat(std::mt19937 &random, float min, float max) { return std::uniform_real_distribution<float>{min, max}(random); }
+
+size_t createDiffuseMaterial(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, const char *name, float r, float g, float b)
+{
+	size_t material_id = 0;
+	yafaray_clearParamMap(param_map);
+	yafaray_clearParamMapList(param_map_list);
+	yafaray_setParamMapString(param_map, "type", "shinydiffusemat");
+	yafaray_setParamMapColor(param_map, "color", r, g, b, 1.0);
+	yafaray_createMaterial(scene, &material_id, name, param_map, param_map_list);
+	return material_id;
+}
+
+//! Creates a mesh from arrays of vertices and triangles indices using the bulk mesh functions
+size_t createMesh(yafaray_Scene *scene, yafaray_ParamMap *param_map, const char *name, const std::vector<float> &vertices, const std::vector<float> &uvs, const std::vector<int> &triangles, size_t material_id, bool is_base_object)
+{
+	size_t object_id = 0;
+	const size_t num_triangles{triangles.size() / 3};
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "mesh");
+	yafaray_setParamMapInt(param_map, "num_vertices", static_cast<int>(vertices.size() / 3));
+	yafaray_setParamMapInt(param_map, "num_faces", static_cast<int>(num_triangles));
+	yafaray_setParamMapBool(param_map, "has_uv", uvs.empty() ? YAFARAY_BOOL_FALSE : YAFARAY_BOOL_TRUE);
+	if(is_base_object) yafaray_setParamMapBool(param_map, "is_base_object", YAFARAY_BOOL_TRUE);
+	yafaray_createObject(scene, &object_id, name, param_map);
+	yafaray_initObject(scene, object_id, material_id);
+	yafaray_addVertices(scene, object_id, vertices.data(), nullptr, vertices.size() / 3, 0);
+	if(!uvs.empty()) yafaray_addUvs(scene, object_id, uvs.data(), uvs.size() / 2);
+	yafaray_addFaces(scene, object_id, triangles.data(), uvs.empty() ? nullptr : triangles.data(), num_triangles, 3, nullptr, material_id);
+	return object_id;
+}
+
+//! Axis aligned box made of 12 triangles, with the UVs of each face covering the whole [0, 1] range
+size_t createBox(yafaray_Scene *scene, yafaray_ParamMap *param_map, const char *name, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, size_t material_id, bool with_uv = false)
+{
+	const float corners[8][3]{{min_x, min_y, min_z}, {max_x, min_y, min_z}, {max_x, max_y, min_z}, {min_x, max_y, min_z}, {min_x, min_y, max_z}, {max_x, min_y, max_z}, {max_x, max_y, max_z}, {min_x, max_y, max_z}};
+	const int faces[6][4]{{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+	const float face_uvs[4][2]{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}};
+	std::vector<float> vertices, uvs;
+	std::vector<int> triangles;
+	for(const auto &face : faces)
+	{
+		const int first_vertex{static_cast<int>(vertices.size() / 3)};
+		for(int corner = 0; corner < 4; ++corner)
+		{
+			vertices.insert(vertices.end(), corners[face[corner]], corners[face[corner]] + 3);
+			if(with_uv) uvs.insert(uvs.end(), face_uvs[corner], face_uvs[corner] + 2);
+		}
+		triangles.insert(triangles.end(), {first_vertex, first_vertex + 1, first_vertex + 2, first_vertex, first_vertex + 2, first_vertex + 3});
+	}
+	createMesh(scene, param_map, name, vertices, uvs, triangles, material_id, false);
+	return triangles.size() / 3;
+}
+
+void createPointLight(yafaray_Scene *scene, yafaray_ParamMap *param_map, const char *name, float x, float y, float z, float r, float g, float b, float power)
+{
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "pointlight");
+	yafaray_setParamMapVector(param_map, "from", x, y, z);
+	yafaray_setParamMapColor(param_map, "color", r, g, b, 1.0);
+	yafaray_setParamMapFloat(param_map, "power", power);
+	yafaray_createLight(scene, name, param_map);
+}
+
+void defineConstantBackground(yafaray_Scene *scene, yafaray_ParamMap *param_map, float power)
+{
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "constant");
+	yafaray_setParamMapColor(param_map, "color", 0.7, 0.75, 0.8, 1.0);
+	yafaray_setParamMapFloat(param_map, "power", power);
+	yafaray_defineBackground(scene, param_map);
+}
+
+size_t buildTriangleSoup(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	const size_t material_id{createDiffuseMaterial(scene, param_map, param_map_list, "soup", 0.8f, 0.6f, 0.4f)};
+	const auto num_triangles{static_cast<size_t>(300000 * options.scale_)};
+	std::vector<float> vertices;
+	std::vector<int> triangles;
+	vertices.reserve(num_triangles * 9);
+	triangles.reserve(num_triangles * 3);
+	for(size_t i = 0; i < num_triangles; ++i)
+	{
+		const float center[3]{randomFloat(random, -2.f, 2.f), randomFloat(random, -2.f, 2.f), randomFloat(random, -2.f, 2.f)};
+		for(int vertex = 0; vertex < 3; ++vertex)
+		{
+			for(const float coordinate : center) vertices.emplace_back(coordinate + randomFloat(random, -0.05f, 0.05f));
+			triangles.emplace_back(static_cast<int>(3 * i) + vertex);
+		}
+	}
+	createMesh(scene, param_map, "soup", vertices, {}, triangles, material_id, false);
+	createPointLight(scene, param_map, "key", 6.f, -5.f, 8.f, 1.f, 1.f, 1.f, 80.f);
+	defineConstantBackground(scene, param_map, 0.5f);
+	yafaray_setParamMapString(integrator_param_map, "type", "directlighting");
+	return num_triangles;
+}
+
+size_t buildInstancing(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	const size_t material_id{createDiffuseMaterial(scene, param_map, param_map_list, "instanced", 0.5f, 0.7f, 0.9f)};
+	//Base object: a sphere tessellated in latitude/longitude bands
+	constexpr int bands{24};
+	std::vector<float> vertices;
+	std::vector<int> triangles;
+	for(int lat = 0; lat <= bands; ++lat)
+	{
+		const float theta{pi * static_cast<float>(lat) / bands};
+		for(int lon = 0; lon <= 2 * bands; ++lon)
+		{
+			const float phi{pi * static_cast<float>(lon) / bands};
+			vertices.insert(vertices.end(), {0.1f * std::sin(theta) * std::cos(phi), 0.1f * std::sin(theta) * std::sin(phi), 0.1f * std::cos(theta)});
+		}
+	}
+	for(int lat = 0; lat < bands; ++lat)
+	{
+		for(int lon = 0; lon < 2 * bands; ++lon)
+		{
+			const int a{lat * (2 * bands + 1) + lon}, b{a + 2 * bands + 1};
+			triangles.insert(triangles.end(), {a, b, a + 1, a + 1, b, b + 1});
+		}
+	}
+	const size_t base_object_id{createMesh(scene, param_map, "sphere", vertices, {}, triangles, material_id, true)};
+	const auto num_instances{static_cast<size_t>(20000 * options.scale_)};
+	for(size_t i = 0; i < num_instances; ++i)
+	{
+		const size_t instance_id{yafaray_createInstance(scene)};
+		yafaray_addInstanceObject(scene, instance_id, base_object_id);
+		const float scale{randomFloat(random, 0.5f, 1.5f)};
+		yafaray_addInstanceMatrix(scene, instance_id, scale, 0.f, 0.f, randomFloat(random, -3.f, 3.f), 0.f, scale, 0.f, randomFloat(random, -3.f, 3.f), 0.f, 0.f, scale, randomFloat(random, -3.f, 3.f), 0.f, 0.f, 0.f, 1.f, 0.f);
+	}
+	createPointLight(scene, param_map, "key", 6.f, -5.f, 8.f, 1.f, 1.f, 1.f, 80.f);
+	defineConstantBackground(scene, param_map, 0.5f);
+	yafaray_setParamMapString(integrator_param_map, "type", "directlighting");
+	return num_instances * triangles.size() / 3;
+}
+
+//! Soup of small triangles and sphere instances moving fast along curved paths, so their bounds for the whole shutter time are much larger than their size
+size_t buildMotionBlur(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	const size_t material_id{createDiffuseMaterial(scene, param_map, param_map_list, "moving", 0.8f, 0.6f, 0.4f)};
+	const auto num_triangles{static_cast<size_t>(100000 * options.scale_)};
+	std::array<std::vector<float>, 3> time_step_vertices;
+	std::vector<int> triangles;
+	for(auto &vertices : time_step_vertices) vertices.reserve(num_triangles * 9);
+	triangles.reserve(num_triangles * 3);
+	for(size_t i = 0; i < num_triangles; ++i)
+	{
+		const float center[3]{randomFloat(random, -2.f, 2.f), randomFloat(random, -2.f, 2.f), randomFloat(random, -2.f, 2.f)};
+		const float motion[3]{randomFloat(random, -0.5f, 0.5f), randomFloat(random, -0.5f, 0.5f), randomFloat(random, -0.5f, 0.5f)};
+		const float bend[3]{randomFloat(random, -0.2f, 0.2f), randomFloat(random, -0.2f, 0.2f), randomFloat(random, -0.2f, 0.2f)};
+		for(int vertex = 0; vertex < 3; ++vertex)
+		{
+			float offset[3];
+			for(float &coordinate : offset) coordinate = randomFloat(random, -0.05f, 0.05f);
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				time_step_vertices[0].emplace_back(center[axis] + offset[axis] - motion[axis]);
+				time_step_vertices[1].emplace_back(center[axis] + offset[axis] + bend[axis]);
+				time_step_vertices[2].emplace_back(center[axis] + offset[axis] + motion[axis]);
+			}
+			triangles.emplace_back(static_cast<int>(3 * i) + vertex);
+		}
+	}
+	size_t object_id = 0;
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "mesh");
+	yafaray_setParamMapInt(param_map, "num_vertices", static_cast<int>(num_triangles * 3));
+	yafaray_setParamMapInt(param_map, "num_faces", static_cast<int>(num_triangles));
+	yafaray_setParamMapBool(param_map, "motion_blur_bezier", YAFARAY_BOOL_TRUE);
+	yafaray_createObject(scene, &object_id, "moving_soup", param_map);
+	yafaray_initObject(scene, object_id, material_id);
+	for(unsigned char time_step = 0; time_step < 3; ++time_step) yafaray_addVertices(scene, object_id, time_step_vertices[time_step].data(), nullptr, num_triangles * 3, time_step);
+	yafaray_addFaces(scene, object_id, triangles.data(), nullptr, num_triangles, 3, nullptr, material_id);
+
+	//Base object: an octahedron
+	const std::vector<float> octahedron_vertices{0.1f, 0.f, 0.f, -0.1f, 0.f, 0.f, 0.f, 0.1f, 0.f, 0.f, -0.1f, 0.f, 0.f, 0.f, 0.1f, 0.f, 0.f, -0.1f};
+	const std::vector<int> octahedron_triangles{0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5};
+	const size_t base_object_id{createMesh(scene, param_map, "octahedron", octahedron_vertices, {}, octahedron_triangles, material_id, true)};
+	const auto num_instances{static_cast<size_t>(5000 * options.scale_)};
+	for(size_t i = 0; i < num_instances; ++i)
+	{
+		const size_t instance_id{yafaray_createInstance(scene)};
+		yafaray_addInstanceObject(scene, instance_id, base_object_id);
+		const float x{randomFloat(random, -3.f, 3.f)}, y{randomFloat(random, -3.f, 3.f)}, z{randomFloat(random, -3.f, 3.f)};
+		const float motion_x{randomFloat(random, -0.8f, 0.8f)}, motion_y{randomFloat(random, -0.8f, 0.8f)}, motion_z{randomFloat(random, -0.8f, 0.8f)};
+		for(int time_step = 0; time_step < 3; ++time_step)
+		{
+			const float step{static_cast<float>(time_step - 1)};
+			yafaray_addInstanceMatrix(scene, instance_id, 1.f, 0.f, 0.f, x + step * motion_x, 0.f, 1.f, 0.f, y + step * motion_y, 0.f, 0.f, 1.f, z + step * motion_z, 0.f, 0.f, 0.f, 1.f, 0.5f * static_cast<float>(time_step));
+		}
+	}
+	createPointLight(scene, param_map, "key", 6.f, -5.f, 8.f, 1.f, 1.f, 1.f, 80.f);
+	defineConstantBackground(scene, param_map, 0.5f);
+	yafaray_setParamMapString(integrator_param_map, "type", "directlighting");
+	return num_triangles + num_instances * octahedron_triangles.size() / 3;
+}
+
+size_t buildManyLights(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	const size_t material_id{createDiffuseMaterial(scene, param_map, param_map_list, "floor", 0.8f, 0.8f, 0.8f)};
+	size_t num_primitives{createBox(scene, param_map, "floor", -5.f, -5.f, -0.1f, 5.f, 5.f, 0.f, material_id)};
+	for(int i = 0; i < 16; ++i)
+	{
+		const float x{randomFloat(random, -4.f, 4.f)}, y{randomFloat(random, -4.f, 4.f)};
+		num_primitives += createBox(scene, param_map, ("block_" + std::to_string(i)).c_str(), x, y, 0.f, x + 0.5f, y + 0.5f, randomFloat(random, 0.2f, 1.5f), material_id);
+	}
+	const auto num_lights{static_cast<size_t>(1000 * options.scale_)};
+	for(size_t i = 0; i < num_lights; ++i)
+	{
+		createPointLight(scene, param_map, ("light_" + std::to_string(i)).c_str(), randomFloat(random, -5.f, 5.f), randomFloat(random, -5.f, 5.f), randomFloat(random, 0.2f, 3.f), randomFloat(random, 0.2f, 1.f), randomFloat(random, 0.2f, 1.f), randomFloat(random, 0.2f, 1.f), 0.2f);
+	}
+	defineConstantBackground(scene, param_map, 0.1f);
+	yafaray_setParamMapString(integrator_param_map, "type", "pathtracing");
+	yafaray_setParamMapInt(integrator_param_map, "path_samples", 4);
+	yafaray_setParamMapInt(integrator_param_map, "bounces", 2);
+	return num_primitives;
+}
+
+size_t buildTextured(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	//Procedural checker image created in memory, so the benchmark does not depend on the image formats built in the library
+	constexpr int image_size{1024};
+	size_t image_id = 0;
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "ColorAlpha");
+	yafaray_setParamMapString(param_map, "color_space", "LinearRGB");
+	yafaray_setParamMapInt(param_map, "width", image_size);
+	yafaray_setParamMapInt(param_map, "height", image_size);
+	yafaray_createImage(scene, "checker_image", &image_id, param_map);
+	for(int y = 0; y < image_size; ++y)
+	{
+		for(int x = 0; x < image_size; ++x)
+		{
+			const bool checker{((x / 32) + (y / 32)) % 2 == 0};
+			const float noise{randomFloat(random, 0.f, 0.1f)};
+			yafaray_setImageColor(scene, image_id, x, y, checker ? 0.9f - noise : 0.1f + noise, 0.5f, checker ? 0.2f : 0.7f, 1.f);
+		}
+	}
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "image");
+	yafaray_setParamMapString(param_map, "image_name", "checker_image");
+	yafaray_setParamMapString(param_map, "interpolate", "bilinear");
+	yafaray_createTexture(scene, "checker", param_map);
+
+	size_t material_id = 0;
+	yafaray_clearParamMapList(param_map_list);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "layer");
+	yafaray_setParamMapString(param_map, "name", "diff_layer0");
+	yafaray_setParamMapString(param_map, "input", "map0");
+	yafaray_setParamMapColor(param_map, "upper_color", 0.8, 0.8, 0.8, 1);
+	yafaray_addParamMapToList(param_map_list, param_map);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "texture_mapper");
+	yafaray_setParamMapString(param_map, "name", "map0");
+	yafaray_setParamMapString(param_map, "texco", "uv");
+	yafaray_setParamMapString(param_map, "texture", "checker");
+	yafaray_addParamMapToList(param_map_list, param_map);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "shinydiffusemat");
+	yafaray_setParamMapColor(param_map, "color", 0.8, 0.8, 0.8, 1);
+	yafaray_setParamMapString(param_map, "diffuse_shader", "diff_layer0");
+	yafaray_createMaterial(scene, &material_id, "textured", param_map, param_map_list);
+
+	size_t num_primitives{createBox(scene, param_map, "floor", -6.f, -6.f, -0.1f, 6.f, 6.f, 0.f, material_id, true)};
+	const auto num_boxes{static_cast<int>(200 * options.scale_)};
+	for(int i = 0; i < num_boxes; ++i)
+	{
+		const float x{randomFloat(random, -5.f, 5.f)}, y{randomFloat(random, -5.f, 5.f)}, size{randomFloat(random, 0.2f, 0.6f)};
+		num_primitives += createBox(scene, param_map, ("box_" + std::to_string(i)).c_str(), x, y, 0.f, x + size, y + size, size, material_id, true);
+	}
+	createPointLight(scene, param_map, "key", 6.f, -5.f, 8.f, 1.f, 1.f, 1.f, 80.f);
+	defineConstantBackground(scene, param_map, 0.5f);
+	yafaray_setParamMapString(integrator_param_map, "type", "directlighting");
+	return num_primitives;
+}
+
+size_t buildVolumetric(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &, std::mt19937 &random)
+{
+	const size_t material_id{createDiffuseMaterial(scene, param_map, param_map_list, "diffuse", 0.8f, 0.8f, 0.8f)};
+	size_t num_primitives{createBox(scene, param_map, "floor", -5.f, -5.f, -0.1f, 5.f, 5.f, 0.f, material_id)};
+	for(int i = 0; i < 8; ++i)
+	{
+		const float x{randomFloat(random, -3.f, 3.f)}, y{randomFloat(random, -3.f, 3.f)};
+		num_primitives += createBox(scene, param_map, ("pillar_" + std::to_string(i)).c_str(), x, y, 0.f, x + 0.3f, y + 0.3f, 2.f, material_id);
+	}
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "UniformVolume");
+	yafaray_setParamMapFloat(param_map, "sigma_s", 0.2);
+	yafaray_setParamMapFloat(param_map, "sigma_a", 0.05);
+	yafaray_setParamMapFloat(param_map, "minX", -4.0);
+	yafaray_setParamMapFloat(param_map, "minY", -4.0);
+	yafaray_setParamMapFloat(param_map, "minZ", 0.0);
+	yafaray_setParamMapFloat(param_map, "maxX", 4.0);
+	yafaray_setParamMapFloat(param_map, "maxY", 4.0);
+	yafaray_setParamMapFloat(param_map, "maxZ", 3.0);
+	yafaray_createVolumeRegion(scene, "fog", param_map);
+	createPointLight(scene, param_map, "key", 2.f, -2.f, 4.f, 1.f, 0.9f, 0.8f, 60.f);
+	defineConstantBackground(scene, param_map, 0.1f);
+	yafaray_setParamMapString(integrator_param_map, "type", "directlighting");
+	return num_primitives;
+}
+
+size_t buildPhotonMapping(yafaray_Scene *scene, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, yafaray_ParamMap *integrator_param_map, const Options &options, std::mt19937 &random)
+{
+	//Box open at the front and lit from near the ceiling, so most of the lighting is indirect
+	const size_t white_id{createDiffuseMaterial(scene, param_map, param_map_list, "white", 0.8f, 0.8f, 0.8f)};
+	const size_t red_id{createDiffuseMaterial(scene, param_map, param_map_list, "red", 0.8f, 0.1f, 0.1f)};
+	const size_t green_id{createDiffuseMaterial(scene, param_map, param_map_list, "green", 0.1f, 0.8f, 0.1f)};
+	size_t num_primitives{createBox(scene, param_map, "floor", -2.f, -2.f, -0.1f, 2.f, 2.f, 0.f, white_id)};
+	num_primitives += createBox(scene, param_map, "ceiling", -2.f, -2.f, 3.f, 2.f, 2.f, 3.1f, white_id);
+	num_primitives += createBox(scene, param_map, "back", -2.f, 2.f, 0.f, 2.f, 2.1f, 3.f, white_id);
+	num_primitives += createBox(scene, param_map, "left", -2.1f, -2.f, 0.f, -2.f, 2.f, 3.f, red_id);
+	num_primitives += createBox(scene, param_map, "right", 2.f, -2.f, 0.f, 2.1f, 2.f, 3.f, green_id);
+	for(int i = 0; i < 4; ++i)
+	{
+		const float x{randomFloat(random, -1.5f, 1.f)}, y{randomFloat(random, -1.5f, 1.f)};
+		num_primitives += createBox(scene, param_map, ("block_" + std::to_string(i)).c_str(), x, y, 0.f, x + 0.5f, y + 0.5f, randomFloat(random, 0.3f, 1.2f), white_id);
+	}
+	createPointLight(scene, param_map, "ceiling_light", 0.f, 0.f, 2.8f, 1.f, 0.95f, 0.9f, 5.f);
+	yafaray_setParamMapString(integrator_param_map, "type", "photonmapping");
+	yafaray_setParamMapInt(integrator_param_map, "diffuse_photons", static_cast<int>(500000 * options.scale_));
+	yafaray_setParamMapInt(integrator_param_map, "caustic_photons", static_cast<int>(100000 * options.scale_));
+	yafaray_setParamMapInt(integrator_param_map, "fg_samples", 8);
+	return num_primitives;
+}
+
+std::vector<BenchScene> referenceScenes()
+{
+	return {
+			{"triangle_soup", "Dense soup of small random triangles, stresses the accelerator build and traversal", buildTriangleSoup},
+			{"instancing", "Thousands of instances of a tessellated sphere, stresses the two level instance traversal", buildInstancing},
+			{"motion_blur", "Triangles and instances moving fast during the shutter time, stresses the traversal of motion blurred geometry", buildMotionBlur},
+			{"many_lights", "Thousands of point lights with the path tracer, stresses the light selection", buildManyLights},
+			{"textured", "Boxes mapped with a large in-memory image texture, stresses texture fetches and mipmaps", buildTextured},
+			{"volumetric", "Uniform participating medium with single scattering, stresses the volume integration", buildVolumetric, true},
+			{"photon_mapping", "Box lit from near the ceiling, stresses photon shooting, photon map building and final gathering", buildPhotonMapping},
+	};
+}
+
+StageTimes runScene(const BenchScene &bench_scene, const Options &options, yafaray_Logger *logger)
+{
+	StageTimes times;
+	std::mt19937 random{random_seed};
+	std::srand(random_seed);
+
+	yafaray_ParamMap *param_map{yafaray_createParamMap()};
+	yafaray_ParamMap *integrator_param_map{yafaray_createParamMap()};
+	yafaray_ParamMapList *param_map_list{yafaray_createParamMapList()};
+
+	const WallTimer build_timer;
+	yafaray_Scene *scene{yafaray_createScene(logger, bench_scene.name_.c_str())};
+	yafaray_setParamMapString(param_map, "type", options.accelerator_.c_str());
+	if(options.accelerator_ == "yafaray-kdtree-multi-thread") yafaray_setParamMapInt(param_map, "threads", options.threads_);
+	yafaray_setSceneAcceleratorParams(scene, param_map);
+	yafaray_setParamMapInt(integrator_param_map, "threads", options.threads_);
+	yafaray_setParamMapInt(integrator_param_map, "threads_photons", options.threads_);
+	times.primitives_ = bench_scene.build_(scene, param_map, param_map_list, integrator_param_map, options, random);
+	times.scene_build_ = build_timer.seconds();
+
+	yafaray_SurfaceIntegrator *surface_integrator{yafaray_createSurfaceIntegrator(logger, "surface integrator", integrator_param_map)};
+	if(bench_scene.volumetric_)
+	{
+		yafaray_clearParamMap(param_map);
+		yafaray_setParamMapString(param_map, "type", "SingleScatterIntegrator");
+		yafaray_setParamMapFloat(param_map, "stepSize", 0.1);
+		yafaray_defineVolumeIntegrator(surface_integrator, scene, param_map);
+	}
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapInt(param_map, "width", options.width_);
+	yafaray_setParamMapInt(param_map, "height", options.height_);
+	yafaray_setParamMapInt(param_map, "threads", options.threads_);
+	yafaray_setParamMapInt(param_map, "AA_passes", 2);
+	yafaray_setParamMapInt(param_map, "AA_minsamples", 2);
+	yafaray_setParamMapInt(param_map, "AA_inc_samples", 2);
+	yafaray_setParamMapFloat(param_map, "AA_threshold", 0.0);
+	yafaray_setParamMapString(param_map, "AA_sampler", options.sampler_.c_str());
+	yafaray_Film *film{yafaray_createFilm(logger, surface_integrator, "film", param_map)};
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "combined");
+	yafaray_setParamMapString(param_map, "image_type", "ColorAlpha");
+	yafaray_setParamMapString(param_map, "exported_image_type", "ColorAlpha");
+	yafaray_setParamMapString(param_map, "exported_image_name", "Combined");
+	yafaray_defineLayer(film, param_map);
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "perspective");
+	yafaray_setParamMapInt(param_map, "resx", options.width_);
+	yafaray_setParamMapInt(param_map, "resy", options.height_);
+	yafaray_setParamMapFloat(param_map, "focal", 1.1);
+	if(bench_scene.name_ == "photon_mapping")
+	{
+		yafaray_setParamMapVector(param_map, "from", 0.0, -6.0, 1.5);
+		yafaray_setParamMapVector(param_map, "to", 0.0, -5.0, 1.5);
+		yafaray_setParamMapVector(param_map, "up", 0.0, -6.0, 2.5);
+	}
+	else
+	{
+		yafaray_setParamMapVector(param_map, "from", 7.0, -7.0, 5.0);
+		yafaray_setParamMapVector(param_map, "to", 6.35, -6.35, 4.55);
+		yafaray_setParamMapVector(param_map, "up", 6.7, -6.7, 6.0);
+	}
+	yafaray_defineCamera(film, param_map);
+
+	if(!options.images_dir_.empty())
+	{
+		yafaray_clearParamMap(param_map);
+		yafaray_setParamMapString(param_map, "image_path", (options.images_dir_ + "/" + bench_scene.name_ + ".tga").c_str());
+		yafaray_createOutput(film, "output_tga", param_map);
+	}
+
+	yafaray_RenderMonitor *render_monitor{yafaray_createRenderMonitor(nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_HIDDEN)};
+	yafaray_RenderControl *render_control{yafaray_createRenderControl()};
+	yafaray_setRenderControlForNormalStart(render_control);
+	const double rays_start{yafaray_getNumRaysTraced()};
+
+	const WallTimer scene_preprocess_timer;
+	yafaray_preprocessScene(scene, render_control, yafaray_checkAndClearSceneModifiedFlags(scene));
+	times.scene_preprocess_ = scene_preprocess_timer.seconds();
+	times.accelerator_build_ = yafaray_getSceneAcceleratorBuildTime(scene);
+
+	const WallTimer integrator_preprocess_timer;
+	yafaray_preprocessSurfaceIntegrator(render_monitor, surface_integrator, render_control, scene);
+	times.integrator_preprocess_ = integrator_preprocess_timer.seconds();
+	times.photon_shooting_ = yafaray_getRenderMonitorTimerTime(render_monitor, "prepass");
+
+	const WallTimer render_timer;
+	yafaray_render(render_control, render_monitor, surface_integrator, film);
+	times.render_ = render_timer.seconds();
+	times.rays_ = yafaray_getNumRaysTraced() - rays_start;
+	for(int pass = 1;; ++pass)
+	{
+		const double pass_time{yafaray_getRenderMonitorTimerTime(render_monitor, ("pass_" + std::to_string(pass)).c_str())};
+		if(pass_time < 0.0) break;
+		times.passes_.emplace_back(pass_time);
+	}
+	times.output_ = yafaray_getRenderMonitorTimerTime(render_monitor, "output");
+
+	yafaray_destroyRenderControl(render_control);
+	yafaray_destroyRenderMonitor(render_monitor);
+	yafaray_destroyFilm(film);
+	yafaray_destroySurfaceIntegrator(surface_integrator);
+	yafaray_destroyScene(scene);
+	yafaray_destroyParamMapList(param_map_list);
+	yafaray_destroyParamMap(integrator_param_map);
+	yafaray_destroyParamMap(param_map);
+	return times;
+}
+
+std::string jsonString(const std::string &text)
+{
+	std::string result{"\""};
+	for(const char c : text)
+	{
+		if(c == '"' || c == '\\') result += '\\';
+		result += c;
+	}
+	return result + "\"";
+}
+
+std::string resultsToJson(const Options &options, const std::vector<std::pair<const BenchScene *, StageTimes>> &results)
+{
+	char *version{yafaray_getVersionString()};
+	std::stringstream ss;
+	ss.precision(6);
+	ss << std::fixed;
+	ss << "{\n";
+	ss << "\t\"yafaray_version\": " << jsonString(version) << ",\n";
+	ss << "\t\"seed\": " << random_seed << ",\n";
+	ss << "\t\"threads\": " << options.threads_ << ",\n";
+	ss << "\t\"width\": " << options.width_ << ",\n";
+	ss << "\t\"height\": " << options.height_ << ",\n";
+	ss << "\t\"scale\": " << options.scale_ << ",\n";
+	ss << "\t\"accelerator\": " << jsonString(options.accelerator_) << ",\n";
+	ss << "\t\"sampler\": " << jsonString(options.sampler_) << ",\n";
+	ss << "\t\"scenes\": [\n";
+	for(size_t i = 0; i < results.size(); ++i)
+	{
+		const auto &[bench_scene, times]{results[i]};
+		const double tracing_time{times.integrator_preprocess_ + times.render_};
+		ss << "\t\t{\n";
+		ss << "\t\t\t\"name\": " << jsonString(bench_scene->name_) << ",\n";
+		ss << "\t\t\t\"description\": " << jsonString(bench_scene->description_) << ",\n";
+		ss << "\t\t\t\"primitives\": " << times.primitives_ << ",\n";
+		ss << "\t\t\t\"stages\": {\n";
+		ss << "\t\t\t\t\"scene_build\": " << times.scene_build_ << ",\n";
+		ss << "\t\t\t\t\"scene_preprocess\": " << times.scene_preprocess_ << ",\n";
+		ss << "\t\t\t\t\"accelerator_build\": " << times.accelerator_build_ << ",\n";
+		ss << "\t\t\t\t\"integrator_preprocess\": " << times.integrator_preprocess_ << ",\n";
+		ss << "\t\t\t\t\"photon_shooting\": ";
+		if(times.photon_shooting_ >= 0.0) ss << times.photon_shooting_; else ss << "null";
+		ss << ",\n";
+		ss << "\t\t\t\t\"render_passes\": [";
+		for(size_t pass = 0; pass < times.passes_.size(); ++pass) ss << (pass > 0 ? ", " : "") << times.passes_[pass];
+		ss << "],\n";
+		ss << "\t\t\t\t\"output\": " << times.output_ << ",\n";
+		ss << "\t\t\t\t\"render\": " << times.render_ << "\n";
+		ss << "\t\t\t},\n";
+		ss << "\t\t\t\"rays\": " << std::llround(times.rays_) << ",\n";
+		ss << "\t\t\t\"rays_per_second\": " << (tracing_time > 0.0 ? times.rays_ / tracing_time : 0.0) << "\n";
+		ss << "\t\t}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	ss << "\t]\n";
+	ss << "}\n";
+	yafaray_destroyCharString(version);
+	return ss.str();
+}
+
+void printUsage(const std::vector<BenchScene> &scenes)
+{
+	std::cout << "Usage: yafaray-bench [options] [scene names...]\n"
+			"Options:\n"
+			"  --threads N        Number of render threads, -1 for automatic detection (default -1)\n"
+			"  --size WxH         Render resolution (default 320x240)\n"
+			"  --scale S          Multiplier for the amount of geometry, lights and photons (default 1.0)\n"
+			"  --accelerator T    Scene accelerator type (default yafaray-bvh)\n"
+			"  --sampler T        Pixel sampler: halton, sobol or pmj02 (default halton)\n"
+			"  --output FILE      Write the JSON results to FILE instead of stdout\n"
+			"  --images DIR       Save the rendered images as TGA files in DIR\n"
+			"Scenes:\n";
+	for(const auto &scene : scenes) std::cout << "  " << scene.name_ << ": " << scene.description_ << "\n";
+}
+
+} //namespace
+
+int main(int argc, char *argv[])
+{
+	const std::vector<BenchScene> scenes{referenceScenes()};
+	Options options;
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string arg{argv[i]};
+		const bool has_value{i + 1 < argc};
+		if(arg == "--help" || arg == "-h")
+		{
+			printUsage(scenes);
+			return 0;
+		}
+		else if(arg == "--threads" && has_value) options.threads_ = std::atoi(argv[++i]);
+		else if(arg == "--size" && has_value)
+		{
+			if(std::sscanf(argv[++i], "%dx%d", &options.width_, &options.height_) != 2 || options.width_ <= 0 || options.height_ <= 0)
+			{
+				std::cerr << "yafaray-bench: wrong render size '" << argv[i] << "'\n";
+				return 1;
+			}
+		}
+		else if(arg == "--scale" && has_value) options.scale_ = std::max(0.01f, static_cast<float>(std::atof(argv[++i])));
+		else if(arg == "--accelerator" && has_value) options.accelerator_ = argv[++i];
+		else if(arg == "--sampler" && has_value) options.sampler_ = argv[++i];
+		else if(arg == "--output" && has_value) options.output_path_ = argv[++i];
+		else if(arg == "--images" && has_value) options.images_dir_ = argv[++i];
+		else if(arg.rfind("--", 0) == 0)
+		{
+			std::cerr << "yafaray-bench: unknown option '" << arg << "'\n";
+			printUsage(scenes);
+			return 1;
+		}
+		else options.scenes_.emplace_back(arg);
+	}
+	for(const auto &scene_name : options.scenes_)
+	{
+		bool found = false;
+		for(const auto &scene : scenes) found = found || scene.name_ == scene_name;
+		if(!found)
+		{
+			std::cerr << "yafaray-bench: unknown scene '" << scene_name << "'\n";
+			return 1;
+		}
+	}
+
+	yafaray_Logger *logger{yafaray_createLogger("yafaray-bench", nullptr, nullptr, YAFARAY_DISPLAY_CONSOLE_NORMAL)};
+	yafaray_setConsoleVerbosityLevel(logger, YAFARAY_LOG_LEVEL_WARNING);
+	yafaray_setLogVerbosityLevel(logger, YAFARAY_LOG_LEVEL_MUTE);
+
+	std::vector<std::pair<const BenchScene *, StageTimes>> results;
+	for(const auto &scene : scenes)
+	{
+		if(!options.scenes_.empty() && std::find(options.scenes_.begin(), options.scenes_.end(), scene.name_) == options.scenes_.end()) continue;
+		std::cerr << "yafaray-bench: rendering scene '" << scene.name_ << "'..." << std::endl;
+		results.emplace_back(&scene, runScene(scene, options, logger));
+	}
+	yafaray_destroyLogger(logger);
+
+	const std::string json{resultsToJson(options, results)};
+	if(options.output_path_.empty()) std::cout << json;
+	else
+	{
+		std::ofstream file{options.output_path_};
+		if(!(file << json))
+		{
+			std::cerr << "yafaray-bench: could not write the results to '" << options.output_path_ << "'\n";
+			return 1;
+		}
+	}
+	return 0;
+}
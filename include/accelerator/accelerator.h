@@ -23,12 +23,14 @@
 #include "accelerator/intersect_data.h"
 #include "param/class_meta.h"
 #include "common/enum.h"
-#include "geometry/primitive/primitive.h"
+#include "geometry/primitive/primitive_instance.h"
 #include "geometry/surface.h"
 #include <vector>
 #include <memory>
 #include <limits>
-#include <set>
+#include <array>
+#include <algorithm>
+#include <atomic>
 
 namespace yafaray {
 
@@ -49,30 +51,59 @@ class Accelerator
 		virtual ~Accelerator() = default;
 		virtual IntersectData intersect(const Ray &ray, float t_max) const = 0;
 		virtual IntersectData intersectShadow(const Ray &ray, float t_max) const = 0;
-		virtual IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float dist, const Camera *camera) const = 0;
+		virtual IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float dist, const Camera *camera, const Matrix4f *obj_to_world) const = 0; //!< obj_to_world is only used by object space accelerators, to evaluate the transparency of the surfaces in world space
 		virtual Bound<float> getBound() const = 0;
+		virtual bool refit() { return false; } //!< updates the bounds after the primitives were deformed without changing the topology. Returns false if the accelerator cannot be refitted, so it has to be rebuilt
+		virtual void updatePrimitiveFlags() { } //!< recalculates the precomputed primitive flags (if any) after the materials were modified
 		std::pair<std::unique_ptr<const SurfacePoint>, float> intersect(const Ray &ray, const Camera *camera = nullptr) const;
 		std::pair<bool, const Primitive *> isShadowed(const Ray &ray) const;
 		std::tuple<bool, Rgb, const Primitive *> isShadowedTransparentShadow(const Ray &ray, int max_depth, const Camera *camera) const;
 
+		//! Visibility related properties of a primitive and its material, precomputed by the accelerators that store them next to their leaves, so they do not need the (virtual) primitive and material queries for every candidate hit
+		struct PrimitiveFlags : public Enum<PrimitiveFlags>
+		{
+			using Enum::Enum;
+			enum : ValueType_t { None = 0, Visible = 1 << 0, CastsShadows = 1 << 1, TransparentShadow = 1 << 2, Instance = 1 << 3 };
+		};
+		/*! Transparent primitives already accounted for along a transparent shadow ray, so the surfaces crossed more than once (or split in the accelerator) only attenuate the shadow once.
+		 *  Fixed capacity set kept inline, so no heap allocations are needed. Its capacity also limits the transparent shadow depth */
+		class TransparentShadowFilter
+		{
+			public:
+				static constexpr inline int capacity_ = 64;
+				bool contains(const Primitive *primitive) const { return std::find(primitives_.begin(), primitives_.begin() + size_, primitive) != primitives_.begin() + size_; }
+				bool full() const { return size_ >= capacity_; }
+				void insert(const Primitive *primitive) { primitives_[size_++] = primitive; }
+
+			private:
+				std::array<const Primitive *, capacity_> primitives_;
+				int size_ = 0;
+		};
+
 		static constexpr inline float minRayDist() { return min_raydist_; }
 		static constexpr inline float shadowBias() { return shadow_bias_; }
+		static PrimitiveFlags getPrimitiveFlags(const Primitive *primitive);
 		static void primitiveIntersection(IntersectData &intersect_data, const Primitive *primitive, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time);
 		static bool primitiveIntersectionShadow(IntersectData &intersect_data, const Primitive *primitive, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time);
-		static bool primitiveIntersectionTransparentShadow(IntersectData &intersect_data, std::set<const Primitive *> &filtered, int &depth, int max_depth, const Primitive *primitive, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time);
+		static bool primitiveIntersectionTransparentShadow(IntersectData &intersect_data, TransparentShadowFilter &filtered, int &depth, int max_depth, const Primitive *primitive, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time, const Matrix4f *obj_to_world);
+		//! The following functions record a hit already found in the range [t_min, t_max) for a primitive whose visibility was already checked, for accelerators with their own primitive tests and flags
+		static void primitiveHit(IntersectData &intersect_data, const Primitive *primitive, float t_hit, const Uv<float> &uv);
+		static bool primitiveHitTransparentShadow(IntersectData &intersect_data, TransparentShadowFilter &filtered, int &depth, int max_depth, const Primitive *primitive, bool transparent, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_hit, const Uv<float> &uv, float time, const Matrix4f *obj_to_world); //!< returns true if the hit blocks the shadow ray
 
 		static float calculateDynamicRayBias(const Bound<float>::Cross &bound_cross) { return 0.1f * minRayDist() * std::abs(bound_cross.leave_ - bound_cross.enter_); } //!< empirical guesstimate for ray bias to avoid self intersections, calculated based on the length segment of the ray crossing the tree bound, to estimate the loss of precision caused by the (very roughly approximate) size of the primitive
+		static uint64_t numRaysTraced(); //!< rays traced by all the accelerators since the library was loaded, including the ones still being counted by the live (thread pool) threads
 
 	protected:
 		int setNumThreads(Logger &logger, int threads) const;
 		struct Type : public Enum<Type>
 		{
 			using Enum::Enum;
-			enum : ValueType_t { None, SimpleTest, KdTreeOriginal, KdTreeMultiThread };
+			enum : ValueType_t { None, SimpleTest, KdTreeOriginal, KdTreeMultiThread, Bvh };
 			inline static const EnumMap<ValueType_t> map_{{
 					{"yafaray-simpletest", SimpleTest, ""},
 					{"yafaray-kdtree-original", KdTreeOriginal, ""},
 					{"yafaray-kdtree-multi-thread", KdTreeMultiThread, ""},
+					{"yafaray-bvh", Bvh, "4-wide bounding volume hierarchy built with binned SAH"},
 				}};
 		};
 		const struct Params
@@ -84,17 +115,33 @@ class Accelerator
 		const RenderControl *render_control_{nullptr};
 		static constexpr inline float min_raydist_ = 0.00005f;
 		static constexpr inline float shadow_bias_ = 0.0005f;
+
+	private:
+		//! Each thread counts its own rays in a counter only written by that thread (no atomic read-modify-write needed), registered so the counters of the persistent thread pool workers can be read while they are alive
+		struct ThreadRaysCounter
+		{
+			ThreadRaysCounter();
+			~ThreadRaysCounter();
+			void increment() { rays_.store(rays_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+			std::atomic<uint64_t> rays_{0};
+		};
+		static thread_local ThreadRaysCounter thread_rays_traced_;
 };
 
+inline thread_local Accelerator::ThreadRaysCounter Accelerator::thread_rays_traced_;
+
 inline std::pair<std::unique_ptr<const SurfacePoint>, float> Accelerator::intersect(const Ray &ray, const Camera *camera) const
 {
+	thread_rays_traced_.increment();
 	const float t_max = (ray.tmax_ >= 0.f) ? ray.tmax_ : std::numeric_limits<float>::max();
 	// intersect with tree:
 	const IntersectData intersect_data{intersect(ray, t_max)};
 	if(intersect_data.isHit() && intersect_data.primitive_)
 	{
 		const Point3f hit_point{ray.from_ + intersect_data.t_max_ * ray.dir_};
-		auto sp{intersect_data.primitive_->getSurface(ray.differentials_.get(), hit_point, ray.time_, intersect_data.uv_, camera)};
+		auto sp{intersect_data.instance_ ?
+				intersect_data.primitive_->getSurface(ray.differentials_.get(), hit_point, ray.time_, intersect_data.uv_, camera, intersect_data.instance_->getObjToWorldMatrixAtTime(ray.time_)) :
+				intersect_data.primitive_->getSurface(ray.differentials_.get(), hit_point, ray.time_, intersect_data.uv_, camera)};
 		return {std::move(sp), intersect_data.t_max_};
 	}
 	else return {nullptr, ray.tmax_};
@@ -102,6 +149,7 @@ inline std::pair<std::unique_ptr<const SurfacePoint>, float> Accelerator::inters
 
 inline std::pair<bool, const Primitive *> Accelerator::isShadowed(const Ray &ray) const
 {
+	thread_rays_traced_.increment();
 	Ray sray{ray, Ray::DifferentialsCopy::No};
 	sray.from_ += sray.dir_ * sray.tmin_;
 	sray.time_ = ray.time_;
@@ -112,57 +160,89 @@ inline std::pair<bool, const Primitive *> Accelerator::isShadowed(const Ray &ray
 
 inline std::tuple<bool, Rgb, const Primitive *> Accelerator::isShadowedTransparentShadow(const Ray &ray, int max_depth, const Camera *camera) const
 {
+	thread_rays_traced_.increment();
 	Ray sray{ray, Ray::DifferentialsCopy::No}; //Should this function use Ray::DifferentialsAssignment::Copy ? If using copy it would be slower but would take into account texture mipmaps, although that's probably irrelevant for transparent shadows?
 	sray.from_ += sray.dir_ * sray.tmin_;
 	const float t_max = (ray.tmax_ >= 0.f) ? sray.tmax_ - 2 * sray.tmin_ : std::numeric_limits<float>::max();
-	IntersectData intersect_data{intersectTransparentShadow(sray, max_depth, t_max, camera)};
+	IntersectData intersect_data{intersectTransparentShadow(sray, max_depth, t_max, camera, nullptr)};
 	return {intersect_data.isHit(), intersect_data.color_, intersect_data.primitive_};
 }
 
+inline Accelerator::PrimitiveFlags Accelerator::getPrimitiveFlags(const Primitive *primitive)
+{
+	if(primitive->isInstance()) return PrimitiveFlags::Instance;
+	const Visibility prim_visibility{primitive->getVisibility()};
+	const Material *material{primitive->getMaterial()};
+	const Visibility mat_visibility{material ? material->getVisibility() : Visibility{Visibility::Normal}};
+	PrimitiveFlags flags{PrimitiveFlags::None};
+	if(prim_visibility.has(Visibility::Visible) && mat_visibility.has(Visibility::Visible)) flags |= PrimitiveFlags::Visible;
+	if(prim_visibility.has(Visibility::CastsShadows) && mat_visibility.has(Visibility::CastsShadows)) flags |= PrimitiveFlags::CastsShadows;
+	if(material && material->isTransparent()) flags |= PrimitiveFlags::TransparentShadow;
+	return flags;
+}
+
 inline void Accelerator::primitiveIntersection(IntersectData &intersect_data, const Primitive *primitive, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time)
 {
-	auto [t_hit, uv]{primitive->intersect(from, dir, time)};
+	if(primitive->isInstance()) return static_cast<const PrimitiveInstance *>(primitive)->intersect(intersect_data, from, dir, t_min, t_max, time);
+	const auto [t_hit, uv]{primitive->intersect(from, dir, time)};
 	if(t_hit <= 0.f || t_hit < t_min || t_hit >= t_max) return;
 	if(const Visibility prim_visibility = primitive->getVisibility(); !prim_visibility.has(Visibility::Visible)) return;
 	else if(const Visibility mat_visibility = primitive->getMaterial()->getVisibility(); !mat_visibility.has(Visibility::Visible)) return;
-	intersect_data.t_hit_ = t_hit;
-	intersect_data.t_max_ = t_hit;
-	intersect_data.uv_ = std::move(uv);
-	intersect_data.primitive_ = primitive;
+	primitiveHit(intersect_data, primitive, t_hit, uv);
 }
 
 inline bool Accelerator::primitiveIntersectionShadow(IntersectData &intersect_data, const Primitive *primitive, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time)
 {
-	auto [t_hit, uv]{primitive->intersect(from, dir, time)};
+	if(primitive->isInstance()) return static_cast<const PrimitiveInstance *>(primitive)->intersectShadow(intersect_data, from, dir, t_min, t_max, time);
+	const auto [t_hit, uv]{primitive->intersect(from, dir, time)};
 	if(t_hit <= 0.f || t_hit < t_min || t_hit >= t_max) return false;
 	if(const Visibility prim_visibility = primitive->getVisibility(); !prim_visibility.has(Visibility::CastsShadows)) return false;
 	else if(const Visibility mat_visibility = primitive->getMaterial()->getVisibility(); !mat_visibility.has(Visibility::CastsShadows)) return false;
-	intersect_data.t_hit_ = t_hit;
-	intersect_data.t_max_ = t_hit;
-	intersect_data.uv_ = std::move(uv);
-	intersect_data.primitive_ = primitive;
+	primitiveHit(intersect_data, primitive, t_hit, uv);
 	return true;
 }
 
-inline bool Accelerator::primitiveIntersectionTransparentShadow(IntersectData &intersect_data, std::set<const Primitive *> &filtered, int &depth, int max_depth, const Primitive *primitive, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time)
+inline bool Accelerator::primitiveIntersectionTransparentShadow(IntersectData &intersect_data, TransparentShadowFilter &filtered, int &depth, int max_depth, const Primitive *primitive, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time, const Matrix4f *obj_to_world)
 {
-	auto [t_hit, uv]{primitive->intersect(from, dir, time)};
+	if(primitive->isInstance()) return static_cast<const PrimitiveInstance *>(primitive)->intersectTransparentShadow(intersect_data, depth, max_depth, camera, from, dir, t_min, t_max, time);
+	const auto [t_hit, uv]{primitive->intersect(from, dir, time)};
 	if(t_hit <= 0.f || t_hit < t_min || t_hit >= t_max) return false;
-	const Material *mat = nullptr;
 	if(const Visibility prim_visibility = primitive->getVisibility(); !prim_visibility.has(Visibility::CastsShadows)) return false;
-	mat = primitive->getMaterial();
+	const Material *mat = primitive->getMaterial();
 	if(!mat->getVisibility().has(Visibility::CastsShadows)) return false;
+	return primitiveHitTransparentShadow(intersect_data, filtered, depth, max_depth, primitive, mat->isTransparent(), camera, from, dir, t_hit, uv, time, obj_to_world);
+}
+
+inline void Accelerator::primitiveHit(IntersectData &intersect_data, const Primitive *primitive, float t_hit, const Uv<float> &uv)
+{
 	intersect_data.t_hit_ = t_hit;
 	intersect_data.t_max_ = t_hit;
-	intersect_data.uv_ = std::move(uv);
+	intersect_data.uv_ = uv;
 	intersect_data.primitive_ = primitive;
-	if(!mat || !mat->isTransparent()) return true;
-	else if(filtered.insert(primitive).second)
+	intersect_data.instance_ = nullptr;
+}
+
+inline bool Accelerator::primitiveHitTransparentShadow(IntersectData &intersect_data, TransparentShadowFilter &filtered, int &depth, int max_depth, const Primitive *primitive, bool transparent, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_hit, const Uv<float> &uv, float time, const Matrix4f *obj_to_world)
+{
+	primitiveHit(intersect_data, primitive, t_hit, uv);
+	if(!transparent) return true;
+	else if(!filtered.contains(primitive))
 	{
-		if(depth >= max_depth) return true;
+		if(depth >= max_depth || filtered.full()) return true;
+		filtered.insert(primitive);
 		const Point3f hit_point{from + intersect_data.t_hit_ * dir};
-		const auto sp{primitive->getSurface(nullptr, hit_point, time, intersect_data.uv_, camera)}; //I don't think we need differentials for transparent shadows, no need to blur the texture from a distance for this
-		if(sp) intersect_data.color_ *= sp->getTransparency(dir, camera);
+		//I don't think we need differentials for transparent shadows, no need to blur the texture from a distance for this
+		if(obj_to_world)
+		{
+			//Hit in an object space accelerator: the surface and its transparency are evaluated in world space, as for any other instanced hit
+			const auto sp{primitive->getSurface(nullptr, *obj_to_world * hit_point, time, intersect_data.uv_, camera, *obj_to_world)};
+			if(sp) intersect_data.color_ *= sp->getTransparency((*obj_to_world * dir).normalize(), camera);
+		}
+		else
+		{
+			const auto sp{primitive->getSurface(nullptr, hit_point, time, intersect_data.uv_, camera)};
+			if(sp) intersect_data.color_ *= sp->getTransparency(dir, camera);
+		}
 		++depth;
 	}
 	return false;
@@ -0,0 +1,414 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_ACCELERATOR_BVH_H
+#define LIBYAFARAY_ACCELERATOR_BVH_H
+
+#include "accelerator/accelerator.h"
+#include "accelerator/accelerator_kdtree_common.h"
+#include "geometry/bound.h"
+#include "geometry/primitive/primitive.h"
+#include <array>
+#include <algorithm>
+
+namespace yafaray {
+
+// ============================================================
+/*! Bounding Volume Hierarchy with 4-wide nodes built using binned SAH.
+	The bounds of the 4 children of each node are stored in SoA layout
+	so a single vectorized slab test covers all children at once.
+	Static triangles and quads in the leaves are packed in blocks of 4 triangles,
+	also in SoA layout, tested without going through the primitives virtual interface.
+	The primitives visibility flags are precomputed and stored next to the leaves data,
+	so the hits are accepted or discarded without querying the primitives and materials.
+	Optionally the tree structure is cached on disk, keyed by a hash of the primitive bounds
+	and the build parameters, so the renders of unchanged geometry skip the build.
+	The nodes containing motion blurred primitives also keep their child bounds for each of a
+	few time segments, and the traversal tests the bounds of the segment including the ray time,
+	so fast moving objects are not tested by the rays of the whole shutter interval.
+*/
+class AcceleratorBvh final : public Accelerator
+{
+		using ThisClassType_t = AcceleratorBvh; using ParentClassType_t = Accelerator;
+
+	public:
+		inline static std::string getClassName() { return "AcceleratorBvh"; }
+		static std::pair<std::unique_ptr<Accelerator>, ParamResult> factory(Logger &logger, const RenderControl *render_control, const std::vector<const Primitive *> &primitives, const ParamMap &param_map);
+		[[nodiscard]] std::map<std::string, const ParamMeta *> getParamMetaMap() const override { return params_.getParamMetaMap(); }
+		static std::string printMeta(const std::vector<std::string> &excluded_params) { return class_meta::print<Params>(excluded_params); }
+		AcceleratorBvh(Logger &logger, ParamResult &param_result, const RenderControl *render_control, const std::vector<const Primitive *> &primitives, const ParamMap &param_map);
+		~AcceleratorBvh() override;
+
+	private:
+		[[nodiscard]] Type type() const override { return Type::Bvh; }
+		const struct Params
+		{
+			Params(ParamResult &param_result, const ParamMap &param_map);
+			static std::map<std::string, const ParamMeta *> getParamMetaMap();
+			PARAM_DECL(int, max_leaf_size_, 4, "max_leaf_size", "Maximum number of primitives in a leaf");
+			PARAM_DECL(int, num_bins_, 16, "num_bins", "Number of bins per axis used to evaluate the SAH cost");
+			PARAM_DECL(std::string, cache_path_, "", "cache_path", "Directory where the built trees are saved and loaded from in later renders of the same primitives and build parameters, skipping the build. Empty to disable the cache. Each different scene geometry adds a file, the least recently used ones are removed when the files exceed 'cache_max_size'");
+			PARAM_DECL(int, cache_max_size_, 1024, "cache_max_size", "Maximum size in MB of the tree cache files in 'cache_path'. 0 for no limit");
+			PARAM_DECL(int, time_segments_, 8, "time_segments", "Number of time segments with their own child bounds in the nodes containing motion blurred primitives. 1 to use the bounds of the whole time range for all rays");
+		} params_;
+		[[nodiscard]] ParamMap getAsParamMap(bool only_non_default) const override;
+
+		static constexpr inline int node_width_ = 4;
+		static constexpr inline int triangle_block_width_ = 4;
+		static constexpr inline int max_stack_ = 256;
+		static constexpr inline int max_depth_ = 48; //!< keeps the worst case traversal stack (3 * depth + 1) below max_stack_
+		static constexpr inline char cache_header_[] = "YAF_BVHv2"; //!< to be changed whenever the cache file contents, the nodes layout or the build algorithm change
+		static constexpr inline char cache_file_prefix_[] = "yafaray_bvh_";
+		static constexpr inline uint64_t hash_offset_basis_ = 0xcbf29ce484222325ULL;
+		struct NodeBounds;
+		struct Node;
+		struct Leaf;
+		struct TriangleBlock;
+		struct Bin;
+		template <kdtree::IntersectTestType test_type> IntersectData intersect(const Ray &ray, float t_max, int transparent_color_max_depth, const Camera *camera, const Matrix4f *obj_to_world) const;
+		IntersectData intersect(const Ray &ray, float t_max) const override;
+		IntersectData intersectShadow(const Ray &ray, float t_max) const override;
+		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const override;
+		Bound<float> getBound() const override { return tree_bound_; }
+		bool refit() override;
+		void updatePrimitiveFlags() override;
+		Bound<float> refitNode(int node_id, bool &topology_changed);
+		void buildTriangleBlocks(const std::vector<const Primitive *> &leaf_ordered_primitives);
+		void buildTimeBounds();
+		bool buildNodeTimeBounds(int node_id, std::vector<Bound<float>> &segment_bounds);
+		std::pair<float, float> getTimeSegmentInterval(int time_segment) const;
+		static void enlargeTreeBound(Bound<float> &tree_bound);
+		int buildNode(std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, const std::vector<Point3f> &centroids, int first, int last, int depth);
+		int splitBinned(std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, const std::vector<Point3f> &centroids, int first, int last) const;
+		static Bound<float> calculateBound(const std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, int first, int last);
+		static float surfaceArea(const Bound<float> &bound);
+		uint64_t calculateCacheKey(const std::vector<Bound<float>> &bounds) const;
+		uint64_t calculateCacheChecksum(const std::vector<uint32_t> &indices) const;
+		static uint64_t hashWords(uint64_t hash, const void *data, size_t size);
+		std::string getCacheFilePath(uint64_t cache_key) const;
+		bool loadCache(const std::string &file_path, uint64_t cache_key, uint32_t num_primitives, std::vector<uint32_t> &indices);
+		bool saveCache(const std::string &file_path, uint64_t cache_key, const std::vector<uint32_t> &indices) const;
+		void cleanCache(const std::string &saved_file_path) const;
+
+		std::vector<Node> nodes_;
+		std::vector<NodeBounds> time_bounds_; //!< child bounds of the nodes with motion blurred primitives, num_time_segments_ consecutive entries per node
+		int num_time_segments_ = 1;
+		std::vector<Leaf> leaves_; //!< the first leaf is always empty, used for the unused node slots
+		std::vector<TriangleBlock> triangle_blocks_; //!< packed static triangles, ordered so each leaf references a contiguous range
+		std::vector<const Primitive *> primitives_; //!< primitives not packed in triangle blocks, ordered so each leaf references a contiguous range
+		std::vector<PrimitiveFlags> primitive_flags_; //!< precomputed flags of the primitives in primitives_
+		Bound<float> tree_bound_; //!< overall space the tree encloses
+		int max_depth_reached_ = 0;
+		int num_leaves_ = 0;
+		int num_packed_triangles_ = 0;
+};
+
+//! Bounds of the 4 children of a node, stored as SoA for vectorized ray-box tests
+struct AcceleratorBvh::NodeBounds
+{
+	std::array<float, node_width_> min_x_, min_y_, min_z_;
+	std::array<float, node_width_> max_x_, max_y_, max_z_;
+	void setEmpty(int child_slot);
+	void setBound(int child_slot, const Bound<float> &bound);
+	Bound<float> getBound(int child_slot) const;
+};
+
+/*! 4-wide BVH node.
+ *  child_[i] >= 0 : index of the child node in nodes_
+ *  child_[i] < 0  : leaf with index -(child_[i] + 1) in leaves_
+ *  Unused slots point to the empty leaf 0 and have a degenerate bound, so testing them is a no-op.
+ *  time_bounds_id_ >= 0 : the children contain motion blurred primitives and their bounds for each time segment start at that index in time_bounds_ */
+struct alignas(64) AcceleratorBvh::Node : NodeBounds
+{
+	std::array<int32_t, node_width_> child_;
+	int32_t time_bounds_id_ = -1;
+	void setEmpty(int child_slot);
+	bool isLeaf(int child_slot) const { return child_[child_slot] < 0; }
+	bool isEmpty(int child_slot) const { return child_[child_slot] == -1; }
+	int leafId(int child_slot) const { return -(child_[child_slot] + 1); }
+};
+
+//! Leaf contents: num_blocks_ triangle blocks starting at first_block_ in triangle_blocks_ and num_primitives_ primitives starting at first_primitive_ in primitives_
+struct AcceleratorBvh::Leaf
+{
+	int32_t first_block_ = 0;
+	int32_t num_blocks_ = 0;
+	int32_t first_primitive_ = 0;
+	int32_t num_primitives_ = 0;
+};
+
+/*! Leaf-local copy of up to 4 static triangles, with the first vertex and the two edges used by the Moller-Trumbore test
+ *  precomputed and stored as SoA, so a single vectorized test covers the whole block. Quads are split in two triangles
+ *  along the same diagonal used by ShapePolygon::intersect, and the hit uv is converted back to the quad uv, so the results
+ *  are the same as when testing the primitive itself. Unused lanes have a null primitive and degenerate edges, so they never hit */
+struct alignas(64) AcceleratorBvh::TriangleBlock
+{
+	enum class Kind : unsigned char { Triangle, QuadFirst, QuadSecond };
+	std::array<float, triangle_block_width_> vertex_x_{}, vertex_y_{}, vertex_z_{};
+	std::array<float, triangle_block_width_> edge_1_x_{}, edge_1_y_{}, edge_1_z_{};
+	std::array<float, triangle_block_width_> edge_2_x_{}, edge_2_y_{}, edge_2_z_{};
+	std::array<const Primitive *, triangle_block_width_> primitive_{};
+	std::array<Kind, triangle_block_width_> kind_{};
+	std::array<PrimitiveFlags, triangle_block_width_> flags_{};
+	void setTriangle(int lane, const Primitive *primitive, Kind kind, const std::array<Point3f, 4> &vertices);
+	void intersect(const Point3f &from, const Vec3f &dir, float t_min, float t_max, std::array<float, triangle_block_width_> &t_hit, std::array<float, triangle_block_width_> &u, std::array<float, triangle_block_width_> &v) const;
+	Uv<float> getPrimitiveUv(int lane, float u, float v) const;
+};
+
+inline void AcceleratorBvh::NodeBounds::setEmpty(int child_slot)
+{
+	min_x_[child_slot] = min_y_[child_slot] = min_z_[child_slot] = 0.f;
+	max_x_[child_slot] = max_y_[child_slot] = max_z_[child_slot] = 0.f;
+}
+
+inline void AcceleratorBvh::NodeBounds::setBound(int child_slot, const Bound<float> &bound)
+{
+	min_x_[child_slot] = bound.a_[Axis::X];
+	min_y_[child_slot] = bound.a_[Axis::Y];
+	min_z_[child_slot] = bound.a_[Axis::Z];
+	max_x_[child_slot] = bound.g_[Axis::X];
+	max_y_[child_slot] = bound.g_[Axis::Y];
+	max_z_[child_slot] = bound.g_[Axis::Z];
+}
+
+inline Bound<float> AcceleratorBvh::NodeBounds::getBound(int child_slot) const
+{
+	return {{{min_x_[child_slot], min_y_[child_slot], min_z_[child_slot]}}, {{max_x_[child_slot], max_y_[child_slot], max_z_[child_slot]}}};
+}
+
+inline void AcceleratorBvh::Node::setEmpty(int child_slot)
+{
+	NodeBounds::setEmpty(child_slot);
+	child_[child_slot] = -1;
+}
+
+inline void AcceleratorBvh::TriangleBlock::setTriangle(int lane, const Primitive *primitive, Kind kind, const std::array<Point3f, 4> &vertices)
+{
+	//The second triangle of a quad is (0, 2, 3), the same as in ShapePolygon::intersect
+	const Vec3f edge_1{vertices[(kind == Kind::QuadSecond) ? 2 : 1] - vertices[0]};
+	const Vec3f edge_2{vertices[(kind == Kind::QuadSecond) ? 3 : 2] - vertices[0]};
+	vertex_x_[lane] = vertices[0][Axis::X];
+	vertex_y_[lane] = vertices[0][Axis::Y];
+	vertex_z_[lane] = vertices[0][Axis::Z];
+	edge_1_x_[lane] = edge_1[Axis::X];
+	edge_1_y_[lane] = edge_1[Axis::Y];
+	edge_1_z_[lane] = edge_1[Axis::Z];
+	edge_2_x_[lane] = edge_2[Axis::X];
+	edge_2_y_[lane] = edge_2[Axis::Y];
+	edge_2_z_[lane] = edge_2[Axis::Z];
+	primitive_[lane] = primitive;
+	kind_[lane] = kind;
+	flags_[lane] = Accelerator::getPrimitiveFlags(primitive);
+}
+
+//! Moller-Trumbore test of all the triangles in the block, written without branches so it can be auto-vectorized. Lanes without a hit in [t_min, t_max) get an infinite t_hit
+inline void AcceleratorBvh::TriangleBlock::intersect(const Point3f &from, const Vec3f &dir, float t_min, float t_max, std::array<float, triangle_block_width_> &t_hit, std::array<float, triangle_block_width_> &u, std::array<float, triangle_block_width_> &v) const
+{
+	const float dir_x{dir[Axis::X]};
+	const float dir_y{dir[Axis::Y]};
+	const float dir_z{dir[Axis::Z]};
+	for(int lane = 0; lane < triangle_block_width_; ++lane)
+	{
+		const float pvec_x{dir_y * edge_2_z_[lane] - dir_z * edge_2_y_[lane]};
+		const float pvec_y{dir_z * edge_2_x_[lane] - dir_x * edge_2_z_[lane]};
+		const float pvec_z{dir_x * edge_2_y_[lane] - dir_y * edge_2_x_[lane]};
+		const float det{edge_1_x_[lane] * pvec_x + edge_1_y_[lane] * pvec_y + edge_1_z_[lane] * pvec_z};
+		const float inv_det{1.f / det};
+		const float tvec_x{from[Axis::X] - vertex_x_[lane]};
+		const float tvec_y{from[Axis::Y] - vertex_y_[lane]};
+		const float tvec_z{from[Axis::Z] - vertex_z_[lane]};
+		const float qvec_x{tvec_y * edge_1_z_[lane] - tvec_z * edge_1_y_[lane]};
+		const float qvec_y{tvec_z * edge_1_x_[lane] - tvec_x * edge_1_z_[lane]};
+		const float qvec_z{tvec_x * edge_1_y_[lane] - tvec_y * edge_1_x_[lane]};
+		u[lane] = (tvec_x * pvec_x + tvec_y * pvec_y + tvec_z * pvec_z) * inv_det;
+		v[lane] = (dir_x * qvec_x + dir_y * qvec_y + dir_z * qvec_z) * inv_det;
+		const float t{(edge_2_x_[lane] * qvec_x + edge_2_y_[lane] * qvec_y + edge_2_z_[lane] * qvec_z) * inv_det};
+		const bool hit = (det != 0.f) & (u[lane] >= 0.f) & (u[lane] <= 1.f) & (v[lane] >= 0.f) & ((u[lane] + v[lane]) <= 1.f) & (t > 0.f) & (t >= t_min) & (t < t_max);
+		t_hit[lane] = hit ? t : std::numeric_limits<float>::infinity();
+	}
+}
+
+//! Converts the triangle barycentric coordinates of the hit into the uv of the original primitive, as returned by ShapePolygon::intersect
+inline Uv<float> AcceleratorBvh::TriangleBlock::getPrimitiveUv(int lane, float u, float v) const
+{
+	switch(kind_[lane])
+	{
+		case Kind::QuadFirst: return {u + v, v};
+		case Kind::QuadSecond: return {u, u + v};
+		default: return {u, v};
+	}
+}
+
+template <kdtree::IntersectTestType test_type>
+inline IntersectData AcceleratorBvh::intersect(const Ray &ray, float t_max, int transparent_color_max_depth, const Camera *camera, const Matrix4f *obj_to_world) const
+{
+	const Bound<float>::Cross cross{tree_bound_.cross(ray, t_max)};
+	if(!cross.crossed_ || nodes_.empty()) return {};
+	const float t_min = (test_type == kdtree::IntersectTestType::Shadow) ? Accelerator::calculateDynamicRayBias(cross) : std::max(ray.tmin_, Accelerator::calculateDynamicRayBias(cross));
+	const float inv_dir_x{math::inverse(ray.dir_[Axis::X])};
+	const float inv_dir_y{math::inverse(ray.dir_[Axis::Y])};
+	const float inv_dir_z{math::inverse(ray.dir_[Axis::Z])};
+	const float from_x{ray.from_[Axis::X]};
+	const float from_y{ray.from_[Axis::Y]};
+	const float from_z{ray.from_[Axis::Z]};
+	const int time_segment{std::min(static_cast<int>(math::clamp(ray.time_, 0.f, 1.f) * static_cast<float>(num_time_segments_)), num_time_segments_ - 1)};
+	//The primitives flags required for a hit, the other hits are discarded without querying the primitive
+	constexpr PrimitiveFlags required_flags{(test_type == kdtree::IntersectTestType::Nearest) ? PrimitiveFlags::Visible : PrimitiveFlags::CastsShadows};
+	int depth = 0;
+	[[maybe_unused]] std::conditional_t<test_type == kdtree::IntersectTestType::TransparentShadow, TransparentShadowFilter, bool> filtered; //only needed (and only constructed) for transparent shadows
+	IntersectData intersect_data;
+	intersect_data.t_max_ = t_max;
+	std::array<std::pair<int, float>, max_stack_> stack;
+	int stack_size = 0;
+	stack[stack_size++] = {0, cross.enter_};
+	while(stack_size > 0)
+	{
+		const auto [node_id, node_t_enter]{stack[--stack_size]};
+		if constexpr (test_type == kdtree::IntersectTestType::Nearest)
+		{
+			if(node_t_enter > intersect_data.t_max_) continue;
+		}
+		const Node &node{nodes_[node_id]};
+		const NodeBounds &node_bounds{(node.time_bounds_id_ < 0) ? node : time_bounds_[node.time_bounds_id_ + time_segment]};
+		const float t_far_limit{(test_type == kdtree::IntersectTestType::Nearest) ? intersect_data.t_max_ : t_max};
+		//The following loop over all children is written without branches so it can be auto-vectorized into a single SIMD slab test
+		std::array<float, node_width_> t_enter, t_leave;
+		for(int child_slot = 0; child_slot < node_width_; ++child_slot)
+		{
+			const float t_x_0{(node_bounds.min_x_[child_slot] - from_x) * inv_dir_x};
+			const float t_x_1{(node_bounds.max_x_[child_slot] - from_x) * inv_dir_x};
+			const float t_y_0{(node_bounds.min_y_[child_slot] - from_y) * inv_dir_y};
+			const float t_y_1{(node_bounds.max_y_[child_slot] - from_y) * inv_dir_y};
+			const float t_z_0{(node_bounds.min_z_[child_slot] - from_z) * inv_dir_z};
+			const float t_z_1{(node_bounds.max_z_[child_slot] - from_z) * inv_dir_z};
+			t_enter[child_slot] = std::max(std::max(std::min(t_x_0, t_x_1), std::min(t_y_0, t_y_1)), std::max(std::min(t_z_0, t_z_1), 0.f));
+			t_leave[child_slot] = std::min(std::min(std::max(t_x_0, t_x_1), std::max(t_y_0, t_y_1)), std::min(std::max(t_z_0, t_z_1), t_far_limit));
+		}
+		//Children are pushed farthest first, so the nearest child is traversed first. They are ordered with the optimal 5 compare-exchange sorting network for 4 elements
+		static_assert(node_width_ == 4, "the children sorting network is written for 4 children per node");
+		std::array<int, node_width_> order{0, 1, 2, 3};
+		const auto compareExchange{[&t_enter, &order](int a, int b) { if(t_enter[order[a]] < t_enter[order[b]]) std::swap(order[a], order[b]); }};
+		compareExchange(0, 1);
+		compareExchange(2, 3);
+		compareExchange(0, 2);
+		compareExchange(1, 3);
+		compareExchange(1, 2);
+		for(const int child_slot : order)
+		{
+			if(t_enter[child_slot] > t_leave[child_slot]) continue;
+			if(!node.isLeaf(child_slot))
+			{
+				if(stack_size < max_stack_) stack[stack_size++] = {node.child_[child_slot], t_enter[child_slot]};
+				continue;
+			}
+			const Leaf &leaf{leaves_[node.leafId(child_slot)]};
+			const int last_block{leaf.first_block_ + leaf.num_blocks_};
+			for(int block_id = leaf.first_block_; block_id < last_block; ++block_id)
+			{
+				const TriangleBlock &block{triangle_blocks_[block_id]};
+				std::array<float, triangle_block_width_> t_hit, u, v;
+				block.intersect(ray.from_, ray.dir_, t_min, (test_type == kdtree::IntersectTestType::Nearest) ? intersect_data.t_max_ : t_max, t_hit, u, v);
+				for(int lane = 0; lane < triangle_block_width_; ++lane)
+				{
+					if(t_hit[lane] >= ((test_type == kdtree::IntersectTestType::Nearest) ? intersect_data.t_max_ : t_max) || !block.flags_[lane].has(required_flags)) continue;
+					const Uv<float> uv{block.getPrimitiveUv(lane, u[lane], v[lane])};
+					if constexpr (test_type == kdtree::IntersectTestType::Nearest) Accelerator::primitiveHit(intersect_data, block.primitive_[lane], t_hit[lane], uv);
+					else if constexpr (test_type == kdtree::IntersectTestType::TransparentShadow)
+					{
+						if(Accelerator::primitiveHitTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, block.primitive_[lane], block.flags_[lane].has(PrimitiveFlags::TransparentShadow), camera, ray.from_, ray.dir_, t_hit[lane], uv, ray.time_, obj_to_world)) return intersect_data;
+					}
+					else
+					{
+						Accelerator::primitiveHit(intersect_data, block.primitive_[lane], t_hit[lane], uv);
+						return intersect_data;
+					}
+				}
+			}
+			const int first_primitive{leaf.first_primitive_};
+			const int last_primitive{first_primitive + leaf.num_primitives_};
+			for(int primitive_id = first_primitive; primitive_id < last_primitive; ++primitive_id)
+			{
+				const Primitive *primitive{primitives_[primitive_id]};
+				const PrimitiveFlags flags{primitive_flags_[primitive_id]};
+				if(flags.has(PrimitiveFlags::Instance))
+				{
+					if constexpr (test_type == kdtree::IntersectTestType::Nearest)
+					{
+						Accelerator::primitiveIntersection(intersect_data, primitive, ray.from_, ray.dir_, t_min, intersect_data.t_max_, ray.time_);
+					}
+					else if constexpr (test_type == kdtree::IntersectTestType::TransparentShadow)
+					{
+						if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_, obj_to_world)) return intersect_data;
+					}
+					else
+					{
+						if(Accelerator::primitiveIntersectionShadow(intersect_data, primitive, ray.from_, ray.dir_, t_min, t_max, ray.time_)) return intersect_data;
+					}
+					continue;
+				}
+				if(!flags.has(required_flags)) continue;
+				const auto [t_hit, uv]{primitive->intersect(ray.from_, ray.dir_, ray.time_)};
+				if(t_hit <= 0.f || t_hit < t_min || t_hit >= ((test_type == kdtree::IntersectTestType::Nearest) ? intersect_data.t_max_ : t_max)) continue;
+				if constexpr (test_type == kdtree::IntersectTestType::Nearest) Accelerator::primitiveHit(intersect_data, primitive, t_hit, uv);
+				else if constexpr (test_type == kdtree::IntersectTestType::TransparentShadow)
+				{
+					if(Accelerator::primitiveHitTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, flags.has(PrimitiveFlags::TransparentShadow), camera, ray.from_, ray.dir_, t_hit, uv, ray.time_, obj_to_world)) return intersect_data;
+				}
+				else
+				{
+					Accelerator::primitiveHit(intersect_data, primitive, t_hit, uv);
+					return intersect_data;
+				}
+			}
+		}
+	}
+	if constexpr (test_type == kdtree::IntersectTestType::Nearest)
+	{
+		return intersect_data;
+	}
+	else if constexpr (test_type == kdtree::IntersectTestType::TransparentShadow)
+	{
+		intersect_data.setNoHit();
+		intersect_data.transparent_depth_ = depth;
+		return intersect_data;
+	}
+	else
+	{
+		return {};
+	}
+}
+
+inline IntersectData AcceleratorBvh::intersect(const Ray &ray, float t_max) const
+{
+	return intersect<kdtree::IntersectTestType::Nearest>(ray, t_max, 0, nullptr, nullptr);
+}
+
+inline IntersectData AcceleratorBvh::intersectShadow(const Ray &ray, float t_max) const
+{
+	return intersect<kdtree::IntersectTestType::Shadow>(ray, t_max, 0, nullptr, nullptr);
+}
+
+inline IntersectData AcceleratorBvh::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const
+{
+	return intersect<kdtree::IntersectTestType::TransparentShadow>(ray, t_max, max_depth, camera, obj_to_world);
+}
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_ACCELERATOR_BVH_H
@@ -105,18 +105,18 @@ inline Stats Stats::operator += (const Stats &kd_stats)
 }
 
 template<typename NodeType, typename NodeStackType, IntersectTestType test_type>
-IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType> &nodes, const Bound<float> &tree_bound, int transparent_color_max_depth, const Camera *camera)
+IntersectData intersect(const Ray &ray, float t_max, const NodeType *nodes, const Primitive *const *leaf_primitives, const Bound<float> &tree_bound, int transparent_color_max_depth, const Camera *camera, const Matrix4f *obj_to_world)
 {
 	const Bound<float>::Cross cross{tree_bound.cross(ray, t_max)};
 	if(!cross.crossed_)
 	{ return {}; }
 	const Vec3f inv_dir{{math::inverse(ray.dir_[Axis::X]), math::inverse(ray.dir_[Axis::Y]), math::inverse(ray.dir_[Axis::Z])}};
 	int depth = 0;
-	std::set<const Primitive *> filtered;
+	[[maybe_unused]] std::conditional_t<test_type == IntersectTestType::TransparentShadow, Accelerator::TransparentShadowFilter, bool> filtered; //only needed (and only constructed) for transparent shadows
 	std::array<NodeStackType, kd_max_stack_global> stack;
 	const NodeType *far_child;
 	const NodeType *curr_node;
-	curr_node = nodes.data();
+	curr_node = nodes;
 
 	int entry_id = 0;
 	stack[entry_id].t_ = cross.enter_;
@@ -149,27 +149,27 @@ IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType>
 			{
 				if(stack[exit_id].point_[axis] <= split_val)
 				{
-					++curr_node;
+					curr_node = curr_node->getLeftChild(nodes);
 					continue;
 				}
 					// case N4
 				else
 				{
-					far_child = &nodes[curr_node->getRightChild()];
-					++curr_node;
+					far_child = curr_node->getRightChild(nodes);
+					curr_node = curr_node->getLeftChild(nodes);
 				}
 			}
 			else
 			{
 				if(stack[exit_id].point_[axis] > split_val)
 				{
-					curr_node = &nodes[curr_node->getRightChild()];
+					curr_node = curr_node->getRightChild(nodes);
 					continue;
 				}
 				else
 				{
-					far_child = curr_node + 1;
-					curr_node = &nodes[curr_node->getRightChild()];
+					far_child = curr_node->getLeftChild(nodes);
+					curr_node = curr_node->getRightChild(nodes);
 				}
 			}
 			// traverse both children
@@ -193,14 +193,14 @@ IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType>
 		const uint32_t n_primitives = curr_node->nPrimitives();
 		if(n_primitives == 1)
 		{
-			const Primitive *primitive = curr_node->getOnePrimitive();
+			const Primitive *primitive = curr_node->getOnePrimitive(leaf_primitives);
 			if constexpr (test_type == IntersectTestType::Nearest)
 			{
 				Accelerator::primitiveIntersection(intersect_data, primitive, ray.from_, ray.dir_, t_min, intersect_data.t_max_, ray.time_);
 			}
 			else if constexpr (test_type == IntersectTestType::TransparentShadow)
 			{
-				if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_)) return intersect_data;
+				if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_, obj_to_world)) return intersect_data;
 			}
 			else
 			{
@@ -209,7 +209,7 @@ IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType>
 		}
 		else
 		{
-			const auto &prims = curr_node->primitives_;
+			const Primitive *const *prims = curr_node->getPrimitives(leaf_primitives);
 			for(uint32_t i = 0; i < n_primitives; ++i)
 			{
 				const Primitive *primitive = prims[i];
@@ -219,7 +219,7 @@ IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType>
 				}
 				else if constexpr (test_type == IntersectTestType::TransparentShadow)
 				{
-					if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_)) return intersect_data;
+					if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, transparent_color_max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_, obj_to_world)) return intersect_data;
 				}
 				else
 				{
@@ -246,6 +246,7 @@ IntersectData intersect(const Ray &ray, float t_max, const std::vector<NodeType>
 	else if constexpr (test_type == IntersectTestType::TransparentShadow)
 	{
 		intersect_data.setNoHit();
+		intersect_data.transparent_depth_ = depth;
 		return intersect_data;
 	}
 	else
@@ -22,6 +22,7 @@
 
 #include "accelerator/accelerator.h"
 #include "accelerator/accelerator_kdtree_common.h"
+#include "common/aligned_allocator.h"
 #include "geometry/bound.h"
 #include "geometry/primitive/primitive.h"
 #include <array>
@@ -57,6 +58,8 @@ class AcceleratorKdTreeMultiThread final : public Accelerator
 			PARAM_DECL(int, max_leaf_size_, 1, "max_leaf_size_", "");
 			PARAM_DECL(float , cost_ratio_, 0.8f, "cost_ratio", "node traversal cost divided by primitive intersection cost");
 			PARAM_DECL(float , empty_bonus_, 0.33f, "empty_bonus", "");
+			PARAM_DECL(int, num_bins_, 1024, "num_bins", "Number of bins per axis for the binned SAH split search. Lower values build the tree faster but place the splits less accurately");
+			PARAM_DECL(int, exact_split_threshold_, 128, "exact_split_threshold", "Nodes with this number of primitives or less search the exact SAH split on the sorted primitive bound edges, nodes with more primitives use the binned SAH split search");
 			PARAM_DECL(int, num_threads_, -1, "threads", "Number of threads, -1 = auto detection");
 			PARAM_DECL(int, min_indices_to_spawn_threads_, 10000, "min_indices_threads", "Only spawn threaded subtree building when the number of indices in the subtree is higher than this value to prevent slowdown due to very small subtree left indices");
 		} params_;
@@ -68,38 +71,49 @@ class AcceleratorKdTreeMultiThread final : public Accelerator
 		struct Stack;
 		IntersectData intersect(const Ray &ray, float t_max) const override;
 		IntersectData intersectShadow(const Ray &ray, float t_max) const override;
-		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera) const override;
+		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const override;
 		Bound<float> getBound() const override { return tree_bound_; }
-		AcceleratorKdTreeMultiThread::Result buildTree(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, std::atomic<int> &num_current_threads) const;
-		void buildTreeWorker(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, Result &result, std::atomic<int> &num_current_threads) const;
-		static SplitCost pigeonMinCost(Logger &logger, float e_bonus, float cost_ratio, const std::vector<Bound<float>> &bounds, const Bound<float> &node_bound, const std::vector<uint32_t> &prim_indices);
+		AcceleratorKdTreeMultiThread::Result buildTree(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, uint32_t next_primitive_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, std::atomic<int> &num_current_threads) const;
+		void buildTreeWorker(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, uint32_t next_primitive_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, Result &result, std::atomic<int> &num_current_threads) const;
+		static void mergeChildren(Result &result, const Result &result_left, const Result &result_right);
+		static SplitCost binnedMinCost(float e_bonus, float cost_ratio, int num_bins, const std::vector<Bound<float>> &bounds, const Bound<float> &node_bound, const std::vector<uint32_t> &prim_indices);
 		static SplitCost minimalCost(Logger &logger, float e_bonus, float cost_ratio, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds);
 
-		alignas(8) std::vector<Node> nodes_;
+		std::vector<Node, AlignedAllocator<Node, 64>> nodes_; //!< nodes with the two children of each interior node stored as a pair, in a cache line aligned array
+		std::vector<const Primitive *> leaf_primitives_; //!< flat array with the primitives of all the leaves, each leaf references a contiguous range
 		Bound<float> tree_bound_; 	//!< overall space the tree encloses
 		std::atomic<int> num_current_threads_{setNumThreads(logger_, params_.num_threads_)};
 };
 
 // ============================================================
-/*! kd-tree nodes, kept as small as possible
-    double precision float and/or 64 bit system: 12bytes
-    else 8 bytes */
+/*! kd-tree nodes, 8 bytes each so 8 of them fit in a cache line.
+    The two children of an interior node are stored next to each other, starting at an even position of the cache line aligned nodes array, so both siblings are always in the same cache line.
+    Leaves reference a contiguous range of the tree flat leaf primitives array */
 
 class AcceleratorKdTreeMultiThread::Node
 {
 	public:
-		kdtree::Stats createLeaf(const std::vector<uint32_t> &prim_indices, const std::vector<const Primitive *> &primitives);
+		kdtree::Stats createLeaf(const std::vector<uint32_t> &prim_indices, const std::vector<const Primitive *> &primitives, std::vector<const Primitive *> &leaf_primitives, uint32_t leaf_primitives_offset);
 		kdtree::Stats createInterior(Axis axis, float d);
 		float splitPos() const { return division_; }
 		Axis splitAxis() const { return static_cast<Axis>(flags_ & 3); }
-		uint32_t nPrimitives() const { return primitives_.size(); /*flags_ >> 2; */ }
-		const Primitive *getOnePrimitive() const { return primitives_[0]; }
+		uint32_t nPrimitives() const { return flags_ >> 2; }
+		const Primitive *getOnePrimitive(const Primitive *const *leaf_primitives) const { return leaf_primitives[primitives_offset_]; }
+		const Primitive *const *getPrimitives(const Primitive *const *leaf_primitives) const { return leaf_primitives + primitives_offset_; }
 		bool isLeaf() const { return (flags_ & 3) == 3; }
-		uint32_t getRightChild() const { return (flags_ >> 2); }
-		void setRightChild(uint32_t i) { flags_ = (flags_ & 3) | (i << 2); }
-		std::vector<const Primitive *> primitives_; //!< leaf: list of primitives
-		uint32_t flags_; //!< 2bits: isLeaf, axis; 30bits: nprims (leaf) or index of right child
-		float division_; //!< interior: division plane position
+		uint32_t getChildren() const { return (flags_ >> 2); }
+		void setChildren(uint32_t i) { flags_ = (flags_ & 3) | (i << 2); }
+		const Node *getLeftChild(const Node *nodes) const { return nodes + getChildren(); }
+		const Node *getRightChild(const Node *nodes) const { return nodes + getChildren() + 1; }
+		void addPrimitivesOffset(uint32_t offset) { primitives_offset_ += offset; }
+
+	private:
+		union
+		{
+			float division_ = 0.f; //!< interior: division plane position
+			uint32_t primitives_offset_; //!< leaf: index of the first primitive of the leaf in the flat leaf primitives array
+		};
+		uint32_t flags_ = 0; //!< 2bits: isLeaf, axis; 30bits: nprims (leaf) or index of the first node of the children pair
 };
 
 /*! Stack elements for the custom stack of the recursive traversal */
@@ -124,21 +138,21 @@ struct AcceleratorKdTreeMultiThread::SplitCost
 struct AcceleratorKdTreeMultiThread::Result
 {
 	alignas(8) std::vector<Node> nodes_;
+	std::vector<const Primitive *> leaf_primitives_;
 	kdtree::Stats stats_;
 };
 
 
-inline kdtree::Stats AcceleratorKdTreeMultiThread::Node::createLeaf(const std::vector<uint32_t> &prim_indices, const std::vector<const Primitive *> &primitives)
+inline kdtree::Stats AcceleratorKdTreeMultiThread::Node::createLeaf(const std::vector<uint32_t> &prim_indices, const std::vector<const Primitive *> &primitives, std::vector<const Primitive *> &leaf_primitives, uint32_t leaf_primitives_offset)
 {
 	const uint32_t num_prim_indices = prim_indices.size();
 	kdtree::Stats kd_stats;
-	primitives_.clear();
-	//flags_ = num_prim_indices << 2;
+	flags_ = num_prim_indices << 2;
 	flags_ |= 3;
+	primitives_offset_ = leaf_primitives_offset + static_cast<uint32_t>(leaf_primitives.size());
 	if(num_prim_indices >= 1)
 	{
-		primitives_.reserve(num_prim_indices);
-		for(const auto &prim_id : prim_indices) primitives_.emplace_back(primitives[prim_id]);
+		for(const auto &prim_id : prim_indices) leaf_primitives.emplace_back(primitives[prim_id]);
 		kd_stats.kd_prims_ += num_prim_indices; //stat
 	}
 	else kd_stats.empty_kd_leaves_++; //stat
@@ -157,17 +171,17 @@ inline kdtree::Stats AcceleratorKdTreeMultiThread::Node::createInterior(Axis axi
 
 inline IntersectData AcceleratorKdTreeMultiThread::intersect(const Ray &ray, float t_max) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Nearest>(ray, t_max, nodes_, tree_bound_, 0, nullptr);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Nearest>(ray, t_max, nodes_.data(), leaf_primitives_.data(), tree_bound_, 0, nullptr, nullptr);
 }
 
 inline IntersectData AcceleratorKdTreeMultiThread::intersectShadow(const Ray &ray, float t_max) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Shadow>(ray, t_max, nodes_, tree_bound_, 0, nullptr);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Shadow>(ray, t_max, nodes_.data(), leaf_primitives_.data(), tree_bound_, 0, nullptr, nullptr);
 }
 
-inline IntersectData AcceleratorKdTreeMultiThread::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera) const
+inline IntersectData AcceleratorKdTreeMultiThread::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::TransparentShadow>(ray, t_max, nodes_, tree_bound_, max_depth, camera);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::TransparentShadow>(ray, t_max, nodes_.data(), leaf_primitives_.data(), tree_bound_, max_depth, camera, obj_to_world);
 }
 
 
@@ -68,7 +68,7 @@ class AcceleratorKdTree final : public Accelerator
 		IntersectData intersect(const Ray &ray, float t_max) const override;
 		//	bool IntersectDBG(const ray_t &ray, float dist, triangle_t **tr, float &Z) const;
 		IntersectData intersectShadow(const Ray &ray, float t_max) const override;
-		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera) const override;
+		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const override;
 		//	bool IntersectO(const point3d_t &from, const vector3d_t &ray, float dist, Primitive **tr, float &Z) const;
 		Bound<float> getBound() const override { return tree_bound_; }
 
@@ -111,9 +111,12 @@ class AcceleratorKdTree::Node
 		float splitPos() const { return division_; }
 		Axis splitAxis() const { return static_cast<Axis>(flags_ & 3); }
 		uint32_t nPrimitives() const { return flags_ >> 2; }
-		const Primitive *getOnePrimitive() const { return one_primitive_; }
+		const Primitive *getOnePrimitive(const Primitive *const *) const { return one_primitive_; }
+		const Primitive *const *getPrimitives(const Primitive *const *) const { return primitives_; }
 		bool isLeaf() const { return (flags_ & 3) == 3; }
 		uint32_t getRightChild() const { return (flags_ >> 2); }
+		const Node *getLeftChild(const Node *nodes) const { return this + 1; }
+		const Node *getRightChild(const Node *nodes) const { return nodes + getRightChild(); }
 		void setRightChild(uint32_t i) { flags_ = (flags_ & 3) | (i << 2); }
 		union
 		{
@@ -170,17 +173,17 @@ inline void AcceleratorKdTree::Node::createInterior(int axis, float d, kdtree::S
 
 inline IntersectData AcceleratorKdTree::intersect(const Ray &ray, float t_max) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Nearest>(ray, t_max, nodes_, tree_bound_, 0, nullptr);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Nearest>(ray, t_max, nodes_.data(), nullptr, tree_bound_, 0, nullptr, nullptr);
 }
 
 inline IntersectData AcceleratorKdTree::intersectShadow(const Ray &ray, float t_max) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Shadow>(ray, t_max, nodes_, tree_bound_, 0, nullptr);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::Shadow>(ray, t_max, nodes_.data(), nullptr, tree_bound_, 0, nullptr, nullptr);
 }
 
-inline IntersectData AcceleratorKdTree::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera) const
+inline IntersectData AcceleratorKdTree::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const
 {
-	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::TransparentShadow>(ray, t_max, nodes_, tree_bound_, max_depth, camera);
+	return kdtree::intersect<Node, Stack, kdtree::IntersectTestType::TransparentShadow>(ray, t_max, nodes_.data(), nullptr, tree_bound_, max_depth, camera, obj_to_world);
 }
 
 } //namespace yafaray
@@ -53,7 +53,7 @@ class AcceleratorSimpleTest final : public Accelerator
 		};
 		IntersectData intersect(const Ray &ray, float t_max) const override;
 		IntersectData intersectShadow(const Ray &ray, float t_max) const override;
-		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float dist, const Camera *camera) const override;
+		IntersectData intersectTransparentShadow(const Ray &ray, int max_depth, float dist, const Camera *camera, const Matrix4f *obj_to_world) const override;
 		Bound<float> getBound() const override { return bound_; }
 
 		const std::vector<const Primitive *> &primitives_;
@@ -26,16 +26,19 @@
 namespace yafaray {
 
 class Primitive;
+class PrimitiveInstance;
 
 struct IntersectData
 {
 	bool isHit() const { return t_hit_ > 0.f; }
-	void setNoHit() { t_hit_ = 0.f; primitive_ = nullptr; }
+	void setNoHit() { t_hit_ = 0.f; primitive_ = nullptr; instance_ = nullptr; }
 	alignas(8) float t_hit_ = 0.f;
 	Uv<float> uv_;
 	float t_max_ = std::numeric_limits<float>::max();
 	const Primitive *primitive_ = nullptr;
+	const PrimitiveInstance *instance_ = nullptr; //!< instance through which primitive_ was hit, nullptr if the primitive is not instanced
 	Rgb color_ {1.f};
+	int transparent_depth_ = 0; //!< number of transparent surfaces evaluated along a transparent shadow ray that was not blocked
 };
 
 } //namespace yafaray
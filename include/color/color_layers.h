@@ -23,18 +23,34 @@
 
 #include "common/layers.h"
 #include "color/color.h"
+#include <array>
+#include <bitset>
 
 namespace yafaray {
 
-class ColorLayers final : public Collection<LayerDef::Type, Rgba>  //Actual buffer of colors in the rendering process, one entry for each enabled layer.
+class ColorLayers final //Actual buffer of colors in the rendering process, one slot for each layer type indexed directly by the type. Only the enabled slots are used
 {
 	public:
 		explicit ColorLayers(const Layers &layers);
 		void setDefaultColors();
+		bool isDefined(LayerDef::Type type) const { return enabled_[type]; }
 		bool isDefinedAny(const std::vector<LayerDef::Type> &types) const;
 		LayerDef::Flags getFlags() const { return flags_; }
+		size_t size() const { return num_enabled_; }
+		bool empty() const { return num_enabled_ == 0; }
+		Rgba &operator()(LayerDef::Type type) { return colors_[type]; }
+		const Rgba &operator()(LayerDef::Type type) const { return colors_[type]; }
+		Rgba *find(LayerDef::Type type) { return enabled_[type] ? &colors_[type] : nullptr; }
+		const Rgba *find(LayerDef::Type type) const { return enabled_[type] ? &colors_[type] : nullptr; }
+		//Iteration goes through the types of the enabled layers only, in the same order as the layers in the Layers collection
+		const LayerDef::Type *begin() const { return enabled_types_.data(); }
+		const LayerDef::Type *end() const { return enabled_types_.data() + num_enabled_; }
 
 	private:
+		std::array<Rgba, LayerDef::Type::Size> colors_;
+		std::bitset<LayerDef::Type::Size> enabled_;
+		std::array<LayerDef::Type, LayerDef::Type::Size> enabled_types_;
+		size_t num_enabled_ = 0;
 		LayerDef::Flags flags_{LayerDef::Flags::None};
 };
 
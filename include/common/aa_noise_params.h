@@ -36,6 +36,15 @@ struct AaNoiseParams
 				{"curve", Curve, ""},
 			}};
 	};
+	struct SamplerType : public Enum<SamplerType>
+	{
+		enum : ValueType_t { Halton, Sobol, Pmj02 };
+		inline static const EnumMap<ValueType_t> map_{{
+				{"halton", Halton, "Radical inverse / Halton sequences with per pixel offsets"},
+				{"sobol", Sobol, "Owen-scrambled Sobol sequence"},
+				{"pmj02", Pmj02, "Progressive multi-jittered (0,2) sample tables"},
+			}};
+	};
 	int samples_ = 1;
 	int passes_ = 1;
 	int inc_samples_ = 1; //!< sample count for additional passes
@@ -51,6 +60,8 @@ struct AaNoiseParams
 	int variance_pixels_ = 0;
 	float clamp_samples_ = 0.f;
 	float clamp_indirect_ = 0.f;
+	SamplerType sampler_type_{SamplerType::Halton};
+	float confidence_ = 1.96f; //!< Z score of the confidence interval of the per pixel error estimate. 0 disables the variance based convergence test
 };
 
 } //namespace yafaray
@@ -0,0 +1,50 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_ALIGNED_ALLOCATOR_H
+#define LIBYAFARAY_ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+namespace yafaray {
+
+/*! Minimal allocator for standard containers that aligns the storage to the given alignment,
+ *  for example to cache line boundaries so consecutive small elements do not straddle cache lines */
+template <typename T, size_t alignment>
+class AlignedAllocator
+{
+	public:
+		using value_type = T;
+		template <typename U> struct rebind { using other = AlignedAllocator<U, alignment>; };
+		AlignedAllocator() noexcept = default;
+		template <typename U> AlignedAllocator(const AlignedAllocator<U, alignment> &) noexcept { }
+		T *allocate(size_t num_elements) { return static_cast<T *>(::operator new(num_elements * sizeof(T), std::align_val_t{alignment})); }
+		void deallocate(T *pointer, size_t) noexcept { ::operator delete(pointer, std::align_val_t{alignment}); }
+};
+
+template <typename T, typename U, size_t alignment>
+inline bool operator == (const AlignedAllocator<T, alignment> &, const AlignedAllocator<U, alignment> &) { return true; }
+
+template <typename T, typename U, size_t alignment>
+inline bool operator != (const AlignedAllocator<T, alignment> &, const AlignedAllocator<U, alignment> &) { return false; }
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_ALIGNED_ALLOCATOR_H
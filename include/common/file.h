@@ -24,8 +24,11 @@
 #ifndef YAFARAY_FILE_H
 #define YAFARAY_FILE_H
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
+#include <type_traits>
 
 namespace yafaray {
 
@@ -65,12 +68,19 @@ class File final
 		static bool remove(const std::string &path, bool files_only);
 		static bool rename(const std::string &path_old, const std::string &path_new, bool overwrite, bool files_only);
 		static std::vector<std::string> listFiles(const std::string &directory);
+		static uint64_t getSize(const std::string &path); //!< 0 if the file does not exist
+		static int64_t getModificationTime(const std::string &path); //!< seconds since the epoch, 0 if the file does not exist
+		static bool touch(const std::string &path); //!< sets the modification time of an existing file to the current time
+		static bool seek(std::FILE *fp, uint64_t offset); //!< like fseek from the file start, but with 64 bit offsets also in platforms where long is 32 bit
+		static bool readAt(std::FILE *fp, void *buffer, size_t size, uint64_t offset); //!< reads from the offset without using nor moving the file position, so several threads can read the same file at the same time. Pending writes must be flushed before
 		bool open(const std::string &access_mode);
 		int close();
 		bool read(std::string &str) const;
 		template <typename T> bool read(T &value) const;
+		template <typename T> bool read(std::vector<T> &values) const; //!< reads as many values as the current vector size
 		bool append(const std::string &str);
 		template <typename T> bool append(const T &value);
+		template <typename T> bool append(const std::vector<T> &values);
 		bool appendText(const std::string &str);
 
 	private:
@@ -87,6 +97,12 @@ template <typename T> bool File::read(T &value) const
 	return File::read((char *)&value, sizeof(T));
 }
 
+template <typename T> bool File::read(std::vector<T> &values) const
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable so it can be read in bulk");
+	return File::read((char *)values.data(), values.size() * sizeof(T));
+}
+
 template <typename T> bool File::append(const T &value)
 {
 	static_assert(std::is_standard_layout<T>::value && std::is_trivial<T>::value, "T must be a plain old data (POD) type like char, int32_t, float, etc");
@@ -94,6 +110,12 @@ template <typename T> bool File::append(const T &value)
 }
 
 
+template <typename T> bool File::append(const std::vector<T> &values)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable so it can be written in bulk");
+	return File::append((const char *)values.data(), values.size() * sizeof(T));
+}
+
 } //namespace yafaray
 
 #endif //YAFARAY_FILE_H
@@ -49,7 +49,7 @@ class Layer final
 		Image::Type getExportedImageType() const { return exported_image_type_; }
 		std::string getExportedImageTypeNameLong() const { return Image::getTypeNameLong(exported_image_type_); }
 		std::string getExportedImageTypeNameShort() const { return Image::getTypeNameShort(exported_image_type_); }
-		std::string getExportedImageName() const { return exported_image_name_; }
+		const std::string &getExportedImageName() const { return exported_image_name_; }
 		LayerDef::Flags getFlags() const { return LayerDef::getFlags(type_); }
 		std::string print() const;
 
@@ -53,6 +53,7 @@ class LayerDef final
 			Ao,
 			AoClay,
 			BarycentricUvw,
+			DebugConvergence,
 			DebugDpLengths,
 			DebugDpdu,
 			DebugDpdv,
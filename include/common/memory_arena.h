@@ -23,6 +23,8 @@
 #include <vector>
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <new>
 
 namespace yafaray {
 
@@ -34,43 +36,130 @@ class MemoryArena
 		{
 			block_size_ = block_size;
 			cur_block_pos_ = 0;
-			current_block_ = (char *) malloc(block_size_);
+			current_block_ = {(char *) malloc(block_size_), block_size_};
 		}
 		~MemoryArena()
 		{
-			free(current_block_);
-			for(const auto &used_block : used_blocks_) free(used_block);
-			for(const auto &available_block : available_blocks_) free(available_block);
+			free(current_block_.data_);
+			for(const auto &used_block : used_blocks_) free(used_block.data_);
+			for(const auto &available_block : available_blocks_) free(available_block.data_);
 		}
 		void *alloc(uint32_t sz)
 		{
 			// Round up _sz_ to minimum machine alignment
 			sz = ((sz + 7) & (~7));
-			if(cur_block_pos_ + sz > block_size_)
+			if(cur_block_pos_ + sz > current_block_.size_)
 			{
 				// Get new block of memory for _MemoryArena_
 				used_blocks_.emplace_back(current_block_);
-				if(!available_blocks_.empty() && sz <= block_size_)
+				//Allocations bigger than the block size also reuse the available blocks big enough for them, so they do not make the arena grow after every reset
+				const auto available_block{std::find_if(available_blocks_.begin(), available_blocks_.end(), [sz](const Block &block) { return block.size_ >= sz; })};
+				if(available_block != available_blocks_.end())
 				{
-					current_block_ = available_blocks_.back();
+					current_block_ = *available_block;
+					*available_block = available_blocks_.back();
 					available_blocks_.pop_back();
 				}
 				else
-					current_block_ = (char *) malloc((std::max(sz, block_size_)));
+				{
+					const uint32_t size{std::max(sz, block_size_)};
+					current_block_ = {(char *) malloc(size), size};
+				}
 				cur_block_pos_ = 0;
 			}
-			void *ret = current_block_ + cur_block_pos_;
+			void *ret = current_block_.data_ + cur_block_pos_;
 			cur_block_pos_ += sz;
 			return ret;
 		}
+		//! Releases all the allocations at once, keeping the blocks for reuse
+		void reset()
+		{
+			cur_block_pos_ = 0;
+			available_blocks_.insert(available_blocks_.end(), used_blocks_.begin(), used_blocks_.end());
+			used_blocks_.clear();
+		}
 	private:
+		struct Block
+		{
+			char *data_;
+			uint32_t size_;
+		};
 		// MemoryArena Private Data
 		alignas(8) uint32_t cur_block_pos_;
 		uint32_t block_size_;
-		char *current_block_;
-		std::vector<char *> used_blocks_, available_blocks_;
+		Block current_block_;
+		std::vector<Block> used_blocks_, available_blocks_;
+};
+
+/*! Bump arena owned by each thread, used for the short lived objects of the hit and shading path (surface points, material data, node results, specular directions, ray differentials).
+ *  Classes opt in by routing their operator new/delete to allocate/deallocate. While a SampleScope is alive in the calling thread the allocations come from the thread arena and
+ *  are all released at once when the outermost scope ends, so no object allocated inside a scope can outlive it. Outside any scope allocations fall back to the heap */
+class ThreadMemoryArena final : public MemoryArena
+{
+	public:
+		class SampleScope;
+		static void *allocate(size_t size);
+		static void deallocate(void *pointer) noexcept;
+
+	private:
+		struct alignas(16) Header { bool from_arena_; }; //!< Keeps the returned memory 16 byte aligned and tells deallocate where the memory came from
+		static ThreadMemoryArena &threadArena();
+		int scope_depth_ = 0;
+};
+
+class ThreadMemoryArena::SampleScope final
+{
+	public:
+		SampleScope() : arena_{threadArena()} { ++arena_.scope_depth_; }
+		SampleScope(const SampleScope &) = delete;
+		SampleScope &operator=(const SampleScope &) = delete;
+		~SampleScope() { if(--arena_.scope_depth_ == 0) arena_.reset(); }
+
+	private:
+		ThreadMemoryArena &arena_;
 };
 
+inline ThreadMemoryArena &ThreadMemoryArena::threadArena()
+{
+	thread_local ThreadMemoryArena thread_arena;
+	return thread_arena;
+}
+
+inline void *ThreadMemoryArena::allocate(size_t size)
+{
+	ThreadMemoryArena &arena{threadArena()};
+	const bool from_arena{arena.scope_depth_ > 0};
+	const size_t total_size{sizeof(Header) + ((size + alignof(Header) - 1) & ~(alignof(Header) - 1))};
+	void *block{from_arena ? arena.alloc(static_cast<uint32_t>(total_size)) : ::operator new(total_size)};
+	Header *header{new(block) Header{from_arena}};
+	return header + 1;
+}
+
+inline void ThreadMemoryArena::deallocate(void *pointer) noexcept
+{
+	if(!pointer) return;
+	Header *header{static_cast<Header *>(pointer) - 1};
+	if(!header->from_arena_) ::operator delete(header);
+}
+
+//! Allocator for standard containers allocating from the thread arena
+template <typename T>
+class ThreadArenaAllocator
+{
+	public:
+		using value_type = T;
+		ThreadArenaAllocator() noexcept = default;
+		template <typename U> ThreadArenaAllocator(const ThreadArenaAllocator<U> &) noexcept { }
+		T *allocate(size_t num_elements) { return static_cast<T *>(ThreadMemoryArena::allocate(num_elements * sizeof(T))); }
+		void deallocate(T *pointer, size_t) noexcept { ThreadMemoryArena::deallocate(pointer); }
+};
+
+template <typename T, typename U>
+inline bool operator == (const ThreadArenaAllocator<T> &, const ThreadArenaAllocator<U> &) { return true; }
+
+template <typename T, typename U>
+inline bool operator != (const ThreadArenaAllocator<T> &, const ThreadArenaAllocator<U> &) { return false; }
+
 } //namespace yafaray
 
 #endif // YAFARAY_MEMORY_ARENA_H
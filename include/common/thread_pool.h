@@ -0,0 +1,96 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef YAFARAY_THREAD_POOL_H
+#define YAFARAY_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yafaray {
+
+class TaskGroup;
+
+//! Engine-wide pool of persistent worker threads. Each worker owns a task deque: it pushes and pops its own tasks at the back (LIFO, cache friendly for recursive subdivisions) and, when empty, steals the oldest tasks from the front of the other workers deques
+class ThreadPool final
+{
+	public:
+		//! Pool shared by all the subsystems, created on first use with one worker per system thread
+		static ThreadPool &get();
+		explicit ThreadPool(int num_workers);
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+		~ThreadPool();
+		int numWorkers() const { return static_cast<int>(workers_.size()); }
+
+	private:
+		friend class TaskGroup;
+		struct Task
+		{
+			std::function<void()> function_;
+			TaskGroup *task_group_ = nullptr;
+		};
+		struct WorkerQueue
+		{
+			std::mutex mutex_;
+			std::deque<Task> tasks_;
+		};
+		void submit(Task &&task);
+		bool tryRunTask();
+		bool tryTakeTask(Task &task);
+		void runTask(Task &task);
+		void workerLoop(int worker_id);
+		void wait(const TaskGroup &task_group);
+
+		std::vector<std::unique_ptr<WorkerQueue>> queues_;
+		std::vector<std::thread> workers_;
+		std::atomic<int> num_queued_tasks_{0};
+		std::atomic<unsigned int> next_external_queue_{0};
+		std::mutex sleep_mutex_;
+		std::condition_variable sleep_condition_;
+		bool stop_ = false;
+};
+
+//! Set of tasks submitted to a ThreadPool that can be waited for together. While waiting, the calling thread executes pending pool tasks, so tasks can submit and wait for nested task groups without exhausting the pool workers
+class TaskGroup final
+{
+	public:
+		explicit TaskGroup(ThreadPool &thread_pool = ThreadPool::get()) : thread_pool_(thread_pool) { }
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup &operator=(const TaskGroup &) = delete;
+		~TaskGroup() { wait(); }
+		void run(std::function<void()> &&function);
+		void wait() { thread_pool_.wait(*this); }
+		bool finished() const { return num_pending_tasks_.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class ThreadPool;
+		ThreadPool &thread_pool_;
+		std::atomic<int> num_pending_tasks_{0};
+};
+
+} //namespace yafaray
+
+#endif //YAFARAY_THREAD_POOL_H
@@ -22,6 +22,7 @@
 
 #include "geometry/vector.h"
 #include "color/color.h"
+#include "common/memory_arena.h"
 #include <memory>
 
 namespace yafaray {
@@ -29,6 +30,8 @@ namespace yafaray {
 struct DirectionColor
 {
 	static std::unique_ptr<DirectionColor> blend(std::unique_ptr<DirectionColor> direction_color_1, std::unique_ptr<DirectionColor> direction_color_2, float blend_val);
+	static void *operator new(size_t size) { return ThreadMemoryArena::allocate(size); } //!< Allocated from the thread arena when rendering a sample
+	static void operator delete(void *pointer) { ThreadMemoryArena::deallocate(pointer); }
 	Vec3f dir_;
 	Rgb col_;
 };
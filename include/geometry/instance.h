@@ -30,6 +30,7 @@ namespace yafaray {
 
 class PrimitiveInstance;
 class Scene;
+class Logger;
 
 class Instance final
 {
@@ -42,9 +43,11 @@ class Instance final
 		void addInstance(size_t instance_id);
 		void addObjToWorldMatrix(Matrix4f &&obj_to_world, float time);
 		std::vector<const Matrix4f *> getObjToWorldMatrices() const;
+		std::vector<Matrix4f> getObjToWorldMatricesTimeInterval(float time_start, float time_end) const;
 		const Matrix4f &getObjToWorldMatrix(unsigned char time_step) const { return time_steps_[time_step].obj_to_world_; }
 		Matrix4f getObjToWorldMatrixAtTime(float time) const;
-		[[nodiscard]] bool updatePrimitives(const Scene &scene);
+		std::vector<size_t> getBaseObjectIds() const;
+		[[nodiscard]] bool updatePrimitives(Logger &logger, const Scene &scene);
 		std::vector<const PrimitiveInstance *> getPrimitives() const;
 		bool hasMotionBlur() const { return time_steps_.size() > 2; }
 
@@ -66,6 +66,7 @@ class Object
 			\return number of written primitives */
 		virtual std::vector<const Primitive *> getPrimitives() const = 0;
 		virtual bool hasMotionBlur() const { return false; }
+		virtual void updateGeometricNormals() { } //!< recalculates the geometric normals cached by the primitives, after their vertices were rewritten in place
 
 		/* Mesh-related interface functions below, only for Mesh objects */
 		virtual int lastVertexId(unsigned char time_step) const { return -1; }
@@ -74,9 +75,19 @@ class Object
 		virtual void addVertexNormal(Vec3f &&n, unsigned char time_step) { }
 		virtual void addFace(const FaceIndices<int> &face_indices, size_t material_id) { }
 		virtual int addUvValue(Uv<float> &&uv) { return -1; }
+		/* Bulk mesh functions, taking whole arrays of interleaved float components (xyz for points and normals, uv for UVs) */
+		virtual int addPoints(const float *points, const float *orco_points, size_t num_points, unsigned char time_step) { return -1; }
+		virtual bool addVerticesNormals(const float *normals, size_t num_normals, unsigned char time_step) { return false; }
+		virtual int addUvValues(const float *uv_values, size_t num_uv_values) { return -1; }
+		virtual bool addFaces(const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id) { return false; }
+		virtual float *getPointsBuffer(size_t num_points, unsigned char time_step) { return nullptr; }
+		virtual float *getVerticesNormalsBuffer(size_t num_normals, unsigned char time_step) { return nullptr; }
+		virtual float *getUvValuesBuffer(size_t num_uv_values) { return nullptr; }
 		virtual bool hasVerticesNormals(unsigned char time_step) const { return false; }
 		virtual int numVerticesNormals(unsigned char time_step) const { return 0; }
 		virtual int numVertices(unsigned char time_step) const { return 0; }
+		virtual size_t numUvValues() const { return 0; }
+		virtual int numTimeSteps() const { return 0; }
 		virtual void setSmooth(bool smooth) { }
 		virtual void setAutoSmooth(float smooth_angle) { }
 		virtual bool smoothVerticesNormals(Logger &logger, float angle) { return false; }
@@ -29,6 +29,7 @@
 namespace yafaray {
 
 template <typename T> struct Uv;
+template <typename IndexType> struct VertexIndices;
 class FacePrimitive;
 class Material;
 
@@ -56,6 +57,7 @@ class MeshObject : public Object
 		void addFace(const FaceIndices<int> &face_indices, size_t material_id) override;
 		const std::vector<Point3f> &getPoints(unsigned char time_step) const { return time_steps_[time_step].points_; }
 		const std::vector<Uv<float>> &getUvValues() const { return uv_values_; }
+		size_t numUvValues() const override { return uv_values_.size(); }
 		bool hasOrco(unsigned char time_step) const { return !time_steps_[time_step].orco_points_.empty(); }
 		bool hasUv() const { return !uv_values_.empty(); }
 		bool isSmooth() const { return is_smooth_; }
@@ -66,6 +68,13 @@ class MeshObject : public Object
 		void addOrcoPoint(Point3f &&p, unsigned char time_step) override { time_steps_[time_step].orco_points_.emplace_back(p); }
 		void addVertexNormal(Vec3f &&n, unsigned char time_step) override;
 		int addUvValue(Uv<float> &&uv) override { uv_values_.emplace_back(uv); return static_cast<int>(uv_values_.size()) - 1; }
+		int addPoints(const float *points, const float *orco_points, size_t num_points, unsigned char time_step) override;
+		bool addVerticesNormals(const float *normals, size_t num_normals, unsigned char time_step) override;
+		int addUvValues(const float *uv_values, size_t num_uv_values) override;
+		bool addFaces(const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id) override;
+		float *getPointsBuffer(size_t num_points, unsigned char time_step) override;
+		float *getVerticesNormalsBuffer(size_t num_normals, unsigned char time_step) override;
+		float *getUvValuesBuffer(size_t num_uv_values) override;
 		void setSmooth(bool smooth) override { is_smooth_ = smooth; }
 		void setAutoSmooth(float smooth_angle) override { setSmooth(true); smooth_angle_ = smooth_angle; is_auto_smooth_ = true; }
 		bool smoothVerticesNormals(Logger &logger, float angle) override;
@@ -73,8 +82,9 @@ class MeshObject : public Object
 		bool hasMotionBlurBezier() const { return Object::params_.motion_blur_bezier_; }
 		float getTimeRangeStart() const { return time_steps_.front().time_; }
 		float getTimeRangeEnd() const { return time_steps_.back().time_; }
-		int numTimeSteps() const { return static_cast<int>(time_steps_.size()); }
+		int numTimeSteps() const override { return static_cast<int>(time_steps_.size()); }
 		bool hasMotionBlur() const override { return hasMotionBlurBezier(); }
+		void updateGeometricNormals() override;
 
 	protected:
 		[[nodiscard]] Type type() const override { return Type::Mesh; }
@@ -97,6 +107,7 @@ class MeshObject : public Object
 			std::vector<Vec3f> vertices_normals_;
 		};
 		virtual int calculateNumFaces() const { return params_.num_faces_; }
+		int numIndexedItems(int VertexIndices<int>::*index) const; //!< Number of points, normals or uvs needed by the indices of the existing faces
 		void convertToBezierControlPoints();
 		static float getAngleSine(const std::array<int, 3> &triangle_indices, const std::vector<Point3f> &vertices);
 		std::vector<TimeStepGeometry> time_steps_{1};
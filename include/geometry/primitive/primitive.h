@@ -55,7 +55,11 @@ class Primitive
 		/*! return the object bound in global ("world") coordinates */
 		virtual Bound<float> getBound() const = 0;
 		virtual Bound<float> getBound(const Matrix4f &obj_to_world) const = 0;
+		/*! return the bound of the positions the object can take for ray times in [time_start, time_end]. Only motion blurred primitives need to provide a tighter bound than getBound() */
+		virtual Bound<float> getBoundTimeInterval(float time_start, float time_end) const { return getBound(); }
 		virtual bool clippingSupport() const = 0;
+		/*! returns true for the top level primitives that represent instanced objects (see PrimitiveInstance) */
+		virtual bool isInstance() const { return false; }
 		virtual std::pair<float, Uv<float>> intersect(const Point3f &from, const Vec3f &dir, float time) const = 0;
 		virtual std::pair<float, Uv<float>> intersect(const Point3f &from, const Vec3f &dir, float time, const Matrix4f &obj_to_world) const = 0;
 		virtual std::unique_ptr<const SurfacePoint> getSurface(const RayDifferentials *ray_differentials, const Point3f &hit_point, float time, const Uv<float> &intersect_uv, const Camera *camera) const = 0;
@@ -75,6 +79,8 @@ class Primitive
 		virtual Rgb getObjectIndexAutoColor() const = 0;
 		virtual const Light *getObjectLight() const = 0;
 		virtual bool hasMotionBlur() const = 0;
+		/*! for planar polygons with fixed vertices (no motion blur) copies the vertices into "vertices" and returns their number (3 or 4), so accelerators can keep their own packed copy. Returns 0 for any other primitive */
+		virtual int getStaticPolygonVertices(std::array<Point3f, 4> &vertices) const { return 0; }
 		virtual PolyDouble::ClipResultWithBound clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly) const;
 		virtual PolyDouble::ClipResultWithBound clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly, const Matrix4f &obj_to_world) const;
 };
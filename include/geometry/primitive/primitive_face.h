@@ -48,11 +48,13 @@ class FacePrimitive: public Primitive
 		FaceIndices<int> &getFaceIndices() { return indices_; }
 		const FaceIndices<int> &getFaceIndices() const { return indices_; }
 		void generateInitialVerticesNormalsIndices();
+		virtual void updateGeometricNormal() { } //!< recalculates the cached geometric normal from the current vertices
 		template<typename T=bool> std::vector<Point3f> getVerticesAsVector(unsigned char time_step, const T &obj_to_world = {}) const;
 		template<typename T=bool> Point3f getVertex(int vertex_number, const std::array<float, 3> &bezier_factors, const T &obj_to_world = {}) const;
 		template<typename T=bool> Point3f getVertexAtTime(int vertex_number, float time, const T &obj_to_world = {}) const;
 		static Bound<float> getBound(const std::vector<Point3f> &vertices);
 		template<typename T=bool> Bound<float> getBoundTimeSteps(const T &obj_to_world = {}) const;
+		template<typename T=bool> Bound<float> getBoundTimeSteps(float time_start, float time_end, const T &obj_to_world = {}) const;
 		const Material *getMaterial() const override { return base_mesh_object_.getMaterial(material_id_); }
 		void setMaterial(size_t material_id) { material_id_ = material_id; }
 		uintptr_t getObjectHandle() const override { return reinterpret_cast<uintptr_t>(&base_mesh_object_); }
@@ -167,6 +169,25 @@ inline Bound<float> FacePrimitive::getBoundTimeSteps(const T &obj_to_world) cons
 	return FacePrimitive::getBound(vertices);
 }
 
+//! The bezier path of each vertex is cut to the [time_start, time_end] interval, and the bound includes the control points of the resulting shorter curves
+template <typename T>
+inline Bound<float> FacePrimitive::getBoundTimeSteps(float time_start, float time_end, const T &obj_to_world) const
+{
+	const float range_start{base_mesh_object_.getTimeRangeStart()};
+	const float range_end{base_mesh_object_.getTimeRangeEnd()};
+	if(base_mesh_object_.numTimeSteps() < 3 || time_end < time_start || range_end <= range_start) return getBoundTimeSteps(obj_to_world);
+	const float x_start{math::clamp(math::lerpSegment(time_start, 0.f, range_start, 1.f, range_end), 0.f, 1.f)};
+	const float x_end{math::clamp(math::lerpSegment(time_end, 0.f, range_start, 1.f, range_end), 0.f, 1.f)};
+	std::vector<Point3f> vertices;
+	vertices.reserve(numVertices() * 3);
+	for(int vertex_number = 0; vertex_number < numVertices(); ++vertex_number)
+	{
+		const auto control_points{math::bezierSubdivide<Point3f>({getVertex(vertex_number, 0, obj_to_world), getVertex(vertex_number, 1, obj_to_world), getVertex(vertex_number, 2, obj_to_world)}, x_start, x_end)};
+		vertices.insert(vertices.end(), control_points.begin(), control_points.end());
+	}
+	return FacePrimitive::getBound(vertices);
+}
+
 inline void FacePrimitive::generateInitialVerticesNormalsIndices()
 {
 	for(auto &indices : indices_)
@@ -27,6 +27,8 @@
 
 namespace yafaray {
 
+class Accelerator;
+struct IntersectData;
 class Material;
 template<typename T> class Bound;
 class SurfacePoint;
@@ -35,111 +37,73 @@ typedef Point<float, 3> Point3f;
 class ParamMap;
 class Scene;
 
+/*! Top level primitive representing a whole base object seen through an instance (or a chain of nested instances).
+ *  The base object primitives are kept in their own object space accelerator, shared by all the instances of the object,
+ *  and the ray is transformed into object space once per visit instead of transforming every base primitive into world space.
+ *  Hits resolve to the base object primitive, so the surface related functions of this class are never used for shading.
+ *  They only exist because they are part of the Primitive interface, and they log an error if they are ever called. */
 class PrimitiveInstance final : public Primitive
 {
 	public:
-		PrimitiveInstance(const Primitive &base_primitive, const Instance &base_instance) : base_instance_(base_instance), base_primitive_(base_primitive) { }
+		PrimitiveInstance(Logger &logger, const Accelerator &base_accelerator, const Instance &base_instance);
+		PrimitiveInstance(Logger &logger, const PrimitiveInstance &base_primitive_instance, const Instance &base_instance);
 		[[nodiscard]] std::string exportToString(size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const override;
+		bool isInstance() const override { return true; }
+		void intersect(IntersectData &intersect_data, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const;
+		bool intersectShadow(IntersectData &intersect_data, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const;
+		bool intersectTransparentShadow(IntersectData &intersect_data, int &depth, int max_depth, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const;
+		Matrix4f getObjToWorldMatrixAtTime(float time) const;
 		Bound<float> getBound() const override;
 		Bound<float> getBound(const Matrix4f &obj_to_world) const override;
-		bool clippingSupport() const override { return base_primitive_.clippingSupport() && !hasMotionBlur(); }
-		PolyDouble::ClipResultWithBound clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly) const override;
-		PolyDouble::ClipResultWithBound clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly, const Matrix4f &obj_to_world) const override;
+		Bound<float> getBoundTimeInterval(float time_start, float time_end) const override;
+		bool clippingSupport() const override { return false; }
 		std::pair<float, Uv<float>> intersect(const Point3f &from, const Vec3f &dir, float time) const override;
 		std::pair<float, Uv<float>> intersect(const Point3f &from, const Vec3f &dir, float time, const Matrix4f &obj_to_world) const override;
 		std::unique_ptr<const SurfacePoint> getSurface(const RayDifferentials *ray_differentials, const Point3f &hit_point, float time, const Uv<float> &intersect_uv, const Camera *camera) const override;
 		std::unique_ptr<const SurfacePoint> getSurface(const RayDifferentials *ray_differentials, const Point3f &hit_point, float time, const Uv<float> &intersect_uv, const Camera *camera, const Matrix4f &obj_to_world) const override;
-		const Material *getMaterial() const override { return base_primitive_.getMaterial(); }
+		const Material *getMaterial() const override;
 		float surfaceArea(float time) const override;
 		float surfaceArea(float time, const Matrix4f &obj_to_world) const override;
 		Vec3f getGeometricNormal(const Uv<float> &uv, float time, bool) const override;
 		Vec3f getGeometricNormal(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const override;
 		std::pair<Point3f, Vec3f> sample(const Uv<float> &uv, float time) const override;
 		std::pair<Point3f, Vec3f> sample(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const override;
-		uintptr_t getObjectHandle() const override { return reinterpret_cast<uintptr_t>(&base_instance_); }
-		Visibility getVisibility() const override { return base_primitive_.getVisibility(); }
-		int getObjectIndex() const override { return base_primitive_.getObjectIndex(); }
-		size_t getObjectId() const override { return base_primitive_.getObjectId(); }
-		Rgb getObjectIndexAutoColor() const override { return base_primitive_.getObjectIndexAutoColor(); }
-		const Light *getObjectLight() const override { return base_primitive_.getObjectLight(); }
-		bool hasMotionBlur() const override { return base_instance_.hasMotionBlur(); }
-		float getDistToNearestEdge(const Uv<float> &uv, const Uv<Vec3f> &dp_abs) const override { return base_primitive_.getDistToNearestEdge(uv, dp_abs); }
+		uintptr_t getObjectHandle() const override { return reinterpret_cast<uintptr_t>(instances_.front()); }
+		Visibility getVisibility() const override { return Visibility::Normal; }
+		int getObjectIndex() const override { return 0; }
+		size_t getObjectId() const override { return 0; }
+		Rgb getObjectIndexAutoColor() const override { return Rgb{0.f}; }
+		const Light *getObjectLight() const override { return nullptr; }
+		bool hasMotionBlur() const override { return has_motion_blur_; }
+		float getDistToNearestEdge(const Uv<float> &uv, const Uv<Vec3f> &dp_abs) const override;
 
 	private:
-		const Instance &base_instance_;
-		const Primitive &base_primitive_;
+		Matrix4f getWorldToObjMatrixAtTime(float time) const;
+		void logNotSupported(const std::string &function_name) const;
+		Logger &logger_;
+		const Accelerator &base_accelerator_; //!< object space accelerator of the base object
+		std::vector<const Instance *> instances_; //!< chain of nested instances, from the outermost to the innermost one
+		bool has_motion_blur_{false};
+		Matrix4f obj_to_world_{1.f}; //!< cached object to world matrix, only used when there is no motion blur
+		Matrix4f world_to_obj_{1.f}; //!< cached inverse matrix, only used when there is no motion blur
 };
 
-inline PolyDouble::ClipResultWithBound PrimitiveInstance::clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly) const
+inline Matrix4f PrimitiveInstance::getObjToWorldMatrixAtTime(float time) const
 {
-	return base_primitive_.clipToBound(logger, bound, clip_plane, poly, base_instance_.getObjToWorldMatrix(0));
-}
-
-inline PolyDouble::ClipResultWithBound PrimitiveInstance::clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly, const Matrix4f &obj_to_world) const
-{
-	return base_primitive_.clipToBound(logger, bound, clip_plane, poly, obj_to_world * base_instance_.getObjToWorldMatrix(0));
-}
-
-inline std::pair<float, Uv<float>> PrimitiveInstance::intersect(const Point3f &from, const Vec3f &dir, float time) const
-{
-	return base_primitive_.intersect(from, dir, time, base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline std::pair<float, Uv<float>> PrimitiveInstance::intersect(const Point3f &from, const Vec3f &dir, float time, const Matrix4f &obj_to_world) const
-{
-	return base_primitive_.intersect(from, dir, time, obj_to_world * base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline float PrimitiveInstance::surfaceArea(float time) const
-{
-	return base_primitive_.surfaceArea(time, base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline float PrimitiveInstance::surfaceArea(float time, const Matrix4f &obj_to_world) const
-{
-	return base_primitive_.surfaceArea(time, obj_to_world * base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline Vec3f PrimitiveInstance::getGeometricNormal(const Uv<float> &uv, float time, bool) const
-{
-	return base_primitive_.getGeometricNormal(uv, time, base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline Vec3f PrimitiveInstance::getGeometricNormal(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const
-{
-	return base_primitive_.getGeometricNormal(uv, time, obj_to_world * base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline std::pair<Point3f, Vec3f> PrimitiveInstance::sample(const Uv<float> &uv, float time) const
-{
-	return base_primitive_.sample(uv, time, base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline std::pair<Point3f, Vec3f> PrimitiveInstance::sample(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const
-{
-	return base_primitive_.sample(uv, time, obj_to_world * base_instance_.getObjToWorldMatrixAtTime(time));
-}
-
-inline Bound<float> PrimitiveInstance::getBound() const
-{
-	const std::vector<const Matrix4f *> matrices = base_instance_.getObjToWorldMatrices();
-	Bound result{base_primitive_.getBound(*matrices[0])};
-	for(size_t i = 1; i < matrices.size(); ++i)
+	if(!has_motion_blur_) return obj_to_world_;
+	Matrix4f result{instances_.front()->getObjToWorldMatrixAtTime(time)};
+	for(size_t i = 1; i < instances_.size(); ++i)
 	{
-		result.include(base_primitive_.getBound(*matrices[i]));
+		result = result * instances_[i]->getObjToWorldMatrixAtTime(time);
 	}
 	return result;
 }
 
-inline Bound<float> PrimitiveInstance::getBound(const Matrix4f &obj_to_world) const
+inline Matrix4f PrimitiveInstance::getWorldToObjMatrixAtTime(float time) const
 {
-	const std::vector<const Matrix4f *> matrices = base_instance_.getObjToWorldMatrices();
-	Bound result{base_primitive_.getBound(obj_to_world * *(matrices[0]))};
-	for(size_t i = 1; i < matrices.size(); ++i)
-	{
-		result.include(base_primitive_.getBound(obj_to_world * *(matrices[i])));
-	}
-	return result;
+	if(!has_motion_blur_) return world_to_obj_;
+	Matrix4f result{getObjToWorldMatrixAtTime(time)};
+	return result.inverse();
 }
 
 inline std::string PrimitiveInstance::exportToString(size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const
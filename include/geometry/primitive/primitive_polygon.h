@@ -43,6 +43,7 @@ class PrimitivePolygon final : public FacePrimitive
 		PolyDouble::ClipResultWithBound clipToBound(Logger &logger, const std::array<Vec3d, 2> &bound, const ClipPlane &clip_plane, const PolyDouble &poly, const SquareMatrix<T, 4> &obj_to_world) const override;
 		Bound<T> getBound() const override;
 		Bound<T> getBound(const SquareMatrix<T, 4> &obj_to_world) const override;
+		Bound<T> getBoundTimeInterval(T time_start, T time_end) const override;
 		Vec<T, 3> getGeometricNormal(const Uv<T> &uv, T time, bool) const override;
 		Vec<T, 3> getGeometricNormal(const Uv<T> &uv, T time, const SquareMatrix<T, 4> &obj_to_world) const override;
 		Vec<T, 3> getGeometricNormal(const SquareMatrix<T, 4> &obj_to_world) const;
@@ -55,6 +56,8 @@ class PrimitivePolygon final : public FacePrimitive
 		std::pair<Point<T, 3>, Vec<T, 3>> sample(const Uv<T> &uv, T time) const override;
 		std::pair<Point<T, 3>, Vec<T, 3>> sample(const Uv<T> &uv, T time, const SquareMatrix<T, 4> &obj_to_world) const override;
 		T getDistToNearestEdge(const Uv<T> &uv, const Uv<Vec<T, 3>> &dp_abs) const override { return ShapePolygon<T, N>::getDistToNearestEdge(uv, dp_abs); }
+		int getStaticPolygonVertices(std::array<Point3f, 4> &vertices) const override;
+		void updateGeometricNormal() override { face_normal_geometric_ = ShapePolygon<T, N>{getVerticesAsArray(0)}.calculateFaceNormal(); }
 		template <typename M=bool> std::array<Point<T, 3>, N> getVerticesAsArray(unsigned char time_step, const M &obj_to_world = {}) const;
 		template <typename M=bool> std::array<Point<T, 3>, N> getVerticesAsArray(const std::array<T, 3> &bezier_factors, const M &obj_to_world = {}) const;
 		std::array<Point<T, 3>, N> getOrcoVertices(unsigned char time_step) const;
@@ -150,6 +153,18 @@ inline std::pair<T, Uv<T>> PrimitivePolygon<T, N, MotionBlur>::intersect(const P
 	return getShapeAtTime(time, obj_to_world).intersect(from, dir);
 }
 
+template <typename T, size_t N, MotionBlurType MotionBlur>
+inline int PrimitivePolygon<T, N, MotionBlur>::getStaticPolygonVertices(std::array<Point3f, 4> &vertices) const
+{
+	if constexpr(MotionBlur == MotionBlurType::Bezier || !std::is_same_v<T, float>) return 0;
+	else
+	{
+		const auto polygon_vertices{getVerticesAsArray(0)};
+		std::copy(polygon_vertices.begin(), polygon_vertices.end(), vertices.begin());
+		return N;
+	}
+}
+
 template <typename T, size_t N, MotionBlurType MotionBlur>
 inline T PrimitivePolygon<T, N, MotionBlur>::surfaceArea(T time) const
 {
@@ -204,6 +219,13 @@ inline Bound<T> PrimitivePolygon<T, N, MotionBlur>::getBound(const SquareMatrix<
 	else return FacePrimitive::getBound(getVerticesAsVector(0, obj_to_world));
 }
 
+template <typename T, size_t N, MotionBlurType MotionBlur>
+inline Bound<T> PrimitivePolygon<T, N, MotionBlur>::getBoundTimeInterval(T time_start, T time_end) const
+{
+	if constexpr(MotionBlur == MotionBlurType::Bezier) return getBoundTimeSteps(time_start, time_end);
+	else return getBound();
+}
+
 template <typename T, size_t N, MotionBlurType MotionBlur>
 inline Vec<T, 3> PrimitivePolygon<T, N, MotionBlur>::getGeometricNormal(bool) const
 {
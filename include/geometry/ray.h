@@ -21,6 +21,7 @@
 #define YAFARAY_RAY_H
 
 #include "geometry/vector.h"
+#include "common/memory_arena.h"
 #include <memory>
 
 namespace yafaray {
@@ -29,6 +30,8 @@ struct RayDifferentials
 {
 	RayDifferentials() = default;
 	RayDifferentials(const Point3f &xfrom, const Vec3f &xdir, const Point3f &yfrom, const Vec3f &ydir) : xfrom_(xfrom), yfrom_(yfrom), xdir_(xdir), ydir_(ydir) { }
+	static void *operator new(size_t size) { return ThreadMemoryArena::allocate(size); } //!< Allocated from the thread arena when rendering a sample
+	static void operator delete(void *pointer) { ThreadMemoryArena::deallocate(pointer); }
 	Point3f xfrom_, yfrom_;
 	Vec3f xdir_, ydir_;
 };
@@ -29,6 +29,7 @@
 #include "material/material.h"
 #include "material/material_data.h"
 #include "math/interpolation.h"
+#include "common/memory_arena.h"
 
 namespace yafaray {
 class Light;
@@ -44,6 +45,8 @@ struct SurfaceDifferentials final
 	SurfaceDifferentials(const SurfaceDifferentials &surface_differentials) = default;
 	SurfaceDifferentials(SurfaceDifferentials &&surface_differentials) = default;
 	SurfaceDifferentials(const Vec3f &dp_dx, const Vec3f &dp_dy) : dp_dx_(dp_dx), dp_dy_(dp_dy) { }
+	static void *operator new(size_t size) { return ThreadMemoryArena::allocate(size); }
+	static void operator delete(void *pointer) { ThreadMemoryArena::deallocate(pointer); }
 	Vec3f dp_dx_;
 	Vec3f dp_dy_;
 };
@@ -63,6 +66,8 @@ class SurfacePoint final
 		SurfacePoint& operator=(const SurfacePoint &sp);
 		SurfacePoint(SurfacePoint &&surface_point) = default;
 		SurfacePoint& operator=(SurfacePoint&& surface_point) = default;
+		static void *operator new(size_t size) { return ThreadMemoryArena::allocate(size); } //!< Allocated from the thread arena when rendering a sample
+		static void operator delete(void *pointer) { ThreadMemoryArena::deallocate(pointer); }
 		[[nodiscard]] static Vec3f normalFaceForward(const Vec3f &normal_geometry, const Vec3f &normal, const Vec3f &incoming_vector);
 		[[nodiscard]] float getDistToNearestEdge() const;
 		//! compute differentials for a scattered ray
@@ -78,7 +83,7 @@ class SurfacePoint final
 		[[nodiscard]] float pdf(const Vec3f &wo, const Vec3f &wi, BsdfFlags bsdfs) const;
 		[[nodiscard]] Rgb getTransparency(const Vec3f &wo, const Camera *camera = nullptr) const;
 		[[nodiscard]] Specular getSpecular(int ray_level, const Vec3f &wo, bool chromatic, float wavelength) const;
-		[[nodiscard]] Rgb getReflectivity(FastRandom &fast_random, BsdfFlags flags, bool chromatic, float wavelength = 0.f, const Camera *camera = nullptr) const;
+		[[nodiscard]] Rgb getReflectivity(RandomGenerator &random_generator, BsdfFlags flags, bool chromatic, float wavelength = 0.f, const Camera *camera = nullptr) const;
 		[[nodiscard]] Rgb emit(const Vec3f &wo) const;
 		[[nodiscard]] float getAlpha(const Vec3f &wo, const Camera *camera = nullptr) const;
 		[[nodiscard]] bool scatterPhoton(const Vec3f &wi, Vec3f &wo, PSample &s, bool chromatic, float wavelength = 0.f, const Camera *camera = nullptr) const;
@@ -234,9 +239,9 @@ inline Specular SurfacePoint::getSpecular(int ray_level, const Vec3f &wo, bool c
 	return primitive_->getMaterial()->getSpecular(ray_level, mat_data_.get(), *this, wo, chromatic, wavelength);
 }
 
-inline Rgb SurfacePoint::getReflectivity(FastRandom &fast_random, BsdfFlags flags, bool chromatic, float wavelength, const Camera *camera) const
+inline Rgb SurfacePoint::getReflectivity(RandomGenerator &random_generator, BsdfFlags flags, bool chromatic, float wavelength, const Camera *camera) const
 {
-	return primitive_->getMaterial()->getReflectivity(fast_random, mat_data_.get(), *this, flags, chromatic, wavelength, camera);
+	return primitive_->getMaterial()->getReflectivity(random_generator, mat_data_.get(), *this, flags, chromatic, wavelength, camera);
 }
 
 inline Rgb SurfacePoint::emit(const Vec3f &wo) const
@@ -26,6 +26,7 @@
 #include "geometry/rect.h"
 #include "param/class_meta.h"
 #include "common/enum.h"
+#include "math/buffer_2d.h"
 #include <string>
 #include <memory>
 
@@ -99,6 +100,7 @@ class Image
 			PARAM_ENUM_DECL(ColorSpace, color_space_, ColorSpace::Srgb, "color_space", "");
 			PARAM_DECL(float, gamma_, 1.f, "gamma", "");
 			PARAM_ENUM_DECL(Optimization, image_optimization_, Optimization::Optimized, "image_optimization", "");
+			PARAM_ENUM_DECL(BufferLayout, buffer_layout_, BufferLayout::ColumnMajor, "buffer_layout", "Memory layout of the image pixels");
 			PARAM_DECL(int, width_, 100, "width", "Image width (overriden by the loaded image type if '" + filename_meta_.name() + "' is used)");
 			PARAM_DECL(int, height_, 100, "height", "Image height (overriden by the loaded image type if '" + filename_meta_.name() + "' is used)");
 		} params_;
@@ -115,6 +117,7 @@ class Image
 		virtual void setFloat(const Point2i &point, float val) = 0;
 		virtual void addFloat(const Point2i &point, float val) = 0;
 		virtual void clear() = 0;
+		virtual const float *getFloatData() const { return nullptr; } //!< Pixels as consecutive floats, row by row, or nullptr if the image is not stored that way (compressed pixel types or non row-major layouts)
 		int getWidth() const { return params_.width_; }
 		int getHeight() const { return params_.height_; }
 		Size2i getSize() const { return {{getWidth(), getHeight()}}; }
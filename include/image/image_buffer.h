@@ -33,6 +33,8 @@ class ImageBuffer final : public Image
 {
 	public:
 		explicit ImageBuffer(const Params &params) : Image{params} { }
+		const T *getPixels() const { return buffer_.data(); } //!< Raw pixels, in the order given by the buffer layout
+		T *getPixels() { return buffer_.data(); }
 
 	private:
 		Type type() const override;
@@ -45,8 +47,9 @@ class ImageBuffer final : public Image
 		void setFloat(const Point2i &point, float val) override;
 		void addFloat(const Point2i &point, float val) override; //<! Avoid when using optimized or compressed buffers, not enough precision for additions
 		void clear() override;
+		const float *getFloatData() const override;
 
-		Buffer2D<T> buffer_{Size2i{{params_.width_, params_.height_}}};
+		Buffer2D<T> buffer_{Size2i{{params_.width_, params_.height_}}, params_.buffer_layout_};
 };
 
 template <typename T>
@@ -116,6 +119,17 @@ inline void ImageBuffer<T>::addFloat(const Point2i &point, float val)
 	else addColor(point, Rgba{val});
 }
 
+template <typename T>
+inline const float *ImageBuffer<T>::getFloatData() const
+{
+	if constexpr (std::is_same_v<T, Rgb> || std::is_same_v<T, RgbAlpha> || std::is_same_v<T, Gray> || std::is_same_v<T, GrayAlpha>)
+	{
+		static_assert(sizeof(T) == sizeof(float) * (std::is_same_v<T, Rgb> ? 3 : std::is_same_v<T, RgbAlpha> ? 4 : std::is_same_v<T, Gray> ? 1 : 2), "The float pixel types must not have padding to be exposed as a float array");
+		if(buffer_.getLayout() == BufferLayout::RowMajor) return reinterpret_cast<const float *>(buffer_.data());
+	}
+	return nullptr;
+}
+
 template <typename T>
 inline void ImageBuffer<T>::clear()
 {
@@ -0,0 +1,64 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_IMAGE_TILED_H
+#define LIBYAFARAY_IMAGE_TILED_H
+
+#include "image/image.h"
+#include "texture/texture_cache.h"
+
+namespace yafaray {
+
+/*! Read only image whose texels are not kept in memory but fetched from the tiles of a texture cache */
+class TiledImage final : public Image
+{
+	public:
+		//! Copies the image texels into the texture cache tiles. Returns nullptr if the image could not be added to the cache
+		static std::unique_ptr<Image> factory(const Image &image, const std::shared_ptr<TextureCache> &texture_cache);
+		TiledImage(const Params &params, std::shared_ptr<const TextureCache> texture_cache, const TextureCache::ImageLayout &image_layout) : Image{params}, texture_cache_{std::move(texture_cache)}, image_layout_{image_layout}, tile_size_{texture_cache_->getTileSize()} { }
+
+	private:
+		Type type() const override { return image_layout_.type_; }
+		Optimization getOptimization() const override { return image_layout_.optimization_; }
+		Rgba getColor(const Point2i &point) const override;
+		float getFloat(const Point2i &point) const override { return getColor(point).r_; }
+		//The tiles in the texture cache cannot be modified, so writing to the image is not supported
+		void setColor(const Point2i &point, const Rgba &col) override { }
+		void setColor(const Point2i &point, Rgba &&col) override { }
+		void addColor(const Point2i &point, const Rgba &col) override { }
+		void setFloat(const Point2i &point, float val) override { }
+		void addFloat(const Point2i &point, float val) override { }
+		void clear() override { }
+
+		const std::shared_ptr<const TextureCache> texture_cache_;
+		const TextureCache::ImageLayout image_layout_;
+		const int tile_size_;
+};
+
+inline Rgba TiledImage::getColor(const Point2i &point) const
+{
+	const int x{point[Axis::X]};
+	const int y{point[Axis::Y]};
+	const Image *tile{texture_cache_->getTile(image_layout_, x / tile_size_, y / tile_size_)};
+	return tile->getColor({{x % tile_size_, y % tile_size_}});
+}
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_IMAGE_TILED_H
@@ -29,6 +29,7 @@ namespace yafaray {
 
 class Pdf1D;
 class Halton;
+class LightTree;
 
 class MonteCarloIntegrator: public TiledIntegrator
 {
@@ -40,6 +41,15 @@ class MonteCarloIntegrator: public TiledIntegrator
 		static std::string printMeta(const std::vector<std::string> &excluded_params) { return class_meta::print<Params>(excluded_params); }
 
 	protected:
+		struct LightSampling : public Enum<LightSampling>
+		{
+			using Enum::Enum;
+			enum : ValueType_t { Uniform, LightTree };
+			inline static const EnumMap<ValueType_t> map_{{
+					{"uniform", Uniform, "Pick the light uniformly among all lights"},
+					{"light_tree", LightTree, "Pick the light with a probability proportional to its estimated contribution using a light tree"},
+				}};
+		};
 		const struct Params
 		{
 			Params(ParamResult &param_result, const ParamMap &param_map);
@@ -53,10 +63,12 @@ class MonteCarloIntegrator: public TiledIntegrator
 			PARAM_DECL(Rgb, ao_color_, Rgb{1.f}, "AO_color", "Ambient occlusion color");
 			PARAM_DECL(bool, transparent_background_, false, "bg_transp", "Render background as transparent");
 			PARAM_DECL(bool, transparent_background_refraction_, false, "bg_transp_refract", "Render refractions of background as transparent");
+			PARAM_ENUM_DECL(LightSampling, light_sampling_, LightSampling::LightTree, "light_sampling", "Method to pick the light source when sampling one light per surface point");
 		} params_;
 		[[nodiscard]] ParamMap getAsParamMap(bool only_non_default) const override;
 		MonteCarloIntegrator(Logger &logger, ParamResult &param_result, const std::string &name, const ParamMap &param_map);
 		~MonteCarloIntegrator() override;
+		bool preprocess(RenderMonitor &render_monitor, const RenderControl &render_control, const Scene &scene) override;
 		/*! Estimates direct light from all sources in a mc fashion and completing MIS (Multiple Importance Sampling) for a given surface point */
 		Rgb estimateAllDirectLight(RandomGenerator &random_generator, ColorLayers *color_layers, bool chromatic_enabled, float wavelength, const SurfacePoint &sp, const Vec3f &wo, const RayDivision &ray_division, const PixelSamplingData &pixel_sampling_data) const;
 		/*! Like previous but for only one random light source for a given surface point */
@@ -82,6 +94,7 @@ class MonteCarloIntegrator: public TiledIntegrator
 		std::pair<Rgb, float> glossyReflect(RandomGenerator &random_generator, std::vector<int> &correlative_sample_number, int ray_level, bool chromatic_enabled, float wavelength, const Ray &ray, const SurfacePoint &sp, BsdfFlags bsdfs, int additional_depth, const PixelSamplingData &pixel_sampling_data, const RayDivision &ray_division_new, const Rgb &reflect_color, float w, const Vec3f &dir);
 
 		static constexpr inline int loffs_delta_ = 4567; //just some number to have different sequences per light...and it's a prime even...
+		std::unique_ptr<const LightTree> light_tree_;
 };
 
 } //namespace yafaray
@@ -109,14 +109,12 @@ class SppmIntegrator final : public MonteCarloIntegrator
 		float initial_factor_{1.f}; //!< used to time the initial radius
 		uint64_t totaln_photons_{0}; //!< amount of total photons that have been emited, used to normalize photon energy
 		bool b_hashgrid_{false}; //!< flag to choose using hashgrid or not.
-		Halton hal_1_{2, 0}, hal_2_{3, 0}, hal_3_{5, 0}, hal_4_{7, 0}; //!< halton sequence to do
 		std::vector<HitPoint> hit_points_; //!< per-pixel refine data
 		unsigned int n_refined_; //!< Debug info: Refined pixel per pass
 		int n_max_gathered_ = 0; //!< Just for statistical information about max number of gathered photons
 		std::unique_ptr<PhotonMap> caustic_map_;
 		std::unique_ptr<PhotonMap> diffuse_map_;
 		static constexpr inline int n_max_gather_ = 1000; //!< used to gather all the photon in the radius. FIXME seems could get a better way to do that
-		std::mutex mutex_;
 };
 
 } //namespace yafaray
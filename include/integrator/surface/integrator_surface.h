@@ -48,7 +48,6 @@ struct RayDivision;
 class Scene;
 class ImageFilm;
 class Accelerator;
-class FastRandom;
 class Light;
 struct EdgeToonParams;
 struct AaNoiseParams;
@@ -127,7 +126,6 @@ class SurfaceIntegrator
 		const Background *background_{nullptr};
 		const Accelerator *accelerator_{nullptr};
 		const AaNoiseParams *aa_noise_params_{nullptr};
-		FastRandom fast_random_;
 
 	private:
 		std::map<std::string, const Light *> getFilteredLights(const Scene &scene, const std::string &light_filter_string) const;
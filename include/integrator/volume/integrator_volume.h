@@ -40,7 +40,6 @@ class VolumeRegion;
 class Scene;
 class ImageFilm;
 class Accelerator;
-class FastRandom;
 class SurfaceIntegrator;
 
 class VolumeIntegrator
@@ -42,6 +42,7 @@ typedef Vec<float, 3> Vec3f;
 template <typename T, size_t N> class Point;
 typedef Point<float, 3> Point3f;
 struct LSample;
+struct LightBounds;
 
 class Light
 {
@@ -95,6 +96,8 @@ class Light
 		//! get the pdf values for sampling point sp on the light and outgoing direction wo when emitting energy (emitSample, NOT illumSample)
 		/*! sp should've been generated from illumSample or emitSample, and may only be complete enough to call light functions! */
 		[[nodiscard]] virtual std::array<float, 3> emitPdf(const Vec3f &surface_n, const Vec3f &wo) const { return {0.f, 0.f, 0.f}; }
+		//! spatial and directional bounds of the light emission, used by the light tree. Returns false for lights without finite bounds (background, sun, etc)
+		[[nodiscard]] virtual std::pair<bool, LightBounds> getBounds() const;
 		//! (preferred) number of samples for direct lighting
 		[[nodiscard]] virtual int nSamples() const { return 8; }
 		//! Check whether the light is enabled
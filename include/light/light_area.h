@@ -68,6 +68,7 @@ class AreaLight final : public Light
 		float illumPdf(const Point3f &surface_p, const Point3f &light_p, const Vec3f &light_ng) const override;
 		std::array<float, 3> emitPdf(const Vec3f &surface_n, const Vec3f &wo) const override;
 		int nSamples() const override { return params_.samples_; }
+		std::pair<bool, LightBounds> getBounds() const override;
 
 		const ShapePolygon<float, 4> area_quad_{{params_.corner_, params_.point_1_, params_.point_1_ + params_.point_2_ - params_.corner_, params_.point_2_}};
 		const Vec3f to_x_{params_.point_1_ - params_.corner_};
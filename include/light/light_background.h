@@ -28,7 +28,7 @@
 namespace yafaray {
 
 class Background;
-class Pdf1D;
+class Pdf2D;
 class Scene;
 class ParamMap;
 
@@ -72,13 +72,10 @@ class BackgroundLight final : public Light
 		std::pair<float, Uv<float>> calcFromDir(const Vec3f &dir, bool inv) const;
 		static float calcPdf(float p_0, float p_1, float s);
 		static float calcInvPdf(float p_0, float p_1, float s);
-		static constexpr inline float addOff(float v);
-		static int clampSample(int s, int m);
 		static float clampZero(float val);
 		static float sinSample(float s);
 
-		std::vector<std::unique_ptr<Pdf1D>> u_dist_;
-		std::unique_ptr<Pdf1D> v_dist_;
+		std::unique_ptr<Pdf2D> dist_;
 		const Background *background_{nullptr};
 		Point3f world_center_;
 		float world_radius_;
@@ -89,7 +86,6 @@ class BackgroundLight final : public Light
 		static constexpr inline int max_usamples_ = 720;
 		static constexpr inline int min_samples_ = 16;
 
-		static constexpr inline float smpl_off_ = 0.4999f;
 		static constexpr inline float sigma_ = 0.000001f;
 };
 
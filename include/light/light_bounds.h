@@ -0,0 +1,131 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_LIGHT_BOUNDS_H
+#define LIBYAFARAY_LIGHT_BOUNDS_H
+
+#include "geometry/bound.h"
+#include "geometry/vector.h"
+
+namespace yafaray {
+
+/*! Spatial and directional bounds of the emission of one light or of a group of lights.
+ * The emission is bounded by a box, a cone of normals around axis_ with half-angle theta_o and
+ * an additional spread theta_e around those normals in which light is emitted. Used to build
+ * the light tree and to estimate the contribution of a group of lights to a given point. */
+struct LightBounds
+{
+	[[nodiscard]] float importance(const Point3f &p, const Vec3f &n) const;
+	[[nodiscard]] Point3f centroid() const { return (bound_.a_ + bound_.g_) * 0.5f; }
+	static LightBounds join(const LightBounds &a, const LightBounds &b);
+
+	Bound<float> bound_;
+	Vec3f axis_{{0.f, 0.f, 1.f}}; //!< main emission direction
+	float phi_{0.f}; //!< emitted power
+	float cos_theta_o_{-1.f}; //!< cosine of the half-angle of the cone of emitting normals around the axis
+	float cos_theta_e_{0.f}; //!< cosine of the angle beyond theta_o in which light is still emitted
+	bool two_sided_{false};
+};
+
+inline float LightBounds::importance(const Point3f &p, const Vec3f &n) const
+{
+	//Returns cos(a - b) and sin(a - b) for the angles given by their sines and cosines, clamped to zero angle if a < b
+	const auto cos_sub_clamped{[](float sin_a, float cos_a, float sin_b, float cos_b) { return (cos_a > cos_b) ? 1.f : cos_a * cos_b + sin_a * sin_b; }};
+	const auto sin_sub_clamped{[](float sin_a, float cos_a, float sin_b, float cos_b) { return (cos_a > cos_b) ? 0.f : sin_a * cos_b - cos_a * sin_b; }};
+	const auto safe_sin{[](float cos_x) { return math::sqrt(std::max(0.f, 1.f - cos_x * cos_x)); }};
+
+	const Point3f center{centroid()};
+	Vec3f wi{p - center};
+	const float dist_squared{wi.lengthSquared()};
+	const float half_diagonal_length{(bound_.g_ - bound_.a_).length() * 0.5f};
+	const float dist_squared_clamped{std::max({dist_squared, half_diagonal_length, 1.0e-6f})};
+	if(dist_squared > 0.f) wi *= 1.f / math::sqrt(dist_squared);
+	else wi = axis_;
+
+	float cos_theta_w{axis_ * wi};
+	if(two_sided_) cos_theta_w = std::abs(cos_theta_w);
+	const float sin_theta_w{safe_sin(cos_theta_w)};
+
+	//Directions subtended by the bounding sphere of the bound as seen from p
+	const float radius_squared{half_diagonal_length * half_diagonal_length};
+	const float cos_theta_b{(dist_squared < radius_squared) ? -1.f : safe_sin(math::sqrt(radius_squared / dist_squared))};
+	const float sin_theta_b{safe_sin(cos_theta_b)};
+
+	const float sin_theta_o{safe_sin(cos_theta_o_)};
+	const float cos_theta_x{cos_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o_)};
+	const float sin_theta_x{sin_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o_)};
+	const float cos_theta_p{cos_sub_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b)};
+	if(cos_theta_p <= cos_theta_e_) return 0.f;
+
+	float result{phi_ * cos_theta_p / dist_squared_clamped};
+	if(n.lengthSquared() > 0.f)
+	{
+		const float cos_theta_i{std::abs(wi * n)};
+		const float sin_theta_i{safe_sin(cos_theta_i)};
+		result *= cos_sub_clamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+	}
+	return std::max(result, 0.f);
+}
+
+inline LightBounds LightBounds::join(const LightBounds &a, const LightBounds &b)
+{
+	if(a.phi_ <= 0.f) return b;
+	else if(b.phi_ <= 0.f) return a;
+	LightBounds result;
+	result.bound_ = Bound<float>{a.bound_, b.bound_};
+	result.phi_ = a.phi_ + b.phi_;
+	result.cos_theta_e_ = std::min(a.cos_theta_e_, b.cos_theta_e_);
+	result.two_sided_ = a.two_sided_ || b.two_sided_;
+
+	//Union of the two cones of normals
+	const float theta_a{math::acos(math::clamp(a.cos_theta_o_, -1.f, 1.f))};
+	const float theta_b{math::acos(math::clamp(b.cos_theta_o_, -1.f, 1.f))};
+	const float theta_d{math::acos(math::clamp(a.axis_ * b.axis_, -1.f, 1.f))};
+	if(std::min(theta_d + theta_b, math::num_pi<>) <= theta_a)
+	{
+		result.axis_ = a.axis_;
+		result.cos_theta_o_ = a.cos_theta_o_;
+		return result;
+	}
+	else if(std::min(theta_d + theta_a, math::num_pi<>) <= theta_b)
+	{
+		result.axis_ = b.axis_;
+		result.cos_theta_o_ = b.cos_theta_o_;
+		return result;
+	}
+	const float theta_o{0.5f * (theta_a + theta_d + theta_b)};
+	Vec3f rotation_axis{a.axis_ ^ b.axis_};
+	if(theta_o >= math::num_pi<> || rotation_axis.lengthSquared() == 0.f)
+	{
+		result.axis_ = a.axis_;
+		result.cos_theta_o_ = -1.f;
+		return result;
+	}
+	//Rotate the axis of cone a towards the axis of cone b (Rodrigues rotation formula)
+	rotation_axis.normalize();
+	const float theta_r{theta_o - theta_a};
+	const float cos_theta_r{math::cos(theta_r)};
+	result.axis_ = (a.axis_ * cos_theta_r + (rotation_axis ^ a.axis_) * math::sin(theta_r) + rotation_axis * ((rotation_axis * a.axis_) * (1.f - cos_theta_r))).normalized();
+	result.cos_theta_o_ = math::cos(theta_o);
+	return result;
+}
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_LIGHT_BOUNDS_H
@@ -67,6 +67,7 @@ class IesLight final : public Light
 		std::tuple<Ray, float, Rgb> emitPhoton(float s_1, float s_2, float s_3, float s_4, float time) const override;
 		std::pair<Vec3f, Rgb> emitSample(LSample &s, float time) const override;
 		std::array<float, 3> emitPdf(const Vec3f &surface_n, const Vec3f &wo) const override;
+		std::pair<bool, LightBounds> getBounds() const override;
 		bool isIesOk() const { return ies_ok_; };
 		[[nodiscard]] static Uv<float> getAngles(const Vec3f &dir, float costheta);
 
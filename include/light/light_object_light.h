@@ -73,6 +73,7 @@ class ObjectLight final : public Light
 		std::tuple<bool, float, Rgb> intersect(const Ray &ray, float &t) const override;
 		float illumPdf(const Point3f &surface_p, const Point3f &light_p, const Vec3f &light_ng) const override;
 		std::array<float, 3> emitPdf(const Vec3f &surface_n, const Vec3f &wi) const override;
+		std::pair<bool, LightBounds> getBounds() const override;
 		void initIs();
 		std::pair<Point3f, Vec3f> sampleSurface(float s_1, float s_2, float time) const;
 
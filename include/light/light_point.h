@@ -60,6 +60,7 @@ class PointLight final : public Light
 		std::pair<bool, Ray> illumSample(const Point3f &surface_p, LSample &s, float time) const override;
 		std::tuple<bool, Ray, Rgb> illuminate(const Point3f &surface_p, float time) const override;
 		std::array<float, 3> emitPdf(const Vec3f &, const Vec3f &wo) const override;
+		std::pair<bool, LightBounds> getBounds() const override;
 
 		const Rgb color_{params_.color_ * params_.power_};
 };
@@ -75,6 +75,7 @@ class SphereLight final : public Light
 		float illumPdf(const Point3f &surface_p, const Point3f &light_p, const Vec3f &light_ng) const override;
 		std::array<float, 3> emitPdf(const Vec3f &surface_n, const Vec3f &wo) const override;
 		int nSamples() const override { return params_.samples_; }
+		std::pair<bool, LightBounds> getBounds() const override;
 		static std::pair<bool, Uv<float>> sphereIntersect(const Point3f &from, const Vec3f &dir, const Point3f &c, float r_2);
 
 		const float square_radius_{params_.radius_ * params_.radius_};
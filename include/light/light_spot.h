@@ -67,6 +67,7 @@ class SpotLight final : public Light
 		bool canIntersect() const override { return params_.soft_shadows_; }
 		std::tuple<bool, float, Rgb> intersect(const Ray &ray, float &t) const override;
 		int nSamples() const override { return params_.samples_; };
+		std::pair<bool, LightBounds> getBounds() const override;
 
 		const Vec3f ndir_{(params_.from_ - params_.to_).normalize()}; //!< negative orientation (-dir)
 		const Vec3f dir_{-ndir_}; //!< orientation of the spot cone
@@ -0,0 +1,66 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_LIGHT_TREE_H
+#define LIBYAFARAY_LIGHT_TREE_H
+
+#include "light/light_bounds.h"
+#include <vector>
+
+namespace yafaray {
+
+class Light;
+
+/*! Bounding volume hierarchy over the lights, used to pick one light for direct lighting with
+ * a probability proportional to its estimated contribution to the shading point instead of uniformly.
+ * Lights without bounds (background, sun, directional, etc) are kept aside and picked uniformly. */
+class LightTree final
+{
+	public:
+		explicit LightTree(const std::vector<const Light *> &lights);
+		/*! Picks one light for the shading point p with normal n (or a zero normal for points in volumes)
+		 * using the sample u in [0, 1). Returns the index of the light in the list used to build the tree
+		 * and the probability of picking it, or a zero probability if no light can illuminate the point */
+		[[nodiscard]] std::pair<size_t, float> sample(const Point3f &p, const Vec3f &n, float u) const;
+		[[nodiscard]] size_t numNodes() const { return nodes_.size(); }
+		[[nodiscard]] size_t numUnboundedLights() const { return unbounded_lights_.size(); }
+
+	private:
+		struct Node
+		{
+			LightBounds bounds_;
+			size_t index_; //!< light index for leaf nodes, index of the second child for interior nodes (the first child follows the node)
+			bool leaf_;
+		};
+		struct BuildLight
+		{
+			size_t light_index_;
+			LightBounds bounds_;
+		};
+		void buildRecursive(std::vector<BuildLight>::iterator begin, std::vector<BuildLight>::iterator end);
+		static float cost(const LightBounds &bounds, const Bound<float> &parent_bound, Axis axis);
+
+		static constexpr inline int num_buckets_ = 12;
+		std::vector<Node> nodes_;
+		std::vector<size_t> unbounded_lights_;
+};
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_LIGHT_TREE_H
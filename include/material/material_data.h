@@ -21,6 +21,7 @@
 #define LIBYAFARAY_MATERIAL_DATA_H
 
 #include "material/bsdf.h"
+#include "common/memory_arena.h"
 
 namespace yafaray {
 
@@ -31,6 +32,8 @@ class MaterialData
 		MaterialData(BsdfFlags bsdf_flags, NodeTreeData node_tree_data) : bsdf_flags_(bsdf_flags), node_tree_data_{std::move(node_tree_data)} { }
 		virtual ~MaterialData() = default;
 		virtual std::unique_ptr<MaterialData> clone() const = 0;
+		static void *operator new(size_t size) { return ThreadMemoryArena::allocate(size); } //!< Allocated from the thread arena when rendering a sample
+		static void operator delete(void *pointer) { ThreadMemoryArena::deallocate(pointer); }
 		BsdfFlags bsdf_flags_;
 		NodeTreeData node_tree_data_;
 };
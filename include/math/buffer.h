@@ -40,8 +40,10 @@ class Buffer //! Generic num_dimensions-dimensional buffer. Unrolled starting fr
 		constexpr T &operator()(const std::array<int, num_dimensions> &coordinates) noexcept { return data_[calculateDataPosition(coordinates)]; }
 		constexpr const T &operator()(const std::array<int, num_dimensions> &coordinates) const noexcept { return data_[calculateDataPosition(coordinates)]; }
 		constexpr const std::array<int, num_dimensions> &getDimensions() const noexcept { return dimensions_; }
+		const T *data() const noexcept { return data_.data(); }
+		T *data() noexcept { return data_.data(); }
 
-	private:
+	protected:
 		constexpr size_t calculateDataPosition(const std::array<int, num_dimensions> &coordinates) const noexcept;
 		alignas(8) std::array<int, num_dimensions> dimensions_;
 		alignas(8) std::vector<T> data_;
@@ -24,24 +24,70 @@
 
 #include "math/buffer.h"
 #include "geometry/vector.h"
+#include "common/enum.h"
+#include "common/enum_map.h"
+#include <algorithm>
 
 namespace yafaray {
 
+struct BufferLayout : public Enum<BufferLayout>
+{
+	using Enum::Enum;
+	enum : ValueType_t { ColumnMajor, RowMajor, Tiled };
+	inline static const EnumMap<ValueType_t> map_{{
+			{"column_major", ColumnMajor, "Pixels stored column by column (x * height + y)"},
+			{"row_major", RowMajor, "Pixels stored row by row (y * width + x), contiguous when walking x in the inner loop"},
+			{"tiled", Tiled, "Pixels stored in 16x16 blocks, each block row-major, so a render tile stays cache resident"},
+		}};
+};
+
 template <typename T>
 class Buffer2D final : public Buffer<T, 2>
 {
 	public:
-		explicit Buffer2D(const Size2i &size) : Buffer<T, 2>{size.getArray()} { }
-		void set(const Point2i &point, const T &val) { Buffer<T, 2>::set(point.getArray(), val); }
-		void set(const Point2i &point, T &&val) { Buffer<T, 2>::set(point.getArray(), std::move(val)); }
-		T get(const Point2i &point) const { return Buffer<T, 2>::get(point.getArray()); }
-		T &operator()(const Point2i &point) { return Buffer<T, 2>::operator()(point.getArray()); }
-		const T &operator()(const Point2i &point) const { return Buffer<T, 2>::operator()(point.getArray()); }
+		explicit Buffer2D(const Size2i &size, BufferLayout layout = BufferLayout::ColumnMajor) : Buffer<T, 2>{size.getArray()}, layout_{layout} { }
+		void set(const Point2i &point, const T &val) { this->data_[calculateDataPosition(point)] = val; }
+		void set(const Point2i &point, T &&val) { this->data_[calculateDataPosition(point)] = std::move(val); }
+		T get(const Point2i &point) const { return this->data_[calculateDataPosition(point)]; }
+		T &operator()(const Point2i &point) { return this->data_[calculateDataPosition(point)]; }
+		const T &operator()(const Point2i &point) const { return this->data_[calculateDataPosition(point)]; }
 		void clear() { Buffer<T, 2>::zero(); }
 		int getWidth() const { return static_cast<int>(Buffer<T, 2>::getDimensions().at(0)); }
 		int getHeight() const { return static_cast<int>(Buffer<T, 2>::getDimensions().at(1)); }
+		BufferLayout getLayout() const { return layout_; }
+
+	private:
+		size_t calculateDataPosition(const Point2i &point) const;
+		static constexpr inline int tile_size_log_2_ = 4; //!< Tiled layout uses blocks of 16x16 pixels
+		static constexpr inline int tile_size_ = 1 << tile_size_log_2_;
+		BufferLayout layout_{BufferLayout::ColumnMajor};
 };
 
+template<typename T>
+inline size_t Buffer2D<T>::calculateDataPosition(const Point2i &point) const
+{
+	const int x{point[Axis::X]};
+	const int y{point[Axis::Y]};
+	const int width{this->dimensions_[0]};
+	const int height{this->dimensions_[1]};
+	switch(layout_.value())
+	{
+		case BufferLayout::RowMajor: return static_cast<size_t>(y) * width + x;
+		case BufferLayout::Tiled:
+		{
+			//Blocks are stored one after the other, block rows from top to bottom. Blocks in the right and bottom borders are narrower/shorter so no padding is needed
+			const int tile_x{x >> tile_size_log_2_};
+			const int tile_y{y >> tile_size_log_2_};
+			const int tile_width{std::min(tile_size_, width - (tile_x << tile_size_log_2_))};
+			const int tile_height{std::min(tile_size_, height - (tile_y << tile_size_log_2_))};
+			const size_t tile_row_start{static_cast<size_t>(tile_y << tile_size_log_2_) * width};
+			const size_t tile_start{tile_row_start + static_cast<size_t>(tile_x << tile_size_log_2_) * tile_height};
+			return tile_start + static_cast<size_t>(y & (tile_size_ - 1)) * tile_width + (x & (tile_size_ - 1));
+		}
+		default: return static_cast<size_t>(x) * height + y;
+	}
+}
+
 } //namespace yafaray
 
 #endif //LIBYAFARAY_BUFFER_2D_H
@@ -92,6 +92,16 @@ inline constexpr std::array<X, 3> bezierCalculateFactors(const X &x) noexcept
 	return { x_reversed * x_reversed, 2 * x * x_reversed, x * x };
 }
 
+//! Control points of the part of the quadratic bezier curve between x_start and x_end, obtained by blossoming. That part of the curve lies inside their convex hull
+template<typename Y, typename X>
+inline constexpr std::array<Y, 3> bezierSubdivide(const std::array<Y, 3> &y, const X &x_start, const X &x_end) noexcept
+{
+	const X x_start_reversed { 1 - x_start };
+	const X x_end_reversed { 1 - x_end };
+	const std::array<X, 3> middle_factors { x_start_reversed * x_end_reversed, x_start_reversed * x_end + x_start * x_end_reversed, x_start * x_end };
+	return { bezierInterpolate<Y, X>(y, bezierCalculateFactors<X>(x_start)), bezierInterpolate<Y, X>(y, middle_factors), bezierInterpolate<Y, X>(y, bezierCalculateFactors<X>(x_end)) };
+}
+
 template<typename Y, typename X>
 inline constexpr Y bezierInterpolateTruncated(const std::array<Y, 3> &y, const X &x) noexcept
 {
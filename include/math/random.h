@@ -23,15 +23,15 @@
 #define YAFARAY_RANDOM_H
 
 #include "math/math.h"
-#include <atomic>
 
 namespace yafaray {
 
+//! Random number generators do not use any synchronization, each thread (and each pixel, for reproducibility) must own its own generator
 class FastRandom final
 {
 	public:
 		constexpr FastRandom() noexcept = default;
-		FastRandom(int seed) noexcept { myseed_ = seed; }
+		explicit constexpr FastRandom(int seed) noexcept : myseed_(seed) { }
 		constexpr FastRandom(const FastRandom &fast_random) noexcept = delete; //Avoid mistakenly passing the fast_random objects by value instead of passing them by reference
 		int getNextInt() noexcept;
 		int getNextInt(int &seed) noexcept;
@@ -39,7 +39,7 @@ class FastRandom final
 		float getNextFloatNormalized(int &seed) noexcept;
 
 	private:
-		std::atomic<int> myseed_ = 123212;
+		int myseed_ = 123212;
 		static constexpr inline int a_ = 0x000041A7;
 		static constexpr inline int m_ = 0x7FFFFFFF;
 		static constexpr inline int q_ = 0x0001F31D; // m/a
@@ -63,8 +63,9 @@ class RandomGenerator final
 		explicit constexpr RandomGenerator(unsigned int seed) noexcept : c_(seed) { }
 		constexpr RandomGenerator(const RandomGenerator &random_generator) noexcept = delete; //Avoid mistakenly passing the random_generator objects by value instead of passing them by reference
 		double operator()() noexcept;
+		static constexpr unsigned int seed(unsigned int a, unsigned int b, unsigned int c) noexcept; //!< Well mixed seed from several values (for example pixel coordinates and sampling offset), so neighbour pixels or threads get uncorrelated sequences
 	protected:
-		std::atomic<unsigned int> x_ = 30903, c_ = 0;
+		unsigned int x_ = 30903, c_ = 0;
 		static constexpr inline unsigned int y_a_ = 1791398085;
 		static constexpr inline unsigned int y_ah_ = (y_a_ >> 16);
 		static constexpr inline unsigned int y_al_ = y_a_ & 65535;
@@ -88,8 +89,8 @@ inline float FastRandom::getNextFloatNormalized() noexcept
 inline int FastRandom::getNextInt(int &seed) noexcept
 {
 	seed = a_ * (seed % q_) - r_ * (seed / q_);
-	if(myseed_ < 0)
-		myseed_ += m_;
+	if(seed < 0)
+		seed += m_;
 	return seed;
 }
 
@@ -107,6 +108,22 @@ inline double RandomGenerator::operator()() noexcept
 	return static_cast<double>(x_) * math::sample_mult_ratio<double>;
 }
 
+inline constexpr unsigned int RandomGenerator::seed(unsigned int a, unsigned int b, unsigned int c) noexcept
+{
+	//Murmur3 style hash finalizer applied to each of the combined values
+	unsigned int h = 0x9E3779B9;
+	for(unsigned int v : {a, b, c})
+	{
+		h ^= v;
+		h ^= h >> 16;
+		h *= 0x85EBCA6B;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35;
+		h ^= h >> 16;
+	}
+	return h;
+}
+
 
 } //namespace yafaray
 
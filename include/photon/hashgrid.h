@@ -21,7 +21,6 @@
 #define YAFARAY_HASHGRID_H
 
 #include "geometry/bound.h"
-#include <list>
 #include <vector>
 
 namespace yafaray {
@@ -32,7 +31,9 @@ template<typename T> class Bound;
 template <typename T, size_t N> class Point;
 typedef Point<float, 3> Point3f;
 
-
+/*! Photon hash grid stored in a flat, counting sorted layout: the photons of each hash cell are contiguous in
+ * photon_indices_, delimited by cell_offsets_, and their positions are copied in the same order to separate x, y, z
+ * arrays so the distance tests of gather run over contiguous memory and can be vectorized by the compiler */
 class HashGrid final
 {
 	public:
@@ -40,7 +41,7 @@ class HashGrid final
 		HashGrid(double cell_size, unsigned int grid_size, Bound<float> b_box);
 		void setParm(double cell_size, unsigned int grid_size, Bound<float> b_box);
 		void clear(); //remove all the photons in the grid;
-		void updateGrid(); //build the hashgrid
+		void updateGrid(int num_threads = 1); //build the hashgrid
 		void pushPhoton(Photon &&p);
 		unsigned int gather(const Point3f &p, FoundPhoton *found, unsigned int k, float sq_radius) const;
 
@@ -49,13 +50,18 @@ class HashGrid final
 		{
 			return static_cast<unsigned int>((ix * 73856093) ^ (iy * 19349663) ^ (iz * 83492791)) % grid_size_;
 		}
+		template <typename Function> static void parallelFor(size_t num_items, int num_threads, const Function &function);
 
 	public:
 		double cell_size_, inv_cell_size_;
 		unsigned int grid_size_;
 		Bound<float> bounding_box_;
 		std::vector<Photon>photons_;
-		std::unique_ptr<std::unique_ptr<std::list<const Photon *>>[]> hash_grid_;
+
+	private:
+		std::vector<unsigned int> cell_offsets_; //!< first sorted photon of each hash cell, with an extra item at the end
+		std::vector<unsigned int> photon_indices_; //!< indices of the photons sorted by hash cell
+		std::vector<float> pos_x_, pos_y_, pos_z_; //!< positions of the photons sorted by hash cell
 };
 
 } //namespace yafaray
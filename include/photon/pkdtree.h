@@ -23,9 +23,9 @@
 #include "common/logger.h"
 #include "geometry/bound.h"
 #include "render/render_control.h"
+#include "common/thread_pool.h"
 #include <vector>
 #include <cstdlib>
-#include <thread>
 
 namespace yafaray {
 
@@ -96,7 +96,7 @@ class PointKdTree
 		KdNode<T> *nodes_;
 		uint32_t n_elements_, next_free_node_;
 		Bound<float> tree_bound_;
-		int max_level_threads_ = 0;  //max level where we will launch threads. We will try to launch at least as many threads as scene threads parameter
+		int max_level_threads_ = 0;  //max level where we will submit parallel subtree tasks. We will try to create at least as many tasks as scene threads parameter
 		static constexpr inline unsigned int kd_max_stack_ = 64;
 		std::mutex mutx_;
 };
@@ -123,10 +123,10 @@ PointKdTree<T>::PointKdTree(Logger &logger, const RenderMonitor &render_monitor,
 
 	for(uint32_t i = 1; i < n_elements_; ++i) tree_bound_.include(dat[i].pos_);
 
-	max_level_threads_ = (int) std::ceil(math::log2((float) num_threads)); //in how many pkdtree levels we will spawn threads, so we create at least as many threads as scene threads parameter (or more)
-	int real_threads = static_cast<int>(math::pow(2.f, max_level_threads_)); //real amount of threads we will create during pkdtree creation depending on the maximum level where we will generate threads
+	max_level_threads_ = (int) std::ceil(math::log2((float) num_threads)); //in how many pkdtree levels we will submit parallel tasks, so we create at least as many tasks as scene threads parameter (or more)
+	int real_threads = static_cast<int>(math::pow(2.f, max_level_threads_)); //real amount of subtree tasks we will create during pkdtree creation depending on the maximum level where we will generate tasks
 
-	logger.logInfo("pointKdTree: Starting ", map_name, " recusive tree build for ", n_elements_, " elements [using ", real_threads, " threads]");
+	logger.logInfo("pointKdTree: Starting ", map_name, " recusive tree build for ", n_elements_, " elements [using ", real_threads, " parallel tasks]");
 
 	buildTree(0, n_elements_, tree_bound_, elements.get());
 
@@ -163,20 +163,20 @@ void PointKdTree<T>::buildTreeWorker(uint32_t start, uint32_t end, Bound<float>
 	bound_l.setAxisMax(split_axis, split_pos);
 	bound_r.setAxisMin(split_axis, split_pos);
 
-	if(level <= max_level_threads_)   //launch threads for the first "x" levels to try to match (at least) the scene threads parameter
+	if(level <= max_level_threads_)   //submit the below child to the thread pool for the first "x" levels to try to match (at least) the scene threads parameter, building the above child in the current thread
 	{
 		//<< recurse below child >>
 		uint32_t next_free_node_1 = 0;
 		auto *nodes_1 = (KdNode<T> *) malloc(4 * (split_el - start) * sizeof(KdNode<T>));
-		auto below_worker = std::thread( &PointKdTree<T>::buildTreeWorker, this, start, split_el, std::ref(bound_l), prims, level, std::ref(next_free_node_1), nodes_1 );
+		TaskGroup below_task;
+		below_task.run([&, level] { buildTreeWorker(start, split_el, bound_l, prims, level, next_free_node_1, nodes_1); });
 
 		//<< recurse above child >>
 		uint32_t next_free_node_2 = 0;
 		auto *nodes_2 = (KdNode<T> *) malloc(4 * (end - split_el) * sizeof(KdNode<T>));
-		auto above_worker = std::thread( &PointKdTree<T>::buildTreeWorker, this, split_el, end, std::ref(bound_r), prims, level, std::ref(next_free_node_2), nodes_2 );
+		buildTreeWorker(split_el, end, bound_r, prims, level, next_free_node_2, nodes_2);
 
-		below_worker.join();
-		above_worker.join();
+		below_task.wait();
 
 		if(nodes_1)
 		{
@@ -209,7 +209,7 @@ void PointKdTree<T>::buildTreeWorker(uint32_t start, uint32_t end, Bound<float>
 		local_nodes[cur_node].setRightChild(local_next_free_node + next_free_node_1);
 		local_next_free_node = local_next_free_node + next_free_node_1 + next_free_node_2;
 	}
-	else  //for the rest of the levels in the tree, don't launch more threads, do normal "sequential" operation
+	else  //for the rest of the levels in the tree, don't submit more tasks, do normal "sequential" operation
 	{
 		//<< recurse below child >>
 		buildTreeWorker(start, split_el, bound_l, prims, level, local_next_free_node, local_nodes);
@@ -74,6 +74,17 @@ typedef enum
 typedef void (*yafaray_FilmNotifyLayerCallback)(const char *internal_layer_name, const char *exported_layer_name, int width, int height, int exported_channels, void *callback_data);
 typedef void (*yafaray_FilmPutPixelCallback)(const char *layer_name, int x, int y, float r, float g, float b, float a, void *callback_data);
 typedef void (*yafaray_FilmFlushAreaCallback)(int area_id, int x_0, int y_0, int x_1, int y_1, void *callback_data);
+/* Read-only view of the float pixels of an exported film layer. "data" points to the first pixel of the region described, each pixel has "num_channels" consecutive floats and each row starts "row_stride" floats after the previous one */
+typedef struct
+{
+	const char *layer_name;
+	const char *exported_image_name;
+	const float *data;
+	int num_channels;
+	int row_stride;
+} yafaray_FilmLayerBuffer;
+/* Called once for each finished area with all the exported layers, instead of once per pixel and layer as the put pixel callback. The buffers are only valid during the call */
+typedef void (*yafaray_FilmPutAreaCallback)(int area_id, int x_0, int y_0, int x_1, int y_1, const yafaray_FilmLayerBuffer *layer_buffers, int num_layers, void *callback_data);
 typedef void (*yafaray_FilmFlushCallback)(void *callback_data);
 typedef void (*yafaray_FilmHighlightAreaCallback)(int area_id, int x_0, int y_0, int x_1, int y_1, void *callback_data);
 typedef void (*yafaray_FilmHighlightPixelCallback)(int x, int y, float r, float g, float b, float a, void *callback_data);
@@ -103,6 +114,9 @@ YAFARAY_C_API_EXPORT void yafaray_cancelRendering(yafaray_RenderControl *render_
 /* Render Monitor functions */
 YAFARAY_C_API_EXPORT yafaray_RenderMonitor *yafaray_createRenderMonitor(yafaray_ProgressBarCallback monitor_callback, void *callback_data, yafaray_DisplayConsole progress_bar_display_console);
 YAFARAY_C_API_EXPORT void yafaray_destroyRenderMonitor(yafaray_RenderMonitor *render_monitor);
+/* Statistics: wall time in seconds of a render monitor timer event ("prepass" for the photon maps, "pass_1", "pass_2",... for each render pass, "output" for the final flush of the outputs, "rendert" for the whole render), or a negative number if the event was not timed. The number of rays is the total traced by the library since it was loaded, as a double to be able to hold large counts in C90 */
+YAFARAY_C_API_EXPORT double yafaray_getRenderMonitorTimerTime(const yafaray_RenderMonitor *render_monitor, const char *timer_event);
+YAFARAY_C_API_EXPORT double yafaray_getNumRaysTraced();
 
 /* Parameter Map functions */
 YAFARAY_C_API_EXPORT yafaray_ParamMap *yafaray_createParamMap();
@@ -162,6 +176,9 @@ YAFARAY_C_API_EXPORT void yafaray_setNotifyLayerCallback(yafaray_Film *film, yaf
 YAFARAY_C_API_EXPORT void yafaray_setPutPixelCallback(yafaray_Film *film, yafaray_FilmPutPixelCallback callback, void *callback_data);
 YAFARAY_C_API_EXPORT void yafaray_setHighlightPixelCallback(yafaray_Film *film, yafaray_FilmHighlightPixelCallback callback, void *callback_data);
 YAFARAY_C_API_EXPORT void yafaray_setFlushAreaCallback(yafaray_Film *film, yafaray_FilmFlushAreaCallback callback, void *callback_data);
+YAFARAY_C_API_EXPORT void yafaray_setPutAreaCallback(yafaray_Film *film, yafaray_FilmPutAreaCallback callback, void *callback_data);
+/* Fills layer_buffer with a view of the whole exported image of the layer (internal layer name, for example "combined"). The exported images only exist when the film has outputs or a put area callback set before rendering. The pixels are updated while rendering, so they should be read from the flush area / flush callbacks or after the render finishes. Returns YAFARAY_BOOL_FALSE if the layer has no exported image */
+YAFARAY_C_API_EXPORT yafaray_Bool yafaray_getFilmLayerBuffer(const yafaray_Film *film, const char *layer_name, yafaray_FilmLayerBuffer *layer_buffer);
 YAFARAY_C_API_EXPORT void yafaray_setFlushCallback(yafaray_Film *film, yafaray_FilmFlushCallback callback, void *callback_data);
 YAFARAY_C_API_EXPORT void yafaray_setHighlightAreaCallback(yafaray_Film *film, yafaray_FilmHighlightAreaCallback callback, void *callback_data);
 
@@ -189,8 +206,10 @@ YAFARAY_C_API_EXPORT yafaray_Scene *yafaray_createScene(yafaray_Logger *logger,
 YAFARAY_C_API_EXPORT void yafaray_destroyScene(yafaray_Scene *scene);
 YAFARAY_C_API_EXPORT char *yafaray_getSceneName(yafaray_Scene *scene);
 YAFARAY_C_API_EXPORT void yafaray_setSceneAcceleratorParams(yafaray_Scene *scene, const yafaray_ParamMap *param_map);
+YAFARAY_C_API_EXPORT void yafaray_setSceneTextureCacheParams(yafaray_Scene *scene, const yafaray_ParamMap *param_map);
 YAFARAY_C_API_EXPORT yafaray_SceneModifiedFlags yafaray_checkAndClearSceneModifiedFlags(yafaray_Scene *scene);
 YAFARAY_C_API_EXPORT yafaray_Bool yafaray_preprocessScene(yafaray_Scene *scene, const yafaray_RenderControl *render_control, yafaray_SceneModifiedFlags scene_modified_flags);
+YAFARAY_C_API_EXPORT double yafaray_getSceneAcceleratorBuildTime(const yafaray_Scene *scene);
 YAFARAY_C_API_EXPORT yafaray_ResultFlags yafaray_getMaterialId(yafaray_Scene *scene, size_t *id_obtained, const char *name);
 YAFARAY_C_API_EXPORT yafaray_ResultFlags yafaray_createLight(yafaray_Scene *scene, const char *name, const yafaray_ParamMap *param_map);
 YAFARAY_C_API_EXPORT yafaray_ResultFlags yafaray_createTexture(yafaray_Scene *scene, const char *name, const yafaray_ParamMap *param_map);
@@ -221,6 +240,15 @@ YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addTriangleWithUv(yafaray_Scene *scene
 YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addQuad(yafaray_Scene *scene, size_t object_id, size_t a, size_t b, size_t c, size_t d, size_t material_id);
 YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addQuadWithUv(yafaray_Scene *scene, size_t object_id, size_t a, size_t b, size_t c, size_t d, size_t uv_a, size_t uv_b, size_t uv_c, size_t uv_d, size_t material_id);
 YAFARAY_C_API_EXPORT size_t yafaray_addUv(yafaray_Scene *scene, size_t object_id, double u, double v);
+/* Bulk mesh functions: whole arrays of interleaved components (x,y,z for vertices and normals, u,v for UVs) appended in a single call. The indices of the added items follow the ones already in the mesh. With motion blur, the vertices of all the time steps must be added before the faces, as the face indices must be valid in every time step */
+YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addVertices(yafaray_Scene *scene, size_t object_id, const float *positions, const float *orcos, size_t num_vertices, unsigned char time_step);
+YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addNormals(yafaray_Scene *scene, size_t object_id, const float *normals, size_t num_normals, unsigned char time_step);
+YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addUvs(yafaray_Scene *scene, size_t object_id, const float *uvs, size_t num_uvs);
+YAFARAY_C_API_EXPORT yafaray_Bool yafaray_addFaces(yafaray_Scene *scene, size_t object_id, const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id);
+/* Zero-copy mesh functions: set the number of items of the mesh and return the mesh own storage, so the caller can write the components directly into it. The buffer is valid until the next change of the same mesh data. They return NULL if the number of items is lower than the one needed by the indices of the faces already in the mesh */
+YAFARAY_C_API_EXPORT float *yafaray_getVerticesBuffer(yafaray_Scene *scene, size_t object_id, size_t num_vertices, unsigned char time_step);
+YAFARAY_C_API_EXPORT float *yafaray_getNormalsBuffer(yafaray_Scene *scene, size_t object_id, size_t num_normals, unsigned char time_step);
+YAFARAY_C_API_EXPORT float *yafaray_getUvsBuffer(yafaray_Scene *scene, size_t object_id, size_t num_uvs);
 YAFARAY_C_API_EXPORT yafaray_Bool yafaray_smoothObjectMesh(yafaray_Scene *scene, size_t object_id, double angle);
 
 /* Scene instances */
@@ -39,6 +39,9 @@
 #include "common/aa_noise_params.h"
 #include "common/mask_edge_toon_params.h"
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
 #include <atomic>
 #include <utility>
 
@@ -79,8 +82,13 @@ class ImageFilm final
 			CAUTION! This method MUST be threadsafe!
 			\return false if no area is left to be handed out, true otherwise */
 		bool nextArea(RenderArea &a);
-		/*! Indicate that all pixels inside the area have been sampled for this pass */
+		/*! Indicate that all pixels inside the area have been sampled for this pass.
+			The area samples are queued for the output stage thread, that merges them into the film and does the
+			layers conversion, callbacks and autosaving, so the render threads only wait if the queue is full.
+			CAUTION! This method MUST be threadsafe! */
 		void finishArea(RenderControl &render_control, RenderMonitor &render_monitor, const RenderArea &a);
+		/*! Waits until the output stage has processed all the finished areas. Must be called before using the film images after rendering a pass */
+		void waitForFinishedAreas();
 		/*! Output all pixels to the color output */
 		void flush(RenderControl &render_control, RenderMonitor &render_monitor, Flags flags);
 		/*! query if sample (x,y) was flagged to need more samples.
@@ -89,15 +97,16 @@ class ImageFilm final
 		bool doMoreSamples(const Point2i &point) const;
 		/*!	Add image sample; dx and dy describe the position in the pixel (x,y).
 			IMPORTANT: when a is given, all samples within a are assumed to come from the same thread!
+			They are accumulated without locks in a private buffer of the area (including the filter apron) that is merged into the film in finishArea.
 			use a=0 for contributions outside the area associated with current thread!
 		*/
 		void addSample(const Point2i &point, float dx, float dy, const RenderArea *a = nullptr, int num_sample = 0, int aa_pass_number = 0, float inv_aa_max_possible_samples = 0.1f, const ColorLayers *color_layers = nullptr);
 		/*!	Add light density sample; dx and dy describe the position in the pixel (x,y).
-			IMPORTANT: when a is given, all samples within a are assumed to come from the same thread!
-			use a=0 for contributions outside the area associated with current thread!
+			Samples are accumulated without locks in a private buffer of the thread thread_id, merged into the density image in mergeDensitySamples
 		*/
-		void addDensitySample(const Rgb &c, const Point2i &point, float dx, float dy);
-		void setDensityEstimation(bool enable);
+		void addDensitySample(const Rgb &c, const Point2i &point, float dx, float dy, int thread_id);
+		void setDensityEstimation(bool enable, int num_threads);
+		void mergeDensitySamples(); //!< Adds the per-thread density buffers to the density image. Must be called when no render threads are running, typically at the end of each pass
 		void setNumDensitySamples(int n) { num_density_samples_ = n; }
 		int getTotalPixels() const { return params_.width_ * params_.height_; };
 		int getWidth() const { return params_.width_; }
@@ -127,6 +136,8 @@ class ImageFilm final
 		void setRenderPutPixelCallback(yafaray_FilmPutPixelCallback callback, void *callback_data);
 		void setRenderHighlightPixelCallback(yafaray_FilmHighlightPixelCallback callback, void *callback_data);
 		void setRenderFlushAreaCallback(yafaray_FilmFlushAreaCallback callback, void *callback_data);
+		void setRenderPutAreaCallback(yafaray_FilmPutAreaCallback callback, void *callback_data);
+		bool getLayerBuffer(LayerDef::Type layer_type, const Point2i &start, yafaray_FilmLayerBuffer &layer_buffer) const; //!< View of the exported image of the layer starting at the film relative point start
 		void setRenderFlushCallback(yafaray_FilmFlushCallback callback, void *callback_data);
 		void setRenderHighlightAreaCallback(yafaray_FilmHighlightAreaCallback callback, void *callback_data);
 		float getMaxDepthInverse() const { return max_depth_inverse_; }
@@ -201,6 +212,7 @@ class ImageFilm final
 			PARAM_ENUM_DECL(FilterType, filter_type_, FilterType::Gauss, "filter_type", "AA filter type");
 			PARAM_DECL(int, tile_size_, 32, "tile_size", "Size of the render buckets or tiles");
 			PARAM_ENUM_DECL(ImageSplitter::TilesOrderType, tiles_order_, ImageSplitter::TilesOrderType::CentreRandom, "tiles_order", "Order of the render buckets or tiles");
+			PARAM_ENUM_DECL(BufferLayout, buffer_layout_, BufferLayout::Tiled, "buffer_layout", "Memory layout of the film, weights, flags and density buffers");
 			PARAM_ENUM_DECL(AutoSaveParams::IntervalType, images_autosave_interval_type_, AutoSaveParams::IntervalType::None, "images_autosave_interval_type", "");
 			PARAM_DECL(int, images_autosave_interval_passes_, 1, "images_autosave_interval_passes", "");
 			PARAM_DECL(float, images_autosave_interval_seconds_, 300.f, "images_autosave_interval_seconds", "");
@@ -224,6 +236,8 @@ class ImageFilm final
 			PARAM_DECL(int, aa_variance_pixels_, 0, "AA_variance_pixels", "");
 			PARAM_DECL(float , aa_clamp_samples_, 0.f, "AA_clamp_samples", "");
 			PARAM_DECL(float , aa_clamp_indirect_, 0.f, "AA_clamp_indirect", "");
+			PARAM_ENUM_DECL(AaNoiseParams::SamplerType, aa_sampler_type_, AaNoiseParams::SamplerType::Halton, "AA_sampler", "Sampler used for the pixel, time and lens samples");
+			PARAM_DECL(float , aa_confidence_, 1.96f, "AA_confidence", "Z score of the confidence interval of the per pixel error estimate in the adaptive AA (1.96 = 95%). Pixels whose estimated error is below the AA threshold get no more samples. 0 = only compare neighbour pixels");
 			PARAM_DECL(int , layer_mask_obj_index_, 0, "layer_mask_obj_index", "Object Index used for masking in/out in the Mask Render Layers");
 			PARAM_DECL(int , layer_mask_mat_index_, 0, "layer_mask_mat_index", "Material Index used for masking in/out in the Mask Render Layers");
 			PARAM_DECL(bool , layer_mask_invert, false, "layer_mask_invert", "False=mask in, True=mask out");
@@ -252,6 +266,12 @@ class ImageFilm final
 		static int roundToIntWithBias(double val); //!< Asymmetrical rounding function with a +0.5 bias
 		void defineBasicLayers();
 		void defineDependentLayers(); //!< This function generates the basic/auxiliary layers. Must be called *after* defining all render layers with the defineLayer function.
+		struct AreaAccumulator;
+		struct FinishedArea;
+		void mergeAreaAccumulator(const AreaAccumulator &area_accumulator);
+		void outputStageWorker();
+		void processFinishedArea(const FinishedArea &finished_area);
+		void callPutAreaCallback(int area_id, const Point2i &start, const Point2i &end) const; //!< start and end (exclusive) are film relative
 
 		std::string name_{"Imagefilm"};
 		int computer_node_{params_.computer_node_};
@@ -277,10 +297,57 @@ class ImageFilm final
 		static constexpr inline float filter_scale_ = 1.f / static_cast<float>(filter_table_size_);
 		alignas(16) std::array<float, filter_table_size_ * filter_table_size_> filter_table_;
 
-		std::mutex image_mutex_, out_mutex_, density_image_mutex_; // Thread mutes for shared access
+		std::mutex image_mutex_; // Thread mutex for shared access
 
-		Buffer2D<bool> flags_{{{params_.width_, params_.height_}}}; //!< flags for adaptive AA sampling;
-		Buffer2D<Gray> weights_{{{params_.width_, params_.height_}}};
+		struct AreaAccumulator //!< Samples of one render area plus the apron reached by the filter, owned by the thread rendering the area
+		{
+			AreaAccumulator(const Point2i &start, const Size2i &size, int num_layers);
+			Point2i start_;
+			Size2i size_;
+			Buffer2D<Gray> weights_;
+			std::vector<Buffer2D<Rgba>> colors_; //!< One buffer for each film image layer, in the same order as film_image_layers_
+		};
+		std::vector<std::unique_ptr<AreaAccumulator>> area_accumulators_; //!< Indexed by area id, created in nextArea and moved to the output stage queue in finishArea
+		struct FinishedArea //!< Finished area waiting in the output stage queue, with the samples accumulated by the render thread
+		{
+			RenderArea area_;
+			std::unique_ptr<AreaAccumulator> area_accumulator_;
+			RenderControl *render_control_;
+			RenderMonitor *render_monitor_;
+		};
+		//! A dedicated thread instead of thread pool tasks, so the output stage always progresses even if all the pool threads are waiting for space in the queue
+		std::thread output_stage_thread_;
+		std::mutex output_queue_mutex_;
+		std::condition_variable output_queue_not_empty_;
+		std::condition_variable output_stage_progress_; //!< Signaled each time the output stage takes an area from the queue or finishes processing it
+		std::deque<FinishedArea> output_queue_;
+		bool output_stage_busy_ = false;
+		bool output_stage_stop_ = false;
+		static constexpr inline size_t output_queue_max_size_ = 64;
+		struct DensityAccumulator //!< Split in blocks allocated the first time a sample lands on them, so each thread only stores and merges the parts of the frame it actually touched
+		{
+			explicit DensityAccumulator(const Size2i &size);
+			Rgb &pixel(const Point2i &point); //!< Point relative to the film start, allocating its block if needed
+			static constexpr inline int block_size_log_2_ = 6; //!< Blocks of 64x64 pixels
+			static constexpr inline int block_size_ = 1 << block_size_log_2_;
+			int num_blocks_x_;
+			std::vector<std::unique_ptr<Buffer2D<Rgb>>> blocks_;
+			std::vector<unsigned char> block_touched_;
+			std::vector<int> touched_blocks_; //!< Blocks written since the last merge
+			int num_samples_ = 0;
+		};
+		std::vector<std::unique_ptr<DensityAccumulator>> density_accumulators_; //!< One for each render thread
+
+		struct PixelMoments //!< Running sums of the brightness of the samples taken in a pixel, for its variance estimate
+		{
+			float sum_ = 0.f;
+			float sum_squares_ = 0.f;
+			int num_samples_ = 0;
+		};
+		Buffer2D<unsigned char> flags_{{{params_.width_, params_.height_}}, params_.buffer_layout_}; //!< flags for adaptive AA sampling, one byte per pixel so they can be written in parallel
+		Buffer2D<PixelMoments> pixel_moments_{{{params_.width_, params_.height_}}, params_.buffer_layout_}; //!< Only written for the pixel that owns each sample, which always lies inside the area being rendered, so no locking is needed
+		Buffer2D<Gray> convergence_{{{params_.width_, params_.height_}}, params_.buffer_layout_}; //!< Estimated error of each pixel relative to the AA threshold, computed in nextPass for the debug-convergence layer
+		Buffer2D<Gray> weights_{{{params_.width_, params_.height_}}, params_.buffer_layout_};
 		ImageLayers film_image_layers_;
 		ImageLayers exported_image_layers_;
 		std::unique_ptr<Buffer2D<Rgb>> density_image_; //!< storage for z-buffer channel
@@ -298,6 +365,8 @@ class ImageFilm final
 		void *highlight_pixel_callback_data_ = nullptr;
 		yafaray_FilmFlushAreaCallback flush_area_callback_ = nullptr;
 		void *flush_area_callback_data_ = nullptr;
+		yafaray_FilmPutAreaCallback put_area_callback_ = nullptr;
+		void *put_area_callback_data_ = nullptr;
 		yafaray_FilmFlushCallback flush_callback_ = nullptr;
 		void *flush_callback_data_ = nullptr;
 		yafaray_FilmHighlightAreaCallback highlight_area_callback_ = nullptr;
@@ -319,6 +388,8 @@ class ImageFilm final
 				params_.aa_variance_pixels_,
 				params_.aa_clamp_samples_,
 				params_.aa_clamp_indirect_,
+				params_.aa_sampler_type_,
+				params_.aa_confidence_,
 		};
 		const MaskParams mask_params_{
 				params_.layer_mask_obj_index_,
@@ -35,7 +35,7 @@ class Halton final
 		void setStart(unsigned int start);
 		void reset() { value_ = 0.0; }
 		float getNext();
-		static double lowDiscrepancySampling(FastRandom &fast_random, int dim, unsigned int n);
+		static double lowDiscrepancySampling(RandomGenerator &random_generator, int dim, unsigned int n);
 
 	private:
 		void setBase(int base);
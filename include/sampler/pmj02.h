@@ -0,0 +1,56 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef YAFARAY_PMJ02_H
+#define YAFARAY_PMJ02_H
+
+#include "geometry/uv.h"
+#include <cstdint>
+#include <vector>
+
+namespace yafaray {
+
+// Progressive multi-jittered (0,2) sample tables (Christensen, Kensler & Kilpatrick 2018, "Progressive Multi-Jittered Sample Sequences")
+// Every power of two prefix of a table is stratified in all the base 2 elementary intervals. The tables are generated once, on first use,
+// and each pixel uses one of them selected by its seed
+class Pmj02 final
+{
+	public:
+		static constexpr inline int num_tables_ = 16;
+		static constexpr inline int num_samples_log2_ = 10;
+		static constexpr inline int num_samples_ = 1 << num_samples_log2_;
+		[[nodiscard]] static Uv<float> sample(uint32_t index, uint32_t seed);
+
+	private:
+		explicit Pmj02(uint32_t seed);
+		[[nodiscard]] static const std::vector<Pmj02> &tables();
+		bool generate(uint32_t seed);
+		std::vector<Uv<float>> samples_;
+};
+
+inline Uv<float> Pmj02::sample(uint32_t index, uint32_t seed)
+{
+	//Beyond the table length the next table is used, so the sequence does not repeat itself for high sample counts
+	const uint32_t table = (seed + (index >> num_samples_log2_)) % num_tables_;
+	return tables()[table].samples_[index & (num_samples_ - 1)];
+}
+
+} //namespace yafaray
+
+#endif //YAFARAY_PMJ02_H
@@ -23,12 +23,74 @@
 #include "sampler/sample.h"
 #include "common/logger.h"
 #include <cstring>
+#include <tuple>
 
 namespace yafaray {
 
+/*! Walker / Vose alias table: allows taking discrete samples from a piecewise constant function
+	in constant time. The entries are given as plain ranges so several tables can be stored one
+	after another in the same array.
+*/
+class AliasTable final
+{
+	public:
+		struct Entry
+		{
+			float probability_; //!< probability of keeping this index instead of jumping to its alias
+			uint32_t alias_;
+		};
+		//! Builds the table entries for the function values and returns the sum of the values. If the sum is zero the table will sample uniformly
+		static double build(const float *function, size_t size, Entry *entries);
+		//! Returns the sampled index and the sample remapped to [0, 1) inside the chosen index, so it can be reused
+		[[nodiscard]] static std::pair<size_t, float> sample(const Entry *entries, size_t size, float u);
+};
+
+inline double AliasTable::build(const float *function, size_t size, Entry *entries)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < size; ++i) sum += static_cast<double>(function[i]);
+	for(size_t i = 0; i < size; ++i) entries[i] = {1.f, static_cast<uint32_t>(i)};
+	if(sum <= 0.0) return 0.0;
+	std::vector<double> scaled(size);
+	std::vector<uint32_t> small, large;
+	small.reserve(size);
+	large.reserve(size);
+	for(size_t i = 0; i < size; ++i)
+	{
+		scaled[i] = static_cast<double>(function[i]) * static_cast<double>(size) / sum;
+		if(scaled[i] < 1.0) small.push_back(static_cast<uint32_t>(i));
+		else large.push_back(static_cast<uint32_t>(i));
+	}
+	while(!small.empty() && !large.empty())
+	{
+		const uint32_t index_small = small.back();
+		small.pop_back();
+		const uint32_t index_large = large.back();
+		entries[index_small] = {static_cast<float>(scaled[index_small]), index_large};
+		scaled[index_large] -= 1.0 - scaled[index_small];
+		if(scaled[index_large] < 1.0)
+		{
+			large.pop_back();
+			small.push_back(index_large);
+		}
+	}
+	//Any remaining entries (due to rounding errors) keep their default probability 1
+	return sum;
+}
+
+inline std::pair<size_t, float> AliasTable::sample(const Entry *entries, size_t size, float u)
+{
+	const float scaled = std::max(u, 0.f) * static_cast<float>(size);
+	const size_t index = std::min(static_cast<size_t>(scaled), size - 1);
+	const float offset = std::min(scaled - static_cast<float>(index), 0.99999994f);
+	const Entry &entry = entries[index];
+	if(offset < entry.probability_) return {index, offset / entry.probability_};
+	else return {entry.alias_, (offset - entry.probability_) / (1.f - entry.probability_)};
+}
+
 /*! class that holds a 1D probability distribution function (pdf) and is also able to
-	take samples from it. In order to do this the cumulative distribution function (cdf)
-	is also calculated on construction.
+	take samples from it. In order to do this in constant time an alias table is built on construction.
+	Note that, unlike inverting the cdf, the mapping from the sample to the result is not monotonic.
 */
 
 class Pdf1D final
@@ -41,74 +103,46 @@ class Pdf1D final
 		[[nodiscard]] float integral() const { return integral_; }
 		[[nodiscard]] float invIntegral() const { return inv_integral_; }
 		[[nodiscard]] float function(size_t index) const { return function_[index]; }
-		[[nodiscard]] float cdf(size_t index) const { return cdf_[index]; }
 		[[nodiscard]] std::pair<float, float> sample(float u) const;
 		// take a discrete sample.
-		// determines an index in the array from which the CDF was taked from, rather than a sample in [0;1]
+		// determines an index in the array, rather than a sample in [0;1]
 		[[nodiscard]] std::pair<int, float> dSample(float u) const;
-		// Distribution1D Data
+		// take a discrete sample, also returning the sample remapped to [0;1) inside the chosen index so it can be reused
+		[[nodiscard]] std::tuple<int, float, float> dSampleReuse(float u) const;
 
 	private:
 		void init();
-		[[nodiscard]] static std::pair<float, std::vector<float>> cumulateStep1DDf(const std::vector<float> &function);
 		const std::vector<float> function_;
-		std::vector<float> cdf_;
+		std::vector<AliasTable::Entry> alias_table_;
 		float integral_, inv_integral_, inv_size_;
 };
 
 inline void Pdf1D::init()
 {
-	std::tie(integral_, cdf_) = cumulateStep1DDf(function_);
-	inv_integral_ = 1.f / integral_;
+	alias_table_.resize(function_.size());
+	const double sum = AliasTable::build(function_.data(), function_.size(), alias_table_.data());
+	integral_ = static_cast<float>(sum / static_cast<double>(function_.size()));
+	inv_integral_ = integral_ > 0.f ? 1.f / integral_ : 0.f;
 	inv_size_ = 1.f / size();
 }
 
-inline std::pair<float, std::vector<float>> Pdf1D::cumulateStep1DDf(const std::vector<float> &function)
+inline std::pair<int, float> Pdf1D::dSample(float u) const
 {
-	const size_t n_steps = function.size();
-	std::vector<float> cdf(n_steps);
-	const double delta = 1.0 / static_cast<double>(n_steps);
-	double c = 0.0;
-	for(size_t i = 0; i < n_steps; ++i)
-	{
-		c += static_cast<double>(function[i]) * delta;
-		cdf[i] = static_cast<float>(c);
-	}
-	const auto integral = static_cast<float>(c);// * delta;
-	for(auto &cdf_entry : cdf) cdf_entry /= integral;
-	return {integral, std::move(cdf)};
+	const size_t index = AliasTable::sample(alias_table_.data(), alias_table_.size(), u).first;
+	return {static_cast<int>(index), function_[index] * inv_integral_};
 }
 
-inline std::pair<int, float> Pdf1D::dSample(float u) const
+inline std::tuple<int, float, float> Pdf1D::dSampleReuse(float u) const
 {
-	int index;
-	if(u <= 0.f) index = 0;
-	else if(u >= 1.f) index = cdf_.size() - 1;
-	else
-	{
-		const auto &it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
-		index = static_cast<int>(it - cdf_.begin());
-	}
-	const float pdf = function_[index] * inv_integral_;
-	return {index, pdf};
+	const auto [index, offset]{AliasTable::sample(alias_table_.data(), alias_table_.size(), u)};
+	return {static_cast<int>(index), function_[index] * inv_integral_, offset};
 }
 
 inline std::pair<float, float> Pdf1D::sample(float u) const
 {
-	if(u <= 0.f) return {0.f, function_[0] * inv_integral_};
-	else if(u >= 1.f)
-	{
-		const int index = static_cast<int>(cdf_.size()) - 1;
-		return {static_cast<float>(index) + 1.f, function_[index] * inv_integral_};
-	}
-	else
-	{
-		const auto &it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
-		const int index = static_cast<int>(it - cdf_.begin());
-		// Return offset along current cdf segment
-		const float delta = index > 0 ? (u - cdf_[index - 1]) / (cdf_[index] - cdf_[index - 1]) : u / cdf_[index];
-		return {static_cast<float>(index) + delta, function_[index] * inv_integral_};
-	}
+	const auto [index, offset]{AliasTable::sample(alias_table_.data(), alias_table_.size(), u)};
+	// Return offset along the chosen segment
+	return {static_cast<float>(index) + offset, function_[index] * inv_integral_};
 }
 
 } //namespace yafaray
@@ -0,0 +1,98 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef YAFARAY_SAMPLE_PDF2D_H
+#define YAFARAY_SAMPLE_PDF2D_H
+
+#include "sampler/sample_pdf1d.h"
+#include "geometry/uv.h"
+
+namespace yafaray {
+
+/*! class that holds a 2D piecewise constant probability distribution function (pdf) made of rows
+	that can have different sizes, and is able to take samples from it in constant time.
+	The function values and alias tables of all the rows are stored flat, one row after another,
+	in contiguous arrays, and the row is chosen using the marginal distribution of the row integrals.
+*/
+
+class Pdf2D final
+{
+	public:
+		explicit Pdf2D(const std::vector<std::vector<float>> &rows) : marginal_{initRows(rows)} { }
+		[[nodiscard]] size_t numRows() const { return marginal_.size(); }
+		[[nodiscard]] size_t rowSize(size_t row) const { return row_offsets_[row + 1] - row_offsets_[row]; }
+		//! Continuous sample. Returns the coordinates in [0;1) and the pdfs of the u (column) and v (row) coordinates
+		[[nodiscard]] std::tuple<Uv<float>, float, float> sample(float s_u, float s_v) const;
+		//! Returns the pdfs of the u (column) and v (row) coordinates for coordinates in [0;1]
+		[[nodiscard]] std::pair<float, float> pdf(const Uv<float> &uv) const;
+
+	private:
+		std::vector<float> initRows(const std::vector<std::vector<float>> &rows);
+		[[nodiscard]] static size_t clampIndex(float coordinate, size_t size);
+		std::vector<size_t> row_offsets_;
+		std::vector<float> function_;
+		std::vector<AliasTable::Entry> alias_table_;
+		std::vector<float> row_inv_integrals_;
+		const Pdf1D marginal_; //!< Must be the last member, as it is initialized from the rows once the other members are ready
+};
+
+inline std::vector<float> Pdf2D::initRows(const std::vector<std::vector<float>> &rows)
+{
+	row_offsets_.reserve(rows.size() + 1);
+	row_offsets_.emplace_back(0);
+	for(const auto &row : rows) row_offsets_.emplace_back(row_offsets_.back() + row.size());
+	function_.reserve(row_offsets_.back());
+	for(const auto &row : rows) function_.insert(function_.end(), row.begin(), row.end());
+	alias_table_.resize(row_offsets_.back());
+	row_inv_integrals_.resize(rows.size());
+	std::vector<float> row_integrals(rows.size());
+	for(size_t row = 0; row < rows.size(); ++row)
+	{
+		const double sum = AliasTable::build(&function_[row_offsets_[row]], rowSize(row), &alias_table_[row_offsets_[row]]);
+		row_integrals[row] = static_cast<float>(sum / static_cast<double>(rowSize(row)));
+		row_inv_integrals_[row] = row_integrals[row] > 0.f ? 1.f / row_integrals[row] : 0.f;
+	}
+	return row_integrals;
+}
+
+inline size_t Pdf2D::clampIndex(float coordinate, size_t size)
+{
+	return std::min(static_cast<size_t>(std::max(coordinate, 0.f) * static_cast<float>(size)), size - 1);
+}
+
+inline std::tuple<Uv<float>, float, float> Pdf2D::sample(float s_u, float s_v) const
+{
+	const auto [row, pdf_v, offset_v]{marginal_.dSampleReuse(s_v)};
+	const size_t row_offset = row_offsets_[row];
+	const size_t row_size = rowSize(row);
+	const auto [column, offset_u]{AliasTable::sample(&alias_table_[row_offset], row_size, s_u)};
+	const float pdf_u = function_[row_offset + column] * row_inv_integrals_[row];
+	return {{(static_cast<float>(column) + offset_u) / static_cast<float>(row_size), (static_cast<float>(row) + offset_v) * marginal_.invSize()}, pdf_u, pdf_v};
+}
+
+inline std::pair<float, float> Pdf2D::pdf(const Uv<float> &uv) const
+{
+	const size_t row = clampIndex(uv.v_, numRows());
+	const size_t column = clampIndex(uv.u_, rowSize(row));
+	return {function_[row_offsets_[row] + column] * row_inv_integrals_[row], marginal_.function(row) * marginal_.invIntegral()};
+}
+
+} //namespace yafaray
+
+#endif //YAFARAY_SAMPLE_PDF2D_H
@@ -0,0 +1,121 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef YAFARAY_SOBOL_H
+#define YAFARAY_SOBOL_H
+
+#include <array>
+#include <cstdint>
+
+namespace yafaray {
+
+namespace sobol
+{
+//Direction numbers from the Joe & Kuo primitive polynomials degree, coefficients and initial direction numbers. Dimension 0 (degree 0) is the van der Corput sequence
+constexpr std::array<uint32_t, 32> directionNumbers(uint32_t s, uint32_t a, const std::array<uint32_t, 6> &m)
+{
+	std::array<uint32_t, 32> v{};
+	if(s == 0)
+	{
+		for(uint32_t i = 0; i < 32; ++i) v[i] = 1u << (31 - i);
+		return v;
+	}
+	for(uint32_t i = 0; i < s; ++i) v[i] = m[i] << (31 - i);
+	for(uint32_t i = s; i < 32; ++i)
+	{
+		v[i] = v[i - s] ^ (v[i - s] >> s);
+		for(uint32_t k = 1; k < s; ++k) v[i] ^= ((a >> (s - 1 - k)) & 1u) * v[i - k];
+	}
+	return v;
+}
+} //namespace sobol
+
+// Owen-scrambled Sobol sequence (Burley 2020, "Practical Hash-based Owen Scrambling")
+// The sample index is shuffled and each dimension scrambled with hash based nested uniform scrambling seeded per pixel,
+// so each pixel gets an independent randomization that keeps the (0,2)-sequence stratification of the first two dimensions
+class Sobol final
+{
+	public:
+		static constexpr inline int num_dimensions_ = 8;
+		[[nodiscard]] static float sample(uint32_t index, int dim, uint32_t seed);
+		[[nodiscard]] static uint32_t nestedUniformScramble(uint32_t value, uint32_t seed);
+
+	private:
+		[[nodiscard]] static uint32_t reverseBits(uint32_t value);
+		[[nodiscard]] static uint32_t laineKarrasPermutation(uint32_t value, uint32_t seed);
+		[[nodiscard]] static uint32_t hashCombine(uint32_t seed, uint32_t value);
+		static constexpr inline std::array<std::array<uint32_t, 32>, num_dimensions_> direction_numbers_ {
+			sobol::directionNumbers(0, 0, {}),
+			sobol::directionNumbers(1, 0, {1}),
+			sobol::directionNumbers(2, 1, {1, 3}),
+			sobol::directionNumbers(3, 1, {1, 3, 1}),
+			sobol::directionNumbers(3, 2, {1, 1, 1}),
+			sobol::directionNumbers(4, 1, {1, 1, 3, 3}),
+			sobol::directionNumbers(4, 4, {1, 3, 5, 13}),
+			sobol::directionNumbers(5, 2, {1, 1, 5, 5, 17}),
+		};
+};
+
+inline uint32_t Sobol::reverseBits(uint32_t value)
+{
+	value = (value << 16) | (value >> 16);
+	value = ((value & 0x00ff00ffu) << 8) | ((value & 0xff00ff00u) >> 8);
+	value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+	value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+	value = ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+	return value;
+}
+
+inline uint32_t Sobol::laineKarrasPermutation(uint32_t value, uint32_t seed)
+{
+	value += seed;
+	value ^= value * 0x6c50b47cu;
+	value ^= value * 0xb82f1e52u;
+	value ^= value * 0xc7afe638u;
+	value ^= value * 0x8d22f6e6u;
+	return value;
+}
+
+inline uint32_t Sobol::hashCombine(uint32_t seed, uint32_t value)
+{
+	return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+inline uint32_t Sobol::nestedUniformScramble(uint32_t value, uint32_t seed)
+{
+	return reverseBits(laineKarrasPermutation(reverseBits(value), seed));
+}
+
+//dim MUST be lower than num_dimensions_
+inline float Sobol::sample(uint32_t index, int dim, uint32_t seed)
+{
+	index = nestedUniformScramble(index, seed);
+	uint32_t value = 0;
+	const std::array<uint32_t, 32> &direction_numbers = direction_numbers_[dim];
+	for(int bit = 0; index != 0; index >>= 1, ++bit)
+	{
+		if(index & 1u) value ^= direction_numbers[bit];
+	}
+	value = nestedUniformScramble(value, hashCombine(seed, static_cast<uint32_t>(dim)));
+	return static_cast<float>(value >> 8) * 0x1p-24f; //only the 24 highest bits, exactly representable as float, so rounding never moves the sample to the next stratum
+}
+
+} //namespace yafaray
+
+#endif //YAFARAY_SOBOL_H
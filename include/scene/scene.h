@@ -23,6 +23,8 @@
 #include "common/items.h"
 #include "param/param.h"
 #include <list>
+#include <map>
+#include <set>
 
 namespace yafaray {
 
@@ -58,6 +60,7 @@ template<typename T> class Bound;
 struct ParamResult;
 class Logger;
 class Image;
+class TextureCache;
 class RenderControl;
 class RenderMonitor;
 class File;
@@ -74,11 +77,20 @@ class Scene final
 		[[nodiscard]] std::string exportToString(size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const;
 		bool exportToFile(File &file, size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const;
 		void setAcceleratorParamMap(const ParamMap &param_map);
+		void setTextureCacheParamMap(const ParamMap &param_map);
+		const std::shared_ptr<TextureCache> &getTextureCache() const { return texture_cache_; }
 		int addVertex(size_t object_id, Point3f &&p, unsigned char time_step);
 		int addVertex(size_t object_id, Point3f &&p, Point3f &&orco, unsigned char time_step);
 		void addVertexNormal(size_t object_id, Vec3f &&n, unsigned char time_step);
 		bool addFace(size_t object_id, const FaceIndices<int> &face_indices, size_t material_id);
 		int addUv(size_t object_id, Uv<float> &&uv);
+		bool addVertices(size_t object_id, const float *points, const float *orco_points, size_t num_points, unsigned char time_step);
+		bool addVerticesNormals(size_t object_id, const float *normals, size_t num_normals, unsigned char time_step);
+		bool addUvs(size_t object_id, const float *uv_values, size_t num_uv_values);
+		bool addFaces(size_t object_id, const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id);
+		float *getVerticesBuffer(size_t object_id, size_t num_points, unsigned char time_step);
+		float *getVerticesNormalsBuffer(size_t object_id, size_t num_normals, unsigned char time_step);
+		float *getUvsBuffer(size_t object_id, size_t num_uv_values);
 		bool smoothVerticesNormals(size_t object_id, float angle);
 		std::pair<size_t, ParamResult> createObject(const std::string &name, const ParamMap &param_map);
 		bool initObject(size_t object_id, size_t material_id);
@@ -93,6 +105,8 @@ class Scene final
 		std::pair<const Object *, ResultFlags> getObject(size_t object_id) const;
 		const Items<Object> &getObjects() const { return objects_; }
 		const Accelerator *getAccelerator() const { return accelerator_.get(); }
+		const Accelerator *getObjectAccelerator(size_t object_id) const;
+		double getAcceleratorBuildTime() const { return accelerator_build_time_; }
 		void createDefaultMaterial();
 		const Background *getBackground() const;
 		Bound<float> getSceneBound() const;
@@ -122,6 +136,8 @@ class Scene final
 		size_t getMaterialIndexHighest() const { return material_index_highest_; }
 
 	private:
+		void markBufferChanged(size_t object_id, bool same_size);
+
 		std::string name_{"Renderer"};
 		std::unique_ptr<Bound<float>> scene_bound_; //!< bounding box of all (finite) scene geometry
 		int object_index_highest_ = 1; //!< Highest object index used for the Normalized Object Index pass.
@@ -130,9 +146,15 @@ class Scene final
 		bool mipmap_interpolation_required_{false}; //!< Indicates if there are any textures that require mipmap interpolation
 		ParamMap accelerator_param_map_;
 		bool accelerator_param_map_modified_{true};
-		std::unique_ptr<const Accelerator> accelerator_;
+		std::unique_ptr<Accelerator> accelerator_;
+		double accelerator_build_time_{0.0}; //!< wall time in seconds spent building the accelerators in the last scene preprocess
+		std::map<size_t, std::unique_ptr<Accelerator>> object_accelerators_; //!< object space accelerators of the instanced objects, shared by all the instances of each object
+		std::set<size_t> modified_objects_; //!< objects added, replaced, disabled or with new faces since the last scene preprocess, their accelerators have to be rebuilt
+		std::set<size_t> deformed_objects_; //!< objects with their vertices, normals or uvs rewritten keeping the topology since the last scene preprocess, their accelerators can be refitted
+		bool instances_modified_{false};
 		std::unique_ptr<Background> background_;
 		std::vector<std::unique_ptr<Instance>> instances_;
+		std::shared_ptr<TextureCache> texture_cache_; //!< when enabled, the images loaded from files afterwards are moved into the texture cache tiles
 		Items<Object> objects_;
 		Items<Light> lights_;
 		Items<Material> materials_;
@@ -21,6 +21,7 @@
 #define LIBYAFARAY_NODE_TREE_DATA_H
 
 #include "shader/node/node_result.h"
+#include "common/memory_arena.h"
 #include <vector>
 
 namespace yafaray {
@@ -37,7 +38,7 @@ class NodeTreeData final
 		const NodeResult &operator()(unsigned int id) const { return node_results_[id]; }
 		NodeResult &operator[](unsigned int id) { return node_results_[id]; }
 	private:
-		std::vector<NodeResult> node_results_;
+		std::vector<NodeResult, ThreadArenaAllocator<NodeResult>> node_results_;
 };
 
 } //namespace yafaray
@@ -0,0 +1,106 @@
+#pragma once
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIBYAFARAY_TEXTURE_CACHE_H
+#define LIBYAFARAY_TEXTURE_CACHE_H
+
+#include "image/image.h"
+#include "param/class_meta.h"
+#include <condition_variable>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace yafaray {
+
+class Logger;
+
+/*! Cache of fixed size texture tiles. The images added to the cache are split in tiles and written to a tiles file,
+ * in the same pixel format of the image, then the tiles are loaded back from disk on demand when their texels are
+ * fetched. The tiles loaded in memory are limited by a memory budget, evicting the least recently used tiles when the
+ * budget is exceeded. Each thread keeps a small lookup cache of its most recently used tiles so most texel fetches do
+ * not need to lock the shared cache, and the tiles are read from disk without locking it either. */
+class TextureCache final
+{
+	public:
+		inline static std::string getClassName() { return "TextureCache"; }
+		static std::pair<std::unique_ptr<TextureCache>, ParamResult> factory(Logger &logger, const ParamMap &param_map);
+		static std::string printMeta(const std::vector<std::string> &excluded_params) { return class_meta::print<Params>(excluded_params); }
+		[[nodiscard]] ParamMap getAsParamMap(bool only_non_default) const;
+		TextureCache(Logger &logger, ParamResult &param_result, const ParamMap &param_map);
+		~TextureCache();
+		struct ImageLayout
+		{
+			size_t image_index_{0};
+			uint64_t file_offset_{0};
+			int tiles_x_{0};
+			int tiles_y_{0};
+			Image::Type type_{Image::Type::ColorAlpha};
+			Image::Optimization optimization_{Image::Optimization::None};
+		};
+		/*! Splits the image in tiles and writes them to the tiles file. Returns the layout used to fetch the tiles later, and false if the tiles could not be written */
+		std::pair<ImageLayout, bool> addImage(const Image &image);
+		/*! Returns the tile, loading it from disk if needed. The pointer is only valid until the next call to getTile from the same thread */
+		const Image *getTile(const ImageLayout &image_layout, int tile_x, int tile_y) const;
+		[[nodiscard]] int getTileSize() const { return params_.tile_size_; }
+
+	private:
+		const struct Params
+		{
+			Params(ParamResult &param_result, const ParamMap &param_map);
+			static std::map<std::string, const ParamMeta *> getParamMetaMap();
+			PARAM_DECL(int, size_mb_, 0, "texture_cache_size", "Maximum memory in MB for the texture tiles loaded in memory. Use 0 to disable the texture cache and keep the textures fully loaded in memory");
+			PARAM_DECL(int, tile_size_, 64, "texture_cache_tile_size", "Width and height in texels of the texture cache tiles");
+			PARAM_DECL(std::string, directory_, "", "texture_cache_dir", "Folder for the texture cache tiles file. Leave blank to use a system temporary file");
+		} params_;
+		struct ThreadTileCache;
+		struct CachedTile
+		{
+			uint64_t key_;
+			std::shared_ptr<const Image> tile_; //!< nullptr while the tile is being loaded by another thread
+			size_t bytes_;
+		};
+		std::shared_ptr<const Image> loadTile(const ImageLayout &image_layout, int tile_x, int tile_y) const;
+		template <typename T> bool writeTiles(const Image &image, const ImageLayout &image_layout);
+		template <typename T> std::unique_ptr<Image> readTile(const ImageLayout &image_layout, int tile_x, int tile_y) const;
+		template <typename Function> static auto visitPixelType(Image::Type type, Image::Optimization optimization, Function &&function);
+		Image::Params tileParams(const ImageLayout &image_layout) const;
+		static uint64_t tileKey(size_t image_index, int tile_x, int tile_y) { return (static_cast<uint64_t>(image_index) << 40) | (static_cast<uint64_t>(tile_y) << 20) | static_cast<uint64_t>(tile_x); }
+		static size_t bytesPerTexel(Image::Type type, Image::Optimization optimization);
+		size_t tileTexels() const { return static_cast<size_t>(params_.tile_size_) * static_cast<size_t>(params_.tile_size_); }
+
+		const size_t serial_; //!< unique number of this cache, to tell apart the tiles of different caches in the thread lookup caches
+		const size_t budget_bytes_{static_cast<size_t>(params_.size_mb_) * 1024 * 1024};
+		std::string file_path_;
+		std::FILE *file_{nullptr};
+		uint64_t file_size_{0};
+		size_t num_images_{0};
+		mutable std::mutex mutex_;
+		mutable std::condition_variable tile_loaded_condition_;
+		mutable std::list<CachedTile> lru_tiles_; //!< tiles loaded in memory, most recently used first
+		mutable std::unordered_map<uint64_t, decltype(lru_tiles_)::iterator> tiles_map_;
+		mutable size_t memory_used_{0};
+		mutable size_t tiles_loaded_{0};
+		Logger &logger_;
+};
+
+} //namespace yafaray
+
+#endif //LIBYAFARAY_TEXTURE_CACHE_H
@@ -30,6 +30,7 @@
 namespace yafaray {
 
 template <typename T> class Items;
+class TextureCache;
 
 class ImageTexture final : public Texture
 {
@@ -41,7 +42,7 @@ class ImageTexture final : public Texture
 		[[nodiscard]] std::map<std::string, const ParamMeta *> getParamMetaMap() const override { return params_.getParamMetaMap(); }
 		static std::string printMeta(const std::vector<std::string> &excluded_params) { return class_meta::print<Params>(excluded_params); }
 		[[nodiscard]] ParamMap getAsParamMap(bool only_non_default) const override;
-		ImageTexture(Logger &logger, ParamResult &param_result, const ParamMap &param_map, const Items<Image> &images, size_t image_id, const Items<Texture> &textures);
+		ImageTexture(Logger &logger, ParamResult &param_result, const ParamMap &param_map, const Items<Image> &images, size_t image_id, const Items<Texture> &textures, std::shared_ptr<TextureCache> texture_cache);
 
 	private:
 		struct ClipMode : public Enum<ClipMode>
@@ -108,6 +109,7 @@ class ImageTexture final : public Texture
 		bool use_mipmaps_{Texture::params_.interpolation_type_ == InterpolationType::Trilinear || Texture::params_.interpolation_type_ == InterpolationType::Ewa};
 		size_t mipmaps_image_id_{math::invalid<size_t>};
 		std::vector<std::unique_ptr<const Image>> mipmaps_;
+		std::shared_ptr<TextureCache> texture_cache_; //!< when enabled the mipmaps are also moved into the texture cache tiles
 		float original_image_file_gamma_ = 1.f;
 		ColorSpace original_image_file_color_space_ = ColorSpace::RawManualGamma;
 		class EwaWeightLut;
@@ -19,13 +19,44 @@
 #include "accelerator/accelerator.h"
 #include "accelerator/accelerator_kdtree_original.h"
 #include "accelerator/accelerator_kdtree_multi_thread.h"
+#include "accelerator/accelerator_bvh.h"
 #include "accelerator/accelerator_simple_test.h"
 #include "common/logger.h"
 #include "param/param.h"
 #include "common/sysinfo.h"
+#include <algorithm>
+#include <mutex>
 
 namespace yafaray {
 
+namespace
+{
+std::mutex rays_counters_mutex;
+std::vector<const std::atomic<uint64_t> *> rays_counters; //!< counters of the live threads
+uint64_t rays_traced_finished_threads{0}; //!< rays traced by the threads already finished
+}
+
+Accelerator::ThreadRaysCounter::ThreadRaysCounter()
+{
+	std::lock_guard<std::mutex> lock_guard(rays_counters_mutex);
+	rays_counters.emplace_back(&rays_);
+}
+
+Accelerator::ThreadRaysCounter::~ThreadRaysCounter()
+{
+	std::lock_guard<std::mutex> lock_guard(rays_counters_mutex);
+	rays_traced_finished_threads += rays_.load(std::memory_order_relaxed);
+	rays_counters.erase(std::find(rays_counters.begin(), rays_counters.end(), &rays_));
+}
+
+uint64_t Accelerator::numRaysTraced()
+{
+	std::lock_guard<std::mutex> lock_guard(rays_counters_mutex);
+	uint64_t num_rays_traced{rays_traced_finished_threads};
+	for(const auto &rays_counter : rays_counters) num_rays_traced += rays_counter->load(std::memory_order_relaxed);
+	return num_rays_traced;
+}
+
 std::map<std::string, const ParamMeta *> Accelerator::Params::getParamMetaMap()
 {
 	return {};
@@ -49,6 +80,7 @@ std::pair<std::unique_ptr<Accelerator>, ParamResult> Accelerator::factory(Logger
 	{
 		case Type::SimpleTest: return AcceleratorSimpleTest::factory(logger, render_control, primitives_list, param_map);
 		case Type::KdTreeMultiThread: return AcceleratorKdTreeMultiThread::factory(logger, render_control, primitives_list, param_map);
+		case Type::Bvh: return AcceleratorBvh::factory(logger, render_control, primitives_list, param_map);
 		case Type::KdTreeOriginal:
 		default: return AcceleratorKdTree::factory(logger, render_control, primitives_list, param_map);
 	}
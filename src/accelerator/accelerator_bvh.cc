@@ -0,0 +1,643 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "accelerator/accelerator_bvh.h"
+#include "common/logger.h"
+#include "param/param.h"
+#include "render/render_control.h"
+#include "common/file.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace yafaray {
+
+struct AcceleratorBvh::Bin
+{
+	Bound<float> bound_;
+	int count_ = 0;
+};
+
+std::map<std::string, const ParamMeta *> AcceleratorBvh::Params::getParamMetaMap()
+{
+	auto param_meta_map{ParentClassType_t::Params::getParamMetaMap()};
+	PARAM_META(max_leaf_size_);
+	PARAM_META(num_bins_);
+	PARAM_META(cache_path_);
+	PARAM_META(cache_max_size_);
+	PARAM_META(time_segments_);
+	return param_meta_map;
+}
+
+AcceleratorBvh::Params::Params(ParamResult &param_result, const ParamMap &param_map)
+{
+	PARAM_LOAD(max_leaf_size_);
+	PARAM_LOAD(num_bins_);
+	PARAM_LOAD(cache_path_);
+	PARAM_LOAD(cache_max_size_);
+	PARAM_LOAD(time_segments_);
+}
+
+ParamMap AcceleratorBvh::getAsParamMap(bool only_non_default) const
+{
+	auto param_map{ParentClassType_t::getAsParamMap(only_non_default)};
+	param_map.setParam("type", type().print());
+	PARAM_SAVE(max_leaf_size_);
+	PARAM_SAVE(num_bins_);
+	PARAM_SAVE(cache_path_);
+	PARAM_SAVE(cache_max_size_);
+	PARAM_SAVE(time_segments_);
+	return param_map;
+}
+
+std::pair<std::unique_ptr<Accelerator>, ParamResult> AcceleratorBvh::factory(Logger &logger, const RenderControl *render_control, const std::vector<const Primitive *> &primitives, const ParamMap &param_map)
+{
+	auto param_result{class_meta::check<Params>(param_map, {"type"}, {})};
+	auto accelerator {std::make_unique<AcceleratorBvh>(logger, param_result, render_control, primitives, param_map)};
+	if(param_result.notOk()) logger.logWarning(param_result.print<ThisClassType_t>("", {"type"}));
+	return {std::move(accelerator), param_result};
+}
+
+AcceleratorBvh::AcceleratorBvh(Logger &logger, ParamResult &param_result, const RenderControl *render_control, const std::vector<const Primitive *> &primitives, const ParamMap &param_map) : ParentClassType_t{logger, param_result, render_control, param_map}, params_{param_result, param_map}, num_time_segments_{std::max(1, params_.time_segments_)}
+{
+	if(logger.isDebug()) logger.logDebug("**" + getClassName() + " params_:\n" + getAsParamMap(true).print());
+	const auto num_primitives = static_cast<uint32_t>(primitives.size());
+	logger_.logInfo(getClassName(), ": Starting build (", num_primitives, " prims, bins:", params_.num_bins_, " max_leaf_size:", params_.max_leaf_size_, " time_segments:", num_time_segments_, ")");
+	const clock_t clock_start = clock();
+	std::vector<Bound<float>> bounds;
+	std::vector<Point3f> centroids;
+	bounds.reserve(num_primitives);
+	centroids.reserve(num_primitives);
+	if(num_primitives > 0) tree_bound_ = primitives.front()->getBound();
+	else tree_bound_ = {{{0.f, 0.f, 0.f}}, {{0.f, 0.f, 0.f}}};
+	for(const auto &primitive : primitives)
+	{
+		bounds.emplace_back(primitive->getBound());
+		centroids.emplace_back((bounds.back().a_ + bounds.back().g_) * 0.5f);
+		tree_bound_ = Bound<float>{tree_bound_, bounds.back()};
+	}
+	enlargeTreeBound(tree_bound_);
+	if(num_primitives == 0) return;
+	std::vector<uint32_t> indices;
+	const bool use_cache{!params_.cache_path_.empty()};
+	const uint64_t cache_key{use_cache ? calculateCacheKey(bounds) : 0};
+	const std::string cache_file_path{use_cache ? getCacheFilePath(cache_key) : ""};
+	if(!use_cache || !loadCache(cache_file_path, cache_key, static_cast<uint32_t>(num_primitives), indices))
+	{
+		indices.resize(num_primitives);
+		for(uint32_t prim_num = 0; prim_num < num_primitives; ++prim_num) indices[prim_num] = prim_num;
+		nodes_.reserve(2 * num_primitives / std::max(1, params_.max_leaf_size_) + 1);
+		leaves_.emplace_back(); //Empty leaf for the unused node slots
+		buildNode(indices, bounds, centroids, 0, static_cast<int>(num_primitives), 0);
+		//A canceled build is incomplete, so it is not cached
+		if(use_cache && !(render_control_ && render_control_->canceled())) saveCache(cache_file_path, cache_key, indices);
+	}
+	std::vector<const Primitive *> leaf_ordered_primitives;
+	leaf_ordered_primitives.reserve(num_primitives);
+	for(const auto &index : indices) leaf_ordered_primitives.emplace_back(primitives[index]);
+	buildTriangleBlocks(leaf_ordered_primitives);
+	buildTimeBounds();
+	nodes_.shrink_to_fit();
+	const clock_t clock_elapsed = clock() - clock_start;
+	if(logger_.isVerbose())
+	{
+		logger_.logVerbose(getClassName(), ": CPU total clocks (in seconds): ", static_cast<float>(clock_elapsed) / static_cast<float>(CLOCKS_PER_SEC), "s");
+		logger_.logVerbose(getClassName(), ": Stats: Primitives in tree: ", num_primitives, ", nodes: ", nodes_.size(), " (", nodes_.size() * sizeof(Node), " bytes), leaves: ", num_leaves_, ", max depth: ", max_depth_reached_, ", packed triangles: ", num_packed_triangles_, " (", triangle_blocks_.size(), " blocks, ", triangle_blocks_.size() * sizeof(TriangleBlock), " bytes), unpacked primitives: ", primitives_.size(), ", time segment bounds: ", time_bounds_.size(), " (", time_bounds_.size() * sizeof(NodeBounds), " bytes)");
+	}
+}
+
+AcceleratorBvh::~AcceleratorBvh()
+{
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Done");
+}
+
+/*! The tree only depends on the primitive bounds (in their order) and on the build parameters, so they are
+ *  all hashed into the cache key. The primitives themselves are not stored, the triangle blocks and flags are
+ *  always recalculated from the current primitives after building or loading the tree */
+uint64_t AcceleratorBvh::calculateCacheKey(const std::vector<Bound<float>> &bounds) const
+{
+	static_assert(sizeof(Bound<float>) == 6 * sizeof(float), "the bounds are expected to be hashed as a flat array of floats");
+	const std::array<uint32_t, 5> build_parameters{static_cast<uint32_t>(sizeof(Node)), static_cast<uint32_t>(sizeof(Leaf)), static_cast<uint32_t>(std::max(1, params_.max_leaf_size_)), static_cast<uint32_t>(std::max(2, params_.num_bins_)), static_cast<uint32_t>(bounds.size())};
+	uint64_t hash{hashWords(hash_offset_basis_, cache_header_, sizeof(cache_header_))};
+	hash = hashWords(hash, build_parameters.data(), sizeof(build_parameters));
+	return hashWords(hash, bounds.data(), bounds.size() * sizeof(Bound<float>));
+}
+
+//! 64 bit FNV-1a applied to 32 bit words instead of bytes, fast enough to hash tens of millions of bounds. Trailing bytes (if any) are ignored
+uint64_t AcceleratorBvh::hashWords(uint64_t hash, const void *data, size_t size)
+{
+	const auto *bytes{static_cast<const unsigned char *>(data)};
+	for(size_t offset = 0; offset + sizeof(uint32_t) <= size; offset += sizeof(uint32_t))
+	{
+		uint32_t word;
+		std::memcpy(&word, bytes + offset, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+uint64_t AcceleratorBvh::calculateCacheChecksum(const std::vector<uint32_t> &indices) const
+{
+	uint64_t hash{hashWords(hash_offset_basis_, nodes_.data(), nodes_.size() * sizeof(Node))};
+	hash = hashWords(hash, leaves_.data(), leaves_.size() * sizeof(Leaf));
+	return hashWords(hash, indices.data(), indices.size() * sizeof(uint32_t));
+}
+
+std::string AcceleratorBvh::getCacheFilePath(uint64_t cache_key) const
+{
+	std::stringstream base_name;
+	base_name << cache_file_prefix_ << std::hex << std::setfill('0') << std::setw(16) << cache_key;
+	return Path{params_.cache_path_, base_name.str(), "bvh"}.getFullPath();
+}
+
+/*! Cache file layout: header string, key, number of primitives, nodes, leaves, maximum depth and checksum of the arrays,
+ *  followed by the flat nodes, leaves and leaf ordered primitive indices arrays, so loading is just a few bulk reads.
+ *  The array sizes are checked against the number of primitives and the file size before allocating them, and the
+ *  loaded tree is validated, so a corrupted or stale file just causes a regular build */
+bool AcceleratorBvh::loadCache(const std::string &file_path, uint64_t cache_key, uint32_t num_primitives, std::vector<uint32_t> &indices)
+{
+	File file(file_path);
+	if(!file.open("rb")) return false;
+	std::string header;
+	uint64_t file_cache_key = 0;
+	uint64_t checksum = 0;
+	uint32_t file_num_primitives = 0, num_nodes = 0, num_leaves = 0;
+	int32_t max_depth_reached = 0;
+	if(!file.read(header) || header != cache_header_ || !file.read(file_cache_key) || file_cache_key != cache_key || !file.read(file_num_primitives) || !file.read(num_nodes) || !file.read(num_leaves) || !file.read(max_depth_reached) || !file.read(checksum))
+	{
+		logger_.logWarning(getClassName(), ": Cache file '", file_path, "' is not valid for this scene, building the tree");
+		return false;
+	}
+	constexpr uint64_t header_size{sizeof(cache_header_) + 2 * sizeof(uint64_t) + 3 * sizeof(uint32_t) + sizeof(int32_t)};
+	const uint64_t expected_file_size{header_size + static_cast<uint64_t>(num_nodes) * sizeof(Node) + static_cast<uint64_t>(num_leaves) * sizeof(Leaf) + static_cast<uint64_t>(file_num_primitives) * sizeof(uint32_t)};
+	if(file_num_primitives != num_primitives || num_nodes == 0 || num_leaves == 0 || num_nodes > 2 * static_cast<uint64_t>(num_primitives) + 1 || num_leaves > static_cast<uint64_t>(num_primitives) + 1 || File::getSize(file_path) != expected_file_size)
+	{
+		logger_.logWarning(getClassName(), ": Cache file '", file_path, "' is corrupted, building the tree");
+		return false;
+	}
+	nodes_.resize(num_nodes);
+	leaves_.resize(num_leaves);
+	indices.resize(num_primitives);
+	bool valid{file.read(nodes_) && file.read(leaves_) && file.read(indices) && calculateCacheChecksum(indices) == checksum};
+	for(size_t index_num = 0; valid && index_num < indices.size(); ++index_num) valid = indices[index_num] < num_primitives;
+	for(size_t leaf_id = 0; valid && leaf_id < leaves_.size(); ++leaf_id) valid = leaves_[leaf_id].first_primitive_ >= 0 && leaves_[leaf_id].num_primitives_ >= 0 && static_cast<uint32_t>(leaves_[leaf_id].first_primitive_ + leaves_[leaf_id].num_primitives_) <= num_primitives;
+	for(size_t node_id = 0; valid && node_id < nodes_.size(); ++node_id)
+	{
+		for(int child_slot = 0; valid && child_slot < node_width_; ++child_slot)
+		{
+			valid = nodes_[node_id].isLeaf(child_slot) ? static_cast<uint32_t>(nodes_[node_id].leafId(child_slot)) < num_leaves : static_cast<uint32_t>(nodes_[node_id].child_[child_slot]) < num_nodes && static_cast<size_t>(nodes_[node_id].child_[child_slot]) > node_id; //the children are always built after their parent, which also rules out cycles
+		}
+	}
+	if(!valid)
+	{
+		logger_.logWarning(getClassName(), ": Cache file '", file_path, "' is corrupted, building the tree");
+		nodes_.clear();
+		leaves_.clear();
+		indices.clear();
+		return false;
+	}
+	num_leaves_ = static_cast<int>(num_leaves) - 1;
+	max_depth_reached_ = max_depth_reached;
+	File::touch(file_path); //So the cache cleaning keeps the recently used files
+	logger_.logInfo(getClassName(), ": Loaded tree from cache file '", file_path, "'");
+	return true;
+}
+
+//! The file is written with a temporary name and then renamed, so renders running concurrently never load a partially written file
+bool AcceleratorBvh::saveCache(const std::string &file_path, uint64_t cache_key, const std::vector<uint32_t> &indices) const
+{
+	std::stringstream file_path_tmp;
+	file_path_tmp << file_path << "." << std::hex << std::random_device{}() << ".tmp";
+	File file(file_path_tmp.str());
+	if(!file.open("wb"))
+	{
+		logger_.logWarning(getClassName(), ": Cannot write cache file '", file_path_tmp.str(), "'");
+		return false;
+	}
+	const bool result{file.append(std::string{cache_header_}) && file.append(cache_key) && file.append(static_cast<uint32_t>(indices.size())) && file.append(static_cast<uint32_t>(nodes_.size())) && file.append(static_cast<uint32_t>(leaves_.size())) && file.append(static_cast<int32_t>(max_depth_reached_)) && file.append(calculateCacheChecksum(indices)) && file.append(nodes_) && file.append(leaves_) && file.append(indices)};
+	file.close();
+	if(!result || !File::rename(file_path_tmp.str(), file_path, /*overwrite=*/true, /*files_only=*/true))
+	{
+		logger_.logWarning(getClassName(), ": Cannot write cache file '", file_path, "'");
+		File::remove(file_path_tmp.str(), /*files_only=*/true);
+		return false;
+	}
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Saved tree to cache file '", file_path, "'");
+	cleanCache(file_path);
+	return true;
+}
+
+//! Removes the least recently used cache files (by modification time, refreshed when they are loaded) while the cache files exceed cache_max_size. The file just saved is always kept
+void AcceleratorBvh::cleanCache(const std::string &saved_file_path) const
+{
+	struct CacheFile
+	{
+		std::string path_;
+		uint64_t size_;
+		int64_t modification_time_;
+	};
+	std::vector<CacheFile> cache_files;
+	uint64_t cache_size{0};
+	for(const auto &file_name : File::listFiles(params_.cache_path_))
+	{
+		const Path file_name_path{file_name};
+		if(file_name_path.getBaseName().rfind(cache_file_prefix_, 0) != 0 || file_name_path.getExtension() != "bvh") continue;
+		const std::string file_path{Path{params_.cache_path_, file_name_path.getBaseName(), file_name_path.getExtension()}.getFullPath()}; //Same path format as getCacheFilePath
+		cache_files.push_back({file_path, File::getSize(file_path), File::getModificationTime(file_path)});
+		cache_size += cache_files.back().size_;
+	}
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Cache directory '", params_.cache_path_, "' contains ", cache_files.size(), " tree files, ", cache_size / 1024, "KB");
+	const uint64_t cache_max_size{static_cast<uint64_t>(params_.cache_max_size_) * 1024 * 1024};
+	if(cache_max_size == 0 || cache_size <= cache_max_size) return;
+	std::sort(cache_files.begin(), cache_files.end(), [](const CacheFile &a, const CacheFile &b) { return a.modification_time_ < b.modification_time_; });
+	for(const auto &cache_file : cache_files)
+	{
+		if(cache_size <= cache_max_size) break;
+		if(cache_file.path_ == saved_file_path) continue;
+		if(File::remove(cache_file.path_, /*files_only=*/true))
+		{
+			cache_size -= cache_file.size_;
+			if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Removed old cache file '", cache_file.path_, "'");
+		}
+	}
+	if(cache_size > cache_max_size) logger_.logWarning(getClassName(), ": Cache directory '", params_.cache_path_, "' still exceeds ", params_.cache_max_size_, "MB after removing old cache files");
+}
+
+void AcceleratorBvh::enlargeTreeBound(Bound<float> &tree_bound)
+{
+	//slightly(!) increase tree bound to prevent errors with prims
+	//lying in a bound plane (still slight bug with trees where one dim. is 0)
+	for(const auto axis : axis::spatial)
+	{
+		const double offset = (tree_bound.g_[axis] - tree_bound.a_[axis]) * 0.001;
+		tree_bound.a_[axis] -= static_cast<float>(offset), tree_bound.g_[axis] += static_cast<float>(offset);
+	}
+}
+
+/*! Moves the static triangles and quads of each leaf (the leaf ranges are still referring to leaf_ordered_primitives) into
+ *  the leaf triangle blocks. Only the primitives that need their own intersection test (instances, motion blurred or
+ *  non polygonal primitives) are kept in primitives_ */
+void AcceleratorBvh::buildTriangleBlocks(const std::vector<const Primitive *> &leaf_ordered_primitives)
+{
+	primitives_.clear();
+	primitive_flags_.clear();
+	triangle_blocks_.clear();
+	num_packed_triangles_ = 0;
+	std::array<Point3f, 4> vertices;
+	for(auto &leaf : leaves_)
+	{
+		const int first_primitive{leaf.first_primitive_};
+		const int last_primitive{first_primitive + leaf.num_primitives_};
+		leaf = {static_cast<int32_t>(triangle_blocks_.size()), 0, static_cast<int32_t>(primitives_.size()), 0};
+		int lane = triangle_block_width_;
+		const auto addTriangle = [&](const Primitive *primitive, TriangleBlock::Kind kind)
+		{
+			if(lane == triangle_block_width_)
+			{
+				triangle_blocks_.emplace_back();
+				++leaf.num_blocks_;
+				lane = 0;
+			}
+			triangle_blocks_.back().setTriangle(lane++, primitive, kind, vertices);
+			++num_packed_triangles_;
+		};
+		for(int primitive_id = first_primitive; primitive_id < last_primitive; ++primitive_id)
+		{
+			const Primitive *primitive{leaf_ordered_primitives[primitive_id]};
+			const int num_vertices{primitive->getStaticPolygonVertices(vertices)};
+			if(num_vertices == 3) addTriangle(primitive, TriangleBlock::Kind::Triangle);
+			else if(num_vertices == 4)
+			{
+				addTriangle(primitive, TriangleBlock::Kind::QuadFirst);
+				addTriangle(primitive, TriangleBlock::Kind::QuadSecond);
+			}
+			else
+			{
+				primitives_.emplace_back(primitive);
+				primitive_flags_.emplace_back(getPrimitiveFlags(primitive));
+				++leaf.num_primitives_;
+			}
+		}
+	}
+	triangle_blocks_.shrink_to_fit();
+	primitives_.shrink_to_fit();
+	primitive_flags_.shrink_to_fit();
+}
+
+void AcceleratorBvh::updatePrimitiveFlags()
+{
+	for(auto &block : triangle_blocks_)
+	{
+		for(int lane = 0; lane < triangle_block_width_; ++lane)
+		{
+			if(block.primitive_[lane]) block.flags_[lane] = getPrimitiveFlags(block.primitive_[lane]);
+		}
+	}
+	for(size_t primitive_id = 0; primitive_id < primitives_.size(); ++primitive_id) primitive_flags_[primitive_id] = getPrimitiveFlags(primitives_[primitive_id]);
+}
+
+/*! The tree structure is kept and only the bounds (and the packed triangles) are recalculated bottom-up from the current primitives, => O(n).
+ *  The tree quality degrades if the primitives move far from their original positions, but it is much faster than a rebuild */
+bool AcceleratorBvh::refit()
+{
+	if(nodes_.empty()) return true;
+	const clock_t clock_start = clock();
+	bool topology_changed = false;
+	tree_bound_ = refitNode(0, topology_changed);
+	if(topology_changed) return false; //A packed triangle is no longer a static polygon, so the tree has to be rebuilt
+	enlargeTreeBound(tree_bound_);
+	buildTimeBounds();
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Refitted ", primitives_.size(), " prims in ", static_cast<float>(clock() - clock_start) / static_cast<float>(CLOCKS_PER_SEC), "s");
+	return true;
+}
+
+//! Returns the bound of all the children of the node, after updating their bounds
+Bound<float> AcceleratorBvh::refitNode(int node_id, bool &topology_changed)
+{
+	Bound<float> node_bound;
+	bool node_bound_empty = true;
+	for(int child_slot = 0; child_slot < node_width_; ++child_slot)
+	{
+		Bound<float> child_bound;
+		if(nodes_[node_id].isLeaf(child_slot))
+		{
+			const Leaf &leaf{leaves_[nodes_[node_id].leafId(child_slot)]};
+			bool child_bound_empty = true;
+			const auto includeBound = [&](const Primitive *primitive)
+			{
+				child_bound = child_bound_empty ? primitive->getBound() : Bound<float>{child_bound, primitive->getBound()};
+				child_bound_empty = false;
+			};
+			std::array<Point3f, 4> vertices;
+			for(int block_id = leaf.first_block_; block_id < leaf.first_block_ + leaf.num_blocks_; ++block_id)
+			{
+				TriangleBlock &block{triangle_blocks_[block_id]};
+				for(int lane = 0; lane < triangle_block_width_; ++lane)
+				{
+					const Primitive *primitive{block.primitive_[lane]};
+					if(!primitive) continue;
+					const int num_vertices{primitive->getStaticPolygonVertices(vertices)};
+					if(num_vertices != (block.kind_[lane] == TriangleBlock::Kind::Triangle ? 3 : 4)) topology_changed = true;
+					else block.setTriangle(lane, primitive, block.kind_[lane], vertices);
+					includeBound(primitive);
+				}
+			}
+			for(int primitive_id = leaf.first_primitive_; primitive_id < leaf.first_primitive_ + leaf.num_primitives_; ++primitive_id) includeBound(primitives_[primitive_id]);
+			if(child_bound_empty) continue; //Unused slot
+		}
+		else child_bound = refitNode(nodes_[node_id].child_[child_slot], topology_changed);
+		nodes_[node_id].setBound(child_slot, child_bound);
+		node_bound = node_bound_empty ? child_bound : Bound<float>{node_bound, child_bound};
+		node_bound_empty = false;
+	}
+	return node_bound;
+}
+
+/*! The tree topology is built from the bounds of the whole time range, then the nodes with motion blurred primitives
+ *  below them get additional child bounds for each time segment, calculated bottom-up from the primitive bounds for that segment.
+ *  The nodes without motion blur keep using only their regular bounds, so static geometry does not use any extra memory */
+void AcceleratorBvh::buildTimeBounds()
+{
+	time_bounds_.clear();
+	for(auto &node : nodes_) node.time_bounds_id_ = -1;
+	if(num_time_segments_ <= 1 || nodes_.empty()) return;
+	//Packed triangles are always static, so only the unpacked primitives can have motion blur
+	if(std::none_of(primitives_.begin(), primitives_.end(), [](const Primitive *primitive) { return primitive->hasMotionBlur(); })) return;
+	std::vector<Bound<float>> segment_bounds;
+	buildNodeTimeBounds(0, segment_bounds);
+	time_bounds_.shrink_to_fit();
+}
+
+//! Segment time interval, slightly enlarged so the float rounding in the traversal segment selection is always covered. The first and last segments also cover any time outside [0, 1]
+std::pair<float, float> AcceleratorBvh::getTimeSegmentInterval(int time_segment) const
+{
+	constexpr float margin{1.0e-4f};
+	const float time_start{(time_segment == 0) ? std::numeric_limits<float>::lowest() : static_cast<float>(time_segment) / static_cast<float>(num_time_segments_) - margin};
+	const float time_end{(time_segment == num_time_segments_ - 1) ? std::numeric_limits<float>::max() : static_cast<float>(time_segment + 1) / static_cast<float>(num_time_segments_) + margin};
+	return {time_start, time_end};
+}
+
+//! Returns false if there are no motion blurred primitives below the node. Otherwise sets its time bounds and returns the bound of all its children for each time segment in segment_bounds
+bool AcceleratorBvh::buildNodeTimeBounds(int node_id, std::vector<Bound<float>> &segment_bounds)
+{
+	std::array<bool, node_width_> child_motion_blur{};
+	std::vector<Bound<float>> child_segment_bounds(node_width_ * num_time_segments_);
+	std::vector<Bound<float>> grandchild_segment_bounds;
+	for(int child_slot = 0; child_slot < node_width_; ++child_slot)
+	{
+		if(!nodes_[node_id].isLeaf(child_slot))
+		{
+			child_motion_blur[child_slot] = buildNodeTimeBounds(nodes_[node_id].child_[child_slot], grandchild_segment_bounds);
+			if(child_motion_blur[child_slot]) std::copy(grandchild_segment_bounds.begin(), grandchild_segment_bounds.end(), child_segment_bounds.begin() + child_slot * num_time_segments_);
+			continue;
+		}
+		const Leaf &leaf{leaves_[nodes_[node_id].leafId(child_slot)]};
+		const auto first_primitive{primitives_.begin() + leaf.first_primitive_};
+		const auto last_primitive{first_primitive + leaf.num_primitives_};
+		child_motion_blur[child_slot] = std::any_of(first_primitive, last_primitive, [](const Primitive *primitive) { return primitive->hasMotionBlur(); });
+		if(!child_motion_blur[child_slot]) continue;
+		for(int time_segment = 0; time_segment < num_time_segments_; ++time_segment)
+		{
+			const auto [time_start, time_end]{getTimeSegmentInterval(time_segment)};
+			Bound<float> &child_bound{child_segment_bounds[child_slot * num_time_segments_ + time_segment]};
+			child_bound = (*first_primitive)->getBoundTimeInterval(time_start, time_end);
+			for(auto primitive_it = first_primitive + 1; primitive_it != last_primitive; ++primitive_it) child_bound.include((*primitive_it)->getBoundTimeInterval(time_start, time_end));
+			for(int block_id = leaf.first_block_; block_id < leaf.first_block_ + leaf.num_blocks_; ++block_id)
+			{
+				for(const Primitive *primitive : triangle_blocks_[block_id].primitive_)
+				{
+					if(primitive) child_bound.include(primitive->getBound());
+				}
+			}
+		}
+	}
+	if(std::none_of(child_motion_blur.begin(), child_motion_blur.end(), [](bool motion_blur) { return motion_blur; })) return false;
+	const auto time_bounds_id{static_cast<int32_t>(time_bounds_.size())};
+	nodes_[node_id].time_bounds_id_ = time_bounds_id;
+	time_bounds_.resize(time_bounds_.size() + num_time_segments_);
+	segment_bounds.resize(num_time_segments_);
+	for(int time_segment = 0; time_segment < num_time_segments_; ++time_segment)
+	{
+		NodeBounds &node_bounds{time_bounds_[time_bounds_id + time_segment]};
+		bool segment_bound_empty = true;
+		for(int child_slot = 0; child_slot < node_width_; ++child_slot)
+		{
+			if(nodes_[node_id].isEmpty(child_slot))
+			{
+				node_bounds.setEmpty(child_slot);
+				continue;
+			}
+			const Bound<float> child_bound{child_motion_blur[child_slot] ? child_segment_bounds[child_slot * num_time_segments_ + time_segment] : nodes_[node_id].getBound(child_slot)};
+			node_bounds.setBound(child_slot, child_bound);
+			segment_bounds[time_segment] = segment_bound_empty ? child_bound : Bound<float>{segment_bounds[time_segment], child_bound};
+			segment_bound_empty = false;
+		}
+	}
+	return true;
+}
+
+float AcceleratorBvh::surfaceArea(const Bound<float> &bound)
+{
+	const float length_x{bound.length(Axis::X)};
+	const float length_y{bound.length(Axis::Y)};
+	const float length_z{bound.length(Axis::Z)};
+	return length_x * length_y + length_x * length_z + length_y * length_z;
+}
+
+Bound<float> AcceleratorBvh::calculateBound(const std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, int first, int last)
+{
+	Bound<float> bound{bounds[indices[first]]};
+	for(int index_num = first + 1; index_num < last; ++index_num) bound.include(bounds[indices[index_num]]);
+	return bound;
+}
+
+/*! Recursively builds a 4-wide node: the primitive range is split with binned SAH into two halves,
+ *  then the largest resulting ranges are split again until there are 4 children or nothing left to split.
+ *  Returns the id of the new node */
+int AcceleratorBvh::buildNode(std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, const std::vector<Point3f> &centroids, int first, int last, int depth)
+{
+	const int node_id{static_cast<int>(nodes_.size())};
+	nodes_.emplace_back();
+	if(depth > max_depth_reached_) max_depth_reached_ = depth;
+	const int max_leaf_size{std::max(1, params_.max_leaf_size_)};
+	std::array<std::pair<int, int>, node_width_> ranges;
+	int num_ranges = 0;
+	ranges[num_ranges++] = {first, last};
+	while(num_ranges < node_width_)
+	{
+		int range_to_split = -1;
+		int range_to_split_size = max_leaf_size;
+		for(int range_id = 0; range_id < num_ranges; ++range_id)
+		{
+			const int range_size{ranges[range_id].second - ranges[range_id].first};
+			if(range_size > range_to_split_size)
+			{
+				range_to_split = range_id;
+				range_to_split_size = range_size;
+			}
+		}
+		if(range_to_split < 0) break;
+		const auto [range_first, range_last]{ranges[range_to_split]};
+		const int split_index{splitBinned(indices, bounds, centroids, range_first, range_last)};
+		ranges[range_to_split] = {range_first, split_index};
+		ranges[num_ranges++] = {split_index, range_last};
+	}
+	for(int child_slot = 0; child_slot < node_width_; ++child_slot)
+	{
+		if(child_slot >= num_ranges)
+		{
+			nodes_[node_id].setEmpty(child_slot);
+			continue;
+		}
+		const auto [range_first, range_last]{ranges[child_slot]};
+		const int range_size{range_last - range_first};
+		nodes_[node_id].setBound(child_slot, calculateBound(indices, bounds, range_first, range_last));
+		if(range_size <= max_leaf_size || depth >= max_depth_ || (render_control_ && render_control_->canceled()))
+		{
+			nodes_[node_id].child_[child_slot] = -(static_cast<int32_t>(leaves_.size()) + 1);
+			leaves_.push_back({0, 0, range_first, range_size}); //The primitives are split into triangle blocks and unpacked primitives later, by buildTriangleBlocks()
+			++num_leaves_;
+		}
+		else
+		{
+			const int child_node_id{buildNode(indices, bounds, centroids, range_first, range_last, depth + 1)};
+			nodes_[node_id].child_[child_slot] = child_node_id;
+		}
+	}
+	return node_id;
+}
+
+/*! Splits the range [first, last) of the primitive indices in two, evaluating the SAH cost
+ *  at the boundaries of a fixed number of centroid bins in each axis => O(n).
+ *  Returns the index where the second half starts */
+int AcceleratorBvh::splitBinned(std::vector<uint32_t> &indices, const std::vector<Bound<float>> &bounds, const std::vector<Point3f> &centroids, int first, int last) const
+{
+	const int num_bins{std::max(2, params_.num_bins_)};
+	const int middle{first + (last - first) / 2};
+	Bound<float> centroid_bound{centroids[indices[first]], centroids[indices[first]]};
+	for(int index_num = first + 1; index_num < last; ++index_num) centroid_bound.include(centroids[indices[index_num]]);
+	float best_cost{std::numeric_limits<float>::max()};
+	int best_bin = -1;
+	Axis best_axis{Axis::None};
+	std::vector<Bin> bins(num_bins);
+	std::vector<float> right_costs(num_bins);
+	for(const auto axis : axis::spatial)
+	{
+		const float axis_length{centroid_bound.length(axis)};
+		if(axis_length <= 0.f) continue;
+		const float bin_scale{static_cast<float>(num_bins) / axis_length};
+		for(auto &bin : bins) bin.count_ = 0;
+		for(int index_num = first; index_num < last; ++index_num)
+		{
+			const uint32_t prim_id{indices[index_num]};
+			const int bin_id{std::min(num_bins - 1, static_cast<int>((centroids[prim_id][axis] - centroid_bound.a_[axis]) * bin_scale))};
+			if(bins[bin_id].count_ == 0) bins[bin_id].bound_ = bounds[prim_id];
+			else bins[bin_id].bound_.include(bounds[prim_id]);
+			++bins[bin_id].count_;
+		}
+		Bound<float> accumulated_bound;
+		int accumulated_count = 0;
+		for(int bin_id = num_bins - 1; bin_id > 0; --bin_id)
+		{
+			if(bins[bin_id].count_ > 0)
+			{
+				accumulated_bound = (accumulated_count == 0) ? bins[bin_id].bound_ : Bound<float>{accumulated_bound, bins[bin_id].bound_};
+				accumulated_count += bins[bin_id].count_;
+			}
+			right_costs[bin_id] = (accumulated_count > 0) ? accumulated_count * surfaceArea(accumulated_bound) : 0.f;
+		}
+		accumulated_count = 0;
+		for(int bin_id = 0; bin_id < num_bins - 1; ++bin_id)
+		{
+			if(bins[bin_id].count_ > 0)
+			{
+				accumulated_bound = (accumulated_count == 0) ? bins[bin_id].bound_ : Bound<float>{accumulated_bound, bins[bin_id].bound_};
+				accumulated_count += bins[bin_id].count_;
+			}
+			if(accumulated_count == 0 || accumulated_count == last - first) continue;
+			const float cost{accumulated_count * surfaceArea(accumulated_bound) + right_costs[bin_id + 1]};
+			if(cost < best_cost)
+			{
+				best_cost = cost;
+				best_bin = bin_id;
+				best_axis = axis;
+			}
+		}
+	}
+	if(best_axis == Axis::None)
+	{
+		//All centroids are coincident, any partition is valid so just split the range in two halves
+		return middle;
+	}
+	const float bin_scale{static_cast<float>(num_bins) / centroid_bound.length(best_axis)};
+	const auto split_it{std::partition(indices.begin() + first, indices.begin() + last, [&](uint32_t prim_id)
+	{
+		return std::min(num_bins - 1, static_cast<int>((centroids[prim_id][best_axis] - centroid_bound.a_[best_axis]) * bin_scale)) <= best_bin;
+	})};
+	const auto split_index{static_cast<int>(split_it - indices.begin())};
+	if(split_index == first || split_index == last)
+	{
+		std::nth_element(indices.begin() + first, indices.begin() + middle, indices.begin() + last, [&](uint32_t prim_a, uint32_t prim_b) { return centroids[prim_a][best_axis] < centroids[prim_b][best_axis]; });
+		return middle;
+	}
+	return split_index;
+}
+
+} //namespace yafaray
@@ -22,7 +22,8 @@
 #include "geometry/clip_plane.h"
 #include "geometry/primitive/primitive.h"
 #include "render/render_control.h"
-#include <thread>
+#include "common/thread_pool.h"
+#include <algorithm>
 
 namespace yafaray {
 
@@ -33,6 +34,8 @@ std::map<std::string, const ParamMeta *> AcceleratorKdTreeMultiThread::Params::g
 	PARAM_META(max_leaf_size_);
 	PARAM_META(cost_ratio_);
 	PARAM_META(empty_bonus_);
+	PARAM_META(num_bins_);
+	PARAM_META(exact_split_threshold_);
 	PARAM_META(num_threads_);
 	PARAM_META(min_indices_to_spawn_threads_);
 	return param_meta_map;
@@ -44,6 +47,8 @@ AcceleratorKdTreeMultiThread::Params::Params(ParamResult &param_result, const Pa
 	PARAM_LOAD(max_leaf_size_);
 	PARAM_LOAD(cost_ratio_);
 	PARAM_LOAD(empty_bonus_);
+	PARAM_LOAD(num_bins_);
+	PARAM_LOAD(exact_split_threshold_);
 	PARAM_LOAD(num_threads_);
 	PARAM_LOAD(min_indices_to_spawn_threads_);
 }
@@ -56,6 +61,8 @@ ParamMap AcceleratorKdTreeMultiThread::getAsParamMap(bool only_non_default) cons
 	PARAM_SAVE(max_leaf_size_);
 	PARAM_SAVE(cost_ratio_);
 	PARAM_SAVE(empty_bonus_);
+	PARAM_SAVE(num_bins_);
+	PARAM_SAVE(exact_split_threshold_);
 	PARAM_SAVE(num_threads_);
 	PARAM_SAVE(min_indices_to_spawn_threads_);
 	return param_map;
@@ -71,9 +78,10 @@ std::pair<std::unique_ptr<Accelerator>, ParamResult> AcceleratorKdTreeMultiThrea
 
 AcceleratorKdTreeMultiThread::AcceleratorKdTreeMultiThread(Logger &logger, ParamResult &param_result, const RenderControl *render_control, const std::vector<const Primitive *> &primitives, const ParamMap &param_map) : ParentClassType_t{logger, param_result, render_control, param_map}, params_{param_result, param_map}
 {
+	static_assert(sizeof(Node) == 8, "kd-tree nodes are expected to use 8 bytes");
 	if(logger.isDebug()) logger.logDebug("**" + getClassName() + " params_:\n" + getAsParamMap(true).print());
 	const auto num_primitives = static_cast<uint32_t>(primitives.size());
-	logger_.logInfo(getClassName(), ": Starting build (", num_primitives, " prims, cost_ratio:", params_.cost_ratio_, " empty_bonus:", params_.empty_bonus_, ") [using ", num_current_threads_, " threads, min indices to spawn threads: ", params_.min_indices_to_spawn_threads_, "]");
+	logger_.logInfo(getClassName(), ": Starting build (", num_primitives, " prims, cost_ratio:", params_.cost_ratio_, " empty_bonus:", params_.empty_bonus_, " num_bins:", params_.num_bins_, " exact_split_threshold:", params_.exact_split_threshold_, ") [using ", num_current_threads_, " threads, min indices to spawn threads: ", params_.min_indices_to_spawn_threads_, "]");
 	clock_t clock_start = clock();
 	Params tree_build_parameters{params_};
 	if(tree_build_parameters.max_depth_ <= 0) tree_build_parameters.max_depth_ = static_cast<int>(7.0f + 1.66f * math::log(static_cast<float>(num_primitives)));
@@ -84,6 +92,7 @@ AcceleratorKdTreeMultiThread::AcceleratorKdTreeMultiThread(Logger &logger, Param
 		if(mls <= 0) mls = 1;
 		tree_build_parameters.max_leaf_size_ = mls;
 	}
+	if(tree_build_parameters.num_bins_ < 2) tree_build_parameters.num_bins_ = 2;
 	if(tree_build_parameters.max_depth_ > kdtree::kd_max_stack_global) tree_build_parameters.max_depth_ = kdtree::kd_max_stack_global; //to prevent our stack to overflow
 	//experiment: add penalty to cost ratio to reduce memory usage on huge scenes
 	if(log_leaves > 16.0) tree_build_parameters.cost_ratio_ += 0.25 * (log_leaves - 16.0);
@@ -109,8 +118,11 @@ AcceleratorKdTreeMultiThread::AcceleratorKdTreeMultiThread(Logger &logger, Param
 	std::vector<uint32_t> prim_indices(num_primitives);
 	for(uint32_t prim_num = 0; prim_num < num_primitives; prim_num++) prim_indices[prim_num] = prim_num;
 	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": Starting recursive build...");
-	Result kd_tree_result = buildTree(primitives, tree_bound_, prim_indices, 0, 0, 0, bounds, tree_build_parameters, ClipPlane(ClipPlane::Pos::None), {}, {}, num_current_threads_);
-	nodes_ = std::move(kd_tree_result.nodes_);
+	//The root is followed by an unused node, so the descendants start at position 2. Every interior node adds a pair of nodes, so all the children pairs start at an even position and never straddle a cache line
+	Result kd_tree_result = buildTree(primitives, tree_bound_, prim_indices, 0, 2, 0, 0, bounds, tree_build_parameters, ClipPlane(ClipPlane::Pos::None), {}, {}, num_current_threads_);
+	if(!kd_tree_result.nodes_.empty()) kd_tree_result.nodes_.insert(kd_tree_result.nodes_.begin() + 1, Node{});
+	nodes_.assign(kd_tree_result.nodes_.begin(), kd_tree_result.nodes_.end());
+	leaf_primitives_ = std::move(kd_tree_result.leaf_primitives_);
 	//print some stats:
 	const clock_t clock_elapsed = clock() - clock_start;
 	if(logger_.isVerbose())
@@ -118,6 +130,7 @@ AcceleratorKdTreeMultiThread::AcceleratorKdTreeMultiThread(Logger &logger, Param
 		logger_.logVerbose(getClassName(), ": CPU total clocks (in seconds): ", static_cast<float>(clock_elapsed) / static_cast<float>(CLOCKS_PER_SEC), "s (actual CPU work, including the work done by all threads added together)");
 		logger_.logVerbose(getClassName(), ": used/allocated nodes: ", nodes_.size(), "/", nodes_.capacity()
 				 , " (", 100.f * static_cast<float>(nodes_.size()) / nodes_.capacity(), "%)");
+		logger_.logVerbose(getClassName(), ": memory used by nodes: ", nodes_.size() * sizeof(Node), " bytes, by leaf primitive references: ", leaf_primitives_.size() * sizeof(const Primitive *), " bytes");
 	}
 	kd_tree_result.stats_.outputLog(logger, num_primitives, tree_build_parameters.max_leaf_size_);
 }
@@ -129,148 +142,77 @@ AcceleratorKdTreeMultiThread::~AcceleratorKdTreeMultiThread()
 
 // ============================================================
 /*!
-	Faster cost function: Find the optimal split with SAH
-	and binning => O(n)
+	Faster cost function: Find the optimal split with SAH evaluated
+	on the boundaries of a fixed number of bins per axis => O(n)
 */
 
-AcceleratorKdTreeMultiThread::SplitCost AcceleratorKdTreeMultiThread::pigeonMinCost(Logger &logger, float e_bonus, float cost_ratio, const std::vector<Bound<float>> &bounds, const Bound<float> &node_bound, const std::vector<uint32_t> &prim_indices)
+AcceleratorKdTreeMultiThread::SplitCost AcceleratorKdTreeMultiThread::binnedMinCost(float e_bonus, float cost_ratio, int num_bins, const std::vector<Bound<float>> &bounds, const Bound<float> &node_bound, const std::vector<uint32_t> &prim_indices)
 {
 	const auto num_prim_indices = static_cast<uint32_t>(prim_indices.size());
-	static constexpr int max_bin = 1024;
-	static constexpr int num_bins = max_bin + 1;
-	std::array<kdtree::TreeBin, num_bins> bins;
 	const Vec3f node_bound_axes {{node_bound.length(Axis::X), node_bound.length(Axis::Y), node_bound.length(Axis::Z)}};
 	const Vec3f inv_node_bound_axes {{1.f / node_bound_axes[Axis::X], 1.f / node_bound_axes[Axis::Y], 1.f / node_bound_axes[Axis::Z]}};
 	SplitCost split;
 	split.cost_ = std::numeric_limits<float>::max();
 	const float inv_total_sa = 1.f / (node_bound_axes[Axis::X] * node_bound_axes[Axis::Y] + node_bound_axes[Axis::X] * node_bound_axes[Axis::Z] + node_bound_axes[Axis::Y] * node_bound_axes[Axis::Z]);
-
+	//Smaller nodes use less bins, so evaluating the bin boundaries never costs more than binning the primitives
+	num_bins = std::min(num_bins, 2 * static_cast<int>(num_prim_indices));
+	const auto num_bins_float = static_cast<float>(num_bins);
+	Vec3f bin_scale;
+	for(const auto axis : axis::spatial) bin_scale[axis] = (node_bound_axes[axis] > 0.f) ? num_bins_float * inv_node_bound_axes[axis] : 0.f; //flat axes are not split, avoid 0 * inf in the binning
+	//For each axis, number of primitives whose lower and upper bound edges fall in each bin, stored as [axis][lower/upper][bin]. A primitive is left of
+	//the boundary between bins "bin - 1" and "bin" when its lower edge is in a bin below it, and right of it when its upper edge is in a bin at or above it
+	std::vector<uint32_t> edge_counts(6 * num_bins, 0);
+	const std::array<float, 6> bins_offset {node_bound.a_[Axis::X], node_bound.a_[Axis::Y], node_bound.a_[Axis::Z], node_bound.a_[Axis::X], node_bound.a_[Axis::Y], node_bound.a_[Axis::Z]};
+	const std::array<float, 6> bins_scale {bin_scale[Axis::X], bin_scale[Axis::Y], bin_scale[Axis::Z], bin_scale[Axis::X], bin_scale[Axis::Y], bin_scale[Axis::Z]};
+	const std::array<int, 6> counts_offset {0, 2 * num_bins, 4 * num_bins, num_bins, 3 * num_bins, 5 * num_bins};
+	//All the axes are binned in the same pass over the primitive bounds, the bins of the 6 bound edges are calculated at once without branches so they can be vectorized
+	const int max_bin = num_bins - 1;
+	for(const auto &prim_index : prim_indices)
+	{
+		const Bound<float> &bbox = bounds[prim_index];
+		const std::array<float, 6> edges {bbox.a_[Axis::X], bbox.a_[Axis::Y], bbox.a_[Axis::Z], bbox.g_[Axis::X], bbox.g_[Axis::Y], bbox.g_[Axis::Z]};
+		std::array<int, 6> bins;
+		for(int edge = 0; edge < 6; ++edge) bins[edge] = counts_offset[edge] + std::clamp(static_cast<int>((edges[edge] - bins_offset[edge]) * bins_scale[edge]), 0, max_bin);
+		for(const int bin : bins) ++edge_counts[bin];
+	}
 	for(const auto axis : axis::spatial)
 	{
-		const float s = max_bin * inv_node_bound_axes[axis];
-		const float min = node_bound.a_[axis];
-		// pigeonhole sort:
-		for(uint32_t prim_num = 0; prim_num < num_prim_indices; ++prim_num)
-		{
-			const Bound<float> &bbox = bounds[prim_indices[prim_num]];
-			const float t_low = bbox.a_[axis];
-			const float t_up  = bbox.g_[axis];
-			int b_left = static_cast<int>((t_low - min) * s);
-			int b_right = static_cast<int>((t_up - min) * s);
-			if(b_left < 0) b_left = 0;
-			else if(b_left > max_bin) b_left = max_bin;
-			if(b_right < 0) b_right = 0;
-			else if(b_right > max_bin) b_right = max_bin;
-
-			if(t_low == t_up)
-			{
-				if(bins[b_left].empty() || (t_low >= bins[b_left].t_ && !bins[b_left].empty()))
-				{
-					bins[b_left].t_ = t_low;
-					bins[b_left].c_both_++;
-				}
-				else
-				{
-					bins[b_left].c_left_++;
-					bins[b_left].c_right_++;
-				}
-				bins[b_left].n_ += 2;
-			}
-			else
-			{
-				if(bins[b_left].empty() || (t_low > bins[b_left].t_ && !bins[b_left].empty()))
-				{
-					bins[b_left].t_ = t_low;
-					bins[b_left].c_left_ += bins[b_left].c_both_ + bins[b_left].c_bleft_;
-					bins[b_left].c_right_ += bins[b_left].c_both_;
-					bins[b_left].c_both_ = bins[b_left].c_bleft_ = 0;
-					bins[b_left].c_bleft_++;
-				}
-				else if(t_low == bins[b_left].t_)
-				{
-					bins[b_left].c_bleft_++;
-				}
-				else bins[b_left].c_left_++;
-				bins[b_left].n_++;
-
-				bins[b_right].c_right_++;
-				if(bins[b_right].empty() || t_up > bins[b_right].t_)
-				{
-					bins[b_right].t_ = t_up;
-					bins[b_right].c_left_ += bins[b_right].c_both_ + bins[b_right].c_bleft_;
-					bins[b_right].c_right_ += bins[b_right].c_both_;
-					bins[b_right].c_both_ = bins[b_right].c_bleft_ = 0;
-				}
-				bins[b_right].n_++;
-			}
-		}
+		if(node_bound_axes[axis] <= 0.f) continue;
 		const Axis next_axis = axis::getNextSpatial(axis);
 		const Axis prev_axis = axis::getPrevSpatial(axis);
 		const float cap_area = node_bound_axes[next_axis] * node_bound_axes[prev_axis];
 		const float cap_perim = node_bound_axes[next_axis] + node_bound_axes[prev_axis];
-
-		uint32_t num_left = 0;
-		uint32_t num_right = num_prim_indices;
-		// cumulate prims and evaluate cost
-		for(const auto &bin : bins)
-		{
-			if(!bin.empty())
-			{
-				num_left += bin.c_left_;
-				num_right -= bin.c_right_;
-				// cost:
-				const float edget = bin.t_;
-				if(edget > node_bound.a_[axis] && edget < node_bound.g_[axis])
-				{
-					// Compute cost for split at _i_th edge
-					const float l_below = edget - node_bound.a_[axis];
-					const float l_above = node_bound.g_[axis] - edget;
-					const float below_sa = cap_area + l_below * cap_perim;
-					const float above_sa = cap_area + l_above * cap_perim;
-					const float raw_costs = (below_sa * num_left + above_sa * num_right);
-					float eb;
-					if(num_right == 0) eb = (0.1f + l_above * inv_node_bound_axes[axis]) * e_bonus * raw_costs;
-					else if(num_left == 0) eb = (0.1f + l_below * inv_node_bound_axes[axis]) * e_bonus * raw_costs;
-					else eb = 0.f;
-
-					const float cost = cost_ratio + inv_total_sa * (raw_costs - eb);
-
-					// Update best split if this is lowest cost so far
-					if(cost < split.cost_)
-					{
-						split.t_ = edget;
-						split.cost_ = cost;
-						split.axis_ = axis;
-					}
-				}
-				num_left += bin.c_both_ + bin.c_bleft_;
-				num_right -= bin.c_both_;
-			}
-		} // for all bins
-		if(num_left != num_prim_indices || num_right != 0)
+		const float bin_length = node_bound_axes[axis] / num_bins_float;
+		const uint32_t *axis_lower_edges = &edge_counts[2 * axis::getId(axis) * num_bins];
+		const uint32_t *axis_upper_edges = axis_lower_edges + num_bins;
+		uint32_t num_left = axis_lower_edges[0];
+		uint32_t num_right = num_prim_indices - axis_upper_edges[0];
+		// evaluate cost on the inner bin boundaries
+		for(int bin = 1; bin < num_bins; ++bin)
 		{
-			if(logger.isVerbose())
+			const float l_below = static_cast<float>(bin) * bin_length;
+			const float l_above = node_bound_axes[axis] - l_below;
+			const float below_sa = cap_area + l_below * cap_perim;
+			const float above_sa = cap_area + l_above * cap_perim;
+			const float raw_costs = (below_sa * num_left + above_sa * num_right);
+			float eb;
+			if(num_right == 0) eb = (0.1f + l_above * inv_node_bound_axes[axis]) * e_bonus * raw_costs;
+			else if(num_left == 0) eb = (0.1f + l_below * inv_node_bound_axes[axis]) * e_bonus * raw_costs;
+			else eb = 0.f;
+
+			const float cost = cost_ratio + inv_total_sa * (raw_costs - eb);
+
+			// Update best split if this is lowest cost so far
+			if(cost < split.cost_)
 			{
-				int c_1 = 0, c_2 = 0, c_3 = 0, c_4 = 0, c_5 = 0;
-				logger.logVerbose("SCREWED!!");
-				for(const auto &bin : bins) { c_1 += bin.n_; logger.logVerbose(bin.n_, " "); }
-				logger.logVerbose("\nn total: ", c_1);
-				for(const auto &bin : bins) { c_2 += bin.c_left_; logger.logVerbose(bin.c_left_, " "); }
-				logger.logVerbose("\nc_left total: ", c_2);
-				for(const auto &bin : bins) { c_3 += bin.c_bleft_; logger.logVerbose(bin.c_bleft_, " "); }
-				logger.logVerbose("\nc_bleft total: ", c_3);
-				for(const auto &bin : bins) { c_4 += bin.c_both_; logger.logVerbose(bin.c_both_, " "); }
-				logger.logVerbose("\nc_both total: ", c_4);
-				for(const auto &bin : bins) { c_5 += bin.c_right_; logger.logVerbose(bin.c_right_, " "); }
-				logger.logVerbose("\nc_right total: ", c_5);
-				logger.logVerbose("\nnPrims: ", num_prim_indices, " num_left: ", num_left, " num_right: ", num_right);
-				logger.logVerbose("total left: ", c_2 + c_3 + c_4, "\ntotal right: ", c_4 + c_5);
-				logger.logVerbose("n/2: ", c_1 / 2);
+				split.t_ = node_bound.a_[axis] + l_below;
+				split.cost_ = cost;
+				split.axis_ = axis;
 			}
-			throw std::logic_error("cost function mismatch");
+			num_left += axis_lower_edges[bin];
+			num_right -= axis_upper_edges[bin];
 		}
-		for(auto &bin : bins) bin.reset();
-	} // for all axis
+	}
 	return split;
 }
 
@@ -393,23 +335,23 @@ AcceleratorKdTreeMultiThread::SplitCost AcceleratorKdTreeMultiThread::minimalCos
 
 // ============================================================
 /*!
-	recursively build the Kd-tree
+	recursively build the Kd-tree. The subtree root is the first node of the result, followed by its descendants,
+	which will be placed in the tree starting at position next_node_id
 */
-AcceleratorKdTreeMultiThread::Result AcceleratorKdTreeMultiThread::buildTree(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, std::atomic<int> &num_current_threads) const
+AcceleratorKdTreeMultiThread::Result AcceleratorKdTreeMultiThread::buildTree(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, uint32_t next_primitive_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, std::atomic<int> &num_current_threads) const
 {
 	Result kd_tree_result;
-	buildTreeWorker(primitives, node_bound, indices, depth, next_node_id, bad_refines, bounds, parameters, clip_plane, polygons, primitive_indices, kd_tree_result, num_current_threads);
+	buildTreeWorker(primitives, node_bound, indices, depth, next_node_id, next_primitive_id, bad_refines, bounds, parameters, clip_plane, polygons, primitive_indices, kd_tree_result, num_current_threads);
 	return kd_tree_result;
 }
 
-void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, Result &result, std::atomic<int> &num_current_threads) const
+void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primitive *> &primitives, const Bound<float> &node_bound, const std::vector<uint32_t> &indices, int depth, uint32_t next_node_id, uint32_t next_primitive_id, int bad_refines, const std::vector<Bound<float>> &bounds, const Params &parameters, const ClipPlane &clip_plane, const std::vector<PolyDouble> &polygons, const std::vector<uint32_t> &primitive_indices, Result &result, std::atomic<int> &num_current_threads) const
 {
 	if(render_control_ && render_control_->canceled()) return;
 	//Note: "indices" are:
 	// * primitive indices when not clipping primitives as polygons. In that case all primitive bounds are present using the same indexing as the complete primitive list
 	// * polygon indices when clipping. In that case only the polygon bounds are present using the same indexing as the polygons list. In this case
 	//   we need to keep track separately of the primitive indices corresponding to each polygon+bound using a separate prim_indices list.
-	static constexpr int pigeon_sort_threshold = 128;
 	auto new_indices = std::ref(indices);
 	auto new_primitive_indices = std::ref(primitive_indices);
 	auto new_bounds = std::ref(bounds);
@@ -462,8 +404,10 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 			}
 			else
 			{
-				// no clipping supported by prim, copy old bound:
-				poly_bounds.emplace_back(bounds[prim_id]);
+				// no clipping supported by prim, copy old bound and add an empty polygon to keep the polygon indices in sync with the bounds:
+				new_polygons.emplace_back();
+				poly_bounds.emplace_back(bounds[indices[index_num]]);
+				poly_indices.emplace_back(static_cast<uint32_t>(poly_indices.size()));
 				prim_indices.emplace_back(prim_id);
 			}
 		}
@@ -478,7 +422,7 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 	if(num_new_indices <= static_cast<uint32_t>(parameters.max_leaf_size_) || depth >= parameters.max_depth_)
 	{
 		Node node;
-		const kdtree::Stats leaf_stats = node.createLeaf(new_primitive_indices, primitives);
+		const kdtree::Stats leaf_stats = node.createLeaf(new_primitive_indices, primitives, result.leaf_primitives_, next_primitive_id);
 		result.stats_ += leaf_stats;
 		result.nodes_.emplace_back(node);
 		if(depth >= parameters.max_depth_) result.stats_.depth_limit_reached_++;
@@ -487,8 +431,14 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 
 	//<< calculate cost for all axes and chose minimum >>
 	const float modified_empty_bonus = parameters.empty_bonus_ * (1.1 - static_cast<float>(depth) / static_cast<float>(parameters.max_depth_));
+	//Binned split search for big nodes, exact split search on the sorted bound edges near the leaves. Clipped polygons always use the exact split search, as their classification needs the edges
+#if POLY_CLIPPING_MULTITHREAD > 0
+	const bool binned_split = (num_new_indices > static_cast<uint32_t>(parameters.exact_split_threshold_) && !do_poly_clipping);
+#else
+	const bool binned_split = (num_new_indices > static_cast<uint32_t>(parameters.exact_split_threshold_));
+#endif
 	SplitCost split;
-	if(num_new_indices > pigeon_sort_threshold) split = pigeonMinCost(logger_, modified_empty_bonus, parameters.cost_ratio_, new_bounds, node_bound, new_indices);
+	if(binned_split) split = binnedMinCost(modified_empty_bonus, parameters.cost_ratio_, parameters.num_bins_, new_bounds, node_bound, new_indices);
 	else split = minimalCost(logger_, modified_empty_bonus, parameters.cost_ratio_, node_bound, new_indices, new_bounds);
 	result.stats_.early_out_ += split.stats_early_out_;
 	//<< if (minimum > leafcost) increase bad refines >>
@@ -497,7 +447,7 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 	   split.axis_ == Axis::None || bad_refines == 2)
 	{
 		Node node;
-		const kdtree::Stats leaf_stats = node.createLeaf(new_primitive_indices, primitives);
+		const kdtree::Stats leaf_stats = node.createLeaf(new_primitive_indices, primitives, result.leaf_primitives_, next_primitive_id);
 		result.stats_ += leaf_stats;
 		result.nodes_.emplace_back(node);
 		if(bad_refines == 2) ++result.stats_.num_bad_splits_;
@@ -510,7 +460,7 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 	std::vector<uint32_t> right_indices;
 	std::vector<uint32_t> left_primitive_indices;
 	std::vector<uint32_t> right_primitive_indices;
-	if(num_new_indices > pigeon_sort_threshold) // we did pigeonhole
+	if(binned_split)
 	{
 		for(uint32_t prim_num = 0; prim_num < num_new_indices; prim_num++)
 		{
@@ -586,8 +536,10 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 		right_primitive_indices = right_indices;
 	}
 
+	//The two children are stored next to each other, starting at the first position of the subtree descendants
 	Node node;
 	const kdtree::Stats interior_stats = node.createInterior(Axis(split.axis_), split_pos);
+	node.setChildren(next_node_id);
 	result.stats_ += interior_stats;
 	result.nodes_.emplace_back(node);
 	Bound bound_left = node_bound;
@@ -607,46 +559,53 @@ void AcceleratorKdTreeMultiThread::buildTreeWorker(const std::vector<const Primi
 
 	if(num_current_threads_ < parameters.num_threads_ && (left_primitive_indices.size() >= (right_primitive_indices.size() / 10)) && (right_primitive_indices.size() >= (left_primitive_indices.size() / 10)) && (left_primitive_indices.size() >= static_cast<size_t>(parameters.min_indices_to_spawn_threads_)))
 	{
-		const auto next_free_node_original = static_cast<uint32_t>(next_node_id + result.nodes_.size());
 		Result result_left;
-		auto left_worker = std::thread(&AcceleratorKdTreeMultiThread::buildTreeWorker, this, primitives, bound_left, left_indices, depth + 1, next_free_node_original, bad_refines, new_bounds, parameters, left_clip_plane, new_polygons, left_primitive_indices, std::ref(result_left), std::ref(num_current_threads));
+		//The left subtree is submitted to the thread pool while the current thread builds the right one. Waiting for the left task executes other pending pool tasks, so nested subtree tasks never block the pool workers
+		TaskGroup left_task;
+		left_task.run([&, depth, next_node_id, next_primitive_id, bad_refines] { buildTreeWorker(primitives, bound_left, left_indices, depth + 1, next_node_id + 2, next_primitive_id, bad_refines, new_bounds, parameters, left_clip_plane, new_polygons, left_primitive_indices, result_left, num_current_threads); });
 		num_current_threads++;
 		Result result_right;
-		auto right_worker = std::thread(&AcceleratorKdTreeMultiThread::buildTreeWorker, this, primitives, bound_right, right_indices, depth + 1, 0, bad_refines, new_bounds, parameters, right_clip_plane, new_polygons, right_primitive_indices, std::ref(result_right), std::ref(num_current_threads)); //We don't need to specify next_free_node (set to 0) because all internor node right childs will be modified later adding the left nodes list size once it's known
-		num_current_threads++;
-		left_worker.join();
+		buildTreeWorker(primitives, bound_right, right_indices, depth + 1, 0, 0, bad_refines, new_bounds, parameters, right_clip_plane, new_polygons, right_primitive_indices, result_right, num_current_threads); //We don't need to specify next_node_id and next_primitive_id (set to 0) because all interior node children and leaf primitive offsets will be modified later adding the left lists sizes once they are known
+		left_task.wait();
 		num_current_threads--;
-		right_worker.join();
-		num_current_threads--;
-
-		result.stats_ += result_left.stats_;
-		result.stats_ += result_right.stats_;
+		if(result_left.nodes_.empty() || result_right.nodes_.empty()) return; //build canceled
 
-		const auto num_nodes_left = static_cast<uint32_t>(result_left.nodes_.size());
-		const uint32_t next_free_node_left = next_free_node_original + num_nodes_left;
-		result.nodes_.back().setRightChild(next_free_node_left);
-		//Correct the "right child" in the right nodes adding the original nodes + left nodes list sizes as offset to each
+		//Correct the children in the right nodes adding the position of the right subtree descendants as offset to each, and the same for the leaf primitives offsets
+		const auto next_node_right = static_cast<uint32_t>(next_node_id + 2 + result_left.nodes_.size() - 1);
+		const auto next_primitive_right = static_cast<uint32_t>(next_primitive_id + result_left.leaf_primitives_.size());
 		for(auto &right_node : result_right.nodes_)
 		{
-			if(!right_node.isLeaf()) right_node.setRightChild(right_node.getRightChild() + next_free_node_left);
+			if(!right_node.isLeaf()) right_node.setChildren(right_node.getChildren() + next_node_right);
+			else right_node.addPrimitivesOffset(next_primitive_right);
 		}
-		result.nodes_.reserve(next_free_node_original + num_nodes_left + result_right.nodes_.size());
-		result.nodes_.insert(result.nodes_.end(), result_left.nodes_.begin(), result_left.nodes_.end());
-		result.nodes_.insert(result.nodes_.end(), result_right.nodes_.begin(), result_right.nodes_.end());
+		mergeChildren(result, result_left, result_right);
 	}
 	else
 	{
 		//<< recurse left child >>
-		const Result result_left = buildTree(primitives, bound_left, left_indices, depth + 1, next_node_id + result.nodes_.size(), bad_refines, new_bounds, parameters, left_clip_plane, new_polygons, left_primitive_indices, num_current_threads);
-		result.stats_ += result_left.stats_;
-		result.nodes_.back().setRightChild(next_node_id + result.nodes_.size() + result_left.nodes_.size());
-		result.nodes_.insert(result.nodes_.end(), result_left.nodes_.begin(), result_left.nodes_.end());
+		const Result result_left = buildTree(primitives, bound_left, left_indices, depth + 1, next_node_id + 2, next_primitive_id, bad_refines, new_bounds, parameters, left_clip_plane, new_polygons, left_primitive_indices, num_current_threads);
+		if(result_left.nodes_.empty()) return; //build canceled
 
 		//<< recurse right child >>
-		const Result result_right = buildTree(primitives, bound_right, right_indices, depth + 1, next_node_id + result.nodes_.size(), bad_refines, new_bounds, parameters, right_clip_plane, new_polygons, right_primitive_indices, num_current_threads);
-		result.stats_ += result_right.stats_;
-		result.nodes_.insert(result.nodes_.end(), result_right.nodes_.begin(), result_right.nodes_.end());
+		const Result result_right = buildTree(primitives, bound_right, right_indices, depth + 1, static_cast<uint32_t>(next_node_id + 2 + result_left.nodes_.size() - 1), static_cast<uint32_t>(next_primitive_id + result_left.leaf_primitives_.size()), bad_refines, new_bounds, parameters, right_clip_plane, new_polygons, right_primitive_indices, num_current_threads);
+		if(result_right.nodes_.empty()) return; //build canceled
+		mergeChildren(result, result_left, result_right);
 	}
 }
 
+/*! Appends the two children subtrees after their parent node (the only node in "result"): first the children pair, then the descendants of the left child and then the descendants of the right child */
+void AcceleratorKdTreeMultiThread::mergeChildren(Result &result, const Result &result_left, const Result &result_right)
+{
+	result.stats_ += result_left.stats_;
+	result.stats_ += result_right.stats_;
+	result.nodes_.reserve(result.nodes_.size() + result_left.nodes_.size() + result_right.nodes_.size());
+	result.nodes_.emplace_back(result_left.nodes_.front());
+	result.nodes_.emplace_back(result_right.nodes_.front());
+	result.nodes_.insert(result.nodes_.end(), result_left.nodes_.begin() + 1, result_left.nodes_.end());
+	result.nodes_.insert(result.nodes_.end(), result_right.nodes_.begin() + 1, result_right.nodes_.end());
+	result.leaf_primitives_.reserve(result_left.leaf_primitives_.size() + result_right.leaf_primitives_.size());
+	result.leaf_primitives_.insert(result.leaf_primitives_.end(), result_left.leaf_primitives_.begin(), result_left.leaf_primitives_.end());
+	result.leaf_primitives_.insert(result.leaf_primitives_.end(), result_right.leaf_primitives_.begin(), result_right.leaf_primitives_.end());
+}
+
 } //namespace yafaray
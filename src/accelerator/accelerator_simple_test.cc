@@ -118,9 +118,9 @@ IntersectData AcceleratorSimpleTest::intersectShadow(const Ray &ray, float t_max
 	return intersect_data;
 }
 
-IntersectData AcceleratorSimpleTest::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera) const
+IntersectData AcceleratorSimpleTest::intersectTransparentShadow(const Ray &ray, int max_depth, float t_max, const Camera *camera, const Matrix4f *obj_to_world) const
 {
-	std::set<const Primitive *> filtered;
+	TransparentShadowFilter filtered;
 	int depth = 0;
 	IntersectData intersect_data;
 	for(const auto &[object, object_data] : object_handles_)
@@ -130,11 +130,12 @@ IntersectData AcceleratorSimpleTest::intersectTransparentShadow(const Ray &ray,
 			const float t_min = std::max(ray.tmin_, calculateDynamicRayBias(cross));
 			for(const auto &primitive : object_data.primitives_)
 			{
-				if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_)) return intersect_data;
+				if(Accelerator::primitiveIntersectionTransparentShadow(intersect_data, filtered, depth, max_depth, primitive, camera, ray.from_, ray.dir_, t_min, t_max, ray.time_, obj_to_world)) return intersect_data;
 			}
 		}
 	}
 	intersect_data.setNoHit();
+	intersect_data.transparent_depth_ = depth;
 	return intersect_data;
 }
 
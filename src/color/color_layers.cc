@@ -22,18 +22,23 @@ namespace yafaray {
 
 ColorLayers::ColorLayers(const Layers &layers)
 {
+	for(size_t type = 0; type < LayerDef::Type::Size; ++type) colors_[type] = LayerDef::getDefaultColor(static_cast<LayerDef::Type>(type));
 	for(const auto &[layer_def, layer] : layers)
 	{
-		set(layer_def, LayerDef::getDefaultColor(layer_def));
+		if(!enabled_[layer_def])
+		{
+			enabled_[layer_def] = true;
+			enabled_types_[num_enabled_++] = layer_def;
+		}
 		flags_ |= layer.getFlags();
 	}
 }
 
 void ColorLayers::setDefaultColors()
 {
-	for(auto &[layer_def, color] : items_)
+	for(const LayerDef::Type layer_def : *this)
 	{
-		color = LayerDef::getDefaultColor(layer_def);
+		colors_[layer_def] = LayerDef::getDefaultColor(layer_def);
 	}
 }
 
@@ -41,7 +46,7 @@ bool ColorLayers::isDefinedAny(const std::vector<LayerDef::Type> &types) const
 {
 	for(const auto &type : types)
 	{
-		if(find(type)) return true;
+		if(enabled_[type]) return true;
 	}
 	return false;
 }
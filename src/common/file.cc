@@ -24,10 +24,15 @@
 #include <sys/stat.h>
 #if defined(_WIN32)
 #include "common/string.h"
+#include <algorithm>
 #include <sstream>
 #include <windows.h>
+#include <io.h>
+#include <sys/utime.h>
 #else //defined(_WIN32)
 #include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
 #endif //defined(_WIN32)
 
 namespace yafaray {
@@ -163,14 +168,78 @@ bool File::rename(const std::string &path_old, const std::string &path_new, bool
 #endif //defined(_WIN32)
 }
 
+uint64_t File::getSize(const std::string &path)
+{
+#if defined(_WIN32)
+	struct ::_stat64 buf;
+	if(::_wstat64(string::utf8ToWutf16Le(path).c_str(), &buf) != 0) return 0;
+#else //defined(_WIN32)
+	struct ::stat buf;
+	if(::stat(path.c_str(), &buf) != 0) return 0;
+#endif //defined(_WIN32)
+	return static_cast<uint64_t>(buf.st_size);
+}
+
+int64_t File::getModificationTime(const std::string &path)
+{
+#if defined(_WIN32)
+	struct ::_stat64 buf;
+	if(::_wstat64(string::utf8ToWutf16Le(path).c_str(), &buf) != 0) return 0;
+#else //defined(_WIN32)
+	struct ::stat buf;
+	if(::stat(path.c_str(), &buf) != 0) return 0;
+#endif //defined(_WIN32)
+	return static_cast<int64_t>(buf.st_mtime);
+}
+
+bool File::touch(const std::string &path)
+{
+#if defined(_WIN32)
+	return ::_wutime64(string::utf8ToWutf16Le(path).c_str(), nullptr) == 0;
+#else //defined(_WIN32)
+	return ::utime(path.c_str(), nullptr) == 0;
+#endif //defined(_WIN32)
+}
+
+bool File::seek(std::FILE *fp, uint64_t offset)
+{
+#if defined(_WIN32)
+	return ::_fseeki64(fp, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else //defined(_WIN32)
+	return ::fseeko(fp, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif //defined(_WIN32)
+}
+
+bool File::readAt(std::FILE *fp, void *buffer, size_t size, uint64_t offset)
+{
+	auto *bytes{static_cast<char *>(buffer)};
+	while(size > 0)
+	{
+#if defined(_WIN32)
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD bytes_read{0};
+		const DWORD bytes_to_read{static_cast<DWORD>(std::min<size_t>(size, 1 << 30))};
+		if(!::ReadFile(reinterpret_cast<HANDLE>(::_get_osfhandle(::_fileno(fp))), bytes, bytes_to_read, &bytes_read, &overlapped) || bytes_read == 0) return false;
+#else //defined(_WIN32)
+		const ssize_t bytes_read{::pread(::fileno(fp), bytes, size, static_cast<off_t>(offset))};
+		if(bytes_read <= 0) return false;
+#endif //defined(_WIN32)
+		bytes += bytes_read;
+		size -= static_cast<size_t>(bytes_read);
+		offset += static_cast<uint64_t>(bytes_read);
+	}
+	return true;
+}
+
 bool File::read(std::string &str) const
 {
 	str.clear();
 	char ch;
 	do
 	{
-		read(ch);
-		if(ch == 0x00) break;
+		if(!read(ch) || ch == 0x00) break;
 		else str += ch;
 	}
 	while(true);
@@ -180,8 +249,7 @@ bool File::read(std::string &str) const
 bool File::read(char *buffer, size_t size) const
 {
 	if(!fp_) return false;
-	::fread(buffer, 1, size, fp_);
-	return true;
+	return ::fread(buffer, 1, size, fp_) == size;
 }
 
 bool File::append(const std::string &str)
@@ -198,8 +266,7 @@ bool File::appendText(const std::string &str)
 bool File::append(const char *buffer, size_t size)
 {
 	if(!fp_) return false;
-	std::fwrite(buffer, 1, size, fp_);
-	return true;
+	return std::fwrite(buffer, 1, size, fp_) == size;
 }
 
 int File::close()
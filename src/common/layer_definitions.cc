@@ -30,6 +30,7 @@ const std::array<LayerDef, LayerDef::Type::Size> LayerDef::definitions_array_ {{
 	{Type::Ao, "ao", Flags::BasicLayers | Flags::AoLayers},
 	{Type::AoClay, "ao-clay", Flags::BasicLayers | Flags::AoLayers, Image::Type::Gray},
 	{Type::BarycentricUvw, "debug-barycentric-uvw", Flags::DebugLayers},
+	{Type::DebugConvergence, "debug-convergence", Flags::None, Image::Type::Gray, {0.f, 1.f}, false},
 	{Type::DebugDpLengths, "debug-dp-lengths", Flags::DebugLayers},
 	{Type::DebugDpdu, "debug-dpdu", Flags::DebugLayers},
 	{Type::DebugDpdv, "debug-dpdv", Flags::DebugLayers},
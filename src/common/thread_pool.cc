@@ -0,0 +1,160 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "common/thread_pool.h"
+#include "common/sysinfo.h"
+
+namespace yafaray {
+
+namespace
+{
+//Pool and deque owned by the calling thread, when it is a pool worker
+thread_local const ThreadPool *current_thread_pool{nullptr};
+thread_local int current_worker_id{-1};
+}
+
+ThreadPool &ThreadPool::get()
+{
+	static ThreadPool thread_pool{sysinfo::getNumSystemThreads()};
+	return thread_pool;
+}
+
+ThreadPool::ThreadPool(int num_workers)
+{
+	if(num_workers < 1) num_workers = 1;
+	queues_.reserve(num_workers);
+	for(int worker_id = 0; worker_id < num_workers; ++worker_id) queues_.emplace_back(std::make_unique<WorkerQueue>());
+	workers_.reserve(num_workers);
+	for(int worker_id = 0; worker_id < num_workers; ++worker_id) workers_.emplace_back(&ThreadPool::workerLoop, this, worker_id);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock_guard(sleep_mutex_);
+		stop_ = true;
+	}
+	sleep_condition_.notify_all();
+	for(auto &worker : workers_) worker.join();
+}
+
+void ThreadPool::submit(Task &&task)
+{
+	const int num_queues = static_cast<int>(queues_.size());
+	//Workers keep their own subtasks in their own deque, other threads distribute their tasks among all the deques
+	const int queue_id = (current_thread_pool == this) ? current_worker_id : static_cast<int>(next_external_queue_.fetch_add(1, std::memory_order_relaxed) % num_queues);
+	{
+		std::lock_guard<std::mutex> lock_guard(queues_[queue_id]->mutex_);
+		queues_[queue_id]->tasks_.emplace_back(std::move(task));
+	}
+	num_queued_tasks_.fetch_add(1, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock_guard(sleep_mutex_);
+	}
+	sleep_condition_.notify_one();
+}
+
+bool ThreadPool::tryTakeTask(Task &task)
+{
+	if(num_queued_tasks_.load(std::memory_order_acquire) <= 0) return false;
+	const int num_queues = static_cast<int>(queues_.size());
+	const int own_queue_id = (current_thread_pool == this) ? current_worker_id : -1;
+	if(own_queue_id >= 0)
+	{
+		WorkerQueue &own_queue = *queues_[own_queue_id];
+		std::lock_guard<std::mutex> lock_guard(own_queue.mutex_);
+		if(!own_queue.tasks_.empty())
+		{
+			task = std::move(own_queue.tasks_.back());
+			own_queue.tasks_.pop_back();
+			num_queued_tasks_.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	//Steal the oldest task of another deque, which for recursive subdivisions is usually the biggest one
+	const int first_queue_id = own_queue_id + 1;
+	for(int i = 0; i < num_queues; ++i)
+	{
+		const int queue_id = (first_queue_id + i) % num_queues;
+		if(queue_id == own_queue_id) continue;
+		WorkerQueue &queue = *queues_[queue_id];
+		std::lock_guard<std::mutex> lock_guard(queue.mutex_);
+		if(!queue.tasks_.empty())
+		{
+			task = std::move(queue.tasks_.front());
+			queue.tasks_.pop_front();
+			num_queued_tasks_.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::runTask(Task &task)
+{
+	task.function_();
+	task.function_ = nullptr;
+	//The task group can be destroyed by its waiting thread as soon as the counter reaches zero, so it must not be accessed after that
+	if(task.task_group_->num_pending_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock_guard(sleep_mutex_);
+		}
+		sleep_condition_.notify_all();
+	}
+}
+
+bool ThreadPool::tryRunTask()
+{
+	Task task;
+	if(!tryTakeTask(task)) return false;
+	runTask(task);
+	return true;
+}
+
+void ThreadPool::workerLoop(int worker_id)
+{
+	current_thread_pool = this;
+	current_worker_id = worker_id;
+	while(true)
+	{
+		if(tryRunTask()) continue;
+		std::unique_lock<std::mutex> unique_lock(sleep_mutex_);
+		sleep_condition_.wait(unique_lock, [this] { return stop_ || num_queued_tasks_.load(std::memory_order_acquire) > 0; });
+		if(stop_ && num_queued_tasks_.load(std::memory_order_acquire) <= 0) return;
+	}
+}
+
+void ThreadPool::wait(const TaskGroup &task_group)
+{
+	while(!task_group.finished())
+	{
+		//Help executing pending tasks instead of blocking, so waiting inside a task does not take a worker away from the pool
+		if(tryRunTask()) continue;
+		std::unique_lock<std::mutex> unique_lock(sleep_mutex_);
+		sleep_condition_.wait(unique_lock, [this, &task_group] { return task_group.finished() || num_queued_tasks_.load(std::memory_order_acquire) > 0; });
+	}
+}
+
+void TaskGroup::run(std::function<void()> &&function)
+{
+	num_pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+	thread_pool_.submit({std::move(function), this});
+}
+
+} //namespace yafaray
@@ -41,6 +41,16 @@ std::vector<const PrimitiveInstance *> Instance::getPrimitives() const
 	return result;
 }
 
+std::vector<size_t> Instance::getBaseObjectIds() const
+{
+	std::vector<size_t> result;
+	for(const auto &base_id : base_ids_)
+	{
+		if(base_id.base_id_type_ == BaseId::Type::Object) result.emplace_back(base_id.id_);
+	}
+	return result;
+}
+
 std::vector<const Matrix4f *> Instance::getObjToWorldMatrices() const
 {
 	std::vector<const Matrix4f *> result;
@@ -51,7 +61,24 @@ std::vector<const Matrix4f *> Instance::getObjToWorldMatrices() const
 	return result;
 }
 
-bool Instance::updatePrimitives(const Scene &scene)
+//! Returns the bezier control matrices of the motion between time_start and time_end, so the transformations for any time in that interval are convex combinations of them
+std::vector<Matrix4f> Instance::getObjToWorldMatricesTimeInterval(float time_start, float time_end) const
+{
+	const float range_start = time_steps_.front().time_;
+	const float range_end = time_steps_.back().time_;
+	if(!hasMotionBlur() || time_end < time_start || range_end <= range_start)
+	{
+		std::vector<Matrix4f> result;
+		for(const auto &time_step : time_steps_) result.emplace_back(time_step.obj_to_world_);
+		return result;
+	}
+	const float x_start = math::clamp(math::lerpSegment(time_start, 0.f, range_start, 1.f, range_end), 0.f, 1.f);
+	const float x_end = math::clamp(math::lerpSegment(time_end, 0.f, range_start, 1.f, range_end), 0.f, 1.f);
+	const auto control_matrices = math::bezierSubdivide<Matrix4f>({time_steps_[0].obj_to_world_, time_steps_[1].obj_to_world_, time_steps_[2].obj_to_world_}, x_start, x_end);
+	return {control_matrices.begin(), control_matrices.end()};
+}
+
+bool Instance::updatePrimitives(Logger &logger, const Scene &scene)
 {
 	primitives_.clear();
 	bool result{true};
@@ -59,13 +86,9 @@ bool Instance::updatePrimitives(const Scene &scene)
 	{
 		if(base_id.base_id_type_ == BaseId::Type::Object)
 		{
-			const auto [object, object_result]{scene.getObject(base_id.id_)};
-			if(!object) continue;
-			const auto &primitives{object->getPrimitives()};
-			for(const auto &primitive: primitives)
-			{
-				if(primitive) primitives_.emplace_back(std::make_unique<PrimitiveInstance>(*primitive, *this));
-			}
+			const Accelerator *object_accelerator{scene.getObjectAccelerator(base_id.id_)};
+			if(!object_accelerator) continue;
+			primitives_.emplace_back(std::make_unique<PrimitiveInstance>(logger, *object_accelerator, *this));
 		}
 		else
 		{
@@ -78,7 +101,7 @@ bool Instance::updatePrimitives(const Scene &scene)
 			const auto &primitives{instance->getPrimitives()};
 			for(const auto &primitive: primitives)
 			{
-				if(primitive) primitives_.emplace_back(std::make_unique<PrimitiveInstance>(*primitive, *this));
+				if(primitive) primitives_.emplace_back(std::make_unique<PrimitiveInstance>(logger, *primitive, *this));
 			}
 			//auto primitives{instance->getPrimitives()};
 			//result.insert(result.end(),std::make_move_iterator(primitives.begin()), std::make_move_iterator(primitives.end())); //To append std::vector of std::unique_ptr if needed...
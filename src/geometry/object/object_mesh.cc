@@ -25,6 +25,7 @@
 #include "material/material.h"
 #include <array>
 #include <memory>
+#include <algorithm>
 
 namespace yafaray {
 
@@ -125,6 +126,11 @@ bool MeshObject::calculateObject(size_t)
 	return true;
 }
 
+void MeshObject::updateGeometricNormals()
+{
+	for(auto &face : faces_) face->updateGeometricNormal();
+}
+
 std::vector<const Primitive *> MeshObject::getPrimitives() const
 {
 	std::vector<const Primitive *> primitives;
@@ -140,6 +146,116 @@ void MeshObject::addVertexNormal(Vec3f &&n, unsigned char time_step)
 	time_steps_[time_step].vertices_normals_.emplace_back(n);
 }
 
+int MeshObject::addPoints(const float *points, const float *orco_points, size_t num_points, unsigned char time_step)
+{
+	if(!points || time_step >= time_steps_.size()) return -1;
+	TimeStepGeometry &time_step_geometry{time_steps_[time_step]};
+	const int first_point_id{static_cast<int>(time_step_geometry.points_.size())};
+	time_step_geometry.points_.reserve(time_step_geometry.points_.size() + num_points);
+	for(size_t i = 0; i < num_points; ++i) time_step_geometry.points_.emplace_back(Point3f{{points[3 * i], points[3 * i + 1], points[3 * i + 2]}});
+	if(orco_points)
+	{
+		time_step_geometry.orco_points_.reserve(time_step_geometry.orco_points_.size() + num_points);
+		for(size_t i = 0; i < num_points; ++i) time_step_geometry.orco_points_.emplace_back(Point3f{{orco_points[3 * i], orco_points[3 * i + 1], orco_points[3 * i + 2]}});
+	}
+	return first_point_id;
+}
+
+bool MeshObject::addVerticesNormals(const float *normals, size_t num_normals, unsigned char time_step)
+{
+	if(!normals || time_step >= time_steps_.size()) return false;
+	std::vector<Vec3f> &vertices_normals{time_steps_[time_step].vertices_normals_};
+	vertices_normals.reserve(vertices_normals.size() + num_normals);
+	for(size_t i = 0; i < num_normals; ++i) vertices_normals.emplace_back(Vec3f{{normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]}});
+	return true;
+}
+
+int MeshObject::addUvValues(const float *uv_values, size_t num_uv_values)
+{
+	if(!uv_values) return -1;
+	const int first_uv_id{static_cast<int>(uv_values_.size())};
+	uv_values_.reserve(uv_values_.size() + num_uv_values);
+	for(size_t i = 0; i < num_uv_values; ++i) uv_values_.emplace_back(Uv<float>{uv_values[2 * i], uv_values[2 * i + 1]});
+	return first_uv_id;
+}
+
+bool MeshObject::addFaces(const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id)
+{
+	if(!vertices_indices || (vertices_per_face != 3 && vertices_per_face != 4)) return false;
+	//All the faces are checked before adding any of them, so a wrong index does not leave the mesh half built
+	//The faces use the same vertex indices in all the time steps, so the indices must be valid in the time step with the fewest points
+	int num_points{numVertices(0)};
+	for(int time_step = 1; time_step < numTimeSteps(); ++time_step) num_points = std::min(num_points, numVertices(static_cast<unsigned char>(time_step)));
+	const int num_uv_values{static_cast<int>(uv_values_.size())};
+	for(size_t i = 0; i < num_faces * vertices_per_face; ++i)
+	{
+		const bool unused_fourth_vertex{vertices_per_face == 4 && i % 4 == 3 && vertices_indices[i] < 0};
+		if(unused_fourth_vertex) continue;
+		if(vertices_indices[i] < 0 || vertices_indices[i] >= num_points) return false;
+		if(uv_indices && (uv_indices[i] < 0 || uv_indices[i] >= num_uv_values)) return false;
+	}
+	faces_.reserve(faces_.size() + num_faces);
+	for(size_t face_id = 0; face_id < num_faces; ++face_id)
+	{
+		//With 4 vertices per face, a negative fourth vertex index makes the face a triangle, so triangles and quads can be mixed in the same array
+		FaceIndices<int> face_indices;
+		for(int vertex_number = 0; vertex_number < vertices_per_face; ++vertex_number)
+		{
+			const size_t index{face_id * vertices_per_face + vertex_number};
+			if(vertices_indices[index] < 0) continue;
+			face_indices[vertex_number].vertex_ = vertices_indices[index];
+			if(uv_indices) face_indices[vertex_number].uv_ = uv_indices[index];
+		}
+		addFace(face_indices, materials_ids ? materials_ids[face_id] : material_id);
+	}
+	return true;
+}
+
+int MeshObject::numIndexedItems(int VertexIndices<int>::*index) const
+{
+	int num_items{0};
+	for(const auto &face : faces_)
+	{
+		const FaceIndices<int> &face_indices{face->getFaceIndices()};
+		const int num_vertices{face_indices.numVertices()};
+		for(int vertex_number = 0; vertex_number < num_vertices; ++vertex_number)
+		{
+			const int item_index{face_indices[vertex_number].*index};
+			if(item_index != math::invalid<int>) num_items = std::max(num_items, item_index + 1);
+		}
+	}
+	return num_items;
+}
+
+float *MeshObject::getPointsBuffer(size_t num_points, unsigned char time_step)
+{
+	static_assert(sizeof(Point3f) == 3 * sizeof(float), "Point3f must be made of exactly 3 floats to be used as a buffer of floats");
+	if(time_step >= time_steps_.size()) return nullptr;
+	//The existing faces keep their indices, so the buffer cannot be shrunk below the points they use
+	if(num_points < static_cast<size_t>(numIndexedItems(&VertexIndices<int>::vertex_))) return nullptr;
+	TimeStepGeometry &time_step_geometry{time_steps_[time_step]};
+	if(!time_step_geometry.orco_points_.empty()) time_step_geometry.orco_points_.resize(num_points, Point3f{{0.f, 0.f, 0.f}});
+	time_step_geometry.points_.resize(num_points);
+	return reinterpret_cast<float *>(time_step_geometry.points_.data());
+}
+
+float *MeshObject::getVerticesNormalsBuffer(size_t num_normals, unsigned char time_step)
+{
+	static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be made of exactly 3 floats to be used as a buffer of floats");
+	if(time_step >= time_steps_.size()) return nullptr;
+	if(num_normals < static_cast<size_t>(numIndexedItems(&VertexIndices<int>::normal_))) return nullptr;
+	time_steps_[time_step].vertices_normals_.resize(num_normals);
+	return reinterpret_cast<float *>(time_steps_[time_step].vertices_normals_.data());
+}
+
+float *MeshObject::getUvValuesBuffer(size_t num_uv_values)
+{
+	static_assert(sizeof(Uv<float>) == 2 * sizeof(float), "Uv<float> must be made of exactly 2 floats to be used as a buffer of floats");
+	if(num_uv_values < static_cast<size_t>(numIndexedItems(&VertexIndices<int>::uv_))) return nullptr;
+	uv_values_.resize(num_uv_values);
+	return reinterpret_cast<float *>(uv_values_.data());
+}
+
 float MeshObject::getAngleSine(const std::array<int, 3> &triangle_indices, const std::vector<Point3f> &vertices)
 {
 	const Vec3f edge_1{vertices[triangle_indices[1]] - vertices[triangle_indices[0]]};
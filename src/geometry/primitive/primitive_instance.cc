@@ -17,18 +17,209 @@
  */
 
 #include "geometry/primitive/primitive_instance.h"
+#include "accelerator/accelerator.h"
 #include "geometry/surface.h"
 
 namespace yafaray {
 
+namespace
+{
+	Bound<float> transformBound(const Bound<float> &bound, const Matrix4f &obj_to_world)
+	{
+		Bound<float> result{obj_to_world * bound.a_, obj_to_world * bound.a_};
+		for(int corner = 1; corner < 8; ++corner)
+		{
+			const Point3f point{{(corner & 1) ? bound.g_[Axis::X] : bound.a_[Axis::X], (corner & 2) ? bound.g_[Axis::Y] : bound.a_[Axis::Y], (corner & 4) ? bound.g_[Axis::Z] : bound.a_[Axis::Z]}};
+			result.include(obj_to_world * point);
+		}
+		return result;
+	}
+} //namespace
+
+PrimitiveInstance::PrimitiveInstance(Logger &logger, const Accelerator &base_accelerator, const Instance &base_instance) : logger_{logger}, base_accelerator_{base_accelerator}, instances_{&base_instance}, has_motion_blur_{base_instance.hasMotionBlur()}
+{
+	if(!has_motion_blur_)
+	{
+		obj_to_world_ = base_instance.getObjToWorldMatrix(0);
+		world_to_obj_ = obj_to_world_;
+		world_to_obj_.inverse();
+	}
+}
+
+PrimitiveInstance::PrimitiveInstance(Logger &logger, const PrimitiveInstance &base_primitive_instance, const Instance &base_instance) : logger_{logger}, base_accelerator_{base_primitive_instance.base_accelerator_}, instances_{&base_instance}, has_motion_blur_{base_instance.hasMotionBlur() || base_primitive_instance.has_motion_blur_}
+{
+	instances_.insert(instances_.end(), base_primitive_instance.instances_.begin(), base_primitive_instance.instances_.end());
+	if(!has_motion_blur_)
+	{
+		obj_to_world_ = base_instance.getObjToWorldMatrix(0) * base_primitive_instance.obj_to_world_;
+		world_to_obj_ = obj_to_world_;
+		world_to_obj_.inverse();
+	}
+}
+
+void PrimitiveInstance::intersect(IntersectData &intersect_data, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const
+{
+	const Matrix4f world_to_obj{getWorldToObjMatrixAtTime(time)};
+	const Ray ray{world_to_obj * from, world_to_obj * dir, time, t_min, t_max};
+	const IntersectData base_intersect_data{base_accelerator_.intersect(ray, t_max)};
+	if(!base_intersect_data.isHit() || base_intersect_data.t_hit_ < t_min || base_intersect_data.t_hit_ >= t_max) return;
+	intersect_data.t_hit_ = base_intersect_data.t_hit_;
+	intersect_data.t_max_ = base_intersect_data.t_hit_;
+	intersect_data.uv_ = base_intersect_data.uv_;
+	intersect_data.primitive_ = base_intersect_data.primitive_;
+	intersect_data.instance_ = this;
+}
+
+bool PrimitiveInstance::intersectShadow(IntersectData &intersect_data, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const
+{
+	const Matrix4f world_to_obj{getWorldToObjMatrixAtTime(time)};
+	const Ray ray{world_to_obj * from, world_to_obj * dir, time, t_min, t_max};
+	const IntersectData base_intersect_data{base_accelerator_.intersectShadow(ray, t_max)};
+	if(!base_intersect_data.isHit() || base_intersect_data.t_hit_ < t_min || base_intersect_data.t_hit_ >= t_max) return false;
+	intersect_data.t_hit_ = base_intersect_data.t_hit_;
+	intersect_data.t_max_ = base_intersect_data.t_hit_;
+	intersect_data.uv_ = base_intersect_data.uv_;
+	intersect_data.primitive_ = base_intersect_data.primitive_;
+	intersect_data.instance_ = this;
+	return true;
+}
+
+bool PrimitiveInstance::intersectTransparentShadow(IntersectData &intersect_data, int &depth, int max_depth, const Camera *camera, const Point3f &from, const Vec3f &dir, float t_min, float t_max, float time) const
+{
+	//The base object is traversed in object space, but its transparent surfaces are evaluated in world space through the instance matrix, and each of them counts towards the transparency depth of the whole shadow ray
+	const Matrix4f obj_to_world{getObjToWorldMatrixAtTime(time)};
+	const Matrix4f world_to_obj{getWorldToObjMatrixAtTime(time)};
+	const Ray ray{world_to_obj * from, world_to_obj * dir, time, t_min, t_max};
+	const IntersectData base_intersect_data{base_accelerator_.intersectTransparentShadow(ray, max_depth - depth, t_max, camera, &obj_to_world)};
+	if(base_intersect_data.isHit())
+	{
+		intersect_data.t_hit_ = base_intersect_data.t_hit_;
+		intersect_data.t_max_ = base_intersect_data.t_hit_;
+		intersect_data.uv_ = base_intersect_data.uv_;
+		intersect_data.primitive_ = base_intersect_data.primitive_;
+		intersect_data.instance_ = this;
+		return true;
+	}
+	intersect_data.color_ *= base_intersect_data.color_;
+	depth += base_intersect_data.transparent_depth_;
+	return false;
+}
+
+void PrimitiveInstance::logNotSupported(const std::string &function_name) const
+{
+	logger_.logError("PrimitiveInstance::", function_name, " called, but the instances have no surface of their own: their hits resolve to the base object primitives, which must be used instead");
+}
+
+std::pair<float, Uv<float>> PrimitiveInstance::intersect(const Point3f &from, const Vec3f &dir, float time) const
+{
+	logNotSupported("intersect");
+	return {};
+}
+
+std::pair<float, Uv<float>> PrimitiveInstance::intersect(const Point3f &from, const Vec3f &dir, float time, const Matrix4f &obj_to_world) const
+{
+	logNotSupported("intersect");
+	return {};
+}
+
 std::unique_ptr<const SurfacePoint> PrimitiveInstance::getSurface(const RayDifferentials *ray_differentials, const Point3f &hit_point, float time, const Uv<float> &intersect_uv, const Camera *camera) const
 {
-	return base_primitive_.getSurface(ray_differentials, hit_point, time, intersect_uv, camera, base_instance_.getObjToWorldMatrixAtTime(time));
+	logNotSupported("getSurface");
+	return nullptr;
 }
 
 std::unique_ptr<const SurfacePoint> PrimitiveInstance::getSurface(const RayDifferentials *ray_differentials, const Point3f &hit_point, float time, const Uv<float> &intersect_uv, const Camera *camera, const Matrix4f &obj_to_world) const
 {
-	return base_primitive_.getSurface(ray_differentials, hit_point, time, intersect_uv, camera, obj_to_world * base_instance_.getObjToWorldMatrixAtTime(time));
+	logNotSupported("getSurface");
+	return nullptr;
+}
+
+const Material *PrimitiveInstance::getMaterial() const
+{
+	logNotSupported("getMaterial");
+	return nullptr;
+}
+
+float PrimitiveInstance::surfaceArea(float time) const
+{
+	logNotSupported("surfaceArea");
+	return 0.f;
+}
+
+float PrimitiveInstance::surfaceArea(float time, const Matrix4f &obj_to_world) const
+{
+	logNotSupported("surfaceArea");
+	return 0.f;
+}
+
+Vec3f PrimitiveInstance::getGeometricNormal(const Uv<float> &uv, float time, bool) const
+{
+	logNotSupported("getGeometricNormal");
+	return {};
+}
+
+Vec3f PrimitiveInstance::getGeometricNormal(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const
+{
+	logNotSupported("getGeometricNormal");
+	return {};
+}
+
+std::pair<Point3f, Vec3f> PrimitiveInstance::sample(const Uv<float> &uv, float time) const
+{
+	logNotSupported("sample");
+	return {};
+}
+
+std::pair<Point3f, Vec3f> PrimitiveInstance::sample(const Uv<float> &uv, float time, const Matrix4f &obj_to_world) const
+{
+	logNotSupported("sample");
+	return {};
+}
+
+float PrimitiveInstance::getDistToNearestEdge(const Uv<float> &uv, const Uv<Vec3f> &dp_abs) const
+{
+	logNotSupported("getDistToNearestEdge");
+	return 0.f;
+}
+
+Bound<float> PrimitiveInstance::getBound() const
+{
+	//Bounds are expanded from the innermost to the outermost instance, including all the motion blur time steps of each one
+	Bound<float> result{base_accelerator_.getBound()};
+	for(auto instance_it = instances_.rbegin(); instance_it != instances_.rend(); ++instance_it)
+	{
+		const std::vector<const Matrix4f *> matrices{(*instance_it)->getObjToWorldMatrices()};
+		Bound<float> instance_bound{transformBound(result, *matrices[0])};
+		for(size_t i = 1; i < matrices.size(); ++i)
+		{
+			instance_bound.include(transformBound(result, *matrices[i]));
+		}
+		result = instance_bound;
+	}
+	return result;
+}
+
+Bound<float> PrimitiveInstance::getBoundTimeInterval(float time_start, float time_end) const
+{
+	if(!has_motion_blur_) return getBound();
+	//Same as getBound(), but each instance only contributes the control matrices of its motion within the time interval
+	Bound<float> result{base_accelerator_.getBound()};
+	for(auto instance_it = instances_.rbegin(); instance_it != instances_.rend(); ++instance_it)
+	{
+		const std::vector<Matrix4f> matrices{(*instance_it)->getObjToWorldMatricesTimeInterval(time_start, time_end)};
+		Bound<float> instance_bound{transformBound(result, matrices[0])};
+		for(size_t i = 1; i < matrices.size(); ++i)
+		{
+			instance_bound.include(transformBound(result, matrices[i]));
+		}
+		result = instance_bound;
+	}
+	return result;
+}
+
+Bound<float> PrimitiveInstance::getBound(const Matrix4f &obj_to_world) const
+{
+	return transformBound(getBound(), obj_to_world);
 }
 
 } //namespace yafaray
@@ -19,6 +19,8 @@
 
 #include "image/image.h"
 #include "image/image_buffer.h"
+#include "image/image_tiled.h"
+#include "scene/scene.h"
 #include "common/file.h"
 #include "common/string.h"
 #include "format/format.h"
@@ -35,6 +37,7 @@ std::map<std::string, const ParamMeta *> Image::Params::getParamMetaMap()
 	PARAM_META(color_space_);
 	PARAM_META(gamma_);
 	PARAM_META(image_optimization_);
+	PARAM_META(buffer_layout_);
 	PARAM_META(width_);
 	PARAM_META(height_);
 	return param_meta_map;
@@ -47,6 +50,7 @@ Image::Params::Params(ParamResult &param_result, const ParamMap &param_map)
 	PARAM_ENUM_LOAD(color_space_);
 	PARAM_LOAD(gamma_);
 	PARAM_ENUM_LOAD(image_optimization_);
+	PARAM_ENUM_LOAD(buffer_layout_);
 	PARAM_LOAD(width_);
 	PARAM_LOAD(height_);
 }
@@ -59,6 +63,7 @@ ParamMap Image::getAsParamMap(bool only_non_default) const
 	PARAM_ENUM_SAVE(color_space_);
 	PARAM_SAVE(gamma_);
 	PARAM_ENUM_SAVE(image_optimization_);
+	PARAM_ENUM_SAVE(buffer_layout_);
 	PARAM_SAVE(width_);
 	PARAM_SAVE(height_);
 	return param_map;
@@ -99,6 +104,11 @@ std::pair<std::unique_ptr<Image>, ParamResult> Image::factory(Logger &logger, co
 		if(image)
 		{
 			logger.logInfo("Image '", name, "': loaded from file '", params.filename_, "'");
+			if(scene.getTextureCache())
+			{
+				if(auto tiled_image{TiledImage::factory(*image, scene.getTextureCache())}) image = std::move(tiled_image);
+				else logger.logWarning("Image '", name, "': could not be added to the texture cache, keeping it fully loaded in memory");
+			}
 		}
 		else
 		{
@@ -0,0 +1,36 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "image/image_tiled.h"
+
+namespace yafaray {
+
+std::unique_ptr<Image> TiledImage::factory(const Image &image, const std::shared_ptr<TextureCache> &texture_cache)
+{
+	if(!texture_cache) return nullptr;
+	const auto [image_layout, image_added]{texture_cache->addImage(image)};
+	if(!image_added) return nullptr;
+	Params params{image.params_};
+	params.image_optimization_ = image.getOptimization();
+	auto tiled_image{std::make_unique<TiledImage>(params, texture_cache, image_layout)};
+	tiled_image->setName(image.getName());
+	tiled_image->setId(image.getId());
+	return tiled_image;
+}
+
+} //namespace yafaray
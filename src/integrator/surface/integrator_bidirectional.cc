@@ -255,7 +255,7 @@ bool BidirectionalIntegrator::preprocess(RenderMonitor &render_monitor, const Re
 
 bool BidirectionalIntegrator::render(RenderControl &render_control, RenderMonitor &render_monitor)
 {
-	image_film_->setDensityEstimation(true);
+	image_film_->setDensityEstimation(true, num_threads_);
 	return ParentClassType_t::render(render_control, render_monitor);
 	//	if(logger_.isDebug())logger_.logDebug(integratorName << ": " << "cleanup: flushing light image");
 	image_film_->setNumDensitySamples(n_paths_); //dirty hack...
@@ -354,7 +354,7 @@ std::pair<Rgb, float> BidirectionalIntegrator::integrate(Ray &ray, RandomGenerat
 				float ix, idx, iy, idy;
 				idx = std::modf(path_data.u_, &ix);
 				idy = std::modf(path_data.v_, &iy);
-				image_film_->addDensitySample(li_col, {{static_cast<int>(ix), static_cast<int>(iy)}}, idx, idy);
+				image_film_->addDensitySample(li_col, {{static_cast<int>(ix), static_cast<int>(iy)}}, idx, idy, pixel_sampling_data.thread_id_);
 			}
 		}
 #endif
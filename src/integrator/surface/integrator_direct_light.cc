@@ -54,7 +54,7 @@ DirectLightIntegrator::DirectLightIntegrator(Logger &logger, ParamResult &param_
 
 bool DirectLightIntegrator::preprocess(RenderMonitor &render_monitor, const RenderControl &render_control, const Scene &scene)
 {
-	bool success = SurfaceIntegrator::preprocess(render_monitor, render_control, scene);
+	bool success = ParentClassType_t::preprocess(render_monitor, render_control, scene);
 	std::stringstream set;
 
 	render_monitor.addTimerEvent("prepass");
@@ -28,6 +28,7 @@
 #include "common/logger.h"
 #include "material/material.h"
 #include "light/light.h"
+#include "light/light_tree.h"
 #include "color/spectrum.h"
 #include "sampler/halton.h"
 #include "render/imagefilm.h"
@@ -51,6 +52,7 @@ std::map<std::string, const ParamMeta *> MonteCarloIntegrator::Params::getParamM
 	PARAM_META(ao_color_);
 	PARAM_META(transparent_background_);
 	PARAM_META(transparent_background_refraction_);
+	PARAM_META(light_sampling_);
 	return param_meta_map;
 }
 
@@ -65,6 +67,7 @@ MonteCarloIntegrator::Params::Params(ParamResult &param_result, const ParamMap &
 	PARAM_LOAD(ao_color_);
 	PARAM_LOAD(transparent_background_);
 	PARAM_LOAD(transparent_background_refraction_);
+	PARAM_ENUM_LOAD(light_sampling_);
 }
 
 ParamMap MonteCarloIntegrator::getAsParamMap(bool only_non_default) const
@@ -79,6 +82,7 @@ ParamMap MonteCarloIntegrator::getAsParamMap(bool only_non_default) const
 	PARAM_SAVE(ao_color_);
 	PARAM_SAVE(transparent_background_);
 	PARAM_SAVE(transparent_background_refraction_);
+	PARAM_ENUM_SAVE(light_sampling_);
 	return param_map;
 }
 
@@ -89,6 +93,18 @@ MonteCarloIntegrator::MonteCarloIntegrator(Logger &logger, ParamResult &param_re
 
 MonteCarloIntegrator::~MonteCarloIntegrator() = default;
 
+bool MonteCarloIntegrator::preprocess(RenderMonitor &render_monitor, const RenderControl &render_control, const Scene &scene)
+{
+	const bool success{ParentClassType_t::preprocess(render_monitor, render_control, scene)};
+	light_tree_.reset();
+	if(success && params_.light_sampling_ == LightSampling::LightTree && numLights() > 1)
+	{
+		light_tree_ = std::make_unique<const LightTree>(getLights());
+		if(logger_.isVerbose()) logger_.logVerbose(getName(), ": light tree built with ", light_tree_->numNodes(), " nodes, ", light_tree_->numUnboundedLights(), " unbounded lights");
+	}
+	return success;
+}
+
 Rgb MonteCarloIntegrator::estimateAllDirectLight(RandomGenerator &random_generator, ColorLayers *color_layers, bool chromatic_enabled, float wavelength, const SurfacePoint &sp, const Vec3f &wo, const RayDivision &ray_division, const PixelSamplingData &pixel_sampling_data) const
 {
 	Rgb col{0.f};
@@ -110,8 +126,15 @@ Rgb MonteCarloIntegrator::estimateOneDirectLight(RandomGenerator &random_generat
 	const int num_lights = numLights();
 	if(num_lights == 0) return Rgb{0.f};
 	Halton hal_2(2, image_film_->getBaseSamplingOffset() + correlative_sample_number[pixel_sampling_data.thread_id_] - 1); //Probably with this change the parameter "n" is no longer necessary, but I will keep it just in case I have to revert this change!
-	const int lnum = std::min(static_cast<int>(hal_2.getNext() * static_cast<float>(num_lights)), num_lights - 1);
+	const float s_light{hal_2.getNext()};
 	++correlative_sample_number[pixel_sampling_data.thread_id_];
+	if(light_tree_)
+	{
+		const auto [lnum, light_probability]{light_tree_->sample(sp.p_, sp.n_, s_light)};
+		if(light_probability <= 0.f) return Rgb{0.f};
+		return doLightEstimation(random_generator, nullptr, chromatic_enabled, wavelength, getLight(lnum), sp, wo, lnum, ray_division, pixel_sampling_data) / light_probability;
+	}
+	const int lnum = std::min(static_cast<int>(s_light * static_cast<float>(num_lights)), num_lights - 1);
 	return doLightEstimation(random_generator, nullptr, chromatic_enabled, wavelength, getLight(lnum), sp, wo, lnum, ray_division, pixel_sampling_data) * num_lights;
 }
 
@@ -465,8 +488,8 @@ std::pair<Rgb, float> MonteCarloIntegrator::dispersive(RandomGenerator &random_g
 		}
 		else wavelength_dispersive = 0.f;
 
-		ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
-		ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
+		ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
+		ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
 		ray_division_new.offset_ = branch;
 		++branch;
 		Sample s(0.5f, 0.5f, BsdfFlags::Reflect | BsdfFlags::Transmit | BsdfFlags::Dispersive);
@@ -527,8 +550,8 @@ std::pair<Rgb, float> MonteCarloIntegrator::glossy(RandomGenerator &random_gener
 
 	for(int ns = 0; ns < ray_samples_glossy; ++ns)
 	{
-		ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
-		ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
+		ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
+		ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
 		ray_division_new.offset_ = branch;
 		++offs;
 		++branch;
@@ -82,7 +82,7 @@ PathIntegrator::PathIntegrator(Logger &logger, ParamResult &param_result, const
 
 bool PathIntegrator::preprocess(RenderMonitor &render_monitor, const RenderControl &render_control, const Scene &scene)
 {
-	bool success = SurfaceIntegrator::preprocess(render_monitor, render_control, scene);
+	bool success = ParentClassType_t::preprocess(render_monitor, render_control, scene);
 	std::stringstream set;
 
 	render_monitor.addTimerEvent("prepass");
@@ -193,7 +193,7 @@ std::pair<Rgb, float> PathIntegrator::integrate(Ray &ray, RandomGenerator &rando
 				const float wavelength_dispersive = chromatic_enabled ? sample::riS(offs) : 0.f;
 				//this mat already is initialized, just sample (diffuse...non-specular?)
 				float s_1 = sample::riVdC(offs);
-				float s_2 = Halton::lowDiscrepancySampling(fast_random_, 2, offs);
+				float s_2 = Halton::lowDiscrepancySampling(random_generator, 2, offs);
 				if(ray_division.division_ > 1)
 				{
 					s_1 = math::addMod1(s_1, ray_division.decorrelation_1_);
@@ -229,8 +229,8 @@ std::pair<Rgb, float> PathIntegrator::integrate(Ray &ray, RandomGenerator &rando
 				for(int depth = 1; depth < params_.bounces_; ++depth)
 				{
 					int d_4 = 4 * depth;
-					s.s_1_ = Halton::lowDiscrepancySampling(fast_random_, d_4 + 3, offs); //ourRandom();//
-					s.s_2_ = Halton::lowDiscrepancySampling(fast_random_, d_4 + 4, offs); //ourRandom();//
+					s.s_1_ = Halton::lowDiscrepancySampling(random_generator, d_4 + 3, offs); //ourRandom();//
+					s.s_2_ = Halton::lowDiscrepancySampling(random_generator, d_4 + 4, offs); //ourRandom();//
 
 					if(ray_division.division_ > 1)
 					{
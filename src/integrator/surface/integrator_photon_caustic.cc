@@ -40,6 +40,7 @@
 #include "photon/photon_sample.h"
 #include "volume/handler/volume_handler.h"
 #include "common/sysinfo.h"
+#include "common/thread_pool.h"
 #include "render/render_monitor.h"
 
 namespace yafaray {
@@ -110,15 +111,16 @@ void CausticPhotonIntegrator::causticWorker(RenderMonitor &render_monitor, unsig
 	std::unique_ptr<const SurfacePoint> hit_prev, hit_curr;
 	local_caustic_photons.clear();
 	local_caustic_photons.reserve(n_caus_photons_thread);
+	RandomGenerator random_generator(RandomGenerator::seed(thread_id, n_caus_photons_, 0));
 	while(!done)
 	{
 		if(render_control.canceled()) return;
 		const unsigned int haltoncurr = curr + n_caus_photons_thread * thread_id;
 		const float wavelength = sample::riS(haltoncurr);
 		const float s_1 = sample::riVdC(haltoncurr);
-		const float s_2 = Halton::lowDiscrepancySampling(fast_random_, 2, haltoncurr);
-		const float s_3 = Halton::lowDiscrepancySampling(fast_random_, 3, haltoncurr);
-		const float s_4 = Halton::lowDiscrepancySampling(fast_random_, 4, haltoncurr);
+		const float s_2 = Halton::lowDiscrepancySampling(random_generator, 2, haltoncurr);
+		const float s_3 = Halton::lowDiscrepancySampling(random_generator, 3, haltoncurr);
+		const float s_4 = Halton::lowDiscrepancySampling(random_generator, 4, haltoncurr);
 		const float s_l = static_cast<float>(haltoncurr) / static_cast<float>(n_caus_photons_);
 		const auto [light_num, light_num_pdf]{light_power_d_caustic->dSample(s_l)};
 		if(light_num >= num_lights_caustic)
@@ -177,9 +179,9 @@ void CausticPhotonIntegrator::causticWorker(RenderMonitor &render_monitor, unsig
 			const int d_5 = 3 * n_bounces + 5;
 			//int d6 = d5 + 1;
 
-			const float s_5 = Halton::lowDiscrepancySampling(fast_random_, d_5, haltoncurr);
-			const float s_6 = Halton::lowDiscrepancySampling(fast_random_, d_5 + 1, haltoncurr);
-			const float s_7 = Halton::lowDiscrepancySampling(fast_random_, d_5 + 2, haltoncurr);
+			const float s_5 = Halton::lowDiscrepancySampling(random_generator, d_5, haltoncurr);
+			const float s_6 = Halton::lowDiscrepancySampling(random_generator, d_5 + 1, haltoncurr);
+			const float s_7 = Halton::lowDiscrepancySampling(random_generator, d_5 + 2, haltoncurr);
 
 			PSample sample(s_5, s_6, s_7, BsdfFlags::AllSpecular | BsdfFlags::Glossy | BsdfFlags::Filter | BsdfFlags::Dispersive, pcol, transm);
 			Vec3f wo;
@@ -259,10 +261,10 @@ bool CausticPhotonIntegrator::createCausticMap(RenderMonitor &render_monitor, co
 
 		logger_.logParams(getName(), ": Shooting ", n_caus_photons_, " photons across ", num_threads_photons_, " threads (", (n_caus_photons_ / num_threads_photons_), " photons/thread)");
 
-		std::vector<std::thread> threads;
-		threads.reserve(num_threads_photons_);
-		for(int i = 0; i < num_threads_photons_; ++i) threads.emplace_back(&CausticPhotonIntegrator::causticWorker, this, std::ref(render_monitor), std::ref(curr), std::ref(render_control), i, light_power_d_caustic.get(), lights_caustic, pb_step);
-		for(auto &t : threads) t.join();
+		TaskGroup photon_tasks;
+		const Pdf1D *light_power_d_caustic_ptr = light_power_d_caustic.get();
+		for(int i = 0; i < num_threads_photons_; ++i) photon_tasks.run([=, &render_monitor, &curr, &render_control, &lights_caustic] { causticWorker(render_monitor, curr, render_control, i, light_power_d_caustic_ptr, lights_caustic, pb_step); });
+		photon_tasks.wait();
 
 		render_monitor.setProgressBarAsDone();
 		render_monitor.setProgressBarTag("Caustic photon map built.");
@@ -36,6 +36,7 @@
 #include "volume/handler/volume_handler.h"
 #include "integrator/volume/integrator_volume.h"
 #include "render/render_monitor.h"
+#include "common/thread_pool.h"
 
 namespace yafaray {
 
@@ -169,14 +170,15 @@ void PhotonIntegrator::diffuseWorker(RenderMonitor &render_monitor, PreGatherDat
 	local_diffuse_photons.reserve(n_diffuse_photons_thread);
 	local_rad_points.clear();
 	const float inv_diff_photons = 1.f / static_cast<float>(photons_diffuse_);
+	RandomGenerator random_generator(RandomGenerator::seed(thread_id, photons_diffuse_, 0));
 	while(!done)
 	{
 		if(render_control.canceled()) return;
 		unsigned int haltoncurr = curr + n_diffuse_photons_thread * thread_id;
 		const float s_1 = sample::riVdC(haltoncurr);
-		const float s_2 = Halton::lowDiscrepancySampling(fast_random_, 2, haltoncurr);
-		const float s_3 = Halton::lowDiscrepancySampling(fast_random_, 3, haltoncurr);
-		const float s_4 = Halton::lowDiscrepancySampling(fast_random_, 4, haltoncurr);
+		const float s_2 = Halton::lowDiscrepancySampling(random_generator, 2, haltoncurr);
+		const float s_3 = Halton::lowDiscrepancySampling(random_generator, 3, haltoncurr);
+		const float s_4 = Halton::lowDiscrepancySampling(random_generator, 4, haltoncurr);
 		const float s_l = float(haltoncurr) * inv_diff_photons;
 		const auto [light_num, light_num_pdf]{light_power_d->dSample(s_l)};
 		if(light_num >= num_lights_diffuse)
@@ -228,12 +230,12 @@ void PhotonIntegrator::diffuseWorker(RenderMonitor &render_monitor, PreGatherDat
 				}
 				// create entry for radiance photon:
 				// don't forget to choose subset only, face normal forward; geometric vs. smooth normal?
-				if(params_.final_gather_ && fast_random_.getNextFloatNormalized() < 0.125 && !caustic_photon)
+				if(params_.final_gather_ && random_generator() < 0.125 && !caustic_photon)
 				{
 					const Vec3f n{SurfacePoint::normalFaceForward(hit_curr->ng_, hit_curr->n_, wi)};
 					RadData rd(hit_curr->p_, n, ray.time_);
-					rd.refl_ = hit_curr->getReflectivity(fast_random_, BsdfFlags::Diffuse | BsdfFlags::Glossy | BsdfFlags::Reflect, true);
-					rd.transm_ = hit_curr->getReflectivity(fast_random_, BsdfFlags::Diffuse | BsdfFlags::Glossy | BsdfFlags::Transmit, true);
+					rd.refl_ = hit_curr->getReflectivity(random_generator, BsdfFlags::Diffuse | BsdfFlags::Glossy | BsdfFlags::Reflect, true);
+					rd.transm_ = hit_curr->getReflectivity(random_generator, BsdfFlags::Diffuse | BsdfFlags::Glossy | BsdfFlags::Transmit, true);
 					local_rad_points.emplace_back(rd);
 				}
 			}
@@ -241,9 +243,9 @@ void PhotonIntegrator::diffuseWorker(RenderMonitor &render_monitor, PreGatherDat
 			if(n_bounces == params_.bounces_) break;
 			// scatter photon
 			const int d_5 = 3 * n_bounces + 5;
-			const float s_5 = Halton::lowDiscrepancySampling(fast_random_, d_5, haltoncurr);
-			const float s_6 = Halton::lowDiscrepancySampling(fast_random_, d_5 + 1, haltoncurr);
-			const float s_7 = Halton::lowDiscrepancySampling(fast_random_, d_5 + 2, haltoncurr);
+			const float s_5 = Halton::lowDiscrepancySampling(random_generator, d_5, haltoncurr);
+			const float s_6 = Halton::lowDiscrepancySampling(random_generator, d_5 + 1, haltoncurr);
+			const float s_7 = Halton::lowDiscrepancySampling(random_generator, d_5 + 2, haltoncurr);
 			PSample sample(s_5, s_6, s_7, BsdfFlags::All, pcol, transm);
 			Vec3f wo;
 			bool scattered = hit_curr->scatterPhoton(wi, wo, sample, true);
@@ -286,7 +288,7 @@ void PhotonIntegrator::photonMapKdTreeWorker(PhotonMap *photon_map, const Render
 
 bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderControl &render_control, const Scene &scene)
 {
-	bool success = SurfaceIntegrator::preprocess(render_monitor, render_control, scene);
+	bool success = ParentClassType_t::preprocess(render_monitor, render_control, scene);
 
 	std::stringstream set;
 
@@ -368,10 +370,10 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 		//Pregather diffuse photons
 		photons_diffuse_ = std::max(num_threads_photons_, (photons_diffuse_ / num_threads_photons_) * num_threads_photons_); //rounding the number of diffuse photons so it's a number divisible by the number of threads (distribute uniformly among the threads). At least 1 photon per thread
 		logger_.logParams(getName(), ": Shooting ", photons_diffuse_, " photons across ", num_threads_photons_, " threads (", (photons_diffuse_ / num_threads_photons_), " photons/thread)");
-		std::vector<std::thread> threads;
-		threads.reserve(num_threads_photons_);
-		for(int i = 0; i < num_threads_photons_; ++i) threads.emplace_back(&PhotonIntegrator::diffuseWorker, this, std::ref(render_monitor), std::ref(pgdat), std::ref(curr), std::ref(render_control), i, light_power_d_diffuse.get(), lights_diffuse, pb_step);
-		for(auto &t : threads) t.join();
+		TaskGroup photon_tasks;
+		const Pdf1D *light_power_d_diffuse_ptr = light_power_d_diffuse.get();
+		for(int i = 0; i < num_threads_photons_; ++i) photon_tasks.run([=, &render_monitor, &pgdat, &curr, &render_control, &lights_diffuse] { diffuseWorker(render_monitor, pgdat, curr, render_control, i, light_power_d_diffuse_ptr, lights_diffuse, pb_step); });
+		photon_tasks.wait();
 
 		render_monitor.setProgressBarAsDone();
 		render_monitor.setProgressBarTag("Diffuse photon map built.");
@@ -391,7 +393,7 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 		logger_.logInfo(getName(), ": Diffuse photon mapping disabled, skipping...");
 	}
 
-	std::thread diffuse_map_build_kd_tree_thread;
+	TaskGroup diffuse_map_build_kd_tree_task;
 
 	if(use_photon_diffuse_ && getDiffuseMap()->nPhotons() > 0)
 	{
@@ -399,7 +401,7 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 		{
 			logger_.logInfo(getName(), ": Building diffuse photons kd-tree:");
 			render_monitor.setProgressBarTag("Building diffuse photons kd-tree...");
-			diffuse_map_build_kd_tree_thread = std::thread(&PhotonIntegrator::photonMapKdTreeWorker, diffuse_map_.get(), std::ref(render_monitor), std::ref(render_control));
+			diffuse_map_build_kd_tree_task.run([this, &render_monitor, &render_control] { photonMapKdTreeWorker(diffuse_map_.get(), render_monitor, render_control); });
 		}
 		else
 		{
@@ -447,10 +449,10 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 
 		logger_.logParams(getName(), ": Shooting ", n_caus_photons_, " photons across ", num_threads_photons_, " threads (", (n_caus_photons_ / num_threads_photons_), " photons/thread)");
 
-		std::vector<std::thread> threads;
-		threads.reserve(num_threads_photons_);
-		for(int i = 0; i < num_threads_photons_; ++i) threads.emplace_back(&PhotonIntegrator::causticWorker, this, std::ref(render_monitor), std::ref(curr), std::ref(render_control), i, light_power_d_caustic.get(), lights_caustic, pb_step);
-		for(auto &t : threads) t.join();
+		TaskGroup photon_tasks;
+		const Pdf1D *light_power_d_caustic_ptr = light_power_d_caustic.get();
+		for(int i = 0; i < num_threads_photons_; ++i) photon_tasks.run([=, &render_monitor, &curr, &render_control, &lights_caustic] { causticWorker(render_monitor, curr, render_control, i, light_power_d_caustic_ptr, lights_caustic, pb_step); });
+		photon_tasks.wait();
 
 		render_monitor.setProgressBarAsDone();
 		render_monitor.setProgressBarTag("Caustics photon map built.");
@@ -462,14 +464,14 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 		logger_.logInfo(getName(), ": Caustics photon mapping disabled, skipping...");
 	}
 
-	std::thread caustic_map_build_kd_tree_thread;
+	TaskGroup caustic_map_build_kd_tree_task;
 	if(CausticPhotonIntegrator::params_.use_photon_caustics_ && getCausticMap()->nPhotons() > 0)
 	{
 		if(num_threads_photons_ >= 2)
 		{
 			logger_.logInfo(getName(), ": Building caustic photons kd-tree:");
 			render_monitor.setProgressBarTag("Building caustic photons kd-tree...");
-			caustic_map_build_kd_tree_thread = std::thread(&PhotonIntegrator::photonMapKdTreeWorker, caustic_map_.get(), std::ref(render_monitor), std::ref(render_control));
+			caustic_map_build_kd_tree_task.run([this, &render_monitor, &render_control] { photonMapKdTreeWorker(caustic_map_.get(), render_monitor, render_control); });
 		}
 		else
 		{
@@ -482,7 +484,7 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 
 	if(use_photon_diffuse_ && getDiffuseMap()->nPhotons() > 0 && num_threads_photons_ >= 2)
 	{
-		diffuse_map_build_kd_tree_thread.join();
+		diffuse_map_build_kd_tree_task.wait();
 		if(logger_.isVerbose()) logger_.logVerbose(getName(), ": Diffuse photon map: done.");
 	}
 
@@ -508,10 +510,11 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 		render_monitor.initProgressBar(pgdat.rad_points_.size(), logger_.getConsoleLogColorsEnabled());
 		render_monitor.setProgressBarTag("Pregathering radiance data for final gathering...");
 
-		std::vector<std::thread> threads;
-		threads.reserve(n_threads);
-		for(int i = 0; i < n_threads; ++i) threads.emplace_back(&PhotonIntegrator::preGatherWorker, std::ref(render_monitor), &pgdat, std::ref(render_control), params_.diffuse_radius_, params_.num_photons_diffuse_search_);
-		for(auto &t : threads) t.join();
+		TaskGroup pregather_tasks;
+		const float diffuse_radius = params_.diffuse_radius_;
+		const int num_photons_diffuse_search = params_.num_photons_diffuse_search_;
+		for(int i = 0; i < n_threads; ++i) pregather_tasks.run([&render_monitor, &pgdat, &render_control, diffuse_radius, num_photons_diffuse_search] { preGatherWorker(render_monitor, &pgdat, render_control, diffuse_radius, num_photons_diffuse_search); });
+		pregather_tasks.wait();
 
 		getRadianceMap()->swapVector(pgdat.radiance_vec_);
 		render_monitor.setProgressBarAsDone();
@@ -523,7 +526,7 @@ bool PhotonIntegrator::preprocess(RenderMonitor &render_monitor, const RenderCon
 
 	if(CausticPhotonIntegrator::params_.use_photon_caustics_ && getCausticMap()->nPhotons() > 0 && num_threads_photons_ >= 2)
 	{
-		caustic_map_build_kd_tree_thread.join();
+		caustic_map_build_kd_tree_task.wait();
 		if(logger_.isVerbose()) logger_.logVerbose(getName(), ": Caustic photon map: done.");
 	}
 
@@ -562,7 +565,7 @@ Rgb PhotonIntegrator::finalGathering(RandomGenerator &random_generator, std::vec
 		Rgb lcol, scol;
 		// "zero'th" FG bounce:
 		float s_1 = sample::riVdC(offs);
-		float s_2 = Halton::lowDiscrepancySampling(fast_random_, 2, offs);
+		float s_2 = Halton::lowDiscrepancySampling(random_generator, 2, offs);
 		if(ray_division.division_ > 1)
 		{
 			s_1 = math::addMod1(s_1, ray_division.decorrelation_1_);
@@ -621,8 +624,8 @@ Rgb PhotonIntegrator::finalGathering(RandomGenerator &random_generator, std::vec
 				}
 			}
 
-			s_1 = Halton::lowDiscrepancySampling(fast_random_, d_4 + 3, offs);
-			s_2 = Halton::lowDiscrepancySampling(fast_random_, d_4 + 4, offs);
+			s_1 = Halton::lowDiscrepancySampling(random_generator, d_4 + 3, offs);
+			s_2 = Halton::lowDiscrepancySampling(random_generator, d_4 + 4, offs);
 
 			if(ray_division.division_ > 1)
 			{
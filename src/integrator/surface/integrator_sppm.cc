@@ -20,6 +20,8 @@
 
 #include "integrator/surface/integrator_sppm.h"
 #include "geometry/surface.h"
+#include "common/memory_arena.h"
+#include "common/thread_pool.h"
 #include "param/param.h"
 #include "render/imagefilm.h"
 #include "sampler/sample_pdf1d.h"
@@ -204,7 +206,6 @@ bool SppmIntegrator::render(RenderControl &render_control, RenderMonitor &render
 bool SppmIntegrator::renderTile(std::vector<int> &correlative_sample_number, const RenderArea &a, int n_samples, int offset, bool adaptive, int thread_id, int aa_pass_number, float aa_light_sample_multiplier, float aa_indirect_sample_multiplier, const RenderMonitor &render_monitor, const RenderControl &render_control)
 {
 	const int camera_res_x = image_film_->getCamera()->resX();
-	RandomGenerator random_generator(rand() + offset * (camera_res_x * a.y_ + a.x_) + 123);
 	const bool sample_lns = image_film_->getCamera()->sampleLens();
 	const int pass_offs = offset, end_x = a.x_ + a.w_, end_y = a.y_ + a.h_;
 	int aa_max_possible_samples = aa_noise_params_->samples_;
@@ -213,6 +214,7 @@ bool SppmIntegrator::renderTile(std::vector<int> &correlative_sample_number, con
 		aa_max_possible_samples += ceilf(aa_noise_params_->inc_samples_ * math::pow(aa_noise_params_->sample_multiplier_factor_, i));
 	}
 	float inv_aa_max_possible_samples = 1.f / static_cast<float>(aa_max_possible_samples);
+	const AaNoiseParams::SamplerType sampler_type{aa_noise_params_->sampler_type_};
 	ColorLayers color_layers(*image_film_->getLayers());
 	const int x_start_film = image_film_->getCx0();
 	const int y_start_film = image_film_->getCy0();
@@ -222,6 +224,7 @@ bool SppmIntegrator::renderTile(std::vector<int> &correlative_sample_number, con
 		for(int j = a.x_; j < end_x; ++j)
 		{
 			if(render_control.canceled()) break;
+			RandomGenerator random_generator(RandomGenerator::seed(j, i, offset)); //per pixel generator, so the pixel samples do not depend on the thread or on the order the tiles are rendered
 			color_layers.setDefaultColors();
 			PixelSamplingData pixel_sampling_data{
 					thread_id,
@@ -230,26 +233,38 @@ bool SppmIntegrator::renderTile(std::vector<int> &correlative_sample_number, con
 					aa_light_sample_multiplier,
 					aa_indirect_sample_multiplier
 			};
-			float toff = Halton::lowDiscrepancySampling(fast_random_, 5, pass_offs + pixel_sampling_data.offset_); // **shall be just the pass number...**
+			const unsigned int pixel_seed = RandomGenerator::seed(j, i, 0); //same seed in all the passes, so the progressive samplers continue their sequences
+			float toff = Halton::lowDiscrepancySampling(random_generator, 5, pass_offs + pixel_sampling_data.offset_); // **shall be just the pass number...**
 			for(int sample = 0; sample < n_samples; ++sample) //set n_samples = 1.
 			{
+				const ThreadMemoryArena::SampleScope sample_memory_scope; //Surface points, material data, ray differentials, etc. allocated for this sample are released at once at the end of the sample
 				pixel_sampling_data.sample_ = pass_offs + sample;
-				const float time = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : math::addMod1(static_cast<float>(sample) * d_1, toff); //(0.5+(float)sample)*d1;
-				// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
-				// hence we use scrambled (Sobol, van-der-Corput) for multipass AA //!< the current (normalized) frame time  //FIXME, time not currently used in libYafaRay
-				pixel_sampling_data.time_ = time;
 				float dx = 0.5f, dy = 0.5f;
-				dx = sample::riVdC(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
-				dy = sample::riS(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
-
 				Uv<float> lens_uv{0.5f, 0.5f};
-				if(sample_lns)
+				if(sampler_type != AaNoiseParams::SamplerType::Halton)
 				{
-					lens_uv = {
-							static_cast<float>(Halton::lowDiscrepancySampling(fast_random_, 3, pixel_sampling_data.sample_ + pixel_sampling_data.offset_)),
-							static_cast<float>(Halton::lowDiscrepancySampling(fast_random_, 4, pixel_sampling_data.sample_ + pixel_sampling_data.offset_))
-					};
+					const PixelSample pixel_sample{pixelSample(sampler_type, pixel_sampling_data.sample_, pixel_seed)};
+					dx = pixel_sample.offset_.u_;
+					dy = pixel_sample.offset_.v_;
+					if(sample_lns) lens_uv = pixel_sample.lens_;
+					pixel_sampling_data.time_ = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : pixel_sample.time_;
 				}
+				else
+				{
+					// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
+					// hence we use scrambled (Sobol, van-der-Corput) for multipass AA //!< the current (normalized) frame time  //FIXME, time not currently used in libYafaRay
+					pixel_sampling_data.time_ = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : math::addMod1(static_cast<float>(sample) * d_1, toff); //(0.5+(float)sample)*d1;
+					dx = sample::riVdC(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
+					dy = sample::riS(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
+					if(sample_lns)
+					{
+						lens_uv = {
+								static_cast<float>(Halton::lowDiscrepancySampling(random_generator, 3, pixel_sampling_data.sample_ + pixel_sampling_data.offset_)),
+								static_cast<float>(Halton::lowDiscrepancySampling(random_generator, 4, pixel_sampling_data.sample_ + pixel_sampling_data.offset_))
+						};
+					}
+				}
+				const float time = pixel_sampling_data.time_;
 				CameraRay camera_ray = image_film_->getCamera()->shootRay(static_cast<float>(j) + dx, static_cast<float>(i) + dy, lens_uv); // wt need to be considered
 				if(!camera_ray.valid_)
 				{
@@ -295,8 +310,9 @@ bool SppmIntegrator::renderTile(std::vector<int> &correlative_sample_number, con
 				color.a_ = g_info.constant_randiance_.a_; //the alpha value is hold in the constantRadiance variable
 				color_layers(LayerDef::Combined) = color;
 
-				for(auto &[layer_def, layer_col] : color_layers)
+				for(const LayerDef::Type layer_def : color_layers)
 				{
+					Rgba &layer_col = color_layers(layer_def);
 					switch(layer_def)
 					{
 						case LayerDef::ObjIndexMask:
@@ -376,18 +392,21 @@ void SppmIntegrator::photonWorker(RenderControl &render_control, RenderMonitor &
 	unsigned int nd_photon_stored = 0;
 	//	unsigned int ncPhotonStored = 0;
 
+	//Each thread continues the halton sequences from its own start, after the photons shot in the previous passes, so the threads do not share any sampling state
+	RandomGenerator random_generator(RandomGenerator::seed(thread_id, static_cast<unsigned int>(totaln_photons_), 0));
+	const auto halton_start = static_cast<unsigned int>(totaln_photons_ + n_photons_thread * thread_id);
+	Halton hal_1{2, halton_start}, hal_2{3, halton_start}, hal_3{5, halton_start}, hal_4{7, halton_start};
+
 	while(!done)
 	{
 		unsigned int haltoncurr = curr + n_photons_thread * thread_id;
-		const float wavelength = Halton::lowDiscrepancySampling(fast_random_, 5, haltoncurr);
+		const float wavelength = Halton::lowDiscrepancySampling(random_generator, 5, haltoncurr);
 
 		// Tried LD, get bad and strange results for some stategy.
-		mutex_.lock();
-		const float s_1 = hal_1_.getNext();
-		const float s_2 = hal_2_.getNext();
-		const float s_3 = hal_3_.getNext();
-		const float s_4 = hal_4_.getNext();
-		mutex_.unlock();
+		const float s_1 = hal_1.getNext();
+		const float s_2 = hal_2.getNext();
+		const float s_3 = hal_3.getNext();
+		const float s_4 = hal_4.getNext();
 		const float s_l = static_cast<float>(haltoncurr) * inv_diff_photons; // Does sL also need more random_generator for each pass?
 		const auto [light_num, light_num_pdf]{light_power_d->dSample(s_l)};
 		if(light_num >= num_d_lights)
@@ -455,9 +474,9 @@ void SppmIntegrator::photonWorker(RenderControl &render_control, RenderMonitor &
 			if(n_bounces == params_.bounces_) break;
 
 			// scatter photon
-			const float s_5 = fast_random_.getNextFloatNormalized(); // now should use this to see correctness
-			const float s_6 = fast_random_.getNextFloatNormalized();
-			const float s_7 = fast_random_.getNextFloatNormalized();
+			const float s_5 = random_generator(); // now should use this to see correctness
+			const float s_6 = random_generator();
+			const float s_7 = random_generator();
 
 			PSample sample(s_5, s_6, s_7, BsdfFlags::All, pcol, transm);
 
@@ -545,7 +564,6 @@ void SppmIntegrator::prePass(RenderControl &render_control, RenderMonitor &rende
 
 	//shoot photons
 	unsigned int curr = 0;
-	RandomGenerator random_generator(rand() + offset * (4517) + 123);
 	std::string previous_progress_tag = render_monitor.getProgressBarTag();
 	int previous_progress_total_steps = render_monitor.getProgressBarTotalSteps();
 
@@ -559,10 +577,10 @@ void SppmIntegrator::prePass(RenderControl &render_control, RenderMonitor &rende
 
 	logger_.logParams(getName(), ": Shooting ", n_photons_, " photons across ", num_threads_photons_, " threads (", (n_photons_ / num_threads_photons_), " photons/thread)");
 
-	std::vector<std::thread> threads;
-	threads.reserve(num_threads_photons_);
-	for(int i = 0; i < num_threads_photons_; ++i) threads.emplace_back(&SppmIntegrator::photonWorker, this, std::ref(render_control), std::ref(render_monitor), std::ref(curr), i, num_lights, light_power_d.get(), getLights(), pb_step);
-	for(auto &t : threads) t.join();
+	TaskGroup photon_tasks;
+	const Pdf1D *light_power_d_ptr = light_power_d.get();
+	for(int i = 0; i < num_threads_photons_; ++i) photon_tasks.run([=, &render_control, &render_monitor, &curr] { photonWorker(render_control, render_monitor, curr, i, num_lights, light_power_d_ptr, getLights(), pb_step); });
+	photon_tasks.wait();
 
 	render_monitor.setProgressBarAsDone();
 	render_monitor.setProgressBarTag(previous_progress_tag + " - photon map built.");
@@ -576,7 +594,7 @@ void SppmIntegrator::prePass(RenderControl &render_control, RenderMonitor &rende
 	if(b_hashgrid_)
 	{
 		logger_.logInfo(getName(), ": Building photons hashgrid:");
-		photon_grid_.updateGrid();
+		photon_grid_.updateGrid(num_threads_photons_);
 		if(logger_.isVerbose()) logger_.logVerbose(getName(), ": Done.");
 	}
 	else
@@ -782,8 +800,8 @@ GatherInfo SppmIntegrator::traceGatherRay(Ray &ray, HitPoint &hp, RandomGenerato
 						if(ray_division.division_ > 1) wavelength_dispersive = math::addMod1(wavelength_dispersive, ray_division.decorrelation_1_);
 					}
 					else wavelength_dispersive = 0.f;
-					ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
-					ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
+					ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
+					ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
 					ray_division_new.offset_ = branch;
 					++branch;
 					Sample s(0.5f, 0.5f, BsdfFlags::Reflect | BsdfFlags::Transmit | BsdfFlags::Dispersive);
@@ -846,8 +864,8 @@ GatherInfo SppmIntegrator::traceGatherRay(Ray &ray, HitPoint &hp, RandomGenerato
 
 				for(int ns = 0; ns < ray_samples_glossy; ++ns)
 				{
-					ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
-					ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(fast_random_, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
+					ray_division_new.decorrelation_1_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 1, branch + pixel_sampling_data.offset_);
+					ray_division_new.decorrelation_2_ = Halton::lowDiscrepancySampling(random_generator, 2 * ray_level + 2, branch + pixel_sampling_data.offset_);
 					ray_division_new.offset_ = branch;
 					++offs;
 					++branch;
@@ -29,6 +29,7 @@
 #include "render/imagesplitter.h"
 #include "scene/scene.h"
 #include "render/imagefilm.h"
+#include "render/render_monitor.h"
 #include "light/light.h"
 #include "common/string.h"
 #include "common/sysinfo.h"
@@ -235,7 +236,10 @@ bool SurfaceIntegrator::render(RenderControl &render_control, RenderMonitor &ren
 		logger_.logError(getClassName(), " '", getName(), "': Rendering process failed, exiting...");
 		return false;
 	}
+	render_monitor.addTimerEvent("output");
+	render_monitor.startTimer("output");
 	image_film_->flush(render_control, render_monitor, ImageFilm::All);
+	render_monitor.stopTimer("output");
 	render_control.setFinished();
 	image_film_ = nullptr;
 	return true;
@@ -28,8 +28,12 @@
 #include "common/layers.h"
 #include "background/background.h"
 #include "geometry/surface.h"
+#include "common/memory_arena.h"
+#include "common/thread_pool.h"
 #include "geometry/primitive/primitive.h"
 #include "sampler/halton.h"
+#include "sampler/pmj02.h"
+#include "sampler/sobol.h"
 #include "render/imagefilm.h"
 #include "camera/camera.h"
 #include "sampler/sample.h"
@@ -43,7 +47,7 @@
 
 namespace yafaray {
 
-void TiledIntegrator::renderWorker(ThreadControl *control, std::vector<int> &correlative_sample_number, int thread_id, int samples, int offset, bool adaptive, int aa_pass, float aa_light_sample_multiplier, float aa_indirect_sample_multiplier, const RenderMonitor &render_monitor, const RenderControl &render_control)
+void TiledIntegrator::renderWorker(std::vector<int> &correlative_sample_number, int thread_id, int samples, int offset, bool adaptive, int aa_pass, float aa_light_sample_multiplier, float aa_indirect_sample_multiplier, RenderMonitor &render_monitor, RenderControl &render_control)
 {
 	RenderArea a;
 
@@ -51,15 +55,8 @@ void TiledIntegrator::renderWorker(ThreadControl *control, std::vector<int> &cor
 	{
 		if(render_control.canceled()) break;
 		renderTile(correlative_sample_number, a, samples, offset, adaptive, thread_id, aa_pass, aa_light_sample_multiplier, aa_indirect_sample_multiplier, render_monitor, render_control);
-
-		std::unique_lock<std::mutex> lk(control->m_);
-		control->areas_.emplace_back(a);
-		control->c_.notify_one();
-
+		image_film_->finishArea(render_control, render_monitor, a); //Only queues the area, the image film output stage does the conversions, callbacks and autosaving
 	}
-	std::unique_lock<std::mutex> lk(control->m_);
-	++(control->finished_threads_);
-	control->c_.notify_one();
 }
 
 void TiledIntegrator::precalcDepths() const
@@ -226,26 +223,19 @@ bool TiledIntegrator::renderPass(RenderControl &render_control, RenderMonitor &r
 	prePass(render_control, render_monitor, samples, (offset + image_film_->getBaseSamplingOffset()), adaptive);
 
 	render_monitor.setCurrentPass(aa_pass_number + 1);
+	const std::string pass_timer_event{"pass_" + std::to_string(aa_pass_number + 1)};
+	render_monitor.addTimerEvent(pass_timer_event);
+	render_monitor.startTimer(pass_timer_event);
 
 	image_film_->setSamplingOffset(offset + samples);
 
-	ThreadControl tc;
-	std::vector<std::thread> threads;
-	threads.reserve(num_threads_);
-	for(int i = 0; i < num_threads_; ++i) threads.emplace_back(&TiledIntegrator::renderWorker, this, &tc, std::ref(correlative_sample_number), i, samples, (offset + image_film_->getBaseSamplingOffset()), adaptive, aa_pass_number, aa_light_sample_multiplier, aa_indirect_sample_multiplier, std::ref(render_monitor), std::ref(render_control));
-
-	std::unique_lock<std::mutex> lk(tc.m_);
-	while(tc.finished_threads_ < num_threads_)
-	{
-		tc.c_.wait(lk);
-		for(const auto &area : tc.areas_)
-		{
-			image_film_->finishArea(render_control, render_monitor, area);
-		}
-		tc.areas_.clear();
-	}
-
-	for(auto &t : threads) t.join();	//join all threads (although they probably have exited already, but not necessarily):
+	TaskGroup render_tasks;
+	const int sampling_offset = offset + image_film_->getBaseSamplingOffset();
+	for(int i = 0; i < num_threads_; ++i) render_tasks.run([=, &correlative_sample_number, &render_monitor, &render_control] { renderWorker(correlative_sample_number, i, samples, sampling_offset, adaptive, aa_pass_number, aa_light_sample_multiplier, aa_indirect_sample_multiplier, render_monitor, render_control); });
+	render_tasks.wait();
+	image_film_->waitForFinishedAreas();
+	image_film_->mergeDensitySamples();
+	render_monitor.stopTimer(pass_timer_event);
 
 	return true; //hm...quite useless the return value :)
 }
@@ -253,7 +243,6 @@ bool TiledIntegrator::renderPass(RenderControl &render_control, RenderMonitor &r
 bool TiledIntegrator::renderTile(std::vector<int> &correlative_sample_number, const RenderArea &a, int n_samples, int offset, bool adaptive, int thread_id, int aa_pass_number, float aa_light_sample_multiplier, float aa_indirect_sample_multiplier, const RenderMonitor &render_monitor, const RenderControl &render_control)
 {
 	const int camera_res_x = image_film_->getCamera()->resX();
-	RandomGenerator random_generator(rand() + offset * (camera_res_x * a.y_ + a.x_) + 123);
 	const bool sample_lns = image_film_->getCamera()->sampleLens();
 	const int pass_offs = offset, end_x = a.x_ + a.w_, end_y = a.y_ + a.h_;
 	int aa_max_possible_samples = aa_noise_params_->samples_;
@@ -263,6 +252,7 @@ bool TiledIntegrator::renderTile(std::vector<int> &correlative_sample_number, co
 	}
 	const float inv_aa_max_possible_samples = 1.f / static_cast<float>(aa_max_possible_samples);
 	Uv<Halton> hal{Halton{3}, Halton{5}};
+	const AaNoiseParams::SamplerType sampler_type{aa_noise_params_->sampler_type_};
 	ColorLayers color_layers(*image_film_->getLayers());
 	const Image *sampling_factor_image_pass = (*image_film_->getImageLayers())(LayerDef::DebugSamplingFactor).image_.get();
 	const int film_cx_0 = image_film_->getCx0();
@@ -273,6 +263,7 @@ bool TiledIntegrator::renderTile(std::vector<int> &correlative_sample_number, co
 		for(int j = a.x_; j < end_x; ++j)
 		{
 			if(render_control.canceled()) break;
+			RandomGenerator random_generator(RandomGenerator::seed(j, i, offset)); //per pixel generator, so the pixel samples do not depend on the thread or on the order the tiles are rendered
 			float mat_sample_factor = 1.f;
 			int n_samples_adjusted = n_samples;
 			if(adaptive)
@@ -298,34 +289,54 @@ bool TiledIntegrator::renderTile(std::vector<int> &correlative_sample_number, co
 					aa_light_sample_multiplier,
 					aa_indirect_sample_multiplier
 			};
-			const float toff = Halton::lowDiscrepancySampling(fast_random_, 5, pass_offs + pixel_sampling_data.offset_); // **shall be just the pass number...**
+			const unsigned int pixel_seed = RandomGenerator::seed(j, i, 0); //same seed in all the passes, so the progressive samplers continue their sequences
+			const float toff = Halton::lowDiscrepancySampling(random_generator, 5, pass_offs + pixel_sampling_data.offset_); // **shall be just the pass number...**
 			hal.u_.setStart(pass_offs + pixel_sampling_data.offset_);
 			hal.v_.setStart(pass_offs + pixel_sampling_data.offset_);
 			for(int sample = 0; sample < n_samples_adjusted; ++sample)
 			{
+				const ThreadMemoryArena::SampleScope sample_memory_scope; //Surface points, material data, ray differentials, etc. allocated for this sample are released at once at the end of the sample
 				color_layers.setDefaultColors();
 				pixel_sampling_data.sample_ = pass_offs + sample;
 
-				const float time = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : math::addMod1(static_cast<float>(sample) * d_1, toff); //(0.5+(float)sample)*d1;
-				// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
-				// hence we use scrambled (Sobol, van-der-Corput) for multipass AA  //!< the current (normalized) frame time  //FIXME, time not currently used in libYafaRay
-				pixel_sampling_data.time_ = time;
-				float dx = 0.5f, dy = 0.5f;
-				if(aa_noise_params_->passes_ > 1)
+				if(sampler_type == AaNoiseParams::SamplerType::Halton)
 				{
-					dx = sample::riVdC(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
-					dy = sample::riS(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
+					const float time = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : math::addMod1(static_cast<float>(sample) * d_1, toff); //(0.5+(float)sample)*d1;
+					// the (1/n, Larcher&Pillichshammer-Seq.) only gives good coverage when total sample count is known
+					// hence we use scrambled (Sobol, van-der-Corput) for multipass AA  //!< the current (normalized) frame time  //FIXME, time not currently used in libYafaRay
+					pixel_sampling_data.time_ = time;
 				}
-				else if(n_samples_adjusted > 1)
+				float dx = 0.5f, dy = 0.5f;
+				Uv<float> lens_uv{0.5f, 0.5f};
+				if(sampler_type != AaNoiseParams::SamplerType::Halton)
 				{
-					dx = (0.5f + static_cast<float>(sample)) * d_1;
-					dy = sample::riLp(sample + pixel_sampling_data.offset_);
+					const PixelSample pixel_sample{pixelSample(sampler_type, pixel_sampling_data.sample_, pixel_seed)};
+					if(aa_noise_params_->passes_ > 1 || n_samples_adjusted > 1)
+					{
+						dx = pixel_sample.offset_.u_;
+						dy = pixel_sample.offset_.v_;
+					}
+					if(sample_lns) lens_uv = pixel_sample.lens_;
+					pixel_sampling_data.time_ = TiledIntegrator::params_.time_forced_ ? TiledIntegrator::params_.time_forced_value_ : pixel_sample.time_;
 				}
-				Uv<float> lens_uv{0.5f, 0.5f};
-				if(sample_lns)
+				else
 				{
-					lens_uv = {hal.u_.getNext(), hal.v_.getNext()};
+					if(aa_noise_params_->passes_ > 1)
+					{
+						dx = sample::riVdC(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
+						dy = sample::riS(pixel_sampling_data.sample_, pixel_sampling_data.offset_);
+					}
+					else if(n_samples_adjusted > 1)
+					{
+						dx = (0.5f + static_cast<float>(sample)) * d_1;
+						dy = sample::riLp(sample + pixel_sampling_data.offset_);
+					}
+					if(sample_lns)
+					{
+						lens_uv = {hal.u_.getNext(), hal.v_.getNext()};
+					}
 				}
+				const float time = pixel_sampling_data.time_;
 				CameraRay camera_ray = image_film_->getCamera()->shootRay(static_cast<float>(j) + dx, static_cast<float>(i) + dy, lens_uv);
 				if(!camera_ray.valid_)
 				{
@@ -347,8 +358,9 @@ bool TiledIntegrator::renderTile(std::vector<int> &correlative_sample_number, co
 				RayDivision ray_division;
 				const auto [integ_col, integ_alpha] = integrate(camera_ray.ray_, random_generator, correlative_sample_number, &color_layers, 0, true, 0.f, 0, ray_division, pixel_sampling_data);
 				color_layers(LayerDef::Combined) = {integ_col, integ_alpha};
-				for(auto &[layer_def, layer_col] : color_layers)
+				for(const LayerDef::Type layer_def : color_layers)
 				{
+					Rgba &layer_col = color_layers(layer_def);
 					switch(layer_def)
 					{
 						case LayerDef::ObjIndexMask:
@@ -690,6 +702,31 @@ void TiledIntegrator::applyVolumetricEffects(Rgb &col, float &alpha, ColorLayers
 	col = (col * col_vol_transmittance) + col_vol_integration;
 }
 
+TiledIntegrator::PixelSample TiledIntegrator::pixelSample(AaNoiseParams::SamplerType sampler_type, unsigned int sample, unsigned int pixel_seed)
+{
+	if(sampler_type == AaNoiseParams::SamplerType::Pmj02)
+	{
+		//The pixels share a small set of tables, so each pixel applies its own random digital shift (xor of the binary digits), which keeps the elementary intervals stratification
+		const auto digitalShift = [](const Uv<float> &uv, unsigned int shift) -> Uv<float> {
+			return {
+					static_cast<float>((static_cast<unsigned int>(uv.u_ * 0x1p24f) ^ shift) & 0xffffffu) * 0x1p-24f,
+					static_cast<float>((static_cast<unsigned int>(uv.v_ * 0x1p24f) ^ (shift >> 8)) & 0xffffffu) * 0x1p-24f
+			};
+		};
+		const unsigned int lens_seed = RandomGenerator::seed(pixel_seed, 1, 0);
+		return {
+				digitalShift(Pmj02::sample(sample, pixel_seed), pixel_seed),
+				digitalShift(Pmj02::sample(sample, lens_seed), lens_seed),
+				Sobol::sample(sample, 0, RandomGenerator::seed(pixel_seed, 2, 0)),
+		};
+	}
+	else return {
+				{Sobol::sample(sample, 0, pixel_seed), Sobol::sample(sample, 1, pixel_seed)},
+				{Sobol::sample(sample, 3, pixel_seed), Sobol::sample(sample, 4, pixel_seed)},
+				Sobol::sample(sample, 2, pixel_seed),
+		};
+}
+
 std::pair<Rgb, float> TiledIntegrator::background(const Ray &ray, ColorLayers *color_layers, bool transparent_background, bool transparent_refracted_background, const Background *background, int ray_level)
 {
 	if(transparent_background && (ray_level == 0 || transparent_refracted_background)) return {Rgb{0.f}, 0.f};
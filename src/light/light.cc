@@ -28,6 +28,7 @@
 #include "light/light_directional.h"
 #include "light/light_ies.h"
 #include "light/light_object_light.h"
+#include "light/light_bounds.h"
 #include "common/items.h"
 #include "param/param.h"
 #include "common/logger.h"
@@ -90,6 +91,11 @@ std::string Light::getName() const
 	return lights_.findNameFromId(id_).first;
 }
 
+std::pair<bool, LightBounds> Light::getBounds() const
+{
+	return {false, {}};
+}
+
 std::string Light::exportToString(size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const
 {
 	std::stringstream ss;
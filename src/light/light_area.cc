@@ -19,6 +19,7 @@
  */
 
 #include "light/light_area.h"
+#include "light/light_bounds.h"
 #include "geometry/surface.h"
 #include "param/param.h"
 #include "scene/scene.h"
@@ -175,4 +176,18 @@ std::tuple<bool, Ray, Rgb> AreaLight::illuminate(const Point3f &surface_p, float
 	return {};
 }
 
+std::pair<bool, LightBounds> AreaLight::getBounds() const
+{
+	LightBounds bounds;
+	bounds.bound_ = {params_.corner_, params_.corner_};
+	bounds.bound_.include(params_.point_1_);
+	bounds.bound_.include(params_.point_2_);
+	bounds.bound_.include(params_.point_1_ + params_.point_2_ - params_.corner_);
+	bounds.axis_ = normal_.normalized();
+	bounds.phi_ = totalEnergy().energy();
+	bounds.cos_theta_o_ = 1.f;
+	bounds.cos_theta_e_ = 0.f;
+	return {true, bounds};
+}
+
 } //namespace yafaray
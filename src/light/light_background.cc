@@ -27,7 +27,7 @@
 #include "param/param.h"
 #include "scene/scene.h"
 #include "geometry/surface.h"
-#include "sampler/sample_pdf1d.h"
+#include "sampler/sample_pdf2d.h"
 #include "geometry/ray.h"
 
 namespace yafaray {
@@ -76,15 +76,15 @@ size_t BackgroundLight::init(const Scene &scene)
 {
 	background_ = scene.getBackground();
 	const int nv = max_vsamples_;
-	std::vector<float> fv(nv);
+	std::vector<std::vector<float>> rows(nv);
 	const float inv_nv = 1.f / static_cast<float>(nv);
-	u_dist_ = std::vector<std::unique_ptr<Pdf1D>>(nv);
 	for(int y = 0; y < nv; y++)
 	{
 		const float fy = (static_cast<float>(y) + 0.5f) * inv_nv;
 		const float sintheta = sinSample(fy);
 		const int nu = min_samples_ + static_cast<int>(sintheta * (max_usamples_ - min_samples_));
-		std::vector<float> fu(nu);
+		std::vector<float> &fu = rows[y];
+		fu.resize(nu);
 		const float inv_nu = 1.f / static_cast<float>(nu);
 		for(int x = 0; x < nu; x++)
 		{
@@ -92,10 +92,8 @@ size_t BackgroundLight::init(const Scene &scene)
 			const Vec3f wi{Texture::invSphereMap({fx, fy})};
 			fu[x] = background_->eval(wi, true).energy() * sintheta;
 		}
-		u_dist_[y] = std::make_unique<Pdf1D>(std::move(fu));
-		fv[y] = u_dist_[y]->integral();
 	}
-	v_dist_ = std::make_unique<Pdf1D>(std::move(fv));
+	dist_ = std::make_unique<Pdf2D>(rows);
 	const Bound w = scene.getSceneBound();
 	world_center_ = 0.5f * (w.a_ + w.g_);
 	world_radius_ = 0.5f * (w.g_ - w.a_).length();
@@ -106,22 +104,15 @@ size_t BackgroundLight::init(const Scene &scene)
 
 inline std::pair<float, Uv<float>> BackgroundLight::calcFromSample(float s_1, float s_2, bool inv) const
 {
-	auto [v, pdf_2]{v_dist_->sample(s_2)};
-	const int iv = clampSample(addOff(v), v_dist_->size());
-	auto [u, pdf_1]{u_dist_[iv]->sample(s_1)};
-	u *= u_dist_[iv]->invSize();
-	v *= v_dist_->invSize();
-	if(inv) return {calcInvPdf(pdf_1, pdf_2, v), {u, v}};
-	else return {calcPdf(pdf_1, pdf_2, v), {u, v}};
+	const auto [uv, pdf_1, pdf_2]{dist_->sample(s_1, s_2)};
+	if(inv) return {calcInvPdf(pdf_1, pdf_2, uv.v_), uv};
+	else return {calcPdf(pdf_1, pdf_2, uv.v_), uv};
 }
 
 inline std::pair<float, Uv<float>> BackgroundLight::calcFromDir(const Vec3f &dir, bool inv) const
 {
 	const Uv<float> uv{Texture::sphereMap(static_cast<Point3f>(dir))}; // Returns u,v pair in [0,1] range
-	const int iv = clampSample(addOff(uv.v_ * v_dist_->size()), v_dist_->size());
-	const int iu = clampSample(addOff(uv.u_ * u_dist_[iv]->size()), u_dist_[iv]->size());
-	const float pdf_1 = u_dist_[iv]->function(iu) * u_dist_[iv]->invIntegral();
-	const float pdf_2 = v_dist_->function(iv) * v_dist_->invIntegral();
+	const auto [pdf_1, pdf_2]{dist_->pdf(uv)};
 	if(inv) return {calcInvPdf(pdf_1, pdf_2, uv.v_), uv};
 	return {calcPdf(pdf_1, pdf_2, uv.v_), uv};
 }
@@ -221,16 +212,6 @@ std::array<float, 3> BackgroundLight::emitPdf(const Vec3f &surface_n, const Vec3
 	return {area_pdf, dir_pdf, cos_wo};
 }
 
-constexpr float BackgroundLight::addOff(float v)
-{
-	return v + smpl_off_;
-}
-
-int BackgroundLight::clampSample(int s, int m)
-{
-	return std::max(0, std::min(s, m - 1));
-}
-
 float BackgroundLight::clampZero(float val)
 {
 	if(val > 0.f) return 1.f / val;
@@ -122,20 +122,12 @@ size_t BackgroundPortalLight::init(const Scene &scene)
 
 std::pair<Point3f, Vec3f> BackgroundPortalLight::sampleSurface(float s_1, float s_2, float time) const
 {
-	const auto [prim_num, prim_pdf]{area_dist_->dSample(s_1)};
+	const auto [prim_num, prim_pdf, ss_1]{area_dist_->dSampleReuse(s_1)};
 	if(prim_num >= area_dist_->size())
 	{
 		logger_.logWarning("bgPortalLight: Sampling error!");
 		return {};
 	}
-	float delta = area_dist_->cdf(prim_num);
-	float ss_1;
-	if(prim_num > 0)
-	{
-		delta -= area_dist_->cdf(prim_num - 1);
-		ss_1 = (s_1 - area_dist_->cdf(prim_num - 1)) / delta;
-	}
-	else ss_1 = s_1 / delta;
 	return primitives_[prim_num]->sample({ss_1, s_2}, time);
 }
 
@@ -19,6 +19,7 @@
  */
 
 #include "light/light_ies.h"
+#include "light/light_bounds.h"
 
 #include <memory>
 #include "geometry/surface.h"
@@ -184,4 +185,15 @@ std::array<float, 3> IesLight::emitPdf(const Vec3f &surface_n, const Vec3f &wo)
 	return {area_pdf, dir_pdf, cos_wo};
 }
 
+std::pair<bool, LightBounds> IesLight::getBounds() const
+{
+	LightBounds bounds;
+	bounds.bound_ = {params_.from_, params_.from_};
+	bounds.axis_ = dir_;
+	bounds.phi_ = totalEnergy().energy();
+	bounds.cos_theta_o_ = cos_end_;
+	bounds.cos_theta_e_ = 0.f;
+	return {true, bounds};
+}
+
 } //namespace yafaray
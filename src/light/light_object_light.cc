@@ -21,6 +21,7 @@
 #include <limits>
 
 #include "light/light_object_light.h"
+#include "light/light_bounds.h"
 #include "background/background.h"
 #include "texture/texture.h"
 #include "param/param.h"
@@ -118,20 +119,12 @@ size_t ObjectLight::init(const Scene &scene)
 
 std::pair<Point3f, Vec3f> ObjectLight::sampleSurface(float s_1, float s_2, float time) const
 {
-	const auto [prim_num, prim_pdf]{area_dist_->dSample(s_1)};
+	const auto [prim_num, prim_pdf, ss_1]{area_dist_->dSampleReuse(s_1)};
 	if(prim_num >= area_dist_->size())
 	{
 		logger_.logWarning(getClassName(), ": Sampling error!");
 		return {};
 	}
-	float delta = area_dist_->cdf(prim_num);
-	float ss_1;
-	if(prim_num > 0)
-	{
-		delta -= area_dist_->cdf(prim_num - 1);
-		ss_1 = (s_1 - area_dist_->cdf(prim_num - 1)) / delta;
-	}
-	else ss_1 = s_1 / delta;
 	return primitives_[prim_num]->sample({ss_1, s_2}, time);
 	//	++stats[primNum];
 }
@@ -249,4 +242,17 @@ std::tuple<bool, Ray, Rgb> ObjectLight::illuminate(const Point3f &surface_p, flo
 	return {};
 }
 
+std::pair<bool, LightBounds> ObjectLight::getBounds() const
+{
+	if(primitives_.empty()) return {false, {}};
+	LightBounds bounds;
+	bounds.bound_ = primitives_.front()->getBound();
+	for(const auto &primitive : primitives_) bounds.bound_.include(primitive->getBound());
+	bounds.phi_ = totalEnergy().energy();
+	bounds.cos_theta_o_ = -1.f;
+	bounds.cos_theta_e_ = 0.f;
+	bounds.two_sided_ = params_.double_sided_;
+	return {true, bounds};
+}
+
 } //namespace yafaray
@@ -19,6 +19,7 @@
  */
 
 #include "light/light_point.h"
+#include "light/light_bounds.h"
 #include "geometry/surface.h"
 #include "sampler/sample.h"
 #include "geometry/ray.h"
@@ -121,4 +122,14 @@ std::array<float, 3> PointLight::emitPdf(const Vec3f &surface_n, const Vec3f &wo
 	return {area_pdf, dir_pdf, cos_wo};
 }
 
+std::pair<bool, LightBounds> PointLight::getBounds() const
+{
+	LightBounds bounds;
+	bounds.bound_ = {params_.from_, params_.from_};
+	bounds.phi_ = totalEnergy().energy();
+	bounds.cos_theta_o_ = -1.f;
+	bounds.cos_theta_e_ = 0.f;
+	return {true, bounds};
+}
+
 } //namespace yafaray
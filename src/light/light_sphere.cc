@@ -19,6 +19,7 @@
  */
 
 #include "light/light_sphere.h"
+#include "light/light_bounds.h"
 #include "geometry/surface.h"
 #include "param/param.h"
 #include "scene/scene.h"
@@ -204,4 +205,15 @@ std::tuple<bool, Ray, Rgb> SphereLight::illuminate(const Point3f &surface_p, flo
 	return {};
 }
 
+std::pair<bool, LightBounds> SphereLight::getBounds() const
+{
+	LightBounds bounds;
+	const Vec3f radius{params_.radius_};
+	bounds.bound_ = {params_.from_ - radius, params_.from_ + radius};
+	bounds.phi_ = totalEnergy().energy();
+	bounds.cos_theta_o_ = -1.f;
+	bounds.cos_theta_e_ = 0.f;
+	return {true, bounds};
+}
+
 } //namespace yafaray
@@ -19,6 +19,7 @@
  */
 
 #include "light/light_spot.h"
+#include "light/light_bounds.h"
 
 #include <memory>
 #include "geometry/surface.h"
@@ -272,4 +273,16 @@ std::tuple<bool, float, Rgb> SpotLight::intersect(const Ray &ray, float &t) cons
 	return {};
 }
 
+std::pair<bool, LightBounds> SpotLight::getBounds() const
+{
+	LightBounds bounds;
+	bounds.bound_ = {params_.from_, params_.from_};
+	bounds.axis_ = dir_;
+	bounds.phi_ = totalEnergy().energy();
+	//Full intensity inside the inner cone, falling off until the outer cone
+	bounds.cos_theta_o_ = cos_start_;
+	bounds.cos_theta_e_ = math::cos(math::acos(cos_end_) - math::acos(cos_start_));
+	return {true, bounds};
+}
+
 } //namespace yafaray
@@ -0,0 +1,170 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "light/light_tree.h"
+#include "light/light.h"
+#include <algorithm>
+#include <array>
+
+namespace yafaray {
+
+LightTree::LightTree(const std::vector<const Light *> &lights)
+{
+	std::vector<BuildLight> build_lights;
+	for(size_t light_index = 0; light_index < lights.size(); ++light_index)
+	{
+		const auto [bounded, bounds]{lights[light_index]->getBounds()};
+		//Lights without bounds or with unknown power cannot be weighted by the tree, so they are sampled uniformly
+		if(bounded && bounds.phi_ > 0.f) build_lights.emplace_back(BuildLight{light_index, bounds});
+		else unbounded_lights_.emplace_back(light_index);
+	}
+	if(build_lights.empty()) return;
+	nodes_.reserve(2 * build_lights.size() - 1);
+	buildRecursive(build_lights.begin(), build_lights.end());
+}
+
+float LightTree::cost(const LightBounds &bounds, const Bound<float> &parent_bound, Axis axis)
+{
+	//Orientation cost: solid angle of the cone of emission directions, weighted by the cosine
+	const float theta_o{math::acos(math::clamp(bounds.cos_theta_o_, -1.f, 1.f))};
+	const float theta_e{math::acos(math::clamp(bounds.cos_theta_e_, -1.f, 1.f))};
+	const float theta_w{std::min(theta_o + theta_e, math::num_pi<>)};
+	const float sin_theta_o{math::sqrt(std::max(0.f, 1.f - bounds.cos_theta_o_ * bounds.cos_theta_o_))};
+	const float m_omega{math::mult_pi_by_2<> * (1.f - bounds.cos_theta_o_) + 0.5f * math::num_pi<> * (2.f * theta_w * sin_theta_o - math::cos(theta_o - 2.f * theta_w) - 2.f * theta_o * sin_theta_o + bounds.cos_theta_o_)};
+	const Vec3f diagonal{bounds.bound_.g_ - bounds.bound_.a_};
+	const float surface_area{2.f * (diagonal[Axis::X] * diagonal[Axis::Y] + diagonal[Axis::X] * diagonal[Axis::Z] + diagonal[Axis::Y] * diagonal[Axis::Z])};
+	//Penalize thin splits of the parent along its longest axis
+	const float axis_length{parent_bound.length(axis)};
+	const float regularization{axis_length > 0.f ? parent_bound.longestLength() / axis_length : 1.f};
+	return bounds.phi_ * m_omega * surface_area * regularization;
+}
+
+void LightTree::buildRecursive(std::vector<BuildLight>::iterator begin, std::vector<BuildLight>::iterator end)
+{
+	const size_t node_index{nodes_.size()};
+	nodes_.emplace_back();
+	if(end - begin == 1)
+	{
+		nodes_[node_index] = {begin->bounds_, begin->light_index_, true};
+		return;
+	}
+	LightBounds node_bounds{begin->bounds_};
+	Bound<float> centroid_bound{begin->bounds_.centroid(), begin->bounds_.centroid()};
+	for(auto it = begin + 1; it != end; ++it)
+	{
+		node_bounds = LightBounds::join(node_bounds, it->bounds_);
+		centroid_bound.include(it->bounds_.centroid());
+	}
+
+	//Binned split evaluation along the three axes
+	float best_cost{std::numeric_limits<float>::max()};
+	Axis best_axis{Axis::None};
+	int best_bucket{-1};
+	for(const auto axis : axis::spatial)
+	{
+		const float centroid_min{centroid_bound.a_[axis]};
+		const float centroid_length{centroid_bound.length(axis)};
+		if(centroid_length <= 0.f) continue;
+		const auto bucket_id{[&](const BuildLight &build_light) {
+			const int bucket{static_cast<int>(num_buckets_ * (build_light.bounds_.centroid()[axis] - centroid_min) / centroid_length)};
+			return std::clamp(bucket, 0, num_buckets_ - 1);
+		}};
+		std::array<LightBounds, num_buckets_> buckets;
+		for(auto it = begin; it != end; ++it)
+		{
+			const int bucket{bucket_id(*it)};
+			buckets[bucket] = LightBounds::join(buckets[bucket], it->bounds_);
+		}
+		for(int split = 0; split < num_buckets_ - 1; ++split)
+		{
+			LightBounds below, above;
+			for(int bucket = 0; bucket <= split; ++bucket) below = LightBounds::join(below, buckets[bucket]);
+			for(int bucket = split + 1; bucket < num_buckets_; ++bucket) above = LightBounds::join(above, buckets[bucket]);
+			if(below.phi_ <= 0.f || above.phi_ <= 0.f) continue;
+			const float split_cost{cost(below, node_bounds.bound_, axis) + cost(above, node_bounds.bound_, axis)};
+			if(split_cost < best_cost)
+			{
+				best_cost = split_cost;
+				best_axis = axis;
+				best_bucket = split;
+			}
+		}
+	}
+
+	auto middle{begin + (end - begin) / 2};
+	if(best_axis != Axis::None)
+	{
+		const float centroid_min{centroid_bound.a_[best_axis]};
+		const float centroid_length{centroid_bound.length(best_axis)};
+		middle = std::partition(begin, end, [&](const BuildLight &build_light) {
+			const int bucket{static_cast<int>(num_buckets_ * (build_light.bounds_.centroid()[best_axis] - centroid_min) / centroid_length)};
+			return std::clamp(bucket, 0, num_buckets_ - 1) <= best_bucket;
+		});
+		if(middle == begin || middle == end) middle = begin + (end - begin) / 2;
+	}
+	//If all the centroids are coincident the lights are just split in two halves
+
+	buildRecursive(begin, middle);
+	const size_t second_child_index{nodes_.size()};
+	buildRecursive(middle, end);
+	nodes_[node_index] = {node_bounds, second_child_index, false};
+}
+
+std::pair<size_t, float> LightTree::sample(const Point3f &p, const Vec3f &n, float u) const
+{
+	const size_t num_unbounded_lights{unbounded_lights_.size()};
+	const float unbounded_probability{nodes_.empty() ? 1.f : static_cast<float>(num_unbounded_lights) / static_cast<float>(num_unbounded_lights + 1)};
+	if(u < unbounded_probability)
+	{
+		if(num_unbounded_lights == 0) return {0, 0.f};
+		u /= unbounded_probability;
+		const size_t index{std::min(static_cast<size_t>(u * static_cast<float>(num_unbounded_lights)), num_unbounded_lights - 1)};
+		return {unbounded_lights_[index], unbounded_probability / static_cast<float>(num_unbounded_lights)};
+	}
+	//Sample value remapped at each level of the tree so a single value is enough for the whole traversal
+	u = std::min((u - unbounded_probability) / (1.f - unbounded_probability), 1.f - std::numeric_limits<float>::epsilon());
+	float probability{1.f - unbounded_probability};
+	size_t node_index{0};
+	while(true)
+	{
+		const Node &node{nodes_[node_index]};
+		if(node.leaf_)
+		{
+			if(node_index > 0 || node.bounds_.importance(p, n) > 0.f) return {node.index_, probability};
+			else return {0, 0.f};
+		}
+		const float importance_first{nodes_[node_index + 1].bounds_.importance(p, n)};
+		const float importance_second{nodes_[node.index_].bounds_.importance(p, n)};
+		if(importance_first <= 0.f && importance_second <= 0.f) return {0, 0.f};
+		const float probability_first{importance_first / (importance_first + importance_second)};
+		if(u < probability_first)
+		{
+			node_index = node_index + 1;
+			u = std::min(u / probability_first, 1.f - std::numeric_limits<float>::epsilon());
+			probability *= probability_first;
+		}
+		else
+		{
+			node_index = node.index_;
+			u = std::min((u - probability_first) / (1.f - probability_first), 1.f - std::numeric_limits<float>::epsilon());
+			probability *= 1.f - probability_first;
+		}
+	}
+}
+
+} //namespace yafaray
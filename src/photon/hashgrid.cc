@@ -18,8 +18,9 @@
 
 #include "photon/hashgrid.h"
 
-#include <memory>
 #include "photon/photon.h"
+#include "common/thread_pool.h"
+#include <array>
 
 namespace yafaray {
 
@@ -40,6 +41,11 @@ void HashGrid::setParm(double cell_size, unsigned int grid_size, Bound<float> b_
 void HashGrid::clear()
 {
 	photons_.clear();
+	cell_offsets_.clear();
+	photon_indices_.clear();
+	pos_x_.clear();
+	pos_y_.clear();
+	pos_z_.clear();
 }
 
 void HashGrid::pushPhoton(Photon &&p)
@@ -47,48 +53,58 @@ void HashGrid::pushPhoton(Photon &&p)
 	photons_.emplace_back(p);
 }
 
-void HashGrid::updateGrid()
+template <typename Function>
+void HashGrid::parallelFor(size_t num_items, int num_threads, const Function &function)
 {
-	if(!hash_grid_)
+	const size_t num_chunks{std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(std::max(num_threads, 1)), num_items / 4096))};
+	const size_t chunk_size{(num_items + num_chunks - 1) / num_chunks};
+	TaskGroup chunk_tasks;
+	for(size_t chunk = 0; chunk < num_chunks; ++chunk)
 	{
-		hash_grid_ = std::unique_ptr<std::unique_ptr<std::list<const Photon *>>[]>(new std::unique_ptr<std::list<const Photon *>>[grid_size_]);
-		for(unsigned int i = 0; i < grid_size_; ++i)
-		{
-			hash_grid_[i] = nullptr;
-		}
-	}
-	else
-	{
-		for(unsigned int i = 0; i < grid_size_; ++i)
-		{
-			if(hash_grid_[i])
-			{
-				hash_grid_[i]->clear(); // fix me! too many time consumed here
-			}
-		}
+		const size_t begin{chunk * chunk_size};
+		const size_t end{std::min(begin + chunk_size, num_items)};
+		chunk_tasks.run([&function, begin, end] { for(size_t i = begin; i < end; ++i) function(i); });
 	}
+	chunk_tasks.wait();
+}
 
-	//travel the vector to build the Grid
-	for(const auto &photon : photons_)
+void HashGrid::updateGrid(int num_threads)
+{
+	const size_t num_photons{photons_.size()};
+	std::vector<unsigned int> photon_cells(num_photons);
+	parallelFor(num_photons, num_threads, [&](size_t photon_index)
 	{
-		const Point3f hashindex{(photon.pos_ - bounding_box_.a_) * static_cast<float>(inv_cell_size_)};
+		const Point3f hashindex{(photons_[photon_index].pos_ - bounding_box_.a_) * static_cast<float>(inv_cell_size_)};
 		const int ix = abs(int(hashindex[Axis::X]));
 		const int iy = abs(int(hashindex[Axis::Y]));
 		const int iz = abs(int(hashindex[Axis::Z]));
-		const unsigned int index = hash(ix, iy, iz);
-		if(!hash_grid_[index]) hash_grid_[index] = std::make_unique<std::list<const Photon *>>();
-		hash_grid_[index]->push_front(&photon);
-	}
-	unsigned int notused = 0;
-	for(unsigned int i = 0; i < grid_size_; ++i)
+		photon_cells[photon_index] = hash(ix, iy, iz);
+	});
+
+	//Counting sort of the photons by hash cell
+	cell_offsets_.assign(grid_size_ + 1, 0);
+	for(const unsigned int cell : photon_cells) ++cell_offsets_[cell + 1];
+	for(unsigned int i = 0; i < grid_size_; ++i) cell_offsets_[i + 1] += cell_offsets_[i];
+	//Photons are placed in reverse order inside each cell, the same order in which they were gathered when the cells were linked lists filled from the front
+	std::vector<unsigned int> cell_positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+	photon_indices_.resize(num_photons);
+	for(size_t photon_index = num_photons; photon_index-- > 0;) photon_indices_[cell_positions[photon_cells[photon_index]]++] = static_cast<unsigned int>(photon_index);
+
+	pos_x_.resize(num_photons);
+	pos_y_.resize(num_photons);
+	pos_z_.resize(num_photons);
+	parallelFor(num_photons, num_threads, [&](size_t sorted_index)
 	{
-		if(!hash_grid_[i] || hash_grid_[i]->size() == 0) notused++;
-	}
-	//if(logger_.isVerbose()) logger_.logVerbose("HashGrid: there are ", notused, " enties not used!", std::endl;
+		const Point3f &pos{photons_[photon_indices_[sorted_index]].pos_};
+		pos_x_[sorted_index] = pos[Axis::X];
+		pos_y_[sorted_index] = pos[Axis::Y];
+		pos_z_[sorted_index] = pos[Axis::Z];
+	});
 }
 
 unsigned int HashGrid::gather(const Point3f &p, FoundPhoton *found, unsigned int k, float sq_radius) const
 {
+	if(cell_offsets_.empty()) return 0;
 	unsigned int count = 0;
 	float radius = math::sqrt(sq_radius);
 
@@ -96,19 +112,34 @@ unsigned int HashGrid::gather(const Point3f &p, FoundPhoton *found, unsigned int
 	const Point3f b_min{((p - rad) - bounding_box_.a_) * static_cast<float>(inv_cell_size_)};
 	const Point3f b_max{((p + rad) - bounding_box_.a_) * static_cast<float>(inv_cell_size_)};
 
+	//Distances are calculated in small batches over the position arrays so the loop can be vectorized, then the photons inside the radius are collected
+	constexpr unsigned int batch_size = 8;
+	std::array<float, batch_size> dist_square;
 	for(int iz = abs(int(b_min[Axis::Z])); iz <= abs(int(b_max[Axis::Z])); iz++)
 	{
 		for(int iy = abs(int(b_min[Axis::Y])); iy <= abs(int(b_max[Axis::Y])); iy++)
 		{
 			for(int ix = abs(int(b_min[Axis::X])); ix <= abs(int(b_max[Axis::X])); ix++)
 			{
-				const int hv = hash(ix, iy, iz);
-				if(hash_grid_[hv] == nullptr) continue;
-				for(const auto &photon : *hash_grid_[hv])
+				const unsigned int hv = hash(ix, iy, iz);
+				const unsigned int cell_end{cell_offsets_[hv + 1]};
+				for(unsigned int batch_begin = cell_offsets_[hv]; batch_begin < cell_end; batch_begin += batch_size)
 				{
-					if((photon->pos_ - p).lengthSquared() < sq_radius)
+					const unsigned int batch_count{std::min(batch_size, cell_end - batch_begin)};
+					for(unsigned int i = 0; i < batch_count; ++i)
+					{
+						const float dx{pos_x_[batch_begin + i] - p[Axis::X]};
+						const float dy{pos_y_[batch_begin + i] - p[Axis::Y]};
+						const float dz{pos_z_[batch_begin + i] - p[Axis::Z]};
+						dist_square[i] = dx * dx + dy * dy + dz * dz;
+					}
+					for(unsigned int i = 0; i < batch_count; ++i)
 					{
-						found[count++] = {photon, sq_radius};
+						if(dist_square[i] < sq_radius)
+						{
+							if(count >= k) return count;
+							found[count++] = {&photons_[photon_indices_[batch_begin + i]], sq_radius};
+						}
 					}
 				}
 			}
@@ -75,6 +75,18 @@ void yafaray_setFlushAreaCallback(yafaray_Film *film, yafaray_FilmFlushAreaCallb
 	reinterpret_cast<yafaray::ImageFilm *>(film)->setRenderFlushAreaCallback(callback, callback_data);
 }
 
+void yafaray_setPutAreaCallback(yafaray_Film *film, yafaray_FilmPutAreaCallback callback, void *callback_data)
+{
+	if(!film) return;
+	reinterpret_cast<yafaray::ImageFilm *>(film)->setRenderPutAreaCallback(callback, callback_data);
+}
+
+yafaray_Bool yafaray_getFilmLayerBuffer(const yafaray_Film *film, const char *layer_name, yafaray_FilmLayerBuffer *layer_buffer)
+{
+	if(!film || !layer_name || !layer_buffer) return YAFARAY_BOOL_FALSE;
+	return reinterpret_cast<const yafaray::ImageFilm *>(film)->getLayerBuffer(yafaray::LayerDef::getType(layer_name), {{0, 0}}, *layer_buffer) ? YAFARAY_BOOL_TRUE : YAFARAY_BOOL_FALSE;
+}
+
 void yafaray_setFlushCallback(yafaray_Film *film, yafaray_FilmFlushCallback callback, void *callback_data)
 {
 	if(!film) return;
@@ -19,6 +19,7 @@
 #include "public_api/yafaray_c_api.h"
 #include "render/render_monitor.h"
 #include "render/progress_bar.h"
+#include "accelerator/accelerator.h"
 
 yafaray_RenderMonitor *yafaray_createRenderMonitor(yafaray_ProgressBarCallback monitor_callback, void *callback_data, yafaray_DisplayConsole progress_bar_display_console)
 {
@@ -34,3 +35,14 @@ void yafaray_destroyRenderMonitor(yafaray_RenderMonitor *render_monitor)
 {
 	delete reinterpret_cast<yafaray::RenderMonitor *>(render_monitor);
 }
+
+double yafaray_getRenderMonitorTimerTime(const yafaray_RenderMonitor *render_monitor, const char *timer_event)
+{
+	if(!render_monitor || !timer_event) return -1.0;
+	return reinterpret_cast<const yafaray::RenderMonitor *>(render_monitor)->getTimerTime(timer_event);
+}
+
+double yafaray_getNumRaysTraced()
+{
+	return static_cast<double>(yafaray::Accelerator::numRaysTraced());
+}
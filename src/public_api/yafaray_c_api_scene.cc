@@ -45,6 +45,12 @@ void yafaray_setSceneAcceleratorParams(yafaray_Scene *scene, const yafaray_Param
 	reinterpret_cast<yafaray::Scene *>(scene)->setAcceleratorParamMap(*reinterpret_cast<const yafaray::ParamMap *>(param_map));
 }
 
+void yafaray_setSceneTextureCacheParams(yafaray_Scene *scene, const yafaray_ParamMap *param_map)
+{
+	if(!scene || !param_map) return;
+	reinterpret_cast<yafaray::Scene *>(scene)->setTextureCacheParamMap(*reinterpret_cast<const yafaray::ParamMap *>(param_map));
+}
+
 yafaray_Bool yafaray_initObject(yafaray_Scene *scene, size_t object_id, size_t material_id) //!< initialize object. The material_id may or may not be used by the object depending on the type of the object
 {
 	if(!scene) return YAFARAY_BOOL_FALSE;
@@ -135,6 +141,48 @@ size_t yafaray_addUv(yafaray_Scene *scene, size_t object_id, double u, double v)
 	return reinterpret_cast<yafaray::Scene *>(scene)->addUv(object_id, {static_cast<float>(u), static_cast<float>(v)});
 }
 
+yafaray_Bool yafaray_addVertices(yafaray_Scene *scene, size_t object_id, const float *positions, const float *orcos, size_t num_vertices, unsigned char time_step) //!< add an array of vertices (and optionally their orco coordinates) to mesh
+{
+	if(!scene || !positions) return YAFARAY_BOOL_FALSE;
+	return static_cast<yafaray_Bool>(reinterpret_cast<yafaray::Scene *>(scene)->addVertices(object_id, positions, orcos, num_vertices, time_step));
+}
+
+yafaray_Bool yafaray_addNormals(yafaray_Scene *scene, size_t object_id, const float *normals, size_t num_normals, unsigned char time_step) //!< add an array of vertex normals to mesh, in the same order as the vertices
+{
+	if(!scene || !normals) return YAFARAY_BOOL_FALSE;
+	return static_cast<yafaray_Bool>(reinterpret_cast<yafaray::Scene *>(scene)->addVerticesNormals(object_id, normals, num_normals, time_step));
+}
+
+yafaray_Bool yafaray_addUvs(yafaray_Scene *scene, size_t object_id, const float *uvs, size_t num_uvs) //!< add an array of UV coordinate pairs to mesh
+{
+	if(!scene || !uvs) return YAFARAY_BOOL_FALSE;
+	return static_cast<yafaray_Bool>(reinterpret_cast<yafaray::Scene *>(scene)->addUvs(object_id, uvs, num_uvs));
+}
+
+yafaray_Bool yafaray_addFaces(yafaray_Scene *scene, size_t object_id, const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id) //!< add an array of triangles (vertices_per_face = 3) or quads (vertices_per_face = 4, a negative fourth index makes that face a triangle). uv_indices and materials_ids are optional, when materials_ids is NULL all faces use material_id
+{
+	if(!scene || !vertices_indices) return YAFARAY_BOOL_FALSE;
+	return static_cast<yafaray_Bool>(reinterpret_cast<yafaray::Scene *>(scene)->addFaces(object_id, vertices_indices, uv_indices, num_faces, vertices_per_face, materials_ids, material_id));
+}
+
+float *yafaray_getVerticesBuffer(yafaray_Scene *scene, size_t object_id, size_t num_vertices, unsigned char time_step) //!< resize the mesh vertices to num_vertices and return their storage to be filled with x,y,z components
+{
+	if(!scene) return nullptr;
+	return reinterpret_cast<yafaray::Scene *>(scene)->getVerticesBuffer(object_id, num_vertices, time_step);
+}
+
+float *yafaray_getNormalsBuffer(yafaray_Scene *scene, size_t object_id, size_t num_normals, unsigned char time_step) //!< resize the mesh vertex normals to num_normals and return their storage to be filled with x,y,z components
+{
+	if(!scene) return nullptr;
+	return reinterpret_cast<yafaray::Scene *>(scene)->getVerticesNormalsBuffer(object_id, num_normals, time_step);
+}
+
+float *yafaray_getUvsBuffer(yafaray_Scene *scene, size_t object_id, size_t num_uvs) //!< resize the mesh UVs to num_uvs and return their storage to be filled with u,v components
+{
+	if(!scene) return nullptr;
+	return reinterpret_cast<yafaray::Scene *>(scene)->getUvsBuffer(object_id, num_uvs);
+}
+
 yafaray_Bool yafaray_smoothObjectMesh(yafaray_Scene *scene, size_t object_id, double angle) //!< smooth vertex normals of mesh with given ID and angle (in degrees)
 {
 	if(!scene) return YAFARAY_BOOL_FALSE;
@@ -243,6 +291,12 @@ yafaray_Bool yafaray_preprocessScene(yafaray_Scene *scene, const yafaray_RenderC
 	return static_cast<yafaray_Bool>(reinterpret_cast<yafaray::Scene *>(scene)->preprocess(*reinterpret_cast<const yafaray::RenderControl *>(render_control), scene_modified_flags));
 }
 
+double yafaray_getSceneAcceleratorBuildTime(const yafaray_Scene *scene)
+{
+	if(!scene) return 0.0;
+	return reinterpret_cast<const yafaray::Scene *>(scene)->getAcceleratorBuildTime();
+}
+
 yafaray_ResultFlags yafaray_getImageId(yafaray_Scene *scene, const char *name, size_t *id_obtained)
 {
 	if(!scene || !name) return YAFARAY_RESULT_ERROR_WHILE_CREATING;
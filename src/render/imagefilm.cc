@@ -35,6 +35,7 @@
 #include "integrator/surface/integrator_surface.h"
 #include "render/render_monitor.h"
 #include "image/image_output.h"
+#include "common/thread_pool.h"
 
 namespace yafaray {
 
@@ -55,6 +56,7 @@ std::map<std::string, const ParamMeta *> ImageFilm::Params::getParamMetaMap()
 	PARAM_META(filter_type_);
 	PARAM_META(tile_size_);
 	PARAM_META(tiles_order_);
+	PARAM_META(buffer_layout_);
 	PARAM_META(images_autosave_interval_type_);
 	PARAM_META(images_autosave_interval_passes_);
 	PARAM_META(images_autosave_interval_seconds_);
@@ -78,6 +80,8 @@ std::map<std::string, const ParamMeta *> ImageFilm::Params::getParamMetaMap()
 	PARAM_META(aa_variance_pixels_);
 	PARAM_META(aa_clamp_samples_);
 	PARAM_META(aa_clamp_indirect_);
+	PARAM_META(aa_sampler_type_);
+	PARAM_META(aa_confidence_);
 	PARAM_META(layer_mask_obj_index_);
 	PARAM_META(layer_mask_mat_index_);
 	PARAM_META(layer_mask_invert);
@@ -109,6 +113,7 @@ ImageFilm::Params::Params(ParamResult &param_result, const ParamMap &param_map)
 	PARAM_ENUM_LOAD(filter_type_);
 	PARAM_LOAD(tile_size_);
 	PARAM_ENUM_LOAD(tiles_order_);
+	PARAM_ENUM_LOAD(buffer_layout_);
 	PARAM_ENUM_LOAD(images_autosave_interval_type_);
 	PARAM_LOAD(images_autosave_interval_passes_);
 	PARAM_LOAD(images_autosave_interval_seconds_);
@@ -132,6 +137,8 @@ ImageFilm::Params::Params(ParamResult &param_result, const ParamMap &param_map)
 	PARAM_LOAD(aa_variance_pixels_);
 	PARAM_LOAD(aa_clamp_samples_);
 	PARAM_LOAD(aa_clamp_indirect_);
+	PARAM_ENUM_LOAD(aa_sampler_type_);
+	PARAM_LOAD(aa_confidence_);
 	PARAM_LOAD(layer_mask_obj_index_);
 	PARAM_LOAD(layer_mask_mat_index_);
 	PARAM_LOAD(layer_mask_invert);
@@ -165,6 +172,7 @@ ParamMap ImageFilm::getAsParamMap(bool only_non_default) const
 	PARAM_ENUM_SAVE(filter_type_);
 	PARAM_SAVE(tile_size_);
 	PARAM_ENUM_SAVE(tiles_order_);
+	PARAM_ENUM_SAVE(buffer_layout_);
 	PARAM_ENUM_SAVE(images_autosave_interval_type_);
 	PARAM_SAVE(images_autosave_interval_passes_);
 	PARAM_SAVE(images_autosave_interval_seconds_);
@@ -188,6 +196,8 @@ ParamMap ImageFilm::getAsParamMap(bool only_non_default) const
 	PARAM_SAVE(aa_variance_pixels_);
 	PARAM_SAVE(aa_clamp_samples_);
 	PARAM_SAVE(aa_clamp_indirect_);
+	PARAM_ENUM_SAVE(aa_sampler_type_);
+	PARAM_SAVE(aa_confidence_);
 	PARAM_SAVE(layer_mask_obj_index_);
 	PARAM_SAVE(layer_mask_mat_index_);
 	PARAM_SAVE(layer_mask_invert);
@@ -265,8 +275,18 @@ ImageFilm::ImageFilm(Logger &logger, ParamResult &param_result, const std::strin
 	area_cnt_ = 0;
 }
 
-//This is just to avoid compilation error "error: invalid application of ‘sizeof’ to incomplete type, because the destructor needs to know the type of any shared_ptr or unique_ptr objects
-ImageFilm::~ImageFilm() = default;
+ImageFilm::~ImageFilm()
+{
+	if(output_stage_thread_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock_guard(output_queue_mutex_);
+			output_stage_stop_ = true;
+		}
+		output_queue_not_empty_.notify_one();
+		output_stage_thread_.join();
+	}
+}
 
 void ImageFilm::initLayersImages()
 {
@@ -279,6 +299,7 @@ void ImageFilm::initLayersImages()
 		image_params.height_ = params_.height_;
 		image_params.type_ = image_type;
 		image_params.image_optimization_ = Image::Optimization::None;
+		image_params.buffer_layout_ = params_.buffer_layout_;
 		auto image{Image::factory(image_params)};
 		film_image_layers_.set(layer_def, {std::move(image), layer});
 	}
@@ -295,6 +316,7 @@ void ImageFilm::initLayersExportedImages()
 		image_params.height_ = params_.height_;
 		image_params.type_ = image_type;
 		image_params.image_optimization_ = Image::Optimization::None;
+		image_params.buffer_layout_ = BufferLayout::RowMajor; //So the exported images can be handed to the clients as strided float buffers
 		auto image{Image::factory(image_params)};
 		exported_image_layers_.set(layer_def, {std::move(image), layer});
 	}
@@ -302,6 +324,8 @@ void ImageFilm::initLayersExportedImages()
 
 void ImageFilm::init(RenderControl &render_control, RenderMonitor &render_monitor, const SurfaceIntegrator &surface_integrator)
 {
+	waitForFinishedAreas();
+	if(!output_stage_thread_.joinable()) output_stage_thread_ = std::thread(&ImageFilm::outputStageWorker, this);
 	defineBasicLayers();
 	defineDependentLayers();
 
@@ -309,8 +333,8 @@ void ImageFilm::init(RenderControl &render_control, RenderMonitor &render_monito
 	film_image_layers_.clear();
 	exported_image_layers_.clear();
 	initLayersImages();
-	//If there are any ImageOutputs, creation of the image buffers for the image outputs exported images
-	if(!outputs_->empty())
+	//If there are any ImageOutputs or the client gets the areas as buffers, creation of the image buffers for the exported images
+	if(!outputs_->empty() || put_area_callback_)
 	{
 		initLayersExportedImages();
 		for(auto &output : *outputs_)
@@ -322,7 +346,17 @@ void ImageFilm::init(RenderControl &render_control, RenderMonitor &render_monito
 	// Clear density image
 	if(estimate_density_)
 	{
-		density_image_ = std::make_unique<Buffer2D<Rgb>>(Size2i{{params_.width_, params_.height_}});
+		density_image_ = std::make_unique<Buffer2D<Rgb>>(Size2i{{params_.width_, params_.height_}}, params_.buffer_layout_);
+		for(auto &density_accumulator : density_accumulators_)
+		{
+			for(const int block_id : density_accumulator->touched_blocks_)
+			{
+				density_accumulator->blocks_[block_id]->clear();
+				density_accumulator->block_touched_[block_id] = 0;
+			}
+			density_accumulator->touched_blocks_.clear();
+			density_accumulator->num_samples_ = 0;
+		}
 	}
 
 	// Setup the bucket splitter
@@ -333,6 +367,8 @@ void ImageFilm::init(RenderControl &render_control, RenderMonitor &render_monito
 		area_cnt_ = splitter_->size();
 	}
 	else area_cnt_ = 1;
+	area_accumulators_.clear();
+	area_accumulators_.resize(splitter_ ? splitter_->size() : 0);
 
 	render_monitor.initProgressBar(params_.width_ * params_.height_, logger_.getConsoleLogColorsEnabled());
 
@@ -364,6 +400,7 @@ void ImageFilm::init(RenderControl &render_control, RenderMonitor &render_monito
 
 int ImageFilm::nextPass(RenderControl &render_control, RenderMonitor &render_monitor, bool adaptive_aa, const std::string &integrator_name, bool skip_nrender_layer)
 {
+	waitForFinishedAreas();
 	next_area_ = 0;
 	n_pass_++;
 	images_auto_save_params_.pass_counter_++;
@@ -399,114 +436,137 @@ int ImageFilm::nextPass(RenderControl &render_control, RenderMonitor &render_mon
 	const int variance_half_edge = aa_noise_params_.variance_edge_size_ / 2;
 	auto combined_image{film_image_layers_(LayerDef::Combined).image_};
 
-	float aa_thresh_scaled = aa_threshold_calculated_;
-
 	int n_resample = 0;
 
 	if(adaptive_aa && aa_threshold_calculated_ > 0.f)
 	{
-		for(int y = 0; y < params_.height_; ++y)
+		const int width = params_.width_;
+		const int height = params_.height_;
+		const auto pixelColor = [&](int x, int y) { return combined_image->getColor({{x, y}}).normalized(weights_({{x, y}}).getFloat()); };
+		const auto pixelThreshold = [&](const Rgba &pix_col)
 		{
-			for(int x = 0; x < params_.width_; ++x)
+			if(aa_noise_params_.dark_detection_type_ == AaNoiseParams::DarkDetectionType::Linear && aa_noise_params_.dark_threshold_factor_ > 0.f) return aa_threshold_calculated_ * ((1.f - aa_noise_params_.dark_threshold_factor_) + (pix_col.abscol2Bri() * aa_noise_params_.dark_threshold_factor_));
+			else if(aa_noise_params_.dark_detection_type_ == AaNoiseParams::DarkDetectionType::Curve) return darkThresholdCurveInterpolate(pix_col.abscol2Bri());
+			else return aa_threshold_calculated_;
+		};
+		//We will only consider the Combined Pass (pass 0) for the AA additional sampling calculations.
+		const auto isBackgroundNotResampled = [&](int x, int y)
+		{
+			if(!sampling_factor_image_pass || params_.background_resampling_) return false;
+			const float weight = weights_({{x, y}}).getFloat();
+			return weight > 0.f && sampling_factor_image_pass->getFloat({{x, y}}) == 0.f;
+		};
+		//Pixels with enough samples are decided with their own variance. The others, for example after the first pass or after loading a film, compare themselves with their neighbours
+		const auto hasVarianceEstimate = [&](int x, int y) { return aa_noise_params_.confidence_ > 0.f && pixel_moments_({{x, y}}).num_samples_ >= 2; };
+		//Neighbour comparisons are led by every pixel except the last column and row and the background pixels that are not resampled, each one against its right and lower neighbours
+		const auto isComparisonOrigin = [&](int x, int y) { return x < width - 1 && y < height - 1 && !isBackgroundNotResampled(x, y); };
+		const auto differsFromOrigin = [&](int x_origin, int y_origin, int x, int y)
+		{
+			const Rgba origin_col = pixelColor(x_origin, y_origin);
+			return origin_col.colorDifference(pixelColor(x, y), aa_noise_params_.detect_color_noise_) >= pixelThreshold(origin_col);
+		};
+		//A comparison flags both pixels, so each pixel checks the comparisons it leads and the ones it is the target of. That way every pixel only writes its own flag and the rows can be processed in parallel
+		const auto differsFromNeighbours = [&](int x, int y)
+		{
+			if(isComparisonOrigin(x, y))
 			{
-				const float weight = weights_({{x, y}}).getFloat();
-				if(weight > 0.f) flags_.set({{x, y}}, false);
-				else flags_.set({{x, y}}, true); //If after reloading ImageFiles there are pixels that were not yet rendered at all, make sure they are marked to be rendered in the next AA pass
+				if(differsFromOrigin(x, y, x + 1, y) || differsFromOrigin(x, y, x, y + 1) || differsFromOrigin(x, y, x + 1, y + 1)) return true;
+				if(x > 0 && differsFromOrigin(x, y, x - 1, y + 1)) return true;
 			}
-		}
-
-		for(int y = 0; y < params_.height_ - 1; ++y)
+			if(x > 0 && isComparisonOrigin(x - 1, y) && differsFromOrigin(x - 1, y, x, y)) return true;
+			if(y > 0)
+			{
+				if(isComparisonOrigin(x, y - 1) && differsFromOrigin(x, y - 1, x, y)) return true;
+				if(x > 0 && isComparisonOrigin(x - 1, y - 1) && differsFromOrigin(x - 1, y - 1, x, y)) return true;
+				if(isComparisonOrigin(x + 1, y - 1) && differsFromOrigin(x + 1, y - 1, x, y)) return true;
+			}
+			return false;
+		};
+		//Pixels leading comparisons with too many noisy pixels around them trigger the resampling of the whole window around them
+		const auto triggersVarianceWindow = [&](int x, int y)
 		{
-			for(int x = 0; x < params_.width_ - 1; ++x)
+			const Rgba pix_col = pixelColor(x, y);
+			const float aa_thresh_scaled = pixelThreshold(pix_col);
+			int variance_x = 0, variance_y = 0;
+			for(int xd = -variance_half_edge; xd < variance_half_edge - 1 ; ++xd)
 			{
-				//We will only consider the Combined Pass (pass 0) for the AA additional sampling calculations.
-				const float weight = weights_({{x, y}}).getFloat();
-				float mat_sample_factor = 1.f;
-				if(sampling_factor_image_pass)
-				{
-					mat_sample_factor = weight > 0.f ? sampling_factor_image_pass->getFloat({{x, y}}) / weight : 1.f;
-					if(!params_.background_resampling_ && mat_sample_factor == 0.f) continue;
-				}
-
-				const Rgba pix_col = combined_image->getColor({{x, y}}).normalized(weight);
-				const float pix_col_bri = pix_col.abscol2Bri();
-
-				if(aa_noise_params_.dark_detection_type_ == AaNoiseParams::DarkDetectionType::Linear && aa_noise_params_.dark_threshold_factor_ > 0.f)
-				{
-					if(aa_noise_params_.dark_threshold_factor_ > 0.f) aa_thresh_scaled = aa_threshold_calculated_ * ((1.f - aa_noise_params_.dark_threshold_factor_) + (pix_col_bri * aa_noise_params_.dark_threshold_factor_));
-				}
-				else if(aa_noise_params_.dark_detection_type_ == AaNoiseParams::DarkDetectionType::Curve)
-				{
-					aa_thresh_scaled = darkThresholdCurveInterpolate(pix_col_bri);
-				}
+				const int xi = std::clamp(x + xd, 0, width - 2);
+				if(pixelColor(xi, y).colorDifference(pixelColor(xi + 1, y), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled) ++variance_x;
+			}
+			for(int yd = -variance_half_edge; yd < variance_half_edge - 1 ; ++yd)
+			{
+				const int yi = std::clamp(y + yd, 0, height - 2);
+				if(pixelColor(x, yi).colorDifference(pixelColor(x, yi + 1), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled) ++variance_y;
+			}
+			return variance_x + variance_y >= aa_noise_params_.variance_pixels_;
+		};
+		const auto forEachRowBand = [&](const std::function<void(int y)> &processRow)
+		{
+			TaskGroup row_tasks;
+			const int rows_per_task = std::max(1, params_.tile_size_);
+			for(int y_0 = 0; y_0 < height; y_0 += rows_per_task)
+			{
+				row_tasks.run([=, &processRow] { for(int y = y_0; y < std::min(y_0 + rows_per_task, height); ++y) processRow(y); });
+			}
+			row_tasks.wait();
+		};
 
-				if(pix_col.colorDifference(combined_image->getColor({{x + 1, y}}).normalized(weights_({{x + 1, y}}).getFloat()), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled)
-				{
-					flags_.set({{x, y}}, true); flags_.set({{x + 1, y}}, true);
-				}
-				if(pix_col.colorDifference(combined_image->getColor({{x, y + 1}}).normalized(weights_({{x, y + 1}}).getFloat()), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled)
+		std::vector<unsigned char> variance_window_triggers(aa_noise_params_.variance_pixels_ > 0 ? static_cast<size_t>(width) * height : 0, 0);
+		forEachRowBand([&](int y)
+		{
+			for(int x = 0; x < width; ++x)
+			{
+				if(aa_noise_params_.variance_pixels_ > 0 && isComparisonOrigin(x, y)) variance_window_triggers[static_cast<size_t>(y) * width + x] = triggersVarianceWindow(x, y);
+				bool resample;
+				float convergence;
+				if(weights_({{x, y}}).getFloat() <= 0.f)
 				{
-					flags_.set({{x, y}}, true); flags_.set({{x, y + 1}}, true);
+					//If after reloading ImageFiles there are pixels that were not yet rendered at all, make sure they are marked to be rendered in the next AA pass
+					resample = true;
+					convergence = 1.f;
 				}
-				if(pix_col.colorDifference(combined_image->getColor({{x + 1, y + 1}}).normalized(weights_({{x + 1, y + 1}}).getFloat()), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled)
+				else if(hasVarianceEstimate(x, y))
 				{
-					flags_.set({{x, y}}, true); flags_.set({{x + 1, y + 1}}, true);
+					//Half width of the confidence interval of the mean brightness of the pixel samples
+					const PixelMoments &pixel_moments = pixel_moments_({{x, y}});
+					const float num_samples = static_cast<float>(pixel_moments.num_samples_);
+					const float mean = pixel_moments.sum_ / num_samples;
+					const float variance = std::max(0.f, (pixel_moments.sum_squares_ - pixel_moments.sum_ * mean) / (num_samples - 1.f));
+					const float error = aa_noise_params_.confidence_ * std::sqrt(variance / num_samples);
+					convergence = error / pixelThreshold(pixelColor(x, y));
+					resample = convergence >= 1.f && !isBackgroundNotResampled(x, y);
 				}
-				if(x > 0 && pix_col.colorDifference(combined_image->getColor({{x - 1, y + 1}}).normalized(weights_({{x - 1, y + 1}}).getFloat()), aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled)
+				else
 				{
-					flags_.set({{x, y}}, true); flags_.set({{x - 1, y + 1}}, true);
+					resample = differsFromNeighbours(x, y);
+					convergence = resample ? 1.f : 0.f;
 				}
+				flags_.set({{x, y}}, resample);
+				convergence_({{x, y}}).setFloat(convergence);
+			}
+		});
 
-				if(aa_noise_params_.variance_pixels_ > 0)
+		if(aa_noise_params_.variance_pixels_ > 0)
+		{
+			forEachRowBand([&](int y)
+			{
+				for(int x = 0; x < width; ++x)
 				{
-					int variance_x = 0, variance_y = 0;//, pixelcount = 0;
-
-					//float window_accum = 0.f, window_avg = 0.f;
-
-					for(int xd = -variance_half_edge; xd < variance_half_edge - 1 ; ++xd)
+					if(flags_.get({{x, y}}) || hasVarianceEstimate(x, y)) continue;
+					const int xi_0 = std::max(0, x - variance_half_edge + 1), xi_1 = std::min(width - 1, x + variance_half_edge);
+					const int yi_0 = std::max(0, y - variance_half_edge + 1), yi_1 = std::min(height - 1, y + variance_half_edge);
+					bool triggered = false;
+					for(int yi = yi_0; yi <= yi_1 && !triggered; ++yi)
 					{
-						int xi = x + xd;
-						if(xi < 0) xi = 0;
-						else if(xi >= params_.width_ - 1) xi = params_.width_ - 2;
-
-						const Rgba cx_0 = combined_image->getColor({{xi, y}}).normalized(weights_({{xi, y}}).getFloat());
-						const Rgba cx_1 = combined_image->getColor({{xi + 1, y}}).normalized(weights_({{xi + 1, y}}).getFloat());
-
-						if(cx_0.colorDifference(cx_1, aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled) ++variance_x;
+						for(int xi = xi_0; xi <= xi_1 && !triggered; ++xi) triggered = variance_window_triggers[static_cast<size_t>(yi) * width + xi];
 					}
-
-					for(int yd = -variance_half_edge; yd < variance_half_edge - 1 ; ++yd)
+					if(triggered)
 					{
-						int yi = y + yd;
-						if(yi < 0) yi = 0;
-						else if(yi >= params_.height_ - 1) yi = params_.height_ - 2;
-
-						const Rgba cy_0 = combined_image->getColor({{x, yi}}).normalized(weights_({{x, yi}}).getFloat());
-						const Rgba cy_1 = combined_image->getColor({{x, yi + 1}}).normalized(weights_({{x, yi + 1}}).getFloat());
-
-						if(cy_0.colorDifference(cy_1, aa_noise_params_.detect_color_noise_) >= aa_thresh_scaled) ++variance_y;
-					}
-
-					if(variance_x + variance_y >= aa_noise_params_.variance_pixels_)
-					{
-						for(int xd = -variance_half_edge; xd < variance_half_edge; ++xd)
-						{
-							for(int yd = -variance_half_edge; yd < variance_half_edge; ++yd)
-							{
-								int xi = x + xd;
-								if(xi < 0) xi = 0;
-								else if(xi >= params_.width_) xi = params_.width_ - 1;
-
-								int yi = y + yd;
-								if(yi < 0) yi = 0;
-								else if(yi >= params_.height_) yi = params_.height_ - 1;
-
-								flags_.set({{xi, yi}}, true);
-							}
-						}
+						flags_.set({{x, y}}, true);
+						convergence_({{x, y}}).setFloat(1.f);
 					}
 				}
-			}
+			});
 		}
 
 		for(int y = 0; y < params_.height_; ++y)
@@ -558,6 +618,15 @@ bool ImageFilm::nextArea(RenderArea &a)
 			a.sx_1_ = a.x_ + a.w_ - ifilterw;
 			a.sy_0_ = a.y_ + ifilterw;
 			a.sy_1_ = a.y_ + a.h_ - ifilterw;
+			if(a.id_ >= 0 && a.id_ < static_cast<int>(area_accumulators_.size()))
+			{
+				//The apron covers the whole filter footprint of the samples taken inside the area, clipped to the image
+				const int apron_x_0 = std::max(params_.start_x_, a.x_ - ifilterw - 1);
+				const int apron_y_0 = std::max(params_.start_y_, a.y_ - ifilterw - 1);
+				const int apron_x_1 = std::min(params_.start_x_ + params_.width_, a.x_ + a.w_ + ifilterw + 1);
+				const int apron_y_1 = std::min(params_.start_y_ + params_.height_, a.y_ + a.h_ + ifilterw + 1);
+				area_accumulators_[a.id_] = std::make_unique<AreaAccumulator>(Point2i{{apron_x_0, apron_y_0}}, Size2i{{apron_x_1 - apron_x_0, apron_y_1 - apron_y_0}}, static_cast<int>(film_image_layers_.size()));
+			}
 
 			if(highlight_area_callback_)
 			{
@@ -587,7 +656,47 @@ bool ImageFilm::nextArea(RenderArea &a)
 
 void ImageFilm::finishArea(RenderControl &render_control, RenderMonitor &render_monitor, const RenderArea &a)
 {
-	std::lock_guard<std::mutex> lock_guard(out_mutex_);
+	FinishedArea finished_area{a, nullptr, &render_control, &render_monitor};
+	if(a.id_ >= 0 && a.id_ < static_cast<int>(area_accumulators_.size())) finished_area.area_accumulator_ = std::move(area_accumulators_[a.id_]);
+	std::unique_lock<std::mutex> lock(output_queue_mutex_);
+	output_stage_progress_.wait(lock, [this] { return output_queue_.size() < output_queue_max_size_; });
+	output_queue_.emplace_back(std::move(finished_area));
+	lock.unlock();
+	output_queue_not_empty_.notify_one();
+}
+
+void ImageFilm::waitForFinishedAreas()
+{
+	if(std::this_thread::get_id() == output_stage_thread_.get_id()) return; //Called from the output stage itself, for example when autosaving
+	std::unique_lock<std::mutex> lock(output_queue_mutex_);
+	output_stage_progress_.wait(lock, [this] { return output_queue_.empty() && !output_stage_busy_; });
+}
+
+void ImageFilm::outputStageWorker()
+{
+	std::unique_lock<std::mutex> lock(output_queue_mutex_);
+	while(true)
+	{
+		output_queue_not_empty_.wait(lock, [this] { return output_stage_stop_ || !output_queue_.empty(); });
+		if(output_stage_stop_) return;
+		const FinishedArea finished_area{std::move(output_queue_.front())};
+		output_queue_.pop_front();
+		output_stage_busy_ = true;
+		lock.unlock();
+		output_stage_progress_.notify_all();
+		processFinishedArea(finished_area);
+		lock.lock();
+		output_stage_busy_ = false;
+		output_stage_progress_.notify_all();
+	}
+}
+
+void ImageFilm::processFinishedArea(const FinishedArea &finished_area)
+{
+	const RenderArea &a{finished_area.area_};
+	RenderControl &render_control{*finished_area.render_control_};
+	RenderMonitor &render_monitor{*finished_area.render_monitor_};
+	if(finished_area.area_accumulator_) mergeAreaAccumulator(*finished_area.area_accumulator_);
 	const int end_x = a.x_ + a.w_ - params_.start_x_;
 	const int end_y = a.y_ + a.h_ - params_.start_y_;
 
@@ -610,7 +719,10 @@ void ImageFilm::finishArea(RenderControl &render_control, RenderMonitor &render_
 			for(int i = a.x_ - params_.start_x_; i < end_x; ++i)
 			{
 				const float weight = weights_({{i, j}}).getFloat();
-				Rgba color = (layer_def == LayerDef::AaSamples ? Rgba{weight} : image->getColor({{i, j}}).normalized(weight));
+				Rgba color;
+				if(layer_def == LayerDef::AaSamples) color = Rgba{weight};
+				else if(layer_def == LayerDef::DebugConvergence) color = Rgba{convergence_({{i, j}}).getFloat()};
+				else color = image->getColor({{i, j}}).normalized(weight);
 				switch(layer_def)
 				{
 					//To correct the antialiasing and ceil the "mixed" values to the upper integer in the Object/Material Index layers
@@ -629,6 +741,7 @@ void ImageFilm::finishArea(RenderControl &render_control, RenderMonitor &render_
 		}
 	}
 
+	if(put_area_callback_) callPutAreaCallback(a.id_, {{a.x_ - params_.start_x_, a.y_ - params_.start_y_}}, {{end_x, end_y}});
 	if(flush_area_callback_) flush_area_callback_(a.id_, a.x_, a.y_, end_x + params_.start_x_, end_y + params_.start_y_, flush_area_callback_data_);
 
 	if(render_control.inProgress())
@@ -664,6 +777,7 @@ void ImageFilm::finishArea(RenderControl &render_control, RenderMonitor &render_
 
 void ImageFilm::flush(RenderControl &render_control, RenderMonitor &render_monitor, Flags flags)
 {
+	waitForFinishedAreas();
 	if(render_control.finished())
 	{
 		logger_.logInfo("imageFilm: Flushing buffer (View '", getName(), "')...");
@@ -691,7 +805,10 @@ void ImageFilm::flush(RenderControl &render_control, RenderMonitor &render_monit
 			for(int i = 0; i < params_.width_; i++)
 			{
 				const float weight = weights_({{i, j}}).getFloat();
-				Rgba color = (layer_def == LayerDef::AaSamples ? Rgba{weight} : image->getColor({{i, j}}).normalized(weight));
+				Rgba color;
+				if(layer_def == LayerDef::AaSamples) color = Rgba{weight};
+				else if(layer_def == LayerDef::DebugConvergence) color = Rgba{convergence_({{i, j}}).getFloat()};
+				else color = image->getColor({{i, j}}).normalized(weight);
 				switch(layer_def)
 				{
 					//To correct the antialiasing and ceil the "mixed" values to the upper integer in the Object/Material Index layers
@@ -711,6 +828,7 @@ void ImageFilm::flush(RenderControl &render_control, RenderMonitor &render_monit
 		}
 	}
 
+	if(put_area_callback_) callPutAreaCallback(-1, {{0, 0}}, {{params_.width_, params_.height_}});
 	if(flush_callback_) flush_callback_(flush_callback_data_);
 
 	if(render_control.finished())
@@ -797,7 +915,48 @@ void ImageFilm::addSample(const Point2i &point, float dx, float dy, const Render
 	const int x_1 = point[Axis::X] + dx_1;
 	const int y_0 = point[Axis::Y] + dy_0;
 	const int y_1 = point[Axis::Y] + dy_1;
-	const bool outside_thread_safe_area = (x_0 < a->sx_0_ || x_1 > a->sx_1_ || y_0 < a->sy_0_ || y_1 > a->sy_1_);
+	//The clamped sample colors are gathered once, in the film image layers order, instead of looking them up again for every filter tap
+	std::array<Rgba, LayerDef::Type::Size> sample_colors;
+	size_t num_layers = 0;
+	for(const auto &[layer_def, image_layer] : film_image_layers_)
+	{
+		Rgba &col = sample_colors[num_layers++];
+		col = color_layers ? (*color_layers)(layer_def) : Rgba{0.f};
+		col.clampProportionalRgb(aa_noise_params_.clamp_samples_);
+	}
+
+	if(color_layers)
+	{
+		Rgba combined_col{(*color_layers)(LayerDef::Combined)};
+		combined_col.clampProportionalRgb(aa_noise_params_.clamp_samples_);
+		const float brightness = combined_col.col2Bri();
+		PixelMoments &pixel_moments = pixel_moments_({{point[Axis::X] - params_.start_x_, point[Axis::Y] - params_.start_y_}});
+		pixel_moments.sum_ += brightness;
+		pixel_moments.sum_squares_ += brightness * brightness;
+		++pixel_moments.num_samples_;
+	}
+
+	AreaAccumulator *area_accumulator{(a && a->id_ >= 0 && a->id_ < static_cast<int>(area_accumulators_.size())) ? area_accumulators_[a->id_].get() : nullptr};
+	if(area_accumulator && x_0 >= area_accumulator->start_[Axis::X] && x_1 < area_accumulator->start_[Axis::X] + area_accumulator->size_[Axis::X] && y_0 >= area_accumulator->start_[Axis::Y] && y_1 < area_accumulator->start_[Axis::Y] + area_accumulator->size_[Axis::Y])
+	{
+		for(int j = y_0; j <= y_1; ++j)
+		{
+			for(int i = x_0; i <= x_1; ++i)
+			{
+				const size_t offset = y_index[j - y_0] * filter_table_size_ + x_index[i - x_0];
+				const float filter_wt = filter_table_[offset];
+				const Point2i accumulator_point{{i - area_accumulator->start_[Axis::X], j - area_accumulator->start_[Axis::Y]}};
+				area_accumulator->weights_(accumulator_point).addFloat(filter_wt);
+				for(size_t layer_index = 0; layer_index < num_layers; ++layer_index)
+				{
+					area_accumulator->colors_[layer_index](accumulator_point) += sample_colors[layer_index] * filter_wt;
+				}
+			}
+		}
+		return;
+	}
+
+	const bool outside_thread_safe_area = !a || (x_0 < a->sx_0_ || x_1 > a->sx_1_ || y_0 < a->sy_0_ || y_1 > a->sy_1_);
 
 	if(outside_thread_safe_area) image_mutex_.lock();
 	for(int j = y_0; j <= y_1; ++j)
@@ -810,20 +969,19 @@ void ImageFilm::addSample(const Point2i &point, float dx, float dy, const Render
 			weights_({{i - params_.start_x_, j - params_.start_y_}}).setFloat(weights_({{i - params_.start_x_, j - params_.start_y_}}).getFloat() + filter_wt);
 
 			// update pixel values with filtered sample contribution
+			size_t layer_index = 0;
 			for(auto &[layer_def, image_layer] : film_image_layers_)
 			{
-				Rgba col = color_layers ? (*color_layers)(layer_def) : Rgba{0.f};
-				col.clampProportionalRgb(aa_noise_params_.clamp_samples_);
-				image_layer.image_->addColor({{i - params_.start_x_, j - params_.start_y_}}, col * filter_wt);
+				image_layer.image_->addColor({{i - params_.start_x_, j - params_.start_y_}}, sample_colors[layer_index++] * filter_wt);
 			}
 		}
 	}
 	if(outside_thread_safe_area) image_mutex_.unlock();
 }
 
-void ImageFilm::addDensitySample(const Rgb &c, const Point2i &point, float dx, float dy)
+void ImageFilm::addDensitySample(const Rgb &c, const Point2i &point, float dx, float dy, int thread_id)
 {
-	if(!estimate_density_) return;
+	if(!estimate_density_ || thread_id < 0 || thread_id >= static_cast<int>(density_accumulators_.size())) return;
 
 	// get filter extent and make sure we don't leave image area:
 	//FIXME: using for some reason an asymmetrical rounding function with a +0.5 bias. Using a standard rounding function would increase processing time due to increased filter applicable area and potentially causing more thread locks. Keeping this asymmetrical rounding for now to keep the original functionality, but probably something to be investigated and made better in the future.
@@ -852,29 +1010,113 @@ void ImageFilm::addDensitySample(const Rgb &c, const Point2i &point, float dx, f
 	const int y_0 = point[Axis::Y] + dy_0;
 	const int y_1 = point[Axis::Y] + dy_1;
 
-	std::lock_guard<std::mutex> lock_guard(density_image_mutex_);
+	DensityAccumulator &density_accumulator{*density_accumulators_[thread_id]};
 	for(int j = y_0; j <= y_1; ++j)
 	{
 		for(int i = x_0; i <= x_1; ++i)
 		{
 			const size_t offset = y_index[j - y_0] * filter_table_size_ + x_index[i - x_0];
-			Rgb &pixel = (*density_image_)({{i - params_.start_x_, j - params_.start_y_}});
-			pixel += c * filter_table_[offset];
+			density_accumulator.pixel({{i - params_.start_x_, j - params_.start_y_}}) += c * filter_table_[offset];
+		}
+	}
+	++density_accumulator.num_samples_;
+}
+
+void ImageFilm::mergeDensitySamples()
+{
+	if(!estimate_density_ || !density_image_) return;
+	for(auto &density_accumulator : density_accumulators_)
+	{
+		for(const int block_id : density_accumulator->touched_blocks_)
+		{
+			Buffer2D<Rgb> &block{*density_accumulator->blocks_[block_id]};
+			const int block_x = (block_id % density_accumulator->num_blocks_x_) * DensityAccumulator::block_size_;
+			const int block_y = (block_id / density_accumulator->num_blocks_x_) * DensityAccumulator::block_size_;
+			const int width = std::min(DensityAccumulator::block_size_, params_.width_ - block_x);
+			const int height = std::min(DensityAccumulator::block_size_, params_.height_ - block_y);
+			for(int j = 0; j < height; ++j)
+			{
+				for(int i = 0; i < width; ++i)
+				{
+					(*density_image_)({{block_x + i, block_y + j}}) += block({{i, j}});
+				}
+			}
+			block.clear();
+			density_accumulator->block_touched_[block_id] = 0;
+		}
+		density_accumulator->touched_blocks_.clear();
+		num_density_samples_ += density_accumulator->num_samples_;
+		density_accumulator->num_samples_ = 0;
+	}
+}
+
+ImageFilm::DensityAccumulator::DensityAccumulator(const Size2i &size) : num_blocks_x_{(size[Axis::X] + block_size_ - 1) >> block_size_log_2_}
+{
+	const int num_blocks = num_blocks_x_ * ((size[Axis::Y] + block_size_ - 1) >> block_size_log_2_);
+	blocks_.resize(num_blocks);
+	block_touched_.resize(num_blocks, 0);
+}
+
+Rgb &ImageFilm::DensityAccumulator::pixel(const Point2i &point)
+{
+	const int block_id = (point[Axis::Y] >> block_size_log_2_) * num_blocks_x_ + (point[Axis::X] >> block_size_log_2_);
+	if(!block_touched_[block_id])
+	{
+		if(!blocks_[block_id]) blocks_[block_id] = std::make_unique<Buffer2D<Rgb>>(Size2i{{block_size_, block_size_}}, BufferLayout::RowMajor);
+		block_touched_[block_id] = 1;
+		touched_blocks_.emplace_back(block_id);
+	}
+	return (*blocks_[block_id])({{point[Axis::X] & (block_size_ - 1), point[Axis::Y] & (block_size_ - 1)}});
+}
+
+void ImageFilm::mergeAreaAccumulator(const AreaAccumulator &area_accumulator)
+{
+	std::lock_guard<std::mutex> lock_guard(image_mutex_);
+	for(int j = 0; j < area_accumulator.size_[Axis::Y]; ++j)
+	{
+		for(int i = 0; i < area_accumulator.size_[Axis::X]; ++i)
+		{
+			const Point2i film_point{{area_accumulator.start_[Axis::X] + i - params_.start_x_, area_accumulator.start_[Axis::Y] + j - params_.start_y_}};
+			weights_(film_point).addFloat(area_accumulator.weights_({{i, j}}).getFloat());
+		}
+	}
+	size_t layer_index = 0;
+	for(auto &[layer_def, image_layer] : film_image_layers_)
+	{
+		const Buffer2D<Rgba> &colors{area_accumulator.colors_[layer_index++]};
+		for(int j = 0; j < area_accumulator.size_[Axis::Y]; ++j)
+		{
+			for(int i = 0; i < area_accumulator.size_[Axis::X]; ++i)
+			{
+				image_layer.image_->addColor({{area_accumulator.start_[Axis::X] + i - params_.start_x_, area_accumulator.start_[Axis::Y] + j - params_.start_y_}}, colors({{i, j}}));
+			}
 		}
 	}
-	++num_density_samples_;
 }
 
-void ImageFilm::setDensityEstimation(bool enable)
+ImageFilm::AreaAccumulator::AreaAccumulator(const Point2i &start, const Size2i &size, int num_layers) : start_{start}, size_{size}, weights_{size, BufferLayout::RowMajor}
+{
+	colors_.reserve(num_layers);
+	for(int layer_index = 0; layer_index < num_layers; ++layer_index)
+	{
+		colors_.emplace_back(size, BufferLayout::RowMajor);
+		colors_.back().fill(Rgba{0.f});
+	}
+}
+
+void ImageFilm::setDensityEstimation(bool enable, int num_threads)
 {
 	if(enable)
 	{
-		if(!density_image_) density_image_ = std::make_unique<Buffer2D<Rgb>>(Size2i{{params_.width_, params_.height_}});
+		if(!density_image_) density_image_ = std::make_unique<Buffer2D<Rgb>>(Size2i{{params_.width_, params_.height_}}, params_.buffer_layout_);
 		else density_image_->clear();
+		density_accumulators_.clear();
+		for(int thread_id = 0; thread_id < num_threads; ++thread_id) density_accumulators_.emplace_back(std::make_unique<DensityAccumulator>(Size2i{{params_.width_, params_.height_}}));
 	}
 	else
 	{
 		density_image_ = nullptr;
+		density_accumulators_.clear();
 	}
 	estimate_density_ = enable;
 }
@@ -1390,6 +1632,39 @@ void ImageFilm::setRenderFlushAreaCallback(yafaray_FilmFlushAreaCallback callbac
 	flush_area_callback_data_ = callback_data;
 }
 
+void ImageFilm::setRenderPutAreaCallback(yafaray_FilmPutAreaCallback callback, void *callback_data)
+{
+	put_area_callback_ = callback;
+	put_area_callback_data_ = callback_data;
+}
+
+bool ImageFilm::getLayerBuffer(LayerDef::Type layer_type, const Point2i &start, yafaray_FilmLayerBuffer &layer_buffer) const
+{
+	const ImageLayer *image_layer = exported_image_layers_.find(layer_type);
+	if(!image_layer || !image_layer->image_) return false;
+	const float *data = image_layer->image_->getFloatData();
+	if(!data) return false;
+	const int num_channels = image_layer->image_->getNumChannels();
+	layer_buffer.layer_name = LayerDef::getName(layer_type).c_str();
+	layer_buffer.exported_image_name = image_layer->layer_.getExportedImageName().c_str();
+	layer_buffer.num_channels = num_channels;
+	layer_buffer.row_stride = image_layer->image_->getWidth() * num_channels;
+	layer_buffer.data = data + static_cast<size_t>(start[Axis::Y]) * layer_buffer.row_stride + static_cast<size_t>(start[Axis::X]) * num_channels;
+	return true;
+}
+
+void ImageFilm::callPutAreaCallback(int area_id, const Point2i &start, const Point2i &end) const
+{
+	std::vector<yafaray_FilmLayerBuffer> layer_buffers;
+	layer_buffers.reserve(exported_image_layers_.size());
+	for(const auto &[layer_def, image_layer] : exported_image_layers_)
+	{
+		yafaray_FilmLayerBuffer layer_buffer;
+		if(getLayerBuffer(layer_def, start, layer_buffer)) layer_buffers.emplace_back(layer_buffer);
+	}
+	put_area_callback_(area_id, start[Axis::X] + params_.start_x_, start[Axis::Y] + params_.start_y_, end[Axis::X] + params_.start_x_, end[Axis::Y] + params_.start_y_, layer_buffers.data(), static_cast<int>(layer_buffers.size()), put_area_callback_data_);
+}
+
 void ImageFilm::setRenderFlushCallback(yafaray_FilmFlushCallback callback, void *callback_data)
 {
 	flush_callback_ = callback;
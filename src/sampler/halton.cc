@@ -416,7 +416,7 @@ static constexpr inline std::array<double, 50> inv_prims
 /** Low Discrepancy Halton sampling */
 // dim MUST NOT be larger than 50! Above that, random numbers may be
 // the better choice anyway, not even scrambling is realiable at high dimensions.
-double Halton::lowDiscrepancySampling(FastRandom &fast_random, int dim, unsigned int n)
+double Halton::lowDiscrepancySampling(RandomGenerator &random_generator, int dim, unsigned int n)
 {
 	double value = 0.0;
 	if(dim < 50)
@@ -434,7 +434,7 @@ double Halton::lowDiscrepancySampling(FastRandom &fast_random, int dim, unsigned
 			factor *= f;
 		}
 	}
-	else value = static_cast<double>(fast_random.getNextFloatNormalized());
+	else value = random_generator();
 	return value;
 }
 
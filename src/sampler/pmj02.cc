@@ -0,0 +1,117 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "sampler/pmj02.h"
+#include "math/random.h"
+#include <algorithm>
+
+namespace yafaray {
+
+static_assert(Pmj02::num_samples_log2_ % 2 == 0, "The pmj02 tables are built in steps of 4x samples, so their size must be a power of 4");
+
+const std::vector<Pmj02> &Pmj02::tables()
+{
+	static const std::vector<Pmj02> tables{[]
+	{
+		std::vector<Pmj02> result;
+		result.reserve(num_tables_);
+		for(int table = 0; table < num_tables_; ++table) result.push_back(Pmj02{static_cast<uint32_t>(table)});
+		return result;
+	}()};
+	return tables;
+}
+
+Pmj02::Pmj02(uint32_t seed)
+{
+	//Random choices can very rarely lead to a sub-quadrant without any valid position left, in that case the table is generated again with another seed
+	for(uint32_t attempt = 0; !generate(RandomGenerator::seed(seed, attempt, 0x706d6a30)); ++attempt) { }
+}
+
+bool Pmj02::generate(uint32_t seed)
+{
+	RandomGenerator random_generator(seed);
+	samples_.assign(num_samples_, {0.f, 0.f});
+	samples_[0] = {static_cast<float>(random_generator()), static_cast<float>(random_generator())};
+
+	//Occupied strata for each of the elementary interval shapes (2^k x 2^(m-k) strata) for 2^m samples
+	int strata_log2 = 0;
+	std::vector<bool> occupied;
+	std::vector<Uv<int>> candidates;
+	const auto fineStratum = [&](float value) { return std::min(static_cast<int>(value * static_cast<float>(1 << strata_log2)), (1 << strata_log2) - 1); };
+	const auto stratumIndex = [&](int shape, const Uv<int> &fine_stratum) { return (shape << strata_log2) + (fine_stratum.u_ >> (strata_log2 - shape)) + ((fine_stratum.v_ >> shape) << shape); };
+	const auto markOccupied = [&](const Uv<int> &fine_stratum) { for(int shape = 0; shape <= strata_log2; ++shape) occupied[stratumIndex(shape, fine_stratum)] = true; };
+	const auto initOccupied = [&](int num_existing_samples, int new_strata_log2)
+	{
+		strata_log2 = new_strata_log2;
+		occupied.assign((strata_log2 + 1) << strata_log2, false);
+		for(int i = 0; i < num_existing_samples; ++i) markOccupied({fineStratum(samples_[i].u_), fineStratum(samples_[i].v_)});
+	};
+	//Places the sample at a random position in the sub-quadrant that does not fall in any occupied stratum
+	const auto addSample = [&](int index, const Uv<int> &sub_quadrant, int sub_quadrant_grid_log2)
+	{
+		const int side = 1 << (strata_log2 - sub_quadrant_grid_log2);
+		candidates.clear();
+		for(int y = sub_quadrant.v_ * side; y < (sub_quadrant.v_ + 1) * side; ++y)
+		{
+			for(int x = sub_quadrant.u_ * side; x < (sub_quadrant.u_ + 1) * side; ++x)
+			{
+				bool valid = true;
+				for(int shape = 0; shape <= strata_log2 && valid; ++shape) valid = !occupied[stratumIndex(shape, {x, y})];
+				if(valid) candidates.push_back({x, y});
+			}
+		}
+		if(candidates.empty()) return false;
+		const Uv<int> &fine_stratum = candidates[std::min(static_cast<size_t>(random_generator() * static_cast<double>(candidates.size())), candidates.size() - 1)];
+		markOccupied(fine_stratum);
+		//The jitter is slightly below 1 so float rounding never moves the sample to the next stratum
+		const float inv_num_strata = 1.f / static_cast<float>(1 << strata_log2);
+		samples_[index] = {
+				(static_cast<float>(fine_stratum.u_) + 0.9998f * static_cast<float>(random_generator())) * inv_num_strata,
+				(static_cast<float>(fine_stratum.v_) + 0.9998f * static_cast<float>(random_generator())) * inv_num_strata
+		};
+		return true;
+	};
+
+	for(int num_samples_log2 = 0; num_samples_log2 < num_samples_log2_; num_samples_log2 += 2)
+	{
+		const int num_samples = 1 << num_samples_log2;
+		const int grid_log2 = num_samples_log2 / 2; //the existing samples are stratified in a square grid of 2^grid_log2 x 2^grid_log2 cells
+		const auto subQuadrant = [&](const Uv<float> &sample) -> Uv<int> { return {static_cast<int>(sample.u_ * static_cast<float>(2 << grid_log2)), static_cast<int>(sample.v_ * static_cast<float>(2 << grid_log2))}; };
+		//From N to 2N samples: each new sample goes to the sub-quadrant diagonally opposite to the existing sample in its grid cell
+		initOccupied(num_samples, num_samples_log2 + 1);
+		for(int i = 0; i < num_samples; ++i)
+		{
+			const Uv<int> sub_quadrant{subQuadrant(samples_[i])};
+			if(!addSample(num_samples + i, {sub_quadrant.u_ ^ 1, sub_quadrant.v_ ^ 1}, grid_log2 + 1)) return false;
+		}
+		//From 2N to 4N samples: the two new samples of each grid cell go to its two remaining sub-quadrants, randomly paired with the previous samples
+		initOccupied(2 * num_samples, num_samples_log2 + 2);
+		for(int i = 0; i < num_samples; ++i)
+		{
+			const Uv<int> sub_quadrant{subQuadrant(samples_[i])};
+			const bool swap_x = random_generator() < 0.5;
+			const Uv<int> sub_quadrant_first{swap_x ? sub_quadrant.u_ ^ 1 : sub_quadrant.u_, swap_x ? sub_quadrant.v_ : sub_quadrant.v_ ^ 1};
+			const Uv<int> sub_quadrant_second{sub_quadrant_first.u_ ^ 1, sub_quadrant_first.v_ ^ 1};
+			if(!addSample(2 * num_samples + i, sub_quadrant_first, grid_log2 + 1)) return false;
+			if(!addSample(3 * num_samples + i, sub_quadrant_second, grid_log2 + 1)) return false;
+		}
+	}
+	return true;
+}
+
+} //namespace yafaray
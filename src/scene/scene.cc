@@ -33,10 +33,12 @@
 #include "light/light.h"
 #include "material/material.h"
 #include "texture/texture.h"
+#include "texture/texture_cache.h"
 #include "param/param_result.h"
 #include "volume/region/volume_region.h"
 #include "render/render_control.h"
 #include "common/file.h"
+#include "common/timer.h"
 #include <memory>
 
 namespace yafaray {
@@ -213,6 +215,7 @@ bool Scene::addFace(size_t object_id, const FaceIndices<int> &face_indices, size
 {
 	auto[object, object_result]{objects_.getById(object_id)};
 	object->addFace(face_indices, material_id);
+	modified_objects_.insert(object_id);
 	return true;
 }
 
@@ -222,6 +225,79 @@ int Scene::addUv(size_t object_id, Uv<float> &&uv)
 	return object->addUvValue(std::move(uv));
 }
 
+bool Scene::addVertices(size_t object_id, const float *points, const float *orco_points, size_t num_points, unsigned char time_step)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return false;
+	return object->addPoints(points, orco_points, num_points, time_step) >= 0;
+}
+
+bool Scene::addVerticesNormals(size_t object_id, const float *normals, size_t num_normals, unsigned char time_step)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return false;
+	return object->addVerticesNormals(normals, num_normals, time_step);
+}
+
+bool Scene::addUvs(size_t object_id, const float *uv_values, size_t num_uv_values)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return false;
+	return object->addUvValues(uv_values, num_uv_values) >= 0;
+}
+
+bool Scene::addFaces(size_t object_id, const int *vertices_indices, const int *uv_indices, size_t num_faces, int vertices_per_face, const size_t *materials_ids, size_t material_id)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return false;
+	const bool result{object->addFaces(vertices_indices, uv_indices, num_faces, vertices_per_face, materials_ids, material_id)};
+	if(!result) logger_.logWarning(getClassName(), " '", getName(), "'::addFaces: wrong face indices or vertices per face for object id '", object_id, "', no faces added");
+	else modified_objects_.insert(object_id);
+	return result;
+}
+
+float *Scene::getVerticesBuffer(size_t object_id, size_t num_points, unsigned char time_step)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return nullptr;
+	//Rewriting the same number of vertices keeps the mesh topology, so its accelerators only need to be refitted to the new vertices positions
+	const bool same_size{num_points > 0 && time_step < object->numTimeSteps() && static_cast<int>(num_points) == object->numVertices(time_step)};
+	float *buffer{object->getPointsBuffer(num_points, time_step)};
+	//An empty buffer has no storage, so it is null even when the vertices were cleared successfully
+	if(!buffer && num_points > 0) logger_.logWarning(getClassName(), " '", getName(), "'::getVerticesBuffer: cannot set ", num_points, " vertices in object id '", object_id, "', time step or existing face indices out of range");
+	else markBufferChanged(object_id, same_size);
+	return buffer;
+}
+
+float *Scene::getVerticesNormalsBuffer(size_t object_id, size_t num_normals, unsigned char time_step)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return nullptr;
+	const bool same_size{num_normals > 0 && time_step < object->numTimeSteps() && static_cast<int>(num_normals) == object->numVerticesNormals(time_step)};
+	float *buffer{object->getVerticesNormalsBuffer(num_normals, time_step)};
+	if(!buffer && num_normals > 0) logger_.logWarning(getClassName(), " '", getName(), "'::getVerticesNormalsBuffer: cannot set ", num_normals, " normals in object id '", object_id, "', time step or existing face indices out of range");
+	else markBufferChanged(object_id, same_size);
+	return buffer;
+}
+
+float *Scene::getUvsBuffer(size_t object_id, size_t num_uv_values)
+{
+	auto[object, object_result]{objects_.getById(object_id)};
+	if(!object) return nullptr;
+	const bool same_size{num_uv_values > 0 && num_uv_values == object->numUvValues()};
+	float *buffer{object->getUvValuesBuffer(num_uv_values)};
+	if(!buffer && num_uv_values > 0) logger_.logWarning(getClassName(), " '", getName(), "'::getUvsBuffer: cannot set ", num_uv_values, " uvs in object id '", object_id, "', existing face indices out of range");
+	else markBufferChanged(object_id, same_size);
+	return buffer;
+}
+
+void Scene::markBufferChanged(size_t object_id, bool same_size)
+{
+	//A buffer rewritten with the same size is treated as an in-place deformation, any other size is a full modification of the object
+	if(same_size) deformed_objects_.insert(object_id);
+	else modified_objects_.insert(object_id);
+}
+
 std::pair<size_t, ParamResult> Scene::createObject(const std::string &name, const ParamMap &param_map)
 {
 	auto result{Items<Object>::createItem<Scene>(logger_, objects_, name, param_map, *this)};
@@ -241,6 +317,7 @@ std::pair<const Object *, ResultFlags> Scene::getObject(size_t object_id) const
 size_t Scene::createInstance()
 {
 	instances_.emplace_back(std::make_unique<Instance>());
+	instances_modified_ = true;
 	return instances_.size() - 1;
 }
 
@@ -252,6 +329,7 @@ bool Scene::addInstanceObject(size_t instance_id, size_t object_id)
 	else
 	{
 		instances_[instance_id]->addObject(object_id);
+		instances_modified_ = true;
 		return true;
 	}
 }
@@ -260,6 +338,7 @@ bool Scene::addInstanceOfInstance(size_t instance_id, size_t base_instance_id)
 {
 	if(instance_id >= instances_.size() || base_instance_id >= instances_.size()) return false;
 	instances_[instance_id]->addInstance(base_instance_id);
+	instances_modified_ = true;
 	return true;
 }
 
@@ -267,15 +346,18 @@ bool Scene::addInstanceMatrix(size_t instance_id, Matrix4f &&obj_to_world, float
 {
 	if(instance_id >= instances_.size()) return false;
 	instances_[instance_id]->addObjToWorldMatrix(std::move(obj_to_world), time);
+	instances_modified_ = true;
 	return true;
 }
 
 yafaray_SceneModifiedFlags Scene::checkAndClearSceneModifiedFlags()
 {
 	int scene_modified_flags{YAFARAY_SCENE_MODIFIED_NOTHING};
-	if(objects_.modified()) //FIXME: INSTANCES MODIFIED????
+	if(objects_.modified() || !modified_objects_.empty() || !deformed_objects_.empty() || instances_modified_)
 	{
 		scene_modified_flags = scene_modified_flags | YAFARAY_SCENE_MODIFIED_OBJECTS;
+		//The modified objects are kept until the next scene preprocess, to update only their accelerators
+		modified_objects_.insert(objects_.modifiedList().begin(), objects_.modifiedList().end());
 		objects_.clearModifiedList();
 	}
 	if(lights_.modified())
@@ -317,40 +399,105 @@ bool Scene::preprocess(const RenderControl &render_control, yafaray_SceneModifie
 	//if(!accelerator_) scene_modified_flags = static_cast<yafaray_SceneModifiedFlags>(YAFARAY_SCENE_MODIFIED_LIGHTS | YAFARAY_SCENE_MODIFIED_IMAGES | YAFARAY_SCENE_MODIFIED_TEXTURES | YAFARAY_SCENE_MODIFIED_MATERIALS | YAFARAY_SCENE_MODIFIED_OBJECTS | YAFARAY_SCENE_MODIFIED_VOLUME_REGIONS);
 	if((scene_modified_flags & YAFARAY_SCENE_MODIFIED_OBJECTS) || (scene_modified_flags & YAFARAY_SCENE_MODIFIED_SCENE_ACCELERATOR_PARAMS))
 	{
-		std::vector<const Primitive *> primitives;
-		for(const auto &[object, object_name, object_enabled]: objects_)
+		Timer timer;
+		const bool timer_started{timer.addEvent("accelerators") && timer.start("accelerators")};
+		//Without dirty tracking information (for example when the flags are set by the caller) everything is rebuilt
+		const bool rebuild_all{!accelerator_ || (scene_modified_flags & YAFARAY_SCENE_MODIFIED_SCENE_ACCELERATOR_PARAMS) || (modified_objects_.empty() && deformed_objects_.empty() && !instances_modified_)};
+		bool rebuild_top_level{rebuild_all || instances_modified_ || !modified_objects_.empty()};
+		if(rebuild_all) object_accelerators_.clear();
+		else
 		{
-			if(!object || !object_enabled || object->getVisibility() == Visibility::None || object->isBaseObject()) continue;
-			const auto object_primitives{object->getPrimitives()};
-			primitives.insert(primitives.end(), object_primitives.begin(), object_primitives.end());
+			for(const size_t object_id : modified_objects_) object_accelerators_.erase(object_id);
+			for(const size_t object_id : deformed_objects_)
+			{
+				//The primitives cache their geometric normals, which are not valid anymore after a deformation (unless it is just a translation)
+				if(auto [object, object_result]{objects_.getById(object_id)}; object) object->updateGeometricNormals();
+				const auto object_accelerator_it{object_accelerators_.find(object_id)};
+				if(object_accelerator_it == object_accelerators_.end() || object_accelerator_it->second->refit()) continue;
+				//The object accelerator cannot be refitted, it will be rebuilt together with the top level accelerator, as the instances primitives will change
+				object_accelerators_.erase(object_accelerator_it);
+				rebuild_top_level = true;
+			}
 		}
-		for(size_t instance_id = 0; instance_id < instances_.size(); ++instance_id)
+		if(!rebuild_top_level)
 		{
-			//if(object->getVisibility() == Visibility::Invisible) continue; //FIXME
-			//if(object->isBaseObject()) continue; //FIXME
-			auto instance{instances_[instance_id].get()};
-			if(!instance) continue;
-			const bool instance_primitives_result{instance->updatePrimitives(*this)};
-			if(!instance_primitives_result)
+			if(accelerator_->refit())
+			{
+				if(logger_.isVerbose()) logger_.logVerbose(getClassName(), " '", getName(), "': Refitted ", accelerator_->getClassName(), " (", accelerator_->type().print(), ") to ", deformed_objects_.size(), " deformed objects");
+			}
+			else
 			{
-				logger_.logWarning(getClassName(), " '", getName(), "': Instance id=", instance_id, " could not update primitives, maybe recursion problem...");
-				continue;
+				if(logger_.isVerbose()) logger_.logVerbose(getClassName(), " '", getName(), "': ", accelerator_->getClassName(), " (", accelerator_->type().print(), ") cannot be refitted, rebuilding it");
+				rebuild_top_level = true;
 			}
-			const auto instance_primitives{instance->getPrimitives()};
-			primitives.insert(primitives.end(), instance_primitives.begin(), instance_primitives.end());
 		}
-		if(primitives.empty())
+		if(rebuild_top_level)
 		{
-			logger_.logWarning(getClassName(), " '", getName(), "': Scene is empty...");
-		}
+			std::vector<const Primitive *> primitives;
+			for(const auto &[object, object_name, object_enabled]: objects_)
+			{
+				if(!object || !object_enabled || object->getVisibility() == Visibility::None || object->isBaseObject()) continue;
+				const auto object_primitives{object->getPrimitives()};
+				primitives.insert(primitives.end(), object_primitives.begin(), object_primitives.end());
+			}
+			std::set<size_t> instanced_object_ids;
+			for(const auto &instance : instances_)
+			{
+				if(!instance) continue;
+				const auto base_object_ids{instance->getBaseObjectIds()};
+				instanced_object_ids.insert(base_object_ids.begin(), base_object_ids.end());
+			}
+			for(auto object_accelerator_it = object_accelerators_.begin(); object_accelerator_it != object_accelerators_.end();)
+			{
+				if(instanced_object_ids.find(object_accelerator_it->first) == instanced_object_ids.end()) object_accelerator_it = object_accelerators_.erase(object_accelerator_it);
+				else ++object_accelerator_it;
+			}
+			const size_t num_object_accelerators_kept{object_accelerators_.size()};
+			for(const size_t object_id : instanced_object_ids)
+			{
+				if(object_accelerators_.find(object_id) != object_accelerators_.end()) continue;
+				const auto [object, object_result]{objects_.getById(object_id)};
+				if(!object) continue;
+				auto [object_accelerator, object_accelerator_result]{Accelerator::factory(logger_, &render_control, object->getPrimitives(), accelerator_param_map_)};
+				if(object_accelerator) object_accelerators_[object_id] = std::move(object_accelerator);
+			}
+			if(logger_.isVerbose() && !object_accelerators_.empty()) logger_.logVerbose(getClassName(), " '", getName(), "': Built object space accelerators for ", object_accelerators_.size() - num_object_accelerators_kept, " instanced objects, reused ", num_object_accelerators_kept, " unmodified ones");
+			for(size_t instance_id = 0; instance_id < instances_.size(); ++instance_id)
+			{
+				//if(object->getVisibility() == Visibility::Invisible) continue; //FIXME
+				//if(object->isBaseObject()) continue; //FIXME
+				auto instance{instances_[instance_id].get()};
+				if(!instance) continue;
+				const bool instance_primitives_result{instance->updatePrimitives(logger_, *this)};
+				if(!instance_primitives_result)
+				{
+					logger_.logWarning(getClassName(), " '", getName(), "': Instance id=", instance_id, " could not update primitives, maybe recursion problem...");
+					continue;
+				}
+				const auto instance_primitives{instance->getPrimitives()};
+				primitives.insert(primitives.end(), instance_primitives.begin(), instance_primitives.end());
+			}
+			if(primitives.empty())
+			{
+				logger_.logWarning(getClassName(), " '", getName(), "': Scene is empty...");
+			}
 
-		auto [accelerator, accelerator_result]{Accelerator::factory(logger_, &render_control, primitives, accelerator_param_map_)};
-		if(logger_.isVerbose() && accelerator)
-		{
-			logger_.logVerbose(getClassName(), " '", getName(), "': Added ", accelerator->getClassName(), " (", accelerator->type().print(), ")!");
+			auto [accelerator, accelerator_result]{Accelerator::factory(logger_, &render_control, primitives, accelerator_param_map_)};
+			if(logger_.isVerbose() && accelerator)
+			{
+				logger_.logVerbose(getClassName(), " '", getName(), "': Added ", accelerator->getClassName(), " (", accelerator->type().print(), ")!");
+			}
+			accelerator_ = std::move(accelerator);
 		}
-		accelerator_ = std::move(accelerator);
+		modified_objects_.clear();
+		deformed_objects_.clear();
+		instances_modified_ = false;
 		*scene_bound_ = accelerator_->getBound();
+		if(timer_started && timer.stop("accelerators"))
+		{
+			accelerator_build_time_ = timer.getTime("accelerators");
+			if(logger_.isVerbose()) logger_.logVerbose(getClassName(), " '", getName(), "': Accelerators building time: ", accelerator_build_time_, "s");
+		}
 		if(logger_.isVerbose()) logger_.logVerbose(getClassName(), " '", getName(), "': New scene bound is: ", "(", scene_bound_->a_[Axis::X], ", ", scene_bound_->a_[Axis::Y], ", ", scene_bound_->a_[Axis::Z], "), (", scene_bound_->g_[Axis::X], ", ", scene_bound_->g_[Axis::Y], ", ", scene_bound_->g_[Axis::Z], ")");
 
 		object_index_highest_ = 1;
@@ -363,6 +510,12 @@ bool Scene::preprocess(const RenderControl &render_control, yafaray_SceneModifie
 
 	if(scene_modified_flags & YAFARAY_SCENE_MODIFIED_MATERIALS || scene_modified_flags & YAFARAY_SCENE_MODIFIED_TEXTURES || scene_modified_flags & YAFARAY_SCENE_MODIFIED_IMAGES)
 	{
+		if(scene_modified_flags & YAFARAY_SCENE_MODIFIED_MATERIALS)
+		{
+			//The accelerators may keep precomputed materials visibility and transparency
+			if(accelerator_) accelerator_->updatePrimitiveFlags();
+			for(auto &[object_id, object_accelerator] : object_accelerators_) object_accelerator->updatePrimitiveFlags();
+		}
 		for(auto &texture: textures_)
 		{
 			texture.item_->updateMipMaps();
@@ -402,6 +555,13 @@ bool Scene::preprocess(const RenderControl &render_control, yafaray_SceneModifie
 	return true;
 }
 
+const Accelerator *Scene::getObjectAccelerator(size_t object_id) const
+{
+	const auto object_accelerator_it{object_accelerators_.find(object_id)};
+	if(object_accelerator_it == object_accelerators_.end()) return nullptr;
+	else return object_accelerator_it->second.get();
+}
+
 std::pair<const Instance *, ResultFlags> Scene::getInstance(size_t instance_id) const
 {
 	if(instance_id >= instances_.size()) return {nullptr, YAFARAY_RESULT_ERROR_NOT_FOUND};
@@ -447,6 +607,12 @@ void Scene::setAcceleratorParamMap(const ParamMap &param_map)
 	}
 }
 
+void Scene::setTextureCacheParamMap(const ParamMap &param_map)
+{
+	//Images already loaded keep using the previous cache, if any, as they hold a reference to it
+	texture_cache_ = TextureCache::factory(logger_, param_map).first;
+}
+
 std::string Scene::exportToString(size_t indent_level, yafaray_ContainerExportType container_export_type, bool only_export_non_default_parameters) const
 {
 	std::stringstream ss;
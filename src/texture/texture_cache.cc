@@ -0,0 +1,267 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "texture/texture_cache.h"
+#include "image/image_buffer.h"
+#include "param/param.h"
+#include "common/logger.h"
+#include "common/file.h"
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+namespace yafaray {
+
+//! Direct mapped lookup cache of the tiles most recently used by the calling thread. Holding the tiles here keeps them alive even if they are evicted from the shared cache meanwhile
+struct TextureCache::ThreadTileCache
+{
+	struct Entry
+	{
+		size_t cache_serial_{0};
+		uint64_t key_{0};
+		std::shared_ptr<const Image> tile_;
+	};
+	static constexpr inline size_t num_entries_ = 32;
+	std::array<Entry, num_entries_> entries_;
+};
+
+std::map<std::string, const ParamMeta *> TextureCache::Params::getParamMetaMap()
+{
+	std::map<std::string, const ParamMeta *> param_meta_map;
+	PARAM_META(size_mb_);
+	PARAM_META(tile_size_);
+	PARAM_META(directory_);
+	return param_meta_map;
+}
+
+TextureCache::Params::Params(ParamResult &param_result, const ParamMap &param_map)
+{
+	PARAM_LOAD(size_mb_);
+	PARAM_LOAD(tile_size_);
+	PARAM_LOAD(directory_);
+}
+
+ParamMap TextureCache::getAsParamMap(bool only_non_default) const
+{
+	ParamMap param_map;
+	PARAM_SAVE(size_mb_);
+	PARAM_SAVE(tile_size_);
+	PARAM_SAVE(directory_);
+	return param_map;
+}
+
+std::pair<std::unique_ptr<TextureCache>, ParamResult> TextureCache::factory(Logger &logger, const ParamMap &param_map)
+{
+	if(logger.isDebug()) logger.logDebug("** " + getClassName() + "::factory 'raw' ParamMap contents:\n" + param_map.logContents());
+	auto param_result{class_meta::check<Params>(param_map, {}, {})};
+	auto texture_cache{std::make_unique<TextureCache>(logger, param_result, param_map)};
+	if(param_result.notOk()) logger.logWarning(param_result.print<TextureCache>(getClassName(), {}));
+	if(texture_cache->params_.size_mb_ <= 0) return {nullptr, param_result};
+	if(!texture_cache->file_)
+	{
+		logger.logError(getClassName(), ": could not create the tiles file, the texture cache will be disabled");
+		return {nullptr, ParamResult{YAFARAY_RESULT_ERROR_WHILE_CREATING}};
+	}
+	logger.logParams(getClassName(), ": using ", texture_cache->params_.size_mb_, "MB for tiles of ", texture_cache->params_.tile_size_, "x", texture_cache->params_.tile_size_, " texels");
+	return {std::move(texture_cache), param_result};
+}
+
+TextureCache::TextureCache(Logger &logger, ParamResult &param_result, const ParamMap &param_map) : params_{param_result, param_map}, serial_{[]{ static std::atomic<size_t> num_caches{0}; return ++num_caches; }()}, logger_{logger}
+{
+	if(logger_.isDebug()) logger_.logDebug("**" + getClassName() + " params_:\n" + getAsParamMap(true).print());
+	if(params_.size_mb_ <= 0 || params_.tile_size_ <= 0) return;
+	if(params_.directory_.empty()) file_ = std::tmpfile();
+	else
+	{
+		file_path_ = Path{params_.directory_, "yafaray_texture_cache_" + std::to_string(serial_), "tiles"}.getFullPath();
+		file_ = File::open(file_path_, "w+b");
+	}
+}
+
+TextureCache::~TextureCache()
+{
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": ", num_images_, " images in ", file_size_ / (1024 * 1024), "MB of tiles, ", tiles_loaded_, " tiles loaded from disk during the render");
+	if(file_) File::close(file_);
+	if(!file_path_.empty()) File::remove(file_path_, true);
+}
+
+//! Calls "function" with a texel of the pixel type Image::factory uses for the image type and optimization, so the tiles keep the memory layout of the original images
+template <typename Function>
+auto TextureCache::visitPixelType(Image::Type type, Image::Optimization optimization, Function &&function)
+{
+	switch(type.value())
+	{
+		case Image::Type::Gray: return (optimization == Image::Optimization::None) ? function(Gray{}) : function(Gray8{});
+		case Image::Type::GrayAlpha: return function(GrayAlpha{});
+		case Image::Type::Color:
+			switch(optimization.value())
+			{
+				case Image::Optimization::Optimized: return function(Rgb101010{});
+				case Image::Optimization::Compressed: return function(Rgb565{});
+				default: return function(Rgb{});
+			}
+		case Image::Type::ColorAlpha:
+		default:
+			switch(optimization.value())
+			{
+				case Image::Optimization::Optimized: return function(Rgba1010108{});
+				case Image::Optimization::Compressed: return function(Rgba7773{});
+				default: return function(RgbAlpha{});
+			}
+	}
+}
+
+size_t TextureCache::bytesPerTexel(Image::Type type, Image::Optimization optimization)
+{
+	return visitPixelType(type, optimization, [](auto texel) { return sizeof(texel); });
+}
+
+Image::Params TextureCache::tileParams(const ImageLayout &image_layout) const
+{
+	Image::Params tile_params;
+	tile_params.width_ = params_.tile_size_;
+	tile_params.height_ = params_.tile_size_;
+	tile_params.type_ = image_layout.type_;
+	tile_params.image_optimization_ = image_layout.optimization_;
+	tile_params.buffer_layout_ = BufferLayout::RowMajor; //The tile texels are stored in disk row by row
+	return tile_params;
+}
+
+//! The tiles are stored one after another, padding the tiles at the right and bottom edges of the image
+template <typename T>
+bool TextureCache::writeTiles(const Image &image, const ImageLayout &image_layout)
+{
+	const int tile_size{params_.tile_size_};
+	ImageBuffer<T> tile_buffer{tileParams(image_layout)};
+	Image &tile{tile_buffer};
+	for(int tile_y = 0; tile_y < image_layout.tiles_y_; ++tile_y)
+	{
+		for(int tile_x = 0; tile_x < image_layout.tiles_x_; ++tile_x)
+		{
+			for(int y = 0; y < tile_size; ++y)
+			{
+				const int image_y{std::min(tile_y * tile_size + y, image.getHeight() - 1)};
+				for(int x = 0; x < tile_size; ++x)
+				{
+					const int image_x{std::min(tile_x * tile_size + x, image.getWidth() - 1)};
+					tile.setColor({{x, y}}, image.getColor({{image_x, image_y}}));
+				}
+			}
+			if(std::fwrite(tile_buffer.getPixels(), sizeof(T), tileTexels(), file_) != tileTexels()) return false;
+			file_size_ += tileTexels() * sizeof(T);
+		}
+	}
+	return true;
+}
+
+template <typename T>
+std::unique_ptr<Image> TextureCache::readTile(const ImageLayout &image_layout, int tile_x, int tile_y) const
+{
+	auto tile{std::make_unique<ImageBuffer<T>>(tileParams(image_layout))};
+	const uint64_t tile_bytes{tileTexels() * sizeof(T)};
+	const uint64_t tile_offset{image_layout.file_offset_ + (static_cast<uint64_t>(tile_y) * static_cast<uint64_t>(image_layout.tiles_x_) + static_cast<uint64_t>(tile_x)) * tile_bytes};
+	if(!File::readAt(file_, tile->getPixels(), tile_bytes, tile_offset))
+	{
+		logger_.logError(getClassName(), ": error reading tile [", tile_x, ", ", tile_y, "] from the tiles file");
+		static_cast<Image &>(*tile).clear();
+	}
+	return tile;
+}
+
+std::pair<TextureCache::ImageLayout, bool> TextureCache::addImage(const Image &image)
+{
+	const int tile_size{params_.tile_size_};
+	ImageLayout image_layout;
+	image_layout.tiles_x_ = (image.getWidth() + tile_size - 1) / tile_size;
+	image_layout.tiles_y_ = (image.getHeight() + tile_size - 1) / tile_size;
+	image_layout.type_ = image.type();
+	image_layout.optimization_ = image.getOptimization();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(!file_) return {image_layout, false};
+	image_layout.image_index_ = num_images_;
+	image_layout.file_offset_ = file_size_;
+	if(!File::seek(file_, file_size_)) return {image_layout, false};
+	const bool result{visitPixelType(image_layout.type_, image_layout.optimization_, [&](auto texel) { return writeTiles<decltype(texel)>(image, image_layout); })};
+	//The tiles are read directly from the file descriptor, bypassing the stdio buffers
+	if(!result || std::fflush(file_) != 0)
+	{
+		logger_.logError(getClassName(), ": error writing the tiles file");
+		return {image_layout, false};
+	}
+	++num_images_;
+	if(logger_.isVerbose()) logger_.logVerbose(getClassName(), ": image [", image.getWidth(), " x ", image.getHeight(), "] split in ", image_layout.tiles_x_ * image_layout.tiles_y_, " tiles of ", tileTexels() * bytesPerTexel(image_layout.type_, image_layout.optimization_) / 1024, "KB");
+	return {image_layout, true};
+}
+
+std::shared_ptr<const Image> TextureCache::loadTile(const ImageLayout &image_layout, int tile_x, int tile_y) const
+{
+	const uint64_t key{tileKey(image_layout.image_index_, tile_x, tile_y)};
+	const size_t tile_bytes{tileTexels() * bytesPerTexel(image_layout.type_, image_layout.optimization_)};
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(true)
+		{
+			const auto it{tiles_map_.find(key)};
+			if(it == tiles_map_.end()) break;
+			if(it->second->tile_)
+			{
+				lru_tiles_.splice(lru_tiles_.begin(), lru_tiles_, it->second);
+				return it->second->tile_;
+			}
+			tile_loaded_condition_.wait(lock); //Another thread is loading the tile
+		}
+		//The tiles still being loaded cannot be evicted, their threads will need their entries
+		for(auto it{lru_tiles_.end()}; it != lru_tiles_.begin() && memory_used_ + tile_bytes > budget_bytes_;)
+		{
+			--it;
+			if(!it->tile_) continue;
+			tiles_map_.erase(it->key_);
+			memory_used_ -= it->bytes_;
+			it = lru_tiles_.erase(it);
+		}
+		lru_tiles_.emplace_front(CachedTile{key, nullptr, tile_bytes});
+		tiles_map_[key] = lru_tiles_.begin();
+		memory_used_ += tile_bytes;
+	}
+
+	std::shared_ptr<const Image> tile{visitPixelType(image_layout.type_, image_layout.optimization_, [&](auto texel) { return readTile<decltype(texel)>(image_layout, tile_x, tile_y); })};
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tiles_map_.at(key)->tile_ = tile;
+		++tiles_loaded_;
+	}
+	tile_loaded_condition_.notify_all();
+	return tile;
+}
+
+const Image *TextureCache::getTile(const ImageLayout &image_layout, int tile_x, int tile_y) const
+{
+	thread_local ThreadTileCache thread_tile_cache;
+	const uint64_t key{tileKey(image_layout.image_index_, tile_x, tile_y)};
+	ThreadTileCache::Entry &entry{thread_tile_cache.entries_[(key ^ (key >> 20) ^ (key >> 40)) % ThreadTileCache::num_entries_]};
+	if(entry.cache_serial_ != serial_ || entry.key_ != key || !entry.tile_)
+	{
+		entry.tile_ = loadTile(image_layout, tile_x, tile_y);
+		entry.cache_serial_ = serial_;
+		entry.key_ = key;
+	}
+	return entry.tile_.get();
+}
+
+} //namespace yafaray
@@ -26,6 +26,7 @@
 #include "math/interpolation.h"
 #include "common/file.h"
 #include "image/image_manipulation.h"
+#include "image/image_tiled.h"
 //#include "format/format.h"
 //#include "image/image_layers.h"
 
@@ -126,12 +127,12 @@ std::pair<std::unique_ptr<Texture>, ParamResult> ImageTexture::factory(Logger &l
 		logger.logError("ImageTexture: Couldn't load image file, dropping texture.");
 		return {nullptr, ParamResult{YAFARAY_RESULT_ERROR_WHILE_CREATING}};
 	}
-	auto texture {std::make_unique<ImageTexture>(logger, param_result, param_map, scene.getImages(), image_id, scene.getTextures())};
+	auto texture {std::make_unique<ImageTexture>(logger, param_result, param_map, scene.getImages(), image_id, scene.getTextures(), scene.getTextureCache())};
 	if(param_result.notOk()) logger.logWarning(param_result.print<ThisClassType_t>(name, {"type"}));
 	return {std::move(texture), param_result};
 }
 
-ImageTexture::ImageTexture(Logger &logger, ParamResult &param_result, const ParamMap &param_map, const Items<Image> &images, size_t image_id, const Items<Texture> &textures) : ParentClassType_t{logger, param_result, param_map, textures}, params_{param_result, param_map}, image_id_{image_id}, images_{images}
+ImageTexture::ImageTexture(Logger &logger, ParamResult &param_result, const ParamMap &param_map, const Items<Image> &images, size_t image_id, const Items<Texture> &textures, std::shared_ptr<TextureCache> texture_cache) : ParentClassType_t{logger, param_result, param_map, textures}, params_{param_result, param_map}, image_id_{image_id}, images_{images}, texture_cache_{std::move(texture_cache)}
 {
 	if(logger.isDebug()) logger.logDebug("**" + getClassName() + " params_:\n" + getAsParamMap(true).print());
 	const Image *image{images.getById(image_id_).first};
@@ -569,6 +570,13 @@ void ImageTexture::updateMipMaps()
 	if(use_mipmaps_ && (mipmaps_.empty() || mipmaps_image_id_ != image_id_))
 	{
 		mipmaps_ = image_manipulation::generateMipMaps(logger_, images_.getById(image_id_).first);
+		if(texture_cache_)
+		{
+			for(auto &mipmap : mipmaps_)
+			{
+				if(auto tiled_mipmap{TiledImage::factory(*mipmap, texture_cache_)}) mipmap = std::move(tiled_mipmap);
+			}
+		}
 /*		//FIXME DAVID: TEST SAVING MIPMAPS. CAREFUL: IT COULD CAUSE CRASHES!
 		for(size_t mipmap_id = 0; mipmap_id < mipmaps_.size(); ++mipmap_id)
 		{
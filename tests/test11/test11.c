@@ -0,0 +1,259 @@
+/****************************************************************************
+ *      This is part of the libYafaRay package
+ *
+ *      test11.c : in-place mesh deformation test. A flat sheet (instanced)
+ *      lit by a flat mesh light is rendered, then both meshes are bent by
+ *      rewriting their vertices buffers, so the scene is only refitted.
+ *      The result must match the render of a scene built directly with
+ *      the bent meshes.
+ *      Should work even with a "barebones" libYafaRay built without
+ *      any dependencies
+ *
+ *      This library is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free Software
+ *      Foundation,Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "yafaray_c_api.h"
+
+#define GRID_SIZE 8
+#define NUM_GRID_VERTICES ((GRID_SIZE + 1) * (GRID_SIZE + 1))
+#define RES_X 96
+#define RES_Y 72
+
+struct TestScene
+{
+	yafaray_Scene *scene_;
+	yafaray_SurfaceIntegrator *surface_integrator_;
+	yafaray_Film *film_;
+	size_t sheet_id_;
+	size_t emitter_id_;
+};
+
+/* The exported layers, read back by compareFilms, are only kept when there are outputs or a put area callback */
+void putAreaCallback(int area_id, int x_0, int y_0, int x_1, int y_1, const yafaray_FilmLayerBuffer *layer_buffers, int num_layers, void *callback_data)
+{
+	(void) area_id; (void) x_0; (void) y_0; (void) x_1; (void) y_1; (void) layer_buffers; (void) num_layers; (void) callback_data;
+}
+
+/* Grid of GRID_SIZE x GRID_SIZE squares in [-1, 1] x [-1, 1], at height "z", bent along the x axis. The emitter grid faces down */
+void gridVertices(float *vertices, float z, float bend, int facing_down)
+{
+	int i, j;
+	for(j = 0; j <= GRID_SIZE; ++j)
+	{
+		for(i = 0; i <= GRID_SIZE; ++i)
+		{
+			const float x = -1.f + 2.f * (float) i / GRID_SIZE;
+			const float y = -1.f + 2.f * (float) j / GRID_SIZE;
+			float *vertex = vertices + 3 * (j * (GRID_SIZE + 1) + i);
+			vertex[0] = x;
+			vertex[1] = y;
+			vertex[2] = facing_down ? z - bend * x * x : z + bend * x * x;
+		}
+	}
+}
+
+size_t createGrid(yafaray_Scene *scene, yafaray_ParamMap *param_map, const char *name, const float *vertices, size_t material_id, yafaray_Bool is_base_object, int facing_down)
+{
+	size_t object_id = 0;
+	int i, j;
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "mesh");
+	yafaray_setParamMapInt(param_map, "num_vertices", NUM_GRID_VERTICES);
+	yafaray_setParamMapInt(param_map, "num_faces", GRID_SIZE * GRID_SIZE);
+	yafaray_setParamMapBool(param_map, "is_base_object", is_base_object);
+	yafaray_createObject(scene, &object_id, name, param_map);
+	yafaray_addVertices(scene, object_id, vertices, NULL, NUM_GRID_VERTICES, 0);
+	for(j = 0; j < GRID_SIZE; ++j)
+	{
+		for(i = 0; i < GRID_SIZE; ++i)
+		{
+			const size_t a = j * (GRID_SIZE + 1) + i;
+			const size_t b = a + 1;
+			const size_t c = a + GRID_SIZE + 2;
+			const size_t d = a + GRID_SIZE + 1;
+			if(facing_down) yafaray_addQuad(scene, object_id, a, d, c, b, material_id);
+			else yafaray_addQuad(scene, object_id, a, b, c, d, material_id);
+		}
+	}
+	yafaray_initObject(scene, object_id, material_id);
+	return object_id;
+}
+
+/* A new film for each render, as the film accumulates the samples of all its renders */
+void createTestFilm(struct TestScene *test_scene, yafaray_Logger *logger, yafaray_ParamMap *param_map)
+{
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapInt(param_map, "width", RES_X);
+	yafaray_setParamMapInt(param_map, "height", RES_Y);
+	yafaray_setParamMapInt(param_map, "threads", 1);
+	yafaray_setParamMapInt(param_map, "AA_passes", 1);
+	yafaray_setParamMapInt(param_map, "AA_minsamples", 4);
+	test_scene->film_ = yafaray_createFilm(logger, test_scene->surface_integrator_, "film", param_map);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "exported_image_name", "Combined");
+	yafaray_setParamMapString(param_map, "exported_image_type", "ColorAlpha");
+	yafaray_setParamMapString(param_map, "image_type", "ColorAlpha");
+	yafaray_setParamMapString(param_map, "type", "combined");
+	yafaray_defineLayer(test_scene->film_, param_map);
+	yafaray_setPutAreaCallback(test_scene->film_, putAreaCallback, NULL);
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "perspective");
+	yafaray_setParamMapInt(param_map, "resx", RES_X);
+	yafaray_setParamMapInt(param_map, "resy", RES_Y);
+	yafaray_setParamMapFloat(param_map, "focal", 1.f);
+	yafaray_setParamMapVector(param_map, "from", 0.f, -4.5f, 1.f);
+	yafaray_setParamMapVector(param_map, "to", 0.f, 0.f, 0.5f);
+	yafaray_setParamMapVector(param_map, "up", 0.f, -4.5f, 2.f);
+	yafaray_defineCamera(test_scene->film_, param_map);
+}
+
+void createTestScene(struct TestScene *test_scene, yafaray_Logger *logger, yafaray_ParamMap *param_map, yafaray_ParamMapList *param_map_list, float bend)
+{
+	float vertices[3 * NUM_GRID_VERTICES];
+	size_t material_id = 0;
+	size_t instance_id = 0;
+	test_scene->scene_ = yafaray_createScene(logger, "scene");
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "directlighting");
+	yafaray_setParamMapInt(param_map, "threads", 1);
+	test_scene->surface_integrator_ = yafaray_createSurfaceIntegrator(logger, "surface integrator", param_map);
+
+	yafaray_clearParamMapList(param_map_list);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "shinydiffusemat");
+	yafaray_setParamMapColor(param_map, "color", 0.8f, 0.8f, 0.8f, 1.f);
+	yafaray_createMaterial(test_scene->scene_, &material_id, "diffuse", param_map, param_map_list);
+
+	/* The sheet is a base object seen through an instance, so its hits use the instanced primitives geometric normals */
+	gridVertices(vertices, 0.f, bend, 0);
+	test_scene->sheet_id_ = createGrid(test_scene->scene_, param_map, "sheet", vertices, material_id, YAFARAY_BOOL_TRUE, 0);
+	instance_id = yafaray_createInstance(test_scene->scene_);
+	yafaray_addInstanceObject(test_scene->scene_, instance_id, test_scene->sheet_id_);
+	yafaray_addInstanceMatrix(test_scene->scene_, instance_id, 1.5, 0, 0, 0, 0, 1.5, 0, 0, 0, 0, 1.5, 0, 0, 0, 0, 1, 0.f);
+
+	/* The emitter is a mesh light, its light samples use the primitives geometric normals */
+	gridVertices(vertices, 2.f, bend, 1);
+	test_scene->emitter_id_ = createGrid(test_scene->scene_, param_map, "emitter", vertices, material_id, YAFARAY_BOOL_FALSE, 1);
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "objectlight");
+	yafaray_setParamMapString(param_map, "object_name", "emitter");
+	yafaray_setParamMapColor(param_map, "color", 1.f, 0.9f, 0.8f, 1.f);
+	yafaray_setParamMapFloat(param_map, "power", 3.f);
+	yafaray_setParamMapInt(param_map, "samples", 4);
+	yafaray_createLight(test_scene->scene_, "emitter_light", param_map);
+
+	yafaray_clearParamMap(param_map);
+	yafaray_setParamMapString(param_map, "type", "constant");
+	yafaray_setParamMapColor(param_map, "color", 0.05f, 0.05f, 0.05f, 1.f);
+	yafaray_defineBackground(test_scene->scene_, param_map);
+
+	createTestFilm(test_scene, logger, param_map);
+}
+
+void renderTestScene(struct TestScene *test_scene)
+{
+	yafaray_RenderControl *render_control = yafaray_createRenderControl();
+	yafaray_RenderMonitor *render_monitor = yafaray_createRenderMonitor(NULL, NULL, YAFARAY_DISPLAY_CONSOLE_HIDDEN);
+	const yafaray_SceneModifiedFlags scene_modified_flags = yafaray_checkAndClearSceneModifiedFlags(test_scene->scene_);
+	srand(12345);
+	yafaray_setRenderControlForNormalStart(render_control);
+	yafaray_preprocessScene(test_scene->scene_, render_control, scene_modified_flags);
+	yafaray_preprocessSurfaceIntegrator(render_monitor, test_scene->surface_integrator_, render_control, test_scene->scene_);
+	yafaray_render(render_control, render_monitor, test_scene->surface_integrator_, test_scene->film_);
+	yafaray_destroyRenderMonitor(render_monitor);
+	yafaray_destroyRenderControl(render_control);
+}
+
+void destroyTestScene(struct TestScene *test_scene)
+{
+	yafaray_destroySurfaceIntegrator(test_scene->surface_integrator_);
+	yafaray_destroyScene(test_scene->scene_);
+	yafaray_destroyFilm(test_scene->film_);
+}
+
+/* Returns the number of pixels of the combined layer with a different color in both films, or -1 if the layers cannot be read */
+int compareFilms(const yafaray_Film *film_1, const yafaray_Film *film_2)
+{
+	yafaray_FilmLayerBuffer layer_buffer_1, layer_buffer_2;
+	int x, y, channel, num_different_pixels = 0;
+	if(!yafaray_getFilmLayerBuffer(film_1, "combined", &layer_buffer_1) || !yafaray_getFilmLayerBuffer(film_2, "combined", &layer_buffer_2)) return -1;
+	if(layer_buffer_1.num_channels != layer_buffer_2.num_channels) return -1;
+	for(y = 0; y < RES_Y; ++y)
+	{
+		for(x = 0; x < RES_X; ++x)
+		{
+			const float *pixel_1 = layer_buffer_1.data + y * layer_buffer_1.row_stride + x * layer_buffer_1.num_channels;
+			const float *pixel_2 = layer_buffer_2.data + y * layer_buffer_2.row_stride + x * layer_buffer_2.num_channels;
+			for(channel = 0; channel < layer_buffer_1.num_channels; ++channel)
+			{
+				if(pixel_1[channel] != pixel_2[channel])
+				{
+					++num_different_pixels;
+					break;
+				}
+			}
+		}
+	}
+	return num_different_pixels;
+}
+
+int main()
+{
+	const float bend = 0.6f;
+	yafaray_Logger *logger = NULL;
+	yafaray_ParamMap *param_map = NULL;
+	yafaray_ParamMapList *param_map_list = NULL;
+	struct TestScene deformed_scene, reference_scene;
+	float *vertices_buffer = NULL;
+	int num_different_pixels = 0;
+
+	logger = yafaray_createLogger("", NULL, NULL, YAFARAY_DISPLAY_CONSOLE_NORMAL);
+	yafaray_setConsoleLogColorsEnabled(logger, YAFARAY_BOOL_TRUE);
+	yafaray_setConsoleVerbosityLevel(logger, YAFARAY_LOG_LEVEL_WARNING);
+	param_map = yafaray_createParamMap();
+	param_map_list = yafaray_createParamMapList();
+
+	/* Flat meshes render, then the same meshes bent in place, which only refits the accelerators, rendered in a new film */
+	createTestScene(&deformed_scene, logger, param_map, param_map_list, 0.f);
+	renderTestScene(&deformed_scene);
+	vertices_buffer = yafaray_getVerticesBuffer(deformed_scene.scene_, deformed_scene.sheet_id_, NUM_GRID_VERTICES, 0);
+	if(vertices_buffer) gridVertices(vertices_buffer, 0.f, bend, 0);
+	vertices_buffer = yafaray_getVerticesBuffer(deformed_scene.scene_, deformed_scene.emitter_id_, NUM_GRID_VERTICES, 0);
+	if(vertices_buffer) gridVertices(vertices_buffer, 2.f, bend, 1);
+	yafaray_destroyFilm(deformed_scene.film_);
+	createTestFilm(&deformed_scene, logger, param_map);
+	renderTestScene(&deformed_scene);
+
+	/* Reference scene built directly with the bent meshes */
+	createTestScene(&reference_scene, logger, param_map, param_map_list, bend);
+	renderTestScene(&reference_scene);
+
+	num_different_pixels = compareFilms(deformed_scene.film_, reference_scene.film_);
+	if(num_different_pixels == 0) printf("test11: deformed scene matches the reference scene\n");
+	else if(num_different_pixels < 0) printf("test11: ERROR, the films combined layers could not be read\n");
+	else printf("test11: ERROR, %d pixels of the deformed scene differ from the reference scene\n", num_different_pixels);
+
+	destroyTestScene(&reference_scene);
+	destroyTestScene(&deformed_scene);
+	yafaray_destroyParamMapList(param_map_list);
+	yafaray_destroyParamMap(param_map);
+	yafaray_destroyLogger(logger);
+	return num_different_pixels == 0 ? 0 : 1;
+}